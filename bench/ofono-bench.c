@@ -0,0 +1,788 @@
+/*
+ * Copyright (C) 2013 Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Decode benchmarks: recorded replies and signals, serialized as GVariant
+ * blobs, are mapped from disk and fed straight into the parsers, no bus
+ * involved. Reports the time and the number of heap allocations per
+ * decode.
+ *
+ *   ofono_bench record <txt dir> <blob dir>   serialize data/<case>.txt
+ *   ofono_bench check <txt dir>               run the parser tables and
+ *                                             the allocation checks
+ *   ofono_bench [-n iterations] <blob dir> [case...]
+ */
+#define _GNU_SOURCE /* strptime() */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "common.h"
+#include "log.h"
+
+#define DEFAULT_ITERATIONS 100000
+#define CHECK_ITERATIONS 100
+
+/*
+ * Allocation counting: the bench is linked statically against the library
+ * code, the definitions below take over malloc() for the whole process.
+ */
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+static unsigned long s_allocs;
+
+void *malloc(size_t size)
+{
+  __atomic_add_fetch(&s_allocs, 1, __ATOMIC_RELAXED);
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+  __atomic_add_fetch(&s_allocs, 1, __ATOMIC_RELAXED);
+  return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+  __atomic_add_fetch(&s_allocs, 1, __ATOMIC_RELAXED);
+  return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr)
+{
+  __libc_free(ptr);
+}
+
+/* a{sv} -> GHashTable, the way the property caches hold it */
+static GHashTable *_props_table(GVariant *dict)
+{
+  GHashTable *props;
+  GVariantIter iter;
+  const gchar *key;
+  GVariant *value;
+
+  props = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+        (GDestroyNotify) g_variant_unref);
+
+  g_variant_iter_init(&iter, dict);
+  while (g_variant_iter_next(&iter, "{&sv}", &key, &value))
+    g_hash_table_insert(props, g_strdup(key), value);
+
+  return props;
+}
+
+static void _run_registration(GVariant *v)
+{
+  GHashTable *props = _props_table(v);
+  struct registration_info info;
+
+  memset(&info, 0, sizeof(info));
+  ofono_network_parse_registration_info(props, &info);
+
+  g_hash_table_destroy(props);
+}
+
+static void _run_sim(GVariant *v)
+{
+  GHashTable *props = _props_table(v);
+  struct sim_info info;
+
+  memset(&info, 0, sizeof(info));
+  ofono_sim_parse_info(props, &info);
+
+  g_hash_table_destroy(props);
+}
+
+/* same walk as the GetCellsInformation reply handler */
+static void _run_cells(GVariant *v)
+{
+  struct cell_info *cells, *p_ci;
+  GVariantIter *iter, *iter_cells;
+
+  g_variant_get(v, "(a(a{sv}))", &iter);
+
+  cells = g_malloc0(sizeof(struct cell_info) * g_variant_iter_n_children(iter));
+  p_ci = cells;
+
+  while (g_variant_iter_loop(iter, "(a{sv})", &iter_cells))
+    ofono_netmon_parse_cell_info(p_ci++, iter_cells);
+
+  g_variant_iter_free(iter);
+  g_free(cells);
+}
+
+/* the same cells appended to a column set and summarised */
+static void _run_cells_columns(GVariant *v)
+{
+  static struct netmon_columns *columns;
+  unsigned int histogram[NETMON_RSSI_MAX + 1];
+  struct cell_info *cells;
+  GVariantIter *iter, *iter_cells;
+  unsigned int n = 0;
+
+  if (columns == NULL)
+    columns = ofono_netmon_columns_new(0);
+
+  g_variant_get(v, "(a(a{sv}))", &iter);
+
+  cells = g_malloc0(sizeof(struct cell_info) * g_variant_iter_n_children(iter));
+
+  while (g_variant_iter_loop(iter, "(a{sv})", &iter_cells))
+    ofono_netmon_parse_cell_info(&cells[n++], iter_cells);
+
+  ofono_netmon_columns_clear(columns);
+  ofono_netmon_columns_append(columns, cells, n);
+  ofono_netmon_columns_best_cell(columns);
+  ofono_netmon_columns_rssi_histogram(columns, histogram);
+  ofono_netmon_columns_unique_cells(columns);
+
+  g_variant_iter_free(iter);
+  g_free(cells);
+}
+
+static void _run_operators(GVariant *v)
+{
+  struct operators_info ops;
+
+  ofono_network_parse_operators(v, &ops);
+  ofono_network_free_operators(&ops);
+}
+
+static void _run_call_forwarding(GVariant *v)
+{
+  struct call_forward_setting settings[SS_CF_CONDITION_CFNRC + 1];
+  GVariant *props = g_variant_get_child_value(v, 0);
+
+  ofono_ss_parse_call_forward(props, settings);
+
+  g_variant_unref(props);
+}
+
+static void _run_incoming_sms(GVariant *v)
+{
+  struct ofono_sms_incoming_noti noti;
+
+  /* the strings are borrowed from "v" */
+  memset(&noti, 0, sizeof(noti));
+  ofono_sms_parse_incoming(v, &noti);
+}
+
+/* the copies the SMS handler made before borrowing from "v" */
+static void _run_incoming_sms_copy(GVariant *v)
+{
+  struct ofono_sms_incoming_noti noti;
+  GVariantIter *iter;
+  GVariant *var;
+  char *key;
+
+  memset(&noti, 0, sizeof(noti));
+
+  g_variant_get(v, "(sa{sv})", &noti.message, &iter);
+  while (g_variant_iter_next(iter, "{sv}", &key, &var)) {
+    if (g_strcmp0(key, "Sender") == 0)
+      noti.sender = g_variant_dup_string(var, NULL);
+    else if (g_strcmp0(key, "LocalSentTime") == 0)
+      time_parse_iso8601(g_variant_get_string(var, NULL), &noti.timestamp,
+            &noti.timestamp_offset);
+
+    g_variant_unref(var);
+    g_free(key);
+  }
+
+  g_free(noti.message);
+  g_free(noti.sender);
+  g_variant_iter_free(iter);
+}
+
+static void _run_calls(GVariant *v)
+{
+  struct ofono_calls calls;
+
+  ofono_call_parse_calls(v, &calls);
+}
+
+/* the copies the GetCalls reply handler made before borrowing from "v" */
+static void _run_calls_copy(GVariant *v)
+{
+  struct ofono_calls calls;
+  struct ofono_call_info *p_call;
+  GVariantIter *iter, *iter_val;
+  GVariant *val;
+  char *path, *key;
+
+  memset(&calls, 0, sizeof(calls));
+  g_variant_get(v, "(a(oa{sv}))", &iter);
+
+  calls.count = g_variant_iter_n_children(iter);
+  if (calls.count > MAX_CALL_PARTIES) {
+    g_variant_iter_free(iter);
+    return;
+  }
+
+  p_call = calls.calls;
+  while (g_variant_iter_loop(iter, "(oa{sv})", &path, &iter_val)) {
+    p_call->call_id = ofono_get_call_id_from_obj_path(path);
+
+    while (g_variant_iter_loop(iter_val, "{sv}", &key, &val))
+      ofono_call_parse_property(p_call, key, val);
+
+    p_call++;
+  }
+  g_variant_iter_free(iter);
+}
+
+/*
+ * What ofono_call_parse_calls() did before the keys and states went through
+ * hashed tables, one g_strcmp0() chain each, for comparison.
+ */
+static enum ofono_call_status _call_status_strcmp(const char *str)
+{
+  if (g_strcmp0(str, "active") == 0)
+    return CALL_STATUS_ACTIVE;
+
+  else if (g_strcmp0(str, "held") == 0)
+    return CALL_STATUS_HELD;
+
+  else if (g_strcmp0(str, "dialing") == 0)
+    return CALL_STATUS_DIALING;
+
+  else if (g_strcmp0(str, "alerting") == 0)
+    return CALL_STATUS_ALERTING;
+
+  else if (g_strcmp0(str, "incoming") == 0)
+    return CALL_STATUS_INCOMING;
+
+  else if (g_strcmp0(str, "waiting") == 0)
+    return CALL_STATUS_WAITING;
+
+  else if (g_strcmp0(str, "disconnected") == 0)
+    return CALL_STATUS_DISCONNECTED;
+
+  tapi_warn("unknown call state: %s", str);
+  return CALL_STATUS_DISCONNECTED;
+}
+
+static void _run_calls_strcmp(GVariant *v)
+{
+  struct ofono_calls calls;
+  struct ofono_call_info *p_call;
+  GVariant *val, *list, *props;
+  GVariantIter iter, iter_val;
+  const char *path, *key, *str;
+
+  memset(&calls, 0, sizeof(calls));
+  list = g_variant_get_child_value(v, 0);
+  g_variant_iter_init(&iter, list);
+
+  calls.count = g_variant_iter_n_children(&iter);
+  if (calls.count > MAX_CALL_PARTIES) {
+    g_variant_unref(list);
+    return;
+  }
+
+  p_call = calls.calls;
+  while (g_variant_iter_loop(&iter, "(&o@a{sv})", &path, &props)) {
+    p_call->call_id = ofono_get_call_id_from_obj_path((char *) path);
+
+    g_variant_iter_init(&iter_val, props);
+    while (g_variant_iter_loop(&iter_val, "{&sv}", &key, &val)) {
+      if (g_strcmp0(key, "LineIdentification") == 0) {
+        str = g_variant_get_string(val, NULL);
+        g_strlcpy(p_call->line_id, str, sizeof(p_call->line_id));
+        tapi_debug("LineIdentification: %s", str);
+      } else if (g_strcmp0(key, "State") == 0) {
+        str = g_variant_get_string(val, NULL);
+        p_call->status = _call_status_strcmp(str);
+        tapi_debug("State: %s", str);
+      } else if (g_strcmp0(key, "Name") == 0) {
+        str = g_variant_get_string(val, NULL);
+        g_strlcpy(p_call->name, str, sizeof(p_call->name));
+        tapi_debug("Name: %s", str);
+      } else if (g_strcmp0(key, "Multiparty") == 0) {
+        g_variant_get(val, "b", &p_call->multiparty);
+      } else if (g_strcmp0(key, "Emergency") == 0) {
+        g_variant_get(val, "b", &p_call->emergency);
+      }
+    }
+
+    p_call++;
+  }
+  g_variant_unref(list);
+}
+
+/*
+ * Notification payloads, built from the signal and the cached state the
+ * way the handlers do. Before, the handlers made a blocking GetCalls or
+ * GetProperties round trip and decoded the reply ("calls" and
+ * "registration") instead.
+ */
+static void _run_call_added(GVariant *v)
+{
+  struct ofono_call_info info;
+  GVariantIter iter;
+  const char *path, *key;
+  GVariant *props, *val;
+
+  g_variant_get(v, "(&o@a{sv})", &path, &props);
+
+  memset(&info, 0, sizeof(info));
+  info.call_id = ofono_get_call_id_from_obj_path((char *) path);
+
+  g_variant_iter_init(&iter, props);
+  while (g_variant_iter_loop(&iter, "{&sv}", &key, &val))
+    ofono_call_parse_property(&info, key, val);
+
+  g_variant_unref(props);
+}
+
+/* a modem reduced to its property cache, primed with a registration */
+static struct ofono_modem *_cache_modem(void)
+{
+  static struct ofono_modem *modem;
+  GVariant *dict;
+
+  if (modem != NULL)
+    return modem;
+
+  modem = g_new0(struct ofono_modem, 1);
+  modem->refs = 1;
+  prop_cache_init(modem);
+
+  dict = g_variant_parse(G_VARIANT_TYPE("a{sv}"),
+        "{'Mode': <'auto'>, 'Status': <'registered'>, "
+        "'LocationAreaCode': <uint16 4096>, 'CellId': <uint32 65536>, "
+        "'MobileCountryCode': <'001'>, 'MobileNetworkCode': <'01'>, "
+        "'Technology': <'lte'>, 'Name': <'Mock One'>}", NULL, NULL, NULL);
+  prop_cache_fill(modem, PROP_CACHE_NETREG, dict);
+  g_variant_unref(dict);
+
+  return modem;
+}
+
+static void _run_registration_changed(GVariant *v)
+{
+  struct ofono_modem *modem = _cache_modem();
+  struct registration_info info;
+  GHashTable *props;
+  const char *key;
+  GVariant *val;
+
+  g_variant_get(v, "(&sv)", &key, &val);
+  prop_cache_update(modem, PROP_CACHE_NETREG, key, val);
+
+  props = prop_cache_peek(modem, PROP_CACHE_NETREG);
+  ofono_network_parse_registration_info(props, &info);
+  prop_cache_unlock(modem);
+
+  g_variant_unref(val);
+}
+
+static void _run_timestamp(GVariant *v)
+{
+  time_t time;
+  int offset;
+
+  time_parse_iso8601(g_variant_get_string(v, NULL), &time, &offset);
+}
+
+/* what the SMS handlers did before time_parse_iso8601(), for comparison */
+static void _run_timestamp_libc(GVariant *v)
+{
+  struct tm tm;
+  time_t zonediff;
+  time_t time;
+
+  memset(&tm, 0, sizeof(tm));
+
+  strptime(g_variant_get_string(v, NULL), "%Y-%m-%dT%H:%M:%S%z", &tm);
+  zonediff = tm.tm_gmtoff;
+
+  time = mktime(&tm) - zonediff - timezone;
+  (void) time;
+}
+
+struct bench_case {
+  const char *name; /* data/<name>.txt and <blob dir>/<name>.gv */
+  const char *type;
+  void (*run)(GVariant *v);
+  const char *data; /* data of another case, NULL for its own */
+};
+
+static const struct bench_case cases[] = {
+  {"registration", "a{sv}", _run_registration},
+  {"sim", "a{sv}", _run_sim},
+  {"cells", "(a(a{sv}))", _run_cells},
+  {"cells-columns", "(a(a{sv}))", _run_cells_columns, "cells"},
+  {"operators", "(a(oa{sv}))", _run_operators},
+  {"call-forwarding", "(a{sv})", _run_call_forwarding},
+  {"incoming-sms", "(sa{sv})", _run_incoming_sms},
+  {"incoming-sms-copy", "(sa{sv})", _run_incoming_sms_copy, "incoming-sms"},
+  {"calls", "(a(oa{sv}))", _run_calls},
+  {"calls-copy", "(a(oa{sv}))", _run_calls_copy, "calls"},
+  {"calls-strcmp", "(a(oa{sv}))", _run_calls_strcmp, "calls"},
+  {"call-added", "(oa{sv})", _run_call_added},
+  {"registration-changed", "(sv)", _run_registration_changed},
+  {"timestamp", "s", _run_timestamp},
+  {"timestamp-libc", "s", _run_timestamp_libc, "timestamp"},
+};
+
+static const struct {
+  const char *str;
+  tapi_bool valid;
+  gint64 time;
+  int offset;
+} timestamp_table[] = {
+  {"2013-01-01T12:00:00+0000", TRUE, 1357041600, 0},
+  {"2013-05-01T12:34:56+0800", TRUE, 1367382896, 28800},
+  {"2000-02-29T23:59:59-0330", TRUE, 951881399, -12600},
+  {"2016-12-31T23:59:60+0000", TRUE, 1483228800, 0}, /* leap second */
+  {"2038-01-19T03:14:08+00:00", TRUE, 2147483648LL, 0},
+  {"2013-05-01T12:34:56+08", TRUE, 1367382896, 28800},
+  {"2013-05-01T12:34:56Z", TRUE, 1367411696, 0},
+  {"2013-05-01T12:34:56", TRUE, 1367411696, 0},
+  {"1969-12-31T23:59:59+0000", TRUE, -1, 0},
+  {"2013-02-29T00:00:00+0000", FALSE},
+  {"2013-13-01T00:00:00+0000", FALSE},
+  {"2013-05-01T24:00:00+0000", FALSE},
+  {"2013-05-01 12:34", FALSE},
+  {"2013-05-01T12:34:56+0800x", FALSE},
+  {"2013-05-01T12:34:56+08:", FALSE},
+  {"2013-05-01T12:34:56Z+01", FALSE},
+  {"", FALSE},
+};
+
+/*
+ * Decodes that borrow from the message, against the copying decode they
+ * replaced. What remains is the child GVariant instances GLib hands out,
+ * and the format string GLib checks on every g_variant_get(): at most two
+ * allocations per element of the message.
+ */
+static const struct {
+  const char *borrowed;
+  const char *copy;
+} alloc_checks[] = {
+  {"incoming-sms", "incoming-sms-copy"},
+  {"calls", "calls-copy"},
+};
+
+static const struct bench_case *_find_case(const char *name)
+{
+  unsigned int i;
+
+  for (i = 0; i < G_N_ELEMENTS(cases); i++)
+    if (strcmp(cases[i].name, name) == 0)
+      return &cases[i];
+
+  return NULL;
+}
+
+/* data/<case>.txt, or the data of the case it borrows */
+static GVariant *_load(const struct bench_case *bc, const char *dir)
+{
+  GError *error = NULL;
+  gchar *path, *text;
+  GVariant *v;
+
+  path = g_strdup_printf("%s/%s.txt", dir, bc->data ? bc->data : bc->name);
+
+  if (!g_file_get_contents(path, &text, NULL, &error)) {
+    fprintf(stderr, "%s\n", error->message);
+    g_error_free(error);
+    g_free(path);
+    return NULL;
+  }
+
+  v = g_variant_parse(G_VARIANT_TYPE(bc->type), text, NULL, NULL, &error);
+  g_free(text);
+  if (v == NULL) {
+    fprintf(stderr, "%s: %s\n", path, error->message);
+    g_error_free(error);
+    g_free(path);
+    return NULL;
+  }
+
+  g_free(path);
+
+  return g_variant_ref_sink(v);
+}
+
+/* values below "v", the contents of the variants included */
+static unsigned int _elements(GVariant *v)
+{
+  unsigned int count = 0;
+  gsize i, n;
+
+  if (!g_variant_is_container(v))
+    return 0;
+
+  n = g_variant_n_children(v);
+  for (i = 0; i < n; i++) {
+    GVariant *child = g_variant_get_child_value(v, i);
+
+    count += 1 + _elements(child);
+    g_variant_unref(child);
+  }
+
+  return count;
+}
+
+/* allocations per run of "bc" on "bytes", the message itself excluded */
+static double _allocs_per_op(const struct bench_case *bc, GBytes *bytes)
+{
+  unsigned long allocs = 0, start;
+  unsigned int i;
+
+  for (i = 0; i < 2 * CHECK_ITERATIONS; i++) {
+    GVariant *v = g_variant_new_from_bytes(G_VARIANT_TYPE(bc->type), bytes,
+          FALSE);
+
+    start = s_allocs;
+    bc->run(v);
+    /* the first half warms the str_table indexes and type info caches */
+    if (i >= CHECK_ITERATIONS)
+      allocs += s_allocs - start;
+
+    g_variant_unref(v);
+  }
+
+  return (double) allocs / CHECK_ITERATIONS;
+}
+
+static int _check_allocs(const char *dir)
+{
+  const struct bench_case *borrowed, *copy;
+  double borrowed_allocs, copy_allocs;
+  unsigned int i, bound;
+  GVariant *v;
+  GBytes *bytes;
+  int failed = 0;
+
+  for (i = 0; i < G_N_ELEMENTS(alloc_checks); i++) {
+    borrowed = _find_case(alloc_checks[i].borrowed);
+    copy = _find_case(alloc_checks[i].copy);
+
+    v = _load(borrowed, dir);
+    if (v == NULL)
+      return 1;
+
+    bytes = g_variant_get_data_as_bytes(v);
+    bound = 2 * _elements(v);
+
+    borrowed_allocs = _allocs_per_op(borrowed, bytes);
+    copy_allocs = _allocs_per_op(copy, bytes);
+
+    if (borrowed_allocs > bound) {
+      fprintf(stderr, "%s: %.1f allocs/op, at most %u expected\n",
+            borrowed->name, borrowed_allocs, bound);
+      failed++;
+    }
+
+    if (borrowed_allocs >= copy_allocs) {
+      fprintf(stderr, "%s: %.1f allocs/op, %s makes %.1f\n",
+            borrowed->name, borrowed_allocs, copy->name, copy_allocs);
+      failed++;
+    }
+
+    printf("%s: %.1f allocs/op, %s %.1f, bound %u\n", borrowed->name,
+          borrowed_allocs, copy->name, copy_allocs, bound);
+
+    g_bytes_unref(bytes);
+    g_variant_unref(v);
+  }
+
+  printf("allocs: %u checks, %d failed\n",
+        (unsigned int) G_N_ELEMENTS(alloc_checks) * 2, failed);
+
+  return failed != 0;
+}
+
+static int _check(const char *dir)
+{
+  unsigned int i;
+  int failed = 0;
+
+  for (i = 0; i < G_N_ELEMENTS(timestamp_table); i++) {
+    time_t time = 0;
+    int offset = 0;
+    tapi_bool valid;
+
+    valid = time_parse_iso8601(timestamp_table[i].str, &time, &offset);
+    if (valid != timestamp_table[i].valid || (valid &&
+        ((gint64) time != timestamp_table[i].time ||
+         offset != timestamp_table[i].offset))) {
+      fprintf(stderr, "timestamp \"%s\": got %d %" G_GINT64_FORMAT
+            " %d\n", timestamp_table[i].str, valid, (gint64) time, offset);
+      failed++;
+    }
+  }
+
+  printf("timestamp: %u checks, %d failed\n",
+        (unsigned int) G_N_ELEMENTS(timestamp_table), failed);
+
+  /* the parsers log at debug level, count the decoding only */
+  tapi_log_set_level(TAPI_LOG_ERROR);
+
+  return _check_allocs(dir) || failed != 0;
+}
+
+static int _record(const char *src_dir, const char *dst_dir)
+{
+  unsigned int i;
+
+  for (i = 0; i < G_N_ELEMENTS(cases); i++) {
+    GError *error = NULL;
+    gchar *dst;
+    GVariant *v;
+
+    if (cases[i].data != NULL)
+      continue;
+
+    v = _load(&cases[i], src_dir);
+    if (v == NULL)
+      return 1;
+
+    dst = g_strdup_printf("%s/%s.gv", dst_dir, cases[i].name);
+
+    if (!g_file_set_contents(dst, g_variant_get_data(v),
+          g_variant_get_size(v), &error)) {
+      fprintf(stderr, "%s\n", error->message);
+      return 1;
+    }
+
+    g_variant_unref(v);
+    g_free(dst);
+  }
+
+  return 0;
+}
+
+static guint64 _now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (guint64) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int _bench(const struct bench_case *bc, const char *dir,
+      unsigned long iterations)
+{
+  GError *error = NULL;
+  GMappedFile *file;
+  GBytes *bytes;
+  gchar *path;
+  guint64 start, elapsed;
+  unsigned long allocs, i;
+
+  path = g_strdup_printf("%s/%s.gv", dir, bc->data ? bc->data : bc->name);
+  file = g_mapped_file_new(path, FALSE, &error);
+  g_free(path);
+  if (file == NULL) {
+    fprintf(stderr, "%s\n", error->message);
+    g_error_free(error);
+    return 1;
+  }
+
+  bytes = g_mapped_file_get_bytes(file);
+
+  /* warm up: str_table indexes, type info caches */
+  for (i = 0; i < 100; i++) {
+    GVariant *v = g_variant_new_from_bytes(G_VARIANT_TYPE(bc->type), bytes,
+          FALSE);
+    bc->run(v);
+    g_variant_unref(v);
+  }
+
+  allocs = s_allocs;
+  start = _now_ns();
+
+  for (i = 0; i < iterations; i++) {
+    /* untrusted, like a message off the bus */
+    GVariant *v = g_variant_new_from_bytes(G_VARIANT_TYPE(bc->type), bytes,
+          FALSE);
+    bc->run(v);
+    g_variant_unref(v);
+  }
+
+  elapsed = _now_ns() - start;
+  allocs = s_allocs - allocs;
+
+  printf("%-20s %10.1f ns/op %8.1f allocs/op\n", bc->name,
+        (double) elapsed / iterations, (double) allocs / iterations);
+
+  g_bytes_unref(bytes);
+  g_mapped_file_unref(file);
+
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  unsigned long iterations = DEFAULT_ITERATIONS;
+  const char *dir;
+  unsigned int i;
+  int ret = 0;
+  int arg = 1;
+
+  /* keep the allocations visible to the counters */
+  g_setenv("G_SLICE", "always-malloc", TRUE);
+
+  if (argc == 4 && strcmp(argv[1], "record") == 0)
+    return _record(argv[2], argv[3]);
+
+  if (argc == 3 && strcmp(argv[1], "check") == 0)
+    return _check(argv[2]);
+
+  if (argc > 2 && strcmp(argv[1], "-n") == 0) {
+    iterations = strtoul(argv[2], NULL, 10);
+    arg = 3;
+  }
+
+  if (arg >= argc || iterations == 0) {
+    fprintf(stderr, "usage: %s record <txt dir> <blob dir>\n"
+          "       %s check <txt dir>\n"
+          "       %s [-n iterations] <blob dir> [case...]\n",
+          argv[0], argv[0], argv[0]);
+    return 1;
+  }
+
+  dir = argv[arg++];
+
+  /* the parsers log at debug level, measure the decoding only */
+  tapi_log_set_level(TAPI_LOG_ERROR);
+
+  for (i = 0; i < G_N_ELEMENTS(cases); i++) {
+    int j;
+
+    if (arg < argc) {
+      for (j = arg; j < argc; j++)
+        if (strcmp(argv[j], cases[i].name) == 0)
+          break;
+      if (j == argc)
+        continue;
+    }
+
+    ret |= _bench(&cases[i], dir, iterations);
+  }
+
+  return ret;
+}
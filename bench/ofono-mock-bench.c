@@ -0,0 +1,504 @@
+/*
+ * Copyright (C) 2013 Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Request benchmarks against mock-ofonod, every method reply delayed by
+ * "latency" ms to stand for a real modem:
+ *
+ *   test/run-mock.sh --modems 64 -- ofono_mock_bench [-l latency] [case...]
+ *
+ *   getters   GetCalls on every modem, the blocking getter one modem
+ *             after the other against the async one, all in flight
+ *   dispatch  Strength signals from every modem, a callback on the
+ *             strength only against a callback on every notification
+ *   registry  Modem list and modem init, a GetModems and a GetProperties
+ *             per modem the way it was done before the registry,
+ *             against the registry filled by a single GetModems
+ *   startup   ofono_init() and ofono_modem_init() on every modem against
+ *             ofono_init_async() and ofono_modem_init_async(), all issued
+ *             at once
+ *
+ * The latency is set through MOCK_INPUT, set by run-mock.sh.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include "ofono-common.h"
+#include "ofono-call.h"
+
+#define DEFAULT_LATENCY 5 /* ms */
+#define ROUNDS 5
+#define BURST 1000 /* signals per modem */
+#define BURST_TIMEOUT 30 /* s */
+
+static FILE *s_mock;
+static int s_pending;
+static int s_received;
+static gboolean s_timeout;
+
+/* mock-ofonod reads its input asynchronously, give it time to apply it */
+static void _mock_command(const char *command)
+{
+  fprintf(s_mock, "%s\n", command);
+  fflush(s_mock);
+  g_usleep(G_USEC_PER_SEC / 10);
+}
+
+static void _print(const char *name, int modems, const char *what,
+      gint64 elapsed, int requests)
+{
+  printf("%-10s %3d modems  %-10s %8.1f ms %10.0f req/s\n", name, modems,
+        what, (double) elapsed / 1000,
+        (double) requests * G_USEC_PER_SEC / elapsed);
+}
+
+/* iterate until every pending response has arrived */
+static void _wait_pending(void)
+{
+  while (s_pending > 0)
+    g_main_context_iteration(NULL, TRUE);
+}
+
+static struct ofono_modem **_modems_init(struct str_list *paths)
+{
+  struct ofono_modem **modems;
+  int i;
+
+  modems = g_new0(struct ofono_modem *, paths->count);
+  for (i = 0; i < paths->count; i++)
+    modems[i] = ofono_modem_init(paths->data[i]);
+
+  return modems;
+}
+
+static void _modems_deinit(struct ofono_modem **modems, int count)
+{
+  int i;
+
+  for (i = 0; i < count; i++)
+    ofono_modem_deinit(modems[i]);
+  g_free(modems);
+}
+
+static void _on_calls(TResult ret, const void *data, const void *user_data)
+{
+  if (ret != TAPI_RESULT_OK)
+    fprintf(stderr, "GetCalls failed: %d\n", ret);
+
+  s_pending--;
+}
+
+static int _bench_getters(void)
+{
+  struct ofono_modem **modems;
+  struct ofono_calls calls;
+  struct str_list *paths;
+  gint64 start, blocking = 0, async = 0;
+  int i, round;
+
+  if (!ofono_init()) {
+    fprintf(stderr, "no ofono daemon\n");
+    return 1;
+  }
+
+  paths = ofono_get_modems();
+  modems = _modems_init(paths);
+
+  for (round = 0; round < ROUNDS; round++) {
+    start = g_get_monotonic_time();
+    for (i = 0; i < paths->count; i++)
+      ofono_call_get_calls(modems[i], &calls);
+    blocking += g_get_monotonic_time() - start;
+
+    start = g_get_monotonic_time();
+    for (i = 0; i < paths->count; i++) {
+      if (ofono_call_get_calls_async(modems[i], _on_calls, NULL) != 0)
+        s_pending++;
+    }
+    _wait_pending();
+    async += g_get_monotonic_time() - start;
+  }
+
+  _print("getters", paths->count, "blocking", blocking / ROUNDS,
+        paths->count);
+  _print("getters", paths->count, "async", async / ROUNDS, paths->count);
+
+  _modems_deinit(modems, paths->count);
+  ofono_string_list_free(paths);
+  ofono_deinit();
+
+  return 0;
+}
+
+static void _on_strength(enum ofono_noti noti, void *data, void *user_data)
+{
+  s_received++;
+}
+
+static void _on_noti(enum ofono_noti noti, void *data, void *user_data)
+{
+}
+
+static void _register(struct ofono_modem **modems, int count, tapi_bool all)
+{
+  int i, noti;
+
+  for (i = 0; i < count; i++) {
+    ofono_register_notification_callback(modems[i],
+          OFONO_NOTI_SIGNAL_STRENTH_CHANGED, _on_strength, NULL, NULL);
+
+    for (noti = 0; all && noti < OFONO_NOTI_MAX; noti++)
+      if (noti != OFONO_NOTI_SIGNAL_STRENTH_CHANGED)
+        ofono_register_notification_callback(modems[i], noti, _on_noti,
+              NULL, NULL);
+  }
+}
+
+static void _unregister(struct ofono_modem **modems, int count)
+{
+  int i, noti;
+
+  for (i = 0; i < count; i++) {
+    ofono_unregister_notification_callback(modems[i],
+          OFONO_NOTI_SIGNAL_STRENTH_CHANGED, _on_strength);
+
+    for (noti = 0; noti < OFONO_NOTI_MAX; noti++)
+      if (noti != OFONO_NOTI_SIGNAL_STRENTH_CHANGED)
+        ofono_unregister_notification_callback(modems[i], noti, _on_noti);
+  }
+}
+
+static gboolean _on_burst_timeout(gpointer data)
+{
+  s_timeout = TRUE;
+  return G_SOURCE_REMOVE;
+}
+
+/* burst the strength and iterate until every signal has been dispatched */
+static int _burst(struct ofono_modem **modems, const char *what, int count)
+{
+  struct ofono_calls calls;
+  char command[32];
+  gint64 start;
+  guint timer;
+  int expected = BURST * count;
+
+  /* a round trip, the bus has the match rules once it is answered */
+  ofono_call_get_calls(modems[0], &calls);
+
+  s_received = 0;
+  snprintf(command, sizeof(command), "burst strength %d", BURST);
+  start = g_get_monotonic_time();
+  fprintf(s_mock, "%s\n", command);
+  fflush(s_mock);
+
+  s_timeout = FALSE;
+  timer = g_timeout_add_seconds(BURST_TIMEOUT, _on_burst_timeout, NULL);
+  while (s_received < expected && !s_timeout)
+    g_main_context_iteration(NULL, TRUE);
+
+  if (!s_timeout)
+    g_source_remove(timer);
+
+  if (s_received < expected) {
+    fprintf(stderr, "dispatch %s: %d of %d signals\n", what, s_received,
+          expected);
+    return 1;
+  }
+
+  _print("dispatch", count, what, g_get_monotonic_time() - start, expected);
+
+  return 0;
+}
+
+static int _bench_dispatch(void)
+{
+  struct ofono_modem **modems;
+  struct str_list *paths;
+  int ret;
+
+  if (!ofono_init()) {
+    fprintf(stderr, "no ofono daemon\n");
+    return 1;
+  }
+
+  paths = ofono_get_modems();
+  if (paths == NULL || paths->count == 0) {
+    fprintf(stderr, "no modem\n");
+    ofono_string_list_free(paths);
+    ofono_deinit();
+    return 1;
+  }
+  modems = _modems_init(paths);
+
+  _register(modems, paths->count, FALSE);
+  ret = _burst(modems, "strength", paths->count);
+  _unregister(modems, paths->count);
+
+  _register(modems, paths->count, TRUE);
+  ret |= _burst(modems, "all", paths->count);
+  _unregister(modems, paths->count);
+
+  _modems_deinit(modems, paths->count);
+  ofono_string_list_free(paths);
+  ofono_deinit();
+
+  return ret;
+}
+
+static void _on_modem_property(GDBusConnection *conn, const gchar *sender,
+      const gchar *path, const gchar *iface, const gchar *signal,
+      GVariant *parameters, gpointer data)
+{
+}
+
+static GVariant *_call_sync(GDBusConnection *conn, const char *path,
+      const char *iface, const char *method)
+{
+  GError *error = NULL;
+  GVariant *ret;
+
+  ret = g_dbus_connection_call_sync(conn, "org.ofono", path, iface, method,
+        NULL, NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL, &error);
+  if (ret == NULL) {
+    fprintf(stderr, "%s failed: %s\n", method, error->message);
+    g_error_free(error);
+  }
+
+  return ret;
+}
+
+/*
+ * What ofono_get_modems() and ofono_modem_init() did before the registry:
+ * each modem init listed the modems again to find its path, then fetched
+ * the modem properties.
+ */
+static int _registry_per_modem(GDBusConnection *conn)
+{
+  GVariant *modems, *list, *ret;
+  GVariantIter iter;
+  const char *path;
+  guint *watches;
+  int i, count;
+
+  modems = _call_sync(conn, "/", "org.ofono.Manager", "GetModems");
+  if (modems == NULL)
+    return -1;
+
+  list = g_variant_get_child_value(modems, 0);
+  g_variant_iter_init(&iter, list);
+  count = g_variant_iter_n_children(&iter);
+  watches = g_new0(guint, count);
+
+  for (i = 0; g_variant_iter_loop(&iter, "(&o@a{sv})", &path, NULL); i++) {
+    ret = _call_sync(conn, "/", "org.ofono.Manager", "GetModems");
+    if (ret != NULL)
+      g_variant_unref(ret);
+
+    watches[i] = g_dbus_connection_signal_subscribe(conn, "org.ofono",
+          "org.ofono.Modem", "PropertyChanged", path, NULL,
+          G_DBUS_SIGNAL_FLAGS_NONE, _on_modem_property, NULL, NULL);
+
+    ret = _call_sync(conn, path, "org.ofono.Modem", "GetProperties");
+    if (ret != NULL)
+      g_variant_unref(ret);
+  }
+
+  for (i = 0; i < count; i++)
+    g_dbus_connection_signal_unsubscribe(conn, watches[i]);
+  g_free(watches);
+  g_variant_unref(list);
+  g_variant_unref(modems);
+
+  return count;
+}
+
+static int _bench_registry(void)
+{
+  struct ofono_modem **modems;
+  struct str_list *paths;
+  GDBusConnection *conn;
+  GError *error = NULL;
+  gint64 start, per_modem = 0, registry = 0;
+  int count = 0, round;
+
+  conn = g_bus_get_sync(G_BUS_TYPE_SYSTEM, NULL, &error);
+  if (conn == NULL) {
+    fprintf(stderr, "no bus: %s\n", error->message);
+    g_error_free(error);
+    return 1;
+  }
+
+  for (round = 0; round < ROUNDS; round++) {
+    start = g_get_monotonic_time();
+    count = _registry_per_modem(conn);
+    per_modem += g_get_monotonic_time() - start;
+    if (count < 0)
+      break;
+
+    start = g_get_monotonic_time();
+    if (!ofono_init()) {
+      fprintf(stderr, "no ofono daemon\n");
+      count = -1;
+      break;
+    }
+    paths = ofono_get_modems();
+    modems = _modems_init(paths);
+    registry += g_get_monotonic_time() - start;
+
+    _modems_deinit(modems, paths->count);
+    ofono_string_list_free(paths);
+    ofono_deinit();
+  }
+
+  g_object_unref(conn);
+
+  if (count < 0)
+    return 1;
+
+  _print("registry", count, "per-modem", per_modem / ROUNDS, count);
+  _print("registry", count, "registry", registry / ROUNDS, count);
+
+  return 0;
+}
+
+static void _on_init(TResult ret, const void *data, const void *user_data)
+{
+  if (ret != TAPI_RESULT_OK)
+    fprintf(stderr, "ofono_init_async failed: %d\n", ret);
+
+  s_pending--;
+}
+
+static void _on_modem(TResult ret, const void *data, const void *user_data)
+{
+  struct ofono_modem **modem = (struct ofono_modem **) user_data;
+
+  if (ret != TAPI_RESULT_OK)
+    fprintf(stderr, "ofono_modem_init_async failed: %d\n", ret);
+
+  *modem = (struct ofono_modem *) data;
+  s_pending--;
+}
+
+static int _bench_startup(void)
+{
+  struct ofono_modem **modems;
+  struct str_list *paths;
+  gint64 start, blocking = 0, async = 0;
+  int i, round;
+
+  if (!ofono_init()) {
+    fprintf(stderr, "no ofono daemon\n");
+    return 1;
+  }
+  paths = ofono_get_modems();
+  ofono_deinit();
+
+  for (round = 0; round < ROUNDS; round++) {
+    start = g_get_monotonic_time();
+    ofono_init();
+    modems = _modems_init(paths);
+    blocking += g_get_monotonic_time() - start;
+
+    _modems_deinit(modems, paths->count);
+    ofono_deinit();
+
+    modems = g_new0(struct ofono_modem *, paths->count);
+
+    start = g_get_monotonic_time();
+    s_pending = 1 + paths->count;
+    ofono_init_async(_on_init, NULL);
+    for (i = 0; i < paths->count; i++)
+      ofono_modem_init_async(paths->data[i], _on_modem, &modems[i]);
+    _wait_pending();
+    async += g_get_monotonic_time() - start;
+
+    _modems_deinit(modems, paths->count);
+    ofono_deinit();
+  }
+
+  _print("startup", paths->count, "blocking", blocking / ROUNDS,
+        paths->count);
+  _print("startup", paths->count, "async", async / ROUNDS, paths->count);
+
+  ofono_string_list_free(paths);
+
+  return 0;
+}
+
+static const struct {
+  const char *name;
+  int (*run)(void);
+} cases[] = {
+  {"getters", _bench_getters},
+  {"dispatch", _bench_dispatch},
+  {"registry", _bench_registry},
+  {"startup", _bench_startup},
+};
+
+int main(int argc, char **argv)
+{
+  const char *input = getenv("MOCK_INPUT");
+  int latency = DEFAULT_LATENCY;
+  char command[32];
+  int arg = 1;
+  int ret = 0;
+  unsigned int i;
+
+  if (argc > 2 && strcmp(argv[1], "-l") == 0) {
+    latency = atoi(argv[2]);
+    arg = 3;
+  }
+
+  if (input == NULL || latency < 0) {
+    fprintf(stderr, "usage: test/run-mock.sh --modems <n> -- "
+          "%s [-l latency] [case...]\n", argv[0]);
+    return 1;
+  }
+
+  s_mock = fopen(input, "w");
+  if (s_mock == NULL) {
+    perror(input);
+    return 1;
+  }
+
+  snprintf(command, sizeof(command), "latency %d", latency);
+  _mock_command(command);
+
+  for (i = 0; i < G_N_ELEMENTS(cases); i++) {
+    int j;
+
+    if (arg < argc) {
+      for (j = arg; j < argc; j++)
+        if (strcmp(argv[j], cases[i].name) == 0)
+          break;
+      if (j == argc)
+        continue;
+    }
+
+    ret |= cases[i].run();
+  }
+
+  fclose(s_mock);
+
+  return ret;
+}
@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2013 Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Signal throughput against mock-ofonod, for a growing number of
+ * connection shards: every modem of the mock emits a burst of Strength
+ * changes and the signal strength notifications are counted.
+ *
+ *   test/run-mock.sh --modems 32 -- ofono_signal_bench [-n count] [shards...]
+ *
+ * The burst is requested through MOCK_INPUT, set by run-mock.sh.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "ofono-common.h"
+
+#define DEFAULT_COUNT 2000
+#define MAX_WAIT_US (30 * G_USEC_PER_SEC)
+
+static gint s_received;
+
+static void _on_strength(enum ofono_noti noti, void *data, void *user_data)
+{
+  g_atomic_int_inc(&s_received);
+}
+
+static int _bench(FILE *mock, unsigned int shards, int count)
+{
+  struct ofono_modem **modems;
+  struct str_list *paths;
+  gint64 start, elapsed;
+  gint expected;
+  int i;
+
+  if (!ofono_dispatch_start_sharded(NULL, shards))
+    return 1;
+
+  if (!ofono_init()) {
+    fprintf(stderr, "no ofono daemon\n");
+    ofono_dispatch_stop();
+    return 1;
+  }
+
+  paths = ofono_get_modems();
+  if (paths == NULL || paths->count == 0) {
+    fprintf(stderr, "no modem\n");
+    ofono_deinit();
+    ofono_dispatch_stop();
+    return 1;
+  }
+
+  modems = g_new0(struct ofono_modem *, paths->count);
+  for (i = 0; i < paths->count; i++) {
+    modems[i] = ofono_modem_init(paths->data[i]);
+    ofono_register_notification_callback(modems[i],
+          OFONO_NOTI_SIGNAL_STRENTH_CHANGED, _on_strength, NULL, NULL);
+  }
+
+  /* the subscriptions are made asynchronously on the shard threads */
+  g_usleep(G_USEC_PER_SEC / 2);
+
+  g_atomic_int_set(&s_received, 0);
+  expected = paths->count * count;
+
+  start = g_get_monotonic_time();
+  fprintf(mock, "burst strength %d\n", count);
+  fflush(mock);
+
+  while (g_atomic_int_get(&s_received) < expected &&
+      g_get_monotonic_time() - start < MAX_WAIT_US)
+    g_usleep(1000);
+
+  elapsed = g_get_monotonic_time() - start;
+
+  printf("%2u shards %3d modems %10.0f signals/s", shards, paths->count,
+        (double) g_atomic_int_get(&s_received) * G_USEC_PER_SEC / elapsed);
+  if (g_atomic_int_get(&s_received) < expected)
+    printf(" (%d of %d received)", g_atomic_int_get(&s_received), expected);
+  printf("\n");
+
+  for (i = 0; i < paths->count; i++)
+    ofono_modem_deinit(modems[i]);
+  g_free(modems);
+  ofono_string_list_free(paths);
+
+  ofono_deinit();
+  ofono_dispatch_stop();
+
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  static const unsigned int default_shards[] = {1, 2, 4, 8};
+  const char *input = getenv("MOCK_INPUT");
+  int count = DEFAULT_COUNT;
+  int arg = 1;
+  int ret = 0;
+  FILE *mock;
+  unsigned int i;
+
+  if (argc > 2 && strcmp(argv[1], "-n") == 0) {
+    count = atoi(argv[2]);
+    arg = 3;
+  }
+
+  if (input == NULL || count <= 0) {
+    fprintf(stderr, "usage: test/run-mock.sh --modems <n> -- "
+          "%s [-n count] [shards...]\n", argv[0]);
+    return 1;
+  }
+
+  mock = fopen(input, "w");
+  if (mock == NULL) {
+    perror(input);
+    return 1;
+  }
+
+  if (arg < argc) {
+    for (; arg < argc; arg++)
+      ret |= _bench(mock, strtoul(argv[arg], NULL, 10), count);
+  } else {
+    for (i = 0; i < G_N_ELEMENTS(default_shards); i++)
+      ret |= _bench(mock, default_shards[i], count);
+  }
+
+  fclose(mock);
+
+  return ret;
+}
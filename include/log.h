@@ -21,46 +21,125 @@
 extern "C" {
 #endif
 
+/* log levels, usable in #if */
+#define TAPI_LOG_NONE 0
+#define TAPI_LOG_FATAL 1
+#define TAPI_LOG_ERROR 2
+#define TAPI_LOG_WARN 3
+#define TAPI_LOG_INFO 4
+#define TAPI_LOG_DEBUG 5
+
+/*
+ * Highest level compiled in, the calls above it are removed by the
+ * preprocessor and their arguments are never evaluated.
+ */
+#ifndef TAPI_LOG_LEVEL
 #ifdef NDEBUG
+#define TAPI_LOG_LEVEL TAPI_LOG_NONE
+#else
+#define TAPI_LOG_LEVEL TAPI_LOG_DEBUG
+#endif
+#endif
+
+#define TAPI_LOG_RING_SIZE 256 /* messages kept by the ring sink */
+#define TAPI_LOG_MSG_SIZE 256 /* longer messages are truncated */
+
+/*
+ * 'level': TAPI_LOG_FATAL ... TAPI_LOG_DEBUG
+ * 'msg': the formatted message, without trailing newline
+ */
+typedef void (*tapi_log_sink)(int level, const char *msg, void *user_data);
+
+/* highest level logged at runtime, don't modify it, use tapi_log_set_level() */
+extern int tapi_log_runtime_level;
+
+/**
+ * Set the highest level logged at runtime, default is TAPI_LOG_DEBUG
+ *
+ * The levels above TAPI_LOG_LEVEL are compiled out and can't be enabled.
+ */
+void tapi_log_set_level(int level);
+
+/**
+ * Set the function the log messages are passed to
+ *
+ * 'sink': the sink, NULL restores the default one (stdout)
+ * 'user_data': the user data will be pass through to the sink
+ *
+ * The sink may be called from any thread, set it before ofono_init().
+ */
+void tapi_log_set_sink(tapi_log_sink sink, void *user_data);
 
-#define tapi_debug(...)
-#define tapi_info(...)
-#define tapi_warn(...)
-#define tapi_error(...)
-#define tapi_fatal(...)
-#define tapi_log_bin(bin, size)
+/**
+ * Lock-free sink keeping the last TAPI_LOG_RING_SIZE messages in memory
+ *
+ * Usage: tapi_log_set_sink(tapi_log_ring_sink, NULL)
+ */
+void tapi_log_ring_sink(int level, const char *msg, void *user_data);
 
-#else /* NDEBUG */
+/**
+ * Pass the messages kept by the ring sink to 'sink', oldest first
+ *
+ * Messages being overwritten by concurrent writers are skipped.
+ *
+ * Return the number of messages passed.
+ */
+unsigned int tapi_log_ring_dump(tapi_log_sink sink, void *user_data);
 
-#include <stdio.h>
+void tapi_log_write(int level, const char *file, const char *func, int line,
+      const char *fmt, ...);
 
-#define tapi_log_print printf
+/* check it before building an expensive log argument */
+#define tapi_log_enabled(_level) \
+  ((_level) <= TAPI_LOG_LEVEL && (_level) <= tapi_log_runtime_level)
 
-#define tapi_debug(fmt, args...) \
-  tapi_log_print("<%s %s:%d> " fmt "\n", __FILE__, __func__, __LINE__, ##args)
+#define tapi_log(_level, fmt, args...) \
+  do { \
+    if (tapi_log_enabled(_level)) \
+      tapi_log_write(_level, __FILE__, __func__, __LINE__, fmt, ##args); \
+  } while (0)
 
-#define tapi_info(fmt, args...) \
-  tapi_log_print("<%s %s:%d> " fmt "\n", __FILE__, __func__, __LINE__, ##args)
+#if TAPI_LOG_LEVEL >= TAPI_LOG_DEBUG
+#define tapi_debug(fmt, args...) tapi_log(TAPI_LOG_DEBUG, fmt, ##args)
+#else
+#define tapi_debug(...) do { } while (0)
+#endif
 
-#define tapi_warn(fmt, args...) \
-  tapi_log_print("<Warn> %s %s:%d> " fmt "\n",__FILE__, __func__, __LINE__, ##args)
+#if TAPI_LOG_LEVEL >= TAPI_LOG_INFO
+#define tapi_info(fmt, args...) tapi_log(TAPI_LOG_INFO, fmt, ##args)
+#else
+#define tapi_info(...) do { } while (0)
+#endif
 
-#define tapi_error(fmt, args...) \
-  tapi_log_print("<Error> %s %s:%d> " fmt "\n",__FILE__, __func__, __LINE__, ##args)
+#if TAPI_LOG_LEVEL >= TAPI_LOG_WARN
+#define tapi_warn(fmt, args...) tapi_log(TAPI_LOG_WARN, fmt, ##args)
+#else
+#define tapi_warn(...) do { } while (0)
+#endif
 
-#define tapi_fatal(fmt, args...) \
-  tapi_log_print("<Fatal> %s %s:%d> " fmt "\n",__FILE__, __func__, __LINE__, ##args)
+#if TAPI_LOG_LEVEL >= TAPI_LOG_ERROR
+#define tapi_error(fmt, args...) tapi_log(TAPI_LOG_ERROR, fmt, ##args)
+#else
+#define tapi_error(...) do { } while (0)
+#endif
+
+#if TAPI_LOG_LEVEL >= TAPI_LOG_FATAL
+#define tapi_fatal(fmt, args...) tapi_log(TAPI_LOG_FATAL, fmt, ##args)
+#else
+#define tapi_fatal(...) do { } while (0)
+#endif
+
+#if TAPI_LOG_LEVEL >= TAPI_LOG_DEBUG
+void tapi_log_write_bin(const void *bin, int size);
 
 #define tapi_log_bin(_bin, _size) \
-  { \
-    int _log_i = 0; \
-    unsigned char *_log_bin = (unsigned char *)_bin; \
-    for (_log_i = 0; _log_i < _size; _log_i++) \
-      tapi_log_print("%02X ", _log_bin[_log_i]); \
-    tapi_log_print("\n"); \
-  }
-
-#endif /* NDEBUG */
+  do { \
+    if (tapi_log_enabled(TAPI_LOG_DEBUG)) \
+      tapi_log_write_bin(_bin, _size); \
+  } while (0)
+#else
+#define tapi_log_bin(_bin, _size) do { } while (0)
+#endif
 
 #ifdef __cplusplus
 }
@@ -74,6 +74,15 @@ struct ofono_call_disconnect_reason {
  */
 tapi_bool ofono_call_get_ecc(struct ofono_modem *modem, struct str_list** ecc);
 
+/**
+ * Get emergency numbers
+ *
+ * Async response data: struct str_list * (released after the callback)
+ */
+ofono_request ofono_call_get_ecc_async(struct ofono_modem *modem,
+                response_cb cb,
+                void *user_data);
+
 /**
  * Initiate a new outgoing call
  *
@@ -82,7 +91,7 @@ tapi_bool ofono_call_get_ecc(struct ofono_modem *modem, struct str_list** ecc);
  *
  * Async response data: unsigned int (the call id assigned by ofonod)
  */
-void ofono_call_dial(struct ofono_modem *modem,
+ofono_request ofono_call_dial(struct ofono_modem *modem,
                 char *number,
                 enum clir_dev_status clir,
                 response_cb cb,
@@ -93,7 +102,7 @@ void ofono_call_dial(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_call_answer(struct ofono_modem *modem,
+ofono_request ofono_call_answer(struct ofono_modem *modem,
                 response_cb cb,
                 void *user_data);
 
@@ -104,7 +113,7 @@ void ofono_call_answer(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_call_release_specific(struct ofono_modem *modem,
+ofono_request ofono_call_release_specific(struct ofono_modem *modem,
                 unsigned int call_id,
                 response_cb cb,
                 void *user_data);
@@ -114,7 +123,7 @@ void ofono_call_release_specific(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_call_release_all(struct ofono_modem *modem,
+ofono_request ofono_call_release_all(struct ofono_modem *modem,
                 response_cb cb,
                 void *user_data);
 /**
@@ -122,7 +131,7 @@ void ofono_call_release_all(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_call_swap(struct ofono_modem *modem,
+ofono_request ofono_call_swap(struct ofono_modem *modem,
                 response_cb cb,
                 void *user_data);
 
@@ -132,7 +141,7 @@ void ofono_call_swap(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_call_release_and_answer(struct ofono_modem *modem,
+ofono_request ofono_call_release_and_answer(struct ofono_modem *modem,
                 response_cb cb,
                 void *user_data);
 
@@ -142,7 +151,7 @@ void ofono_call_release_and_answer(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_call_release_and_swap(struct ofono_modem *modem,
+ofono_request ofono_call_release_and_swap(struct ofono_modem *modem,
                 response_cb cb,
                 void *user_data);
 
@@ -152,7 +161,7 @@ void ofono_call_release_and_swap(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_call_hold_and_answer(struct ofono_modem *modem,
+ofono_request ofono_call_hold_and_answer(struct ofono_modem *modem,
                 response_cb cb,
                 void *user_data);
 
@@ -161,7 +170,7 @@ void ofono_call_hold_and_answer(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_call_transfer(struct ofono_modem *modem,
+ofono_request ofono_call_transfer(struct ofono_modem *modem,
                 response_cb cb,
                 void *user_data);
 
@@ -172,7 +181,7 @@ void ofono_call_transfer(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_call_deflect(struct ofono_modem *modem,
+ofono_request ofono_call_deflect(struct ofono_modem *modem,
                 char *number,
                 response_cb cb,
                 void *user_data);
@@ -182,7 +191,7 @@ void ofono_call_deflect(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_call_create_multiparty(struct ofono_modem *modem,
+ofono_request ofono_call_create_multiparty(struct ofono_modem *modem,
                 response_cb cb,
                 void *user_data);
 
@@ -191,7 +200,7 @@ void ofono_call_create_multiparty(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_call_hangup_multiparty(struct ofono_modem *modem,
+ofono_request ofono_call_hangup_multiparty(struct ofono_modem *modem,
                 response_cb cb,
                 void *user_data);
 
@@ -202,7 +211,7 @@ void ofono_call_hangup_multiparty(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_call_private_chat(struct ofono_modem *modem,
+ofono_request ofono_call_private_chat(struct ofono_modem *modem,
                 unsigned int call_id,
                 response_cb cb,
                 void *user_data);
@@ -214,7 +223,7 @@ void ofono_call_private_chat(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_call_send_tones(struct ofono_modem *modem,
+ofono_request ofono_call_send_tones(struct ofono_modem *modem,
                 const char *tones,
                 response_cb cb,
                 void *user_data);
@@ -227,6 +236,15 @@ void ofono_call_send_tones(struct ofono_modem *modem,
 tapi_bool ofono_call_get_calls(struct ofono_modem *modem,
                 struct ofono_calls *calls);
 
+/**
+ * Get current calls
+ *
+ * Async response data: struct ofono_calls *
+ */
+ofono_request ofono_call_get_calls_async(struct ofono_modem *modem,
+                response_cb cb,
+                void *user_data);
+
 /**
  * Get the information of sepcific call
  *
@@ -239,6 +257,18 @@ tapi_bool ofono_call_get_call_info(struct ofono_modem *modem,
                 unsigned int call_id,
                 struct ofono_call_info *info);
 
+/**
+ * Get the information of sepcific call
+ *
+ * "call_id": the id of the call which information will be got
+ *
+ * Async response data: struct ofono_call_info *
+ */
+ofono_request ofono_call_get_call_info_async(struct ofono_modem *modem,
+                unsigned int call_id,
+                response_cb cb,
+                void *user_data);
+
 /**
  * Get mute status
  *
@@ -252,7 +282,7 @@ tapi_bool ofono_call_get_mute_status(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_call_set_mute_status(struct ofono_modem *modem,
+ofono_request ofono_call_set_mute_status(struct ofono_modem *modem,
                 tapi_bool muted,
                 response_cb cb,
                 void *user_data);
@@ -272,7 +302,7 @@ tapi_bool ofono_call_get_speaker_volume(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_call_set_speaker_volume(struct ofono_modem *modem,
+ofono_request ofono_call_set_speaker_volume(struct ofono_modem *modem,
                 unsigned char vol,
                 response_cb cb,
                 void *user_data);
@@ -292,7 +322,7 @@ tapi_bool ofono_call_get_microphone_volume(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_call_set_microphone_volume(struct ofono_modem *modem,
+ofono_request ofono_call_set_microphone_volume(struct ofono_modem *modem,
                 unsigned char vol,
                 response_cb cb,
                 void *user_data);
@@ -304,7 +334,7 @@ void ofono_call_set_microphone_volume(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_call_set_volume_by_alsa(struct ofono_modem *modem,
+ofono_request ofono_call_set_volume_by_alsa(struct ofono_modem *modem,
                 unsigned char vol,
                 response_cb cb,
                 void *user_data);
@@ -316,7 +346,7 @@ void ofono_call_set_volume_by_alsa(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_call_set_sound_path(struct ofono_modem *modem,
+ofono_request ofono_call_set_sound_path(struct ofono_modem *modem,
                 const char *path,
                 response_cb cb,
                 void *user_data);
@@ -92,6 +92,12 @@ enum ofono_noti {
   OFONO_NOTI_SAT_IDLE_MODE_TEXT, /* display idle text notification:
         idle text (char *) */
   OFONO_NOTI_SAT_MAIN_MENU, /* Main menu is changed: NULL */
+
+  /* SMS, appended to keep the values above */
+  OFONO_NOTI_INCOMING_SMS_BATCH, /* Normal SMSs received in a row, see
+        ofono_sms_set_incoming_batch(): (struct ofono_sms_incoming_batch*) */
+
+  OFONO_NOTI_MAX, /* number of notifications, not a notification */
 };
 
 enum ofono_api {
@@ -134,24 +140,79 @@ typedef enum tapi_result {
   TAPI_RESULT_SIM_LOCKED, /* Sim is locked, password required */
   TAPI_RESULT_NETWORK_ERROR, /* Network error */
   TAPI_RESULT_FAIL, /* Fail, reason is unkown */
+  TAPI_RESULT_CANCELLED, /* Request cancelled by ofono_request_cancel() */
 } TResult;
 
+/* Handle of a pending async request, 0 if the request hasn't been sent */
+typedef unsigned int ofono_request;
+
 struct ofono_modem;
 
 typedef void (*destroy_notify)(void *user_data);
 typedef void (*modems_changed_cb)(const char *modem, tapi_bool add);
+typedef void (*modem_listener_cb)(const char *modem, tapi_bool add,
+                void *user_data);
+/* 'data' and the strings it points to are only valid during the call */
 typedef void (*noti_cb) (enum ofono_noti noti, void *data, void *user_data);
 typedef void (*response_cb) (TResult result, const void *resp_data, const void *user_data);
 
+/**
+ * Run the library on its own thread
+ *
+ * Must be called before ofono_init(). The D-Bus traffic then goes through a
+ * private thread and the ofono_* functions can be called from any thread.
+ *
+ * 'callback_context': (GMainContext *) where the response and notification
+ *    callbacks are called, it must be iterated by the application. NULL to
+ *    call them on the library thread.
+ *
+ * Return FALSE if the thread is already running.
+ */
+tapi_bool ofono_dispatch_start(void *callback_context);
+
+/**
+ * Same as ofono_dispatch_start() with the modems spread over 'shards' D-Bus
+ * connections, each with its own thread. A modem always uses the same
+ * connection, picked from a hash of its object path. The connections are
+ * opened by ofono_init() or ofono_init_async().
+ *
+ * With a NULL 'callback_context', the callbacks of different modems may run
+ * concurrently.
+ */
+tapi_bool ofono_dispatch_start_sharded(void *callback_context,
+                unsigned int shards);
+
+/**
+ * Stop the library threads, after ofono_deinit()
+ *
+ * Must not be called from a callback running on the library thread.
+ */
+void ofono_dispatch_stop();
+
 /**
  * Create dbus connection to ofono daemon and start to monitor modem changes
  *
+ * The modems and their properties are fetched once here and then tracked
+ * from the ofono signals.
  */
 tapi_bool ofono_init();
 
+/**
+ * Same as ofono_init() without blocking
+ *
+ * The connection setup and the modem enumeration are done asynchronously,
+ * 'cb' is called once the modems are known (ofono_get_modems() and
+ * ofono_modem_init() can be used).
+ *
+ * Async response data: NULL
+ */
+void ofono_init_async(response_cb cb, void *user_data);
+
 /**
  * Disconnect dbus connection to ofono daemon and release resources
  *
+ * Pending ofono_init_async() and ofono_modem_init_async() complete with
+ * TAPI_RESULT_FAIL.
  */
 void ofono_deinit();
 
@@ -159,18 +220,46 @@ void ofono_deinit();
  * Get modems
  *
  * Return list of modem object path (data: struct str_list, should free it by
- *    ofono_string_list_free).
+ *    ofono_string_list_free). Served from the modem registry, no D-Bus call.
  *
  */
 struct str_list* ofono_get_modems();
 
 /**
- * Set the callback be called when a modem is added or removed
+ * Check whether the modem 'modem' (object path) exists
+ */
+tapi_bool ofono_manager_has_modem(const char *modem);
+
+/**
+ * Add a listener called when a modem is added or removed
  *
  * If call ofono_get_modems() before ofono deamon is started no modem can be
  * found. This API provide user a way to monitor the presence of modems.
  *
  * 'cb': the callback be called when a modem is added or removed
+ * 'user_data': the user data will be pass through to the callback
+ * 'user_data_free_func': the function be called to release the memory of
+ *         'user_data' when the listener is removed.
+ *
+ * Return the listener id (> 0) for ofono_manager_remove_listener(), 0 on
+ * failure
+ */
+unsigned int ofono_manager_add_listener(modem_listener_cb cb,
+                void *user_data,
+                destroy_notify user_data_free_func);
+
+/**
+ * Remove a listener added by ofono_manager_add_listener()
+ */
+void ofono_manager_remove_listener(unsigned int id);
+
+/**
+ * Set the callback be called when a modem is added or removed
+ *
+ * Same as ofono_manager_add_listener(), but only one callback can be set
+ * this way, a new one replaces the previous one.
+ *
+ * 'cb': the callback be called when a modem is added or removed
  */
 void ofono_set_modems_changed_callback(modems_changed_cb cb);
 
@@ -183,6 +272,19 @@ void ofono_set_modems_changed_callback(modems_changed_cb cb);
  */
 struct ofono_modem* ofono_modem_init(const char *modem);
 
+/**
+ * Same as ofono_modem_init() without blocking
+ *
+ * Can be called right after ofono_init_async(), it completes once the
+ * modems are known. The properties of the modem interfaces are fetched
+ * in parallel in the background.
+ *
+ * Async response data: (struct ofono_modem *) owned by the caller, release
+ *    it with ofono_modem_deinit()
+ */
+void ofono_modem_init_async(const char *modem, response_cb cb,
+                void *user_data);
+
 /**
  * finalize a modem
  */
@@ -227,6 +329,47 @@ tapi_bool ofono_has_interface(struct ofono_modem *modem, enum ofono_api api);
 
 void ofono_string_list_free(struct str_list *list);
 
+/**
+ * Cancel a pending request
+ *
+ * 'req': the handle returned by the async function
+ *
+ * The D-Bus call is abandoned and the callback is called with
+ * TAPI_RESULT_CANCELLED. Return FALSE if the request has already completed.
+ */
+tapi_bool ofono_request_cancel(ofono_request req);
+
+struct ofono_shared_call_stats {
+  unsigned long calls; /* read-only D-Bus calls issued */
+  unsigned long saved; /* requests answered by another request's call */
+};
+
+/**
+ * Get how many D-Bus round trips the async getters saved
+ *
+ * Identical getters (same modem, interface, arguments and deadline) in
+ * flight at the same time share one D-Bus call, e.g. ofono_sms_get_sca() and
+ * ofono_sms_get_delivery_report() both read the message manager
+ * properties.
+ */
+tapi_bool ofono_get_shared_call_stats(struct ofono_shared_call_stats *stats);
+
+/**
+ * Set the deadline of the async requests
+ *
+ * The requests not answered within 'timeout_ms' complete with
+ * TAPI_RESULT_TIMEOUT. 0 or less restores the D-Bus default (25 seconds).
+ * Network scans and registrations keep their own longer deadlines.
+ */
+void ofono_set_request_timeout(int timeout_ms);
+
+/**
+ * Same as ofono_set_request_timeout() for the requests sent to 'modem',
+ * 0 or less falls back to the global deadline
+ */
+void ofono_modem_set_request_timeout(struct ofono_modem *modem,
+                int timeout_ms);
+
 #ifdef  __cplusplus
 }
 #endif
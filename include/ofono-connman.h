@@ -90,7 +90,7 @@ struct ps_reg_status {
  *
  * Async response data: (char *) the new added pdp context object path
  */
-void ofono_connman_add_context(struct ofono_modem *modem,
+ofono_request ofono_connman_add_context(struct ofono_modem *modem,
       enum context_type type,
       response_cb cb,
       void *user_data);
@@ -102,7 +102,7 @@ void ofono_connman_add_context(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_connman_remove_context(struct ofono_modem *modem,
+ofono_request ofono_connman_remove_context(struct ofono_modem *modem,
       const char *path,
       response_cb cb,
       void *user_data);
@@ -112,9 +112,14 @@ void ofono_connman_remove_context(struct ofono_modem *modem,
  *
  * "context": Context settings, include APN, user name, password, poxy, mmsc etc
  *
- * Async response data: NULL
+ * The properties are set in parallel, NULL ones are left untouched and the
+ * ones whose value is already the requested one (as known from
+ * ofono_connman_get_contexts) aren't sent again.
+ *
+ * Async response data: NULL on success, otherwise the name of the first
+ *    property which failed (const char *), e.g. "AccessPointName"
  */
-void ofono_connman_set_context(struct ofono_modem *modem,
+ofono_request ofono_connman_set_context(struct ofono_modem *modem,
       char *path,
       struct pdp_context *context,
       response_cb cb,
@@ -130,6 +135,17 @@ void ofono_connman_set_context(struct ofono_modem *modem,
 tapi_bool ofono_connman_get_context_info(struct ofono_modem *modem,
       char *path, struct pdp_context_info *info);
 
+/**
+ * Get context information
+ *
+ * "path": pdp context object path (returned by ofono_add_context)
+ *
+ * Async response data: struct pdp_context_info * (released after the
+ *   callback)
+ */
+ofono_request ofono_connman_get_context_info_async(struct ofono_modem *modem,
+      char *path, response_cb cb, void *user_data);
+
 /**
  * Get all pdp contexts
  *
@@ -140,6 +156,15 @@ tapi_bool ofono_connman_get_context_info(struct ofono_modem *modem,
 tapi_bool ofono_connman_get_contexts(struct ofono_modem *modem,
       struct str_list **contexts);
 
+/**
+ * Get all pdp contexts
+ *
+ * Async response data: struct str_list *, a list of pdp context object
+ *   paths (released after the callback)
+ */
+ofono_request ofono_connman_get_contexts_async(struct ofono_modem *modem,
+      response_cb cb, void *user_data);
+
 /**
  * Active pdp context
  *
@@ -147,7 +172,7 @@ tapi_bool ofono_connman_get_contexts(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_connman_activate_context(struct ofono_modem *modem,
+ofono_request ofono_connman_activate_context(struct ofono_modem *modem,
       char *path,
       response_cb cb,
       void *user_data);
@@ -159,7 +184,7 @@ void ofono_connman_activate_context(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_connman_deactivate_context(struct ofono_modem *modem,
+ofono_request ofono_connman_deactivate_context(struct ofono_modem *modem,
       char *path,
       response_cb cb,
       void *user_data);
@@ -169,7 +194,7 @@ void ofono_connman_deactivate_context(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_connman_deactivate_all_contexts(struct ofono_modem *modem,
+ofono_request ofono_connman_deactivate_all_contexts(struct ofono_modem *modem,
       response_cb cb,
       void *user_data);
 
@@ -188,7 +213,7 @@ tapi_bool ofono_connman_get_powered(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_connman_set_powered(struct ofono_modem *modem,
+ofono_request ofono_connman_set_powered(struct ofono_modem *modem,
       tapi_bool powered,
       response_cb cb,
       void *user_data);
@@ -208,7 +233,7 @@ tapi_bool ofono_connman_get_roaming_allowed(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_connman_set_roaming_allowed(struct ofono_modem *modem,
+ofono_request ofono_connman_set_roaming_allowed(struct ofono_modem *modem,
       tapi_bool allowed,
       response_cb cb,
       void *user_data);
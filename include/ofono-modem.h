@@ -47,6 +47,11 @@ struct modem_info {
   enum modem_type type;
 };
 
+struct ofono_cache_stats {
+  unsigned long hits; /* getters answered from the property cache */
+  unsigned long misses; /* getters which had to call GetProperties */
+};
+
 /**
  * get if modem is online
  *
@@ -59,7 +64,7 @@ tapi_bool ofono_modem_get_online(struct ofono_modem *modem);
  *
  * Async response data: NULL
  */
-void ofono_modem_set_online(struct ofono_modem *modem,
+ofono_request ofono_modem_set_online(struct ofono_modem *modem,
       tapi_bool online,
       response_cb cb,
       void *user_data);
@@ -76,7 +81,7 @@ tapi_bool ofono_modem_get_powered(struct ofono_modem *modem);
  *
  * Async response data: NULL
  */
-void ofono_modem_set_powered(struct ofono_modem *modem,
+ofono_request ofono_modem_set_powered(struct ofono_modem *modem,
       tapi_bool online,
       response_cb cb,
       void *user_data);
@@ -88,6 +93,28 @@ void ofono_modem_set_powered(struct ofono_modem *modem,
  */
 tapi_bool ofono_modem_get_info(struct ofono_modem *modem, struct modem_info* info);
 
+/**
+ * get modem information: manufacturer, model, revision, serial number
+ *
+ * Async response data: struct modem_info *
+ */
+ofono_request ofono_modem_get_info_async(struct ofono_modem *modem,
+      response_cb cb,
+      void *user_data);
+
+/**
+ * get hit/miss counters of the modem property cache
+ *
+ * Property getters (SIM, network registration, connection manager, call
+ * volume and modem info) are served from a per modem cache which is filled
+ * by the first GetProperties call and kept up to date by PropertyChanged
+ * signals.
+ *
+ * Sync API
+ */
+tapi_bool ofono_modem_get_cache_stats(struct ofono_modem *modem,
+      struct ofono_cache_stats *stats);
+
 #ifdef  __cplusplus
 }
 #endif
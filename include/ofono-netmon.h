@@ -49,13 +49,85 @@ struct cells_info {
   struct cell_info *cells; /* information of cells */
 };
 
+#define NETMON_MAX_NEIGHBOURS 32
+
+/* serving cell of one sample, see ofono_netmon_sampler_new() */
+struct netmon_sample {
+  long long time; /* ms, monotonic clock */
+  unsigned int cid;
+  unsigned short lac;
+  unsigned short channel; /* arfcn for 2G, psc for 3G */
+  unsigned char type; /* enum cell_type */
+  unsigned char rssi;
+  unsigned char ber;
+  unsigned char ta;
+  unsigned char neighbours; /* neighbour cells seen */
+  unsigned char added; /* neighbours which weren't in the previous sample */
+  unsigned char removed; /* neighbours of the previous sample now gone */
+};
+
+struct netmon_aggregate {
+  unsigned char min; /* over the samples in the ring */
+  unsigned char max;
+  double ewma; /* over every sample, weight 1/8 */
+};
+
+struct ofono_netmon_sampler_stats {
+  unsigned long samples;
+  unsigned long failures; /* failed or skipped polls */
+  unsigned int stored; /* samples in the ring */
+  struct netmon_aggregate rssi;
+  struct netmon_aggregate ber;
+  struct netmon_aggregate ta;
+};
+
+/* neighbour cell ids which changed between the last two samples */
+struct netmon_neighbour_diff {
+  unsigned int n_added;
+  unsigned int added[NETMON_MAX_NEIGHBOURS];
+  unsigned int n_removed;
+  unsigned int removed[NETMON_MAX_NEIGHBOURS];
+};
+
+struct ofono_netmon_sampler;
+
+/*
+ * PLMN packed in an integer: MCC in the bits 16 and up, MNC length (2 or
+ * 3 digits) in the bits 12 - 13, MNC in the bits 0 - 9. 0 if unknown.
+ */
+#define NETMON_PLMN(mcc, mnc, mnc_len) \
+  (((unsigned int) (mcc) << 16) | ((unsigned int) (mnc_len) << 12) | (mnc))
+#define NETMON_PLMN_MCC(plmn) ((plmn) >> 16)
+#define NETMON_PLMN_MNC(plmn) ((plmn) & 0x3ff)
+#define NETMON_PLMN_MNC_LEN(plmn) (((plmn) >> 12) & 0x3)
+
+#define NETMON_RSSI_MAX 31 /* higher values mean unknown */
+
+/*
+ * Cells stored column by column for bulk analysis, see
+ * ofono_netmon_columns_new(). Entry "i" of every array is the same cell.
+ */
+struct netmon_columns {
+  unsigned int count;
+  unsigned int capacity;
+  unsigned int *cid;
+  unsigned int *plmn; /* NETMON_PLMN() */
+  unsigned short *lac;
+  unsigned short *channel; /* arfcn for 2G, psc for 3G */
+  unsigned char *rssi;
+  unsigned char *ber;
+  unsigned char *ta;
+  unsigned char *type; /* enum cell_type */
+  unsigned char *registered;
+};
+
 
 /**
  * get the information of current serving cell
  *
  * Async response data: struct cell_info*, (information of serving cell)
  */
-tapi_bool ofono_netmon_get_serving_cell_info(struct ofono_modem *modem,
+ofono_request ofono_netmon_get_serving_cell_info(struct ofono_modem *modem,
       response_cb cb,
       void *user_data);
 
@@ -65,10 +137,88 @@ tapi_bool ofono_netmon_get_serving_cell_info(struct ofono_modem *modem,
  *
  * Async response data: struct cells_info* (information of cells)
  */
-tapi_bool ofono_netmon_get_cells_info(struct ofono_modem *modem,
+ofono_request ofono_netmon_get_cells_info(struct ofono_modem *modem,
       response_cb cb,
       void *user_data);
 
+/**
+ * Poll the cells of "modem" every "interval" ms, give or take a tenth of
+ * it so that the modems don't poll in step, until freed. The samples are
+ * kept in a ring of "capacity" entries, the oldest are overwritten.
+ *
+ * "neighbours": TRUE to poll GetCellsInformation and follow the
+ * neighbour cells, FALSE for GetServingCellInformation only
+ *
+ * The sampler must be freed before the modem is deinitialized.
+ */
+struct ofono_netmon_sampler *ofono_netmon_sampler_new(
+      struct ofono_modem *modem,
+      unsigned int interval,
+      unsigned int capacity,
+      tapi_bool neighbours);
+
+void ofono_netmon_sampler_free(struct ofono_netmon_sampler *sampler);
+
+/**
+ * Copy up to "max" of the latest samples to "samples", oldest first
+ *
+ * Return the number of samples copied
+ */
+unsigned int ofono_netmon_sampler_read(struct ofono_netmon_sampler *sampler,
+      struct netmon_sample *samples,
+      unsigned int max);
+
+/**
+ * Get the rolling aggregates, "stats" is filled on success.
+ */
+tapi_bool ofono_netmon_sampler_get_stats(struct ofono_netmon_sampler *sampler,
+      struct ofono_netmon_sampler_stats *stats);
+
+/**
+ * Get the neighbour cells which appeared and disappeared in the last
+ * sample, "diff" is filled on success.
+ */
+tapi_bool ofono_netmon_sampler_get_neighbour_diff(
+      struct ofono_netmon_sampler *sampler,
+      struct netmon_neighbour_diff *diff);
+
+/**
+ * Create an empty column set with room for "capacity" cells, it grows
+ * as needed.
+ */
+struct netmon_columns *ofono_netmon_columns_new(unsigned int capacity);
+
+void ofono_netmon_columns_free(struct netmon_columns *columns);
+
+/* Drop the cells, keeping the memory */
+void ofono_netmon_columns_clear(struct netmon_columns *columns);
+
+/**
+ * Append the cells of an ofono_netmon_get_cells_info() response
+ * (or of one ofono_netmon_get_serving_cell_info() response, "count" 1)
+ */
+tapi_bool ofono_netmon_columns_append(struct netmon_columns *columns,
+      const struct cell_info *cells,
+      unsigned int count);
+
+/**
+ * Index of the cell with the strongest known signal, -1 if none
+ */
+int ofono_netmon_columns_best_cell(const struct netmon_columns *columns);
+
+/**
+ * Count the cells per RSSI value, "histogram" has NETMON_RSSI_MAX + 1
+ * entries. Return the number of cells whose signal is unknown.
+ */
+unsigned int ofono_netmon_columns_rssi_histogram(
+      const struct netmon_columns *columns,
+      unsigned int *histogram);
+
+/**
+ * Number of distinct cells, by PLMN, LAC and cell id
+ */
+unsigned int ofono_netmon_columns_unique_cells(
+      const struct netmon_columns *columns);
 
 #ifdef  __cplusplus
 }
@@ -109,6 +109,15 @@ struct registration_info {
  tapi_bool ofono_network_get_operator_name(struct ofono_modem *modem,
        char **name);
 
+/**
+ * Get current registered operator name
+ *
+ * Async response data: (const char *) operator name, NULL if unknown
+ */
+ofono_request ofono_network_get_operator_name_async(struct ofono_modem *modem,
+      response_cb cb,
+      void *user_data);
+
 /**
  * get sigal strength [0 - 100]
  *
@@ -125,12 +134,21 @@ tapi_bool ofono_network_get_signal_strength(struct ofono_modem *modem,
 tapi_bool ofono_network_get_network_selection_mode(struct ofono_modem *modem,
        enum network_selection_mode *mode);
 
+/**
+ * get network selection mode
+ *
+ * Async response data: enum network_selection_mode *
+ */
+ofono_request ofono_network_get_network_selection_mode_async(struct ofono_modem *modem,
+      response_cb cb,
+      void *user_data);
+
 /**
  * get network mode
  *
  * Async response data: network mode (enum network_mode)
  */
-void ofono_network_get_mode(struct ofono_modem *modem,
+ofono_request ofono_network_get_mode(struct ofono_modem *modem,
       response_cb cb,
       void *user_data);
 
@@ -141,7 +159,7 @@ void ofono_network_get_mode(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_network_set_mode(struct ofono_modem *modem,
+ofono_request ofono_network_set_mode(struct ofono_modem *modem,
       enum network_mode mode,
       response_cb cb,
       void *user_data);
@@ -154,7 +172,7 @@ void ofono_network_set_mode(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_network_register(struct ofono_modem *modem,
+ofono_request ofono_network_register(struct ofono_modem *modem,
       const char *plmn,
       response_cb cb,
       void *user_data);
@@ -164,19 +182,83 @@ void ofono_network_register(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_network_auto_register(struct ofono_modem *modem,
+ofono_request ofono_network_auto_register(struct ofono_modem *modem,
       response_cb cb,
       void *user_data);
 
 /**
  * scan operators
  *
+ * The concurrent callers share one scan, and its result is returned to the
+ * ones coming within the cache TTL (see ofono_network_set_scan_cache()).
+ *
  * Async response data: struct operators_info*, operators information)
  */
-void ofono_network_scan_operators(struct ofono_modem *modem,
+ofono_request ofono_network_scan_operators(struct ofono_modem *modem,
       response_cb cb,
       void *user_data);
 
+/**
+ * set how long the result of a scan is kept, 60 seconds by default
+ *
+ * "ttl": in seconds, 0 to scan every time (the concurrent callers still
+ * share one scan)
+ */
+void ofono_network_set_scan_cache(struct ofono_modem *modem,
+      unsigned int ttl);
+
+/**
+ * look up an operator of the cached scan result, the status is the one
+ * at scan time
+ *
+ * "plmn": the numeric name (MCCMNC) of the operator
+ *
+ * sync API (should free info->name and info->path), FALSE if the operator
+ * isn't in the cache
+ */
+tapi_bool ofono_network_get_cached_operator(struct ofono_modem *modem,
+      const char *plmn,
+      struct operator_info *info);
+
+/*
+ * Filter of the OFONO_NOTI_SIGNAL_STRENTH_CHANGED callback it is set for.
+ * A strength of 0 (signal lost) is passed on at once.
+ */
+struct ofono_signal_filter {
+  unsigned int min_interval; /* ms between two calls, 0 for none */
+  unsigned int min_delta; /* change from the last value passed on */
+  unsigned int smoothing; /* EWMA weight of a new value in percent, 0 for
+        none */
+};
+
+struct ofono_signal_filter_stats {
+  unsigned long delivered; /* callback calls */
+  unsigned long suppressed; /* changes not passed on at once */
+};
+
+/**
+ * Filter the signal strength changes passed to "cb", a callback registered
+ * for OFONO_NOTI_SIGNAL_STRENTH_CHANGED. The changes smaller than
+ * "min_delta" are dropped, the ones coming within "min_interval" of the
+ * previous call are held back and the last of them is passed on once it
+ * is over.
+ *
+ * "filter": NULL to pass every change on again
+ *
+ * sync API, FALSE if "cb" isn't registered
+ */
+tapi_bool ofono_network_set_signal_filter(struct ofono_modem *modem,
+      noti_cb cb,
+      const struct ofono_signal_filter *filter);
+
+/**
+ * get the signal strength notification counters of "modem"
+ *
+ * sync API
+ */
+tapi_bool ofono_network_get_signal_filter_stats(struct ofono_modem *modem,
+      struct ofono_signal_filter_stats *stats);
+
 #ifdef  __cplusplus
 }
 #endif
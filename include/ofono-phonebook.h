@@ -29,7 +29,7 @@ extern "C" {
  * Async response data: (char *) SIM and ME phonebook in VCard 3.0
  *   format (utf-8)
  */
-void ofono_phonebook_import(struct ofono_modem *modem,
+ofono_request ofono_phonebook_import(struct ofono_modem *modem,
       response_cb cb,
       void *user_data);
 
@@ -181,6 +181,14 @@ void ofono_sat_deinit_agent(struct ofono_sat_agent *agent);
 tapi_bool ofono_sat_get_main_menu(struct ofono_modem *modem,
       struct sat_main_menu *menu);
 
+/**
+ * Get sat main menu
+ *
+ * Async response data: struct sat_main_menu * (released after the callback)
+ */
+ofono_request ofono_sat_get_main_menu_async(struct ofono_modem *modem,
+      response_cb cb, void *user_data);
+
 /**
  * Selects an main menu item
  *
@@ -188,7 +196,7 @@ tapi_bool ofono_sat_get_main_menu(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_sat_select_item(struct ofono_modem *modem,
+ofono_request ofono_sat_select_item(struct ofono_modem *modem,
       unsigned char index,
       response_cb cb,
       void *user_data);
@@ -111,7 +111,7 @@ struct sim_io_resp {
  *
  * Async response data: NULL
  */
-void ofono_sim_enable_pin(struct ofono_modem *modem,
+ofono_request ofono_sim_enable_pin(struct ofono_modem *modem,
       enum pin_lock_type type,
       char *pin,
       response_cb cb,
@@ -125,7 +125,7 @@ void ofono_sim_enable_pin(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_sim_disable_pin(struct ofono_modem *modem,
+ofono_request ofono_sim_disable_pin(struct ofono_modem *modem,
       enum pin_lock_type type,
       char *pin,
       response_cb cb,
@@ -139,7 +139,7 @@ void ofono_sim_disable_pin(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_sim_enter_pin(struct ofono_modem *modem,
+ofono_request ofono_sim_enter_pin(struct ofono_modem *modem,
       enum pin_lock_type type,
       char *pin,
       response_cb cb,
@@ -154,7 +154,7 @@ void ofono_sim_enter_pin(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_sim_reset_pin(struct ofono_modem *modem,
+ofono_request ofono_sim_reset_pin(struct ofono_modem *modem,
       enum pin_lock_type type,
       char *puk,
       char *new_pin,
@@ -170,7 +170,7 @@ void ofono_sim_reset_pin(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_sim_change_pin(struct ofono_modem *modem,
+ofono_request ofono_sim_change_pin(struct ofono_modem *modem,
       enum pin_lock_type type,
       char *old_pin,
       char *new_pin,
@@ -194,7 +194,7 @@ tapi_bool ofono_sim_get_info(struct ofono_modem *modem, struct sim_info *info);
  * Note: oFono implements SIM IO internally, it doesn't export SIM IO API.
  *       This API isn't formally supported by oFono, it's user extending.
  */
-void ofono_sim_io(struct ofono_modem *modem,
+ofono_request ofono_sim_io(struct ofono_modem *modem,
       struct sim_io_req *req,
       response_cb cb,
       void *user_data);
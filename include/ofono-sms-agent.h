@@ -18,6 +18,7 @@
 #ifndef _OFONO_SMS_AGENT__H
 #define _OFONO_SMS_AGENT__H
 
+#include <time.h>
 #include "ofono-common.h"
 
 #ifdef  __cplusplus
@@ -26,13 +27,20 @@ extern "C" {
 
 struct ofono_push_noti_agent;
 
+/* only valid during the push_notify_cb_t call */
 struct ofono_push_noti_info {
-  char *content; /* push notification content */
+  char *content; /* push notification content, not NUL terminated */
   int length; /* push notification content length */
 
   char *local_senttime; /* local time (device system time) */
   char *senttime; /* sevice center time stamp */
   char *sender;
+
+  /* the time stamps above, parsed: UTC and seconds east of UTC */
+  time_t local_sent_time;
+  int local_sent_offset;
+  time_t sent_time;
+  int sent_offset;
 };
 
 typedef void (*push_notify_cb_t)(struct ofono_push_noti_info *info, void *user_data);
@@ -49,12 +49,81 @@ struct ofono_sms_incoming_noti {
   time_t timestamp;
   char *sender;
   char *message;
+  int timestamp_offset; /* seconds east of UTC the timestamp was given in */
+};
+
+/* messages in arrival order, valid during the callback */
+struct ofono_sms_incoming_batch {
+  unsigned int count;
+  struct ofono_sms_incoming_noti *messages;
 };
 
 struct ofono_sms_status_report_noti {
   char *message;
   char *uuid;
   time_t timestamp;
+  int timestamp_offset; /* seconds east of UTC the timestamp was given in */
+};
+
+enum ofono_sms_queue_state {
+  OFONO_SMS_QUEUE_SUBMITTED = 0, /* accepted by oFono, "uuid" is known */
+  OFONO_SMS_QUEUE_SENT,
+  OFONO_SMS_QUEUE_DELIVERED,
+  OFONO_SMS_QUEUE_FAILED
+};
+
+/* valid during the callback */
+struct ofono_sms_queue_report {
+  const char *recipient;
+  unsigned int index; /* in the recipients given to ofono_sms_queue_send() */
+  enum ofono_sms_queue_state state;
+  TResult result; /* why it failed, TAPI_RESULT_OK otherwise */
+  const char *uuid; /* NULL until submitted */
+  unsigned int attempts; /* SendMessage calls made */
+};
+
+typedef void (*sms_queue_cb)(const struct ofono_sms_queue_report *report,
+      void *user_data);
+
+struct ofono_sms_queue_stats {
+  unsigned int queued; /* waiting for a free slot of the window */
+  unsigned int in_flight; /* SendMessage calls, including retry delays */
+  unsigned int submitted;
+  unsigned int sent;
+  unsigned int delivered;
+  unsigned int failed;
+  unsigned int retries;
+  double rate; /* sent messages/s over the last ten seconds */
+};
+
+struct ofono_sms_queue;
+
+/* per modem latency histograms of the tracked messages */
+enum ofono_sms_latency {
+  OFONO_SMS_LATENCY_ACCEPTED = 0, /* submission to SendMessage reply */
+  OFONO_SMS_LATENCY_SENT, /* SendMessage reply to sent */
+  OFONO_SMS_LATENCY_DELIVERED, /* sent to delivery report */
+  OFONO_SMS_LATENCY_TOTAL, /* submission to delivery report */
+  OFONO_SMS_LATENCY_MAX
+};
+
+struct ofono_sms_latency_stats {
+  unsigned int count;
+  /* ms, the percentiles are within a quarter of the exact value */
+  unsigned int p50;
+  unsigned int p90;
+  unsigned int p99;
+  unsigned int max;
+};
+
+struct ofono_sms_track_info {
+  void *context; /* see ofono_sms_tracker_set_context() */
+  enum ofono_sms_sent_state state;
+  tapi_bool delivered;
+  /* ms since the submission, -1 until reached */
+  int accepted_ms;
+  int sent_ms;
+  int delivered_ms;
 };
 
 struct ofono_sms_cbs_config {
@@ -79,7 +148,7 @@ struct ofono_cbs_emergency_noti {
  *
  * Async response data: SMS service center address(char *)
  */
-void ofono_sms_get_sca(struct ofono_modem *modem,
+ofono_request ofono_sms_get_sca(struct ofono_modem *modem,
       response_cb cb,
       void *user_data);
 
@@ -90,7 +159,7 @@ void ofono_sms_get_sca(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_sms_set_sca(struct ofono_modem *modem,
+ofono_request ofono_sms_set_sca(struct ofono_modem *modem,
       const char *sca,
       response_cb cb,
       void *user_data);
@@ -101,7 +170,7 @@ void ofono_sms_set_sca(struct ofono_modem *modem,
  * Async response data: delivery report setting(tapi_bool*)
  *   TURE - enabled, FALSE - disabled
  */
-void ofono_sms_get_delivery_report(struct ofono_modem *modem,
+ofono_request ofono_sms_get_delivery_report(struct ofono_modem *modem,
       response_cb cb,
       void *user_data);
 
@@ -110,7 +179,7 @@ void ofono_sms_get_delivery_report(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_sms_set_delivery_report(struct ofono_modem *modem,
+ofono_request ofono_sms_set_delivery_report(struct ofono_modem *modem,
       tapi_bool on,
       response_cb cb,
       void *user_data);
@@ -123,7 +192,7 @@ void ofono_sms_set_delivery_report(struct ofono_modem *modem,
  *
  * Async response data: sms object path (char *)
  */
-void ofono_sms_send_sms(struct ofono_modem *modem,
+ofono_request ofono_sms_send_sms(struct ofono_modem *modem,
       const char *number,
       const char *message,
       response_cb cb,
@@ -137,7 +206,7 @@ void ofono_sms_send_sms(struct ofono_modem *modem,
  *
  * Async response data: sms object (char *)
  */
-void ofono_sms_send_vcard(struct ofono_modem *modem,
+ofono_request ofono_sms_send_vcard(struct ofono_modem *modem,
       const char *number,
       const unsigned char *message,
       response_cb cb,
@@ -151,7 +220,7 @@ void ofono_sms_send_vcard(struct ofono_modem *modem,
  *
  * Async response data: sms object (char *)
  */
-void ofono_sms_send_vcalendar(struct ofono_modem *modem,
+ofono_request ofono_sms_send_vcalendar(struct ofono_modem *modem,
       const char *number,
       const unsigned char *message,
       response_cb cb,
@@ -162,7 +231,7 @@ void ofono_sms_send_vcalendar(struct ofono_modem *modem,
  *
  * Async response data: cbs config (struct ofono_sms_cbs_config*)
  */
-void ofono_sms_get_cbs_config(struct ofono_modem *modem,
+ofono_request ofono_sms_get_cbs_config(struct ofono_modem *modem,
       response_cb cb,
       void *user_data);
 
@@ -173,7 +242,7 @@ void ofono_sms_get_cbs_config(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_sms_set_cbs_powered(struct ofono_modem *modem,
+ofono_request ofono_sms_set_cbs_powered(struct ofono_modem *modem,
       tapi_bool powered,
       response_cb cb,
       void *user_data);
@@ -185,11 +254,135 @@ void ofono_sms_set_cbs_powered(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_sms_set_cbs_topics(struct ofono_modem *modem,
+ofono_request ofono_sms_set_cbs_topics(struct ofono_modem *modem,
       const char *topics,
       response_cb cb,
       void *user_data);
 
+/**
+ * Configure OFONO_NOTI_INCOMING_SMS_BATCH: the incoming messages are
+ * gathered until "max_count" of them are waiting or "window" ms have
+ * passed since the first one. OFONO_NOTI_INCOMING_SMS is still sent for
+ * every message.
+ *
+ * "window": ms, 0 for the default (200)
+ * "max_count": 0 for the default (32)
+ *
+ * Sync API
+ */
+tapi_bool ofono_sms_set_incoming_batch(struct ofono_modem *modem,
+      unsigned int window,
+      unsigned int max_count);
+
+/**
+ * Create the outbound SMS queue of "modem", at most one per modem.
+ *
+ * "window": number of SendMessage calls in flight, 0 for the default (4)
+ *
+ * The queue must be freed before the modem is deinitialized.
+ * Return NULL if the modem has a queue already.
+ */
+struct ofono_sms_queue *ofono_sms_queue_new(struct ofono_modem *modem,
+      unsigned int window);
+
+/**
+ * Free the queue. The recipients waiting for a slot complete with
+ * TAPI_RESULT_CANCELLED before it returns, the ones in flight do so
+ * afterwards. Messages already submitted are still sent by oFono but
+ * no longer reported.
+ */
+void ofono_sms_queue_free(struct ofono_sms_queue *queue);
+
+/**
+ * Retry the SendMessage calls failing with TAPI_RESULT_IN_PROGRESS or
+ * TAPI_RESULT_TIMEOUT up to "max_retries" times, waiting "delay" ms
+ * before the first retry and doubling it for each of the next ones.
+ * Default: 3 retries, 500 ms.
+ */
+void ofono_sms_queue_set_retry(struct ofono_sms_queue *queue,
+      unsigned int max_retries,
+      unsigned int delay);
+
+/**
+ * Wait for the delivery reports: TRUE reports OFONO_SMS_QUEUE_DELIVERED
+ * after OFONO_SMS_QUEUE_SENT, which should only be set when the modem
+ * requests delivery reports (see ofono_sms_set_delivery_report()).
+ * Default: FALSE, sent is the last state.
+ */
+void ofono_sms_queue_set_wait_delivery(struct ofono_sms_queue *queue,
+      tapi_bool wait);
+
+/**
+ * Queue "message" for each of the "count" "recipients"
+ *
+ * "cb" is called for every recipient on each state change, until it
+ * fails, is sent or, when waiting for delivery, is delivered.
+ *
+ * Return FALSE if nothing was queued.
+ */
+tapi_bool ofono_sms_queue_send(struct ofono_sms_queue *queue,
+      const char *message,
+      const char **recipients,
+      unsigned int count,
+      sms_queue_cb cb,
+      void *user_data);
+
+/**
+ * Get the queue counters, "stats" is filled on success.
+ */
+tapi_bool ofono_sms_queue_get_stats(struct ofono_sms_queue *queue,
+      struct ofono_sms_queue_stats *stats);
+
+/**
+ * Track the outgoing messages of "modem" by UUID: the ones sent by
+ * ofono_sms_send_sms(), ofono_sms_send_vcard(), ofono_sms_send_vcalendar()
+ * and the SMS queue from now on. Their state is updated before the
+ * OFONO_NOTI_MSG_STATUS_CHANGED and OFONO_NOTI_SMS_DELIVERY_REPORT
+ * callbacks are called.
+ *
+ * "max_entries": messages kept, the oldest are dropped first, 0 for 1024
+ * "expiry": seconds a message is kept after its submission, 0 for 3600
+ *
+ * Calling it again changes the limits and keeps the tracked messages.
+ */
+tapi_bool ofono_sms_tracker_enable(struct ofono_modem *modem,
+      unsigned int max_entries,
+      unsigned int expiry);
+
+/**
+ * Stop tracking, the contexts and histograms are released.
+ */
+void ofono_sms_tracker_disable(struct ofono_modem *modem);
+
+/**
+ * Associate "context" with the tracked message "uuid", e.g. from the
+ * ofono_sms_send_sms() response callback. "context_free" is called when
+ * the message is dropped or another context is set.
+ *
+ * Return FALSE if the message isn't tracked.
+ */
+tapi_bool ofono_sms_tracker_set_context(struct ofono_modem *modem,
+      const char *uuid,
+      void *context,
+      destroy_notify context_free);
+
+/**
+ * Get the context and the timestamps of the tracked message "uuid",
+ * "info" is filled on success.
+ */
+tapi_bool ofono_sms_tracker_lookup(struct ofono_modem *modem,
+      const char *uuid,
+      struct ofono_sms_track_info *info);
+
+/**
+ * Get a latency histogram summary of the tracked messages
+ *
+ * Return FALSE if the tracker isn't enabled.
+ */
+tapi_bool ofono_sms_tracker_get_latency(struct ofono_modem *modem,
+      enum ofono_sms_latency which,
+      struct ofono_sms_latency_stats *stats);
+
 #ifdef  __cplusplus
 }
 #endif
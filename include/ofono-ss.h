@@ -144,7 +144,7 @@ struct ussd_request_noti {
  *
  * Async response data: FALSE - call waiting is off, TRUE - it is on
  */
-void ofono_ss_get_call_waiting(struct ofono_modem *modem,
+ofono_request ofono_ss_get_call_waiting(struct ofono_modem *modem,
       response_cb cb,
       void *user_data);
 
@@ -155,7 +155,7 @@ void ofono_ss_get_call_waiting(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_ss_set_call_waiting(struct ofono_modem *modem,
+ofono_request ofono_ss_set_call_waiting(struct ofono_modem *modem,
       tapi_bool enable,
       response_cb cb,
       void *user_data);
@@ -165,7 +165,7 @@ void ofono_ss_set_call_waiting(struct ofono_modem *modem,
  *
  * Async response data: struct call_forward_setting
  */
-void ofono_ss_get_call_forward(struct ofono_modem *modem,
+ofono_request ofono_ss_get_call_forward(struct ofono_modem *modem,
       response_cb cb,
       void *user_data);
 
@@ -174,7 +174,7 @@ void ofono_ss_get_call_forward(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_ss_set_call_forward(struct ofono_modem *modem,
+ofono_request ofono_ss_set_call_forward(struct ofono_modem *modem,
       struct call_forward_setting *setting,
       response_cb cb,
       void *user_data);
@@ -184,7 +184,7 @@ void ofono_ss_set_call_forward(struct ofono_modem *modem,
  *
  * Async response data: struct call_barring_setting
  */
-void ofono_ss_get_call_barring(struct ofono_modem *modem,
+ofono_request ofono_ss_get_call_barring(struct ofono_modem *modem,
       response_cb cb,
       void *user_data);
 
@@ -193,14 +193,14 @@ void ofono_ss_get_call_barring(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_ss_set_call_barring(struct ofono_modem *modem,
+ofono_request ofono_ss_set_call_barring(struct ofono_modem *modem,
       tapi_bool enable,
       enum call_barring_type type,
       const char *pwd,
       response_cb cb,
       void *user_data);
 
-void ofono_ss_change_barring_password(struct ofono_modem *modem,
+ofono_request ofono_ss_change_barring_password(struct ofono_modem *modem,
       const char *old_pwd,
       const char *new_pwd,
       response_cb cb,
@@ -211,7 +211,7 @@ void ofono_ss_change_barring_password(struct ofono_modem *modem,
  *
  * Async response data: enum cli_status[5]
  */
-void ofono_ss_get_cli_status(struct ofono_modem *modem,
+ofono_request ofono_ss_get_cli_status(struct ofono_modem *modem,
       response_cb cb,
       void *user_data);
 
@@ -220,7 +220,7 @@ void ofono_ss_get_cli_status(struct ofono_modem *modem,
  *
  * Async response data: enum clir_network_status
  */
-void ofono_ss_get_clir(struct ofono_modem *modem,
+ofono_request ofono_ss_get_clir(struct ofono_modem *modem,
       response_cb cb,
       void *user_data);
 
@@ -229,7 +229,7 @@ void ofono_ss_get_clir(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_ss_set_clir(struct ofono_modem *modem,
+ofono_request ofono_ss_set_clir(struct ofono_modem *modem,
       enum clir_dev_status status,
       response_cb cb,
       void *user_data);
@@ -245,7 +245,7 @@ void ofono_ss_set_clir(struct ofono_modem *modem,
  *
  * Async response data: request response (char *)
  */
-void ofono_ss_initiate_ussd_request(struct ofono_modem *modem,
+ofono_request ofono_ss_initiate_ussd_request(struct ofono_modem *modem,
       char *str,
       response_cb cb,
       void *user_data);
@@ -257,7 +257,7 @@ void ofono_ss_initiate_ussd_request(struct ofono_modem *modem,
  *
  * Async response data: network response string (char*)
  */
-void ofono_ss_send_ussd_response(struct ofono_modem *modem,
+ofono_request ofono_ss_send_ussd_response(struct ofono_modem *modem,
       char *str,
       response_cb cb,
       void *user_data);
@@ -267,7 +267,7 @@ void ofono_ss_send_ussd_response(struct ofono_modem *modem,
  *
  * Async response data: NULL
  */
-void ofono_ss_cancel_ussd_session(struct ofono_modem *modem,
+ofono_request ofono_ss_cancel_ussd_session(struct ofono_modem *modem,
       response_cb cb,
       void *user_data);
 
@@ -0,0 +1,457 @@
+/*
+ * Copyright (C) 2013 Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include <string.h>
+
+#include "common.h"
+#include "log.h"
+#include "ofono-modem.h"
+
+static const struct {
+  const char *name;
+  int api; /* enum ofono_api, -1 if the interface always exists */
+} cache_ifaces[PROP_CACHE_MAX] = {
+  [PROP_CACHE_MODEM] = {OFONO_MODEM_IFACE, -1},
+  [PROP_CACHE_SIM] = {OFONO_SIM_MANAGER_IFACE, OFONO_API_SIM},
+  [PROP_CACHE_NETREG] = {OFONO_NETWORK_REGISTRATION_IFACE, OFONO_API_NETREG},
+  [PROP_CACHE_CONNMAN] = {OFONO_CONNMAN_IFACE, OFONO_API_CONNMAN},
+  [PROP_CACHE_CALL_VOL] = {OFONO_CALL_VOLUME_IFACE, OFONO_API_CALL_VOL},
+};
+
+static void _prop_cache_changed(GDBusConnection *conn,
+     const gchar *sender_name,
+     const gchar *object_path, const gchar *iface,
+     const gchar *signal_name, GVariant *parameters,
+     gpointer user_data)
+{
+  struct prop_cache *cache = user_data;
+  const gchar *key;
+  GVariant *value;
+
+  g_variant_get(parameters, "(&sv)", &key, &value);
+  prop_cache_update(cache->modem, cache->iface, key, value);
+  g_variant_unref(value);
+}
+
+static gpointer _prop_cache_ref(gpointer data)
+{
+  struct prop_cache *cache = data;
+
+  modem_ref(cache->modem);
+  return cache;
+}
+
+static void _prop_cache_unref(gpointer data)
+{
+  struct prop_cache *cache = data;
+
+  modem_unref(cache->modem);
+}
+
+/* must be called with the cache lock held */
+static void _prop_cache_watch(struct prop_cache *cache)
+{
+  struct ofono_modem *modem = cache->modem;
+
+  /* modem properties are fed by the modem's own PropertyChanged watch */
+  if (cache->iface == PROP_CACHE_MODEM || cache->watch > 0)
+    return;
+
+  cache->watch = signal_watch_add_full(modem->conn,
+        cache_ifaces[cache->iface].name, "PropertyChanged",
+        modem->path, FALSE, NULL, _prop_cache_changed, cache,
+        _prop_cache_ref, _prop_cache_unref);
+}
+
+static void _on_response_prefetch(GObject *obj, GAsyncResult *result,
+      gpointer user_data)
+{
+  struct prop_cache *cache = user_data;
+  GError *error = NULL;
+  GVariant *resp, *dict;
+
+  resp = g_dbus_connection_call_finish(G_DBUS_CONNECTION(obj), result, &error);
+  if (resp == NULL) {
+    /* cancelled means the modem has been released, don't touch it */
+    if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+      tapi_error("dbus call failed (%s)", error->message);
+
+    g_error_free(error);
+    _prop_cache_unref(cache);
+    return;
+  }
+
+  dict = g_variant_get_child_value(resp, 0);
+  prop_cache_fill(cache->modem, cache->iface, dict);
+  g_variant_unref(dict);
+  g_variant_unref(resp);
+
+  _prop_cache_unref(cache);
+}
+
+/* must be called with the cache lock held */
+static void _prop_cache_prefetch(struct prop_cache *cache)
+{
+  struct ofono_modem *modem = cache->modem;
+
+  _prop_cache_watch(cache);
+
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
+      cache_ifaces[cache->iface].name, "GetProperties", NULL,
+      G_VARIANT_TYPE("(a{sv})"), G_DBUS_CALL_FLAGS_NONE, -1,
+      modem->cancellable, _on_response_prefetch, _prop_cache_ref(cache));
+}
+
+static void _context_cache_changed(GDBusConnection *conn,
+     const gchar *sender_name,
+     const gchar *object_path, const gchar *iface,
+     const gchar *signal_name, GVariant *parameters,
+     gpointer user_data)
+{
+  struct ofono_modem *modem = user_data;
+  GHashTable *props;
+  const gchar *key;
+  GVariant *value;
+
+  g_variant_get(parameters, "(&sv)", &key, &value);
+
+  g_mutex_lock(&modem->cache_lock);
+
+  /* only the contexts already fetched are cached */
+  props = g_hash_table_lookup(modem->contexts, object_path);
+  if (props != NULL)
+    g_hash_table_replace(props, g_strdup(key), g_variant_ref(value));
+
+  g_mutex_unlock(&modem->cache_lock);
+
+  g_variant_unref(value);
+}
+
+static void _context_cache_added(GDBusConnection *conn,
+     const gchar *sender_name,
+     const gchar *object_path, const gchar *iface,
+     const gchar *signal_name, GVariant *parameters,
+     gpointer user_data)
+{
+  const gchar *path;
+  GVariant *dict;
+
+  g_variant_get(parameters, "(&o@a{sv})", &path, &dict);
+  context_cache_fill(user_data, path, dict);
+  g_variant_unref(dict);
+}
+
+static void _context_cache_removed(GDBusConnection *conn,
+     const gchar *sender_name,
+     const gchar *object_path, const gchar *iface,
+     const gchar *signal_name, GVariant *parameters,
+     gpointer user_data)
+{
+  struct ofono_modem *modem = user_data;
+  const gchar *path;
+
+  g_variant_get(parameters, "(&o)", &path);
+
+  g_mutex_lock(&modem->cache_lock);
+  g_hash_table_remove(modem->contexts, path);
+  g_mutex_unlock(&modem->cache_lock);
+}
+
+void prop_cache_init(struct ofono_modem *modem)
+{
+  int i;
+
+  g_mutex_init(&modem->cache_lock);
+  memset(&modem->cache_stats, 0, sizeof(modem->cache_stats));
+
+  for (i = 0; i < PROP_CACHE_MAX; i++) {
+    struct prop_cache *cache = &modem->cache[i];
+
+    cache->modem = modem;
+    cache->iface = i;
+    cache->props = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+          (GDestroyNotify) g_variant_unref);
+    cache->valid = FALSE;
+    cache->watch = 0;
+  }
+
+  modem->contexts = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+        (GDestroyNotify) g_hash_table_destroy);
+  memset(modem->context_watches, 0, sizeof(modem->context_watches));
+}
+
+void prop_cache_unwatch(struct ofono_modem *modem)
+{
+  int i;
+
+  g_mutex_lock(&modem->cache_lock);
+
+  for (i = 0; i < PROP_CACHE_MAX; i++) {
+    signal_watch_remove(modem->cache[i].watch);
+    modem->cache[i].watch = 0;
+  }
+
+  for (i = 0; i < (int) G_N_ELEMENTS(modem->context_watches); i++) {
+    signal_watch_remove(modem->context_watches[i]);
+    modem->context_watches[i] = 0;
+  }
+
+  g_mutex_unlock(&modem->cache_lock);
+}
+
+void prop_cache_deinit(struct ofono_modem *modem)
+{
+  int i;
+
+  for (i = 0; i < PROP_CACHE_MAX; i++)
+    g_hash_table_destroy(modem->cache[i].props);
+
+  g_hash_table_destroy(modem->contexts);
+
+  g_mutex_clear(&modem->cache_lock);
+}
+
+void prop_cache_fill(struct ofono_modem *modem, enum prop_cache_iface iface,
+      GVariant *dict)
+{
+  struct prop_cache *cache = &modem->cache[iface];
+  GVariantIter iter;
+  const gchar *key;
+  GVariant *value;
+
+  g_mutex_lock(&modem->cache_lock);
+
+  /* a PropertyChanged received while the reply was in flight is newer */
+  g_variant_iter_init(&iter, dict);
+  while (g_variant_iter_next(&iter, "{&sv}", &key, &value)) {
+    if (!g_hash_table_contains(cache->props, key))
+      g_hash_table_insert(cache->props, g_strdup(key), value);
+    else
+      g_variant_unref(value);
+  }
+
+  cache->valid = TRUE;
+
+  g_mutex_unlock(&modem->cache_lock);
+}
+
+void prop_cache_update(struct ofono_modem *modem, enum prop_cache_iface iface,
+      const char *key, GVariant *value)
+{
+  struct prop_cache *cache = &modem->cache[iface];
+  gpointer orig_key, old_value;
+
+  g_mutex_lock(&modem->cache_lock);
+
+  /* keep the stored key, no copy per change */
+  if (g_hash_table_lookup_extended(cache->props, key, &orig_key,
+        &old_value)) {
+    g_hash_table_steal(cache->props, key);
+    g_hash_table_insert(cache->props, orig_key, g_variant_ref(value));
+    g_variant_unref(old_value);
+  } else
+    g_hash_table_insert(cache->props, g_strdup(key), g_variant_ref(value));
+
+  g_mutex_unlock(&modem->cache_lock);
+}
+
+void prop_cache_interfaces_changed(struct ofono_modem *modem)
+{
+  int i;
+
+  g_mutex_lock(&modem->cache_lock);
+
+  for (i = 0; i < PROP_CACHE_MAX; i++) {
+    struct prop_cache *cache = &modem->cache[i];
+
+    if (cache_ifaces[i].api < 0)
+      continue;
+
+    if (has_interface(modem->interfaces, cache_ifaces[i].api)) {
+      /* interface is back, refill it if somebody is watching */
+      if (!cache->valid && cache->watch > 0)
+        _prop_cache_prefetch(cache);
+      continue;
+    }
+
+    /* refetched once the interface comes back */
+    if (cache->valid)
+      tapi_debug("drop cached %s properties", cache_ifaces[i].name);
+
+    cache->valid = FALSE;
+    g_hash_table_remove_all(cache->props);
+  }
+
+  if (!has_interface(modem->interfaces, OFONO_API_CONNMAN))
+    g_hash_table_remove_all(modem->contexts);
+
+  g_mutex_unlock(&modem->cache_lock);
+}
+
+GHashTable *prop_cache_lock(struct ofono_modem *modem,
+      enum prop_cache_iface iface)
+{
+  struct prop_cache *cache = &modem->cache[iface];
+  GError *error = NULL;
+  GVariant *resp, *dict;
+
+  g_mutex_lock(&modem->cache_lock);
+
+  if (cache->valid) {
+    modem->cache_stats.hits++;
+    return cache->props;
+  }
+
+  modem->cache_stats.misses++;
+  _prop_cache_watch(cache);
+
+  g_mutex_unlock(&modem->cache_lock);
+
+  resp = g_dbus_connection_call_sync(modem->conn, OFONO_SERVICE,
+        modem->path, cache_ifaces[iface].name,
+        "GetProperties", NULL, G_VARIANT_TYPE("(a{sv})"),
+        G_DBUS_SEND_MESSAGE_FLAGS_NONE, -1, NULL, &error);
+
+  if (resp == NULL) {
+    tapi_error("dbus call failed (%s)", error->message);
+    g_error_free(error);
+    return NULL;
+  }
+
+  dict = g_variant_get_child_value(resp, 0);
+  prop_cache_fill(modem, iface, dict);
+  g_variant_unref(dict);
+  g_variant_unref(resp);
+
+  g_mutex_lock(&modem->cache_lock);
+  return cache->props;
+}
+
+GHashTable *prop_cache_peek(struct ofono_modem *modem,
+      enum prop_cache_iface iface)
+{
+  g_mutex_lock(&modem->cache_lock);
+  return modem->cache[iface].props;
+}
+
+void prop_cache_prefetch(struct ofono_modem *modem,
+      enum prop_cache_iface iface)
+{
+  struct prop_cache *cache = &modem->cache[iface];
+
+  g_mutex_lock(&modem->cache_lock);
+
+  if (!cache->valid)
+    _prop_cache_prefetch(cache);
+  else
+    _prop_cache_watch(cache);
+
+  g_mutex_unlock(&modem->cache_lock);
+}
+
+void prop_cache_unlock(struct ofono_modem *modem)
+{
+  g_mutex_unlock(&modem->cache_lock);
+}
+
+void context_cache_watch(struct ofono_modem *modem)
+{
+  g_mutex_lock(&modem->cache_lock);
+
+  if (modem->context_watches[0] == 0) {
+    modem->context_watches[0] = signal_watch_add_full(modem->conn,
+          OFONO_CONTEXT_IFACE, "PropertyChanged", modem->path, TRUE, NULL,
+          _context_cache_changed, modem, (GBoxedCopyFunc) modem_ref,
+          (GDestroyNotify) modem_unref);
+    modem->context_watches[1] = signal_watch_add_full(modem->conn,
+          OFONO_CONNMAN_IFACE, "ContextAdded", modem->path, FALSE, NULL,
+          _context_cache_added, modem, (GBoxedCopyFunc) modem_ref,
+          (GDestroyNotify) modem_unref);
+    modem->context_watches[2] = signal_watch_add_full(modem->conn,
+          OFONO_CONNMAN_IFACE, "ContextRemoved", modem->path, FALSE, NULL,
+          _context_cache_removed, modem, (GBoxedCopyFunc) modem_ref,
+          (GDestroyNotify) modem_unref);
+  }
+
+  g_mutex_unlock(&modem->cache_lock);
+}
+
+void context_cache_fill(struct ofono_modem *modem, const char *path,
+      GVariant *dict)
+{
+  GHashTable *props;
+  GVariantIter iter;
+  const gchar *key;
+  GVariant *value;
+
+  g_mutex_lock(&modem->cache_lock);
+
+  /* without the signals the values could go stale, don't keep them */
+  if (modem->context_watches[0] == 0) {
+    g_mutex_unlock(&modem->cache_lock);
+    return;
+  }
+
+  props = g_hash_table_lookup(modem->contexts, path);
+  if (props == NULL) {
+    props = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+          (GDestroyNotify) g_variant_unref);
+    g_hash_table_insert(modem->contexts, g_strdup(path), props);
+  }
+
+  /* same as prop_cache_fill(), a PropertyChanged is newer than the reply */
+  g_variant_iter_init(&iter, dict);
+  while (g_variant_iter_next(&iter, "{&sv}", &key, &value)) {
+    if (!g_hash_table_contains(props, key))
+      g_hash_table_insert(props, g_strdup(key), value);
+    else
+      g_variant_unref(value);
+  }
+
+  g_mutex_unlock(&modem->cache_lock);
+}
+
+GVariant *context_cache_lookup(struct ofono_modem *modem, const char *path,
+      const char *key)
+{
+  GHashTable *props;
+  GVariant *value = NULL;
+
+  g_mutex_lock(&modem->cache_lock);
+
+  props = g_hash_table_lookup(modem->contexts, path);
+  if (props != NULL)
+    value = g_hash_table_lookup(props, key);
+  if (value != NULL)
+    g_variant_ref(value);
+
+  g_mutex_unlock(&modem->cache_lock);
+
+  return value;
+}
+
+EXPORT_API tapi_bool ofono_modem_get_cache_stats(struct ofono_modem *modem,
+      struct ofono_cache_stats *stats)
+{
+  if (modem == NULL || stats == NULL)
+    return FALSE;
+
+  g_mutex_lock(&modem->cache_lock);
+  *stats = modem->cache_stats;
+  g_mutex_unlock(&modem->cache_lock);
+
+  return TRUE;
+}
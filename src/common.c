@@ -44,8 +44,16 @@ TResult ofono_error_parse(GError *err)
   if (NULL == err)
     return TAPI_RESULT_OK;
 
+  if (g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+    tapi_debug("request cancelled");
+    return TAPI_RESULT_CANCELLED;
+  }
+
   tapi_error("dbus error = %d (%s)", err->code, err->message);
 
+  if (g_error_matches(err, G_IO_ERROR, G_IO_ERROR_TIMED_OUT))
+    return TAPI_RESULT_TIMEOUT;
+
   for (itr = error_map; itr->name != NULL; itr++) {
     if (g_strrstr(err->message, itr->name))
       return itr->ret;
@@ -54,6 +62,97 @@ TResult ofono_error_parse(GError *err)
   return TAPI_RESULT_UNKNOWN_ERROR;
 }
 
+static GMutex s_request_lock;
+static GHashTable *s_requests; /* request id -> struct response_cb_data */
+static ofono_request s_last_request;
+static int s_request_timeout = -1;
+
+struct response_cb_data *request_new(response_cb cb, void *user_data)
+{
+  struct response_cb_data *cbd;
+
+  cbd = g_new0(struct response_cb_data, 1);
+  cbd->cb = cb;
+  cbd->user_data = user_data;
+  cbd->cancellable = g_cancellable_new();
+
+  g_mutex_lock(&s_request_lock);
+
+  if (s_requests == NULL)
+    s_requests = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+  /* 0 means failure to the callers */
+  if (++s_last_request == 0)
+    s_last_request++;
+
+  cbd->id = s_last_request;
+  g_hash_table_insert(s_requests, GUINT_TO_POINTER(cbd->id), cbd);
+
+  g_mutex_unlock(&s_request_lock);
+
+  return cbd;
+}
+
+void request_free(struct response_cb_data *cbd)
+{
+  g_mutex_lock(&s_request_lock);
+  g_hash_table_remove(s_requests, GUINT_TO_POINTER(cbd->id));
+  g_mutex_unlock(&s_request_lock);
+
+  g_object_unref(cbd->cancellable);
+  g_free(cbd);
+}
+
+int request_timeout(struct ofono_modem *modem)
+{
+  if (modem != NULL && modem->request_timeout != 0)
+    return modem->request_timeout;
+
+  return g_atomic_int_get(&s_request_timeout);
+}
+
+EXPORT_API tapi_bool ofono_request_cancel(ofono_request req)
+{
+  struct response_cb_data *cbd;
+  GCancellable *cancellable = NULL;
+
+  g_mutex_lock(&s_request_lock);
+
+  cbd = s_requests ? g_hash_table_lookup(s_requests, GUINT_TO_POINTER(req)) :
+        NULL;
+  if (cbd != NULL)
+    cancellable = g_object_ref(cbd->cancellable);
+
+  g_mutex_unlock(&s_request_lock);
+
+  if (cancellable == NULL) {
+    tapi_debug("request %u already completed", req);
+    return FALSE;
+  }
+
+  tapi_debug("cancel request %u", req);
+
+  /* the reply handler runs with G_IO_ERROR_CANCELLED and frees the request */
+  g_cancellable_cancel(cancellable);
+  g_object_unref(cancellable);
+
+  return TRUE;
+}
+
+EXPORT_API void ofono_set_request_timeout(int timeout_ms)
+{
+  g_atomic_int_set(&s_request_timeout, timeout_ms > 0 ? timeout_ms : -1);
+}
+
+EXPORT_API void ofono_modem_set_request_timeout(struct ofono_modem *modem,
+      int timeout_ms)
+{
+  if (modem == NULL)
+    return;
+
+  modem->request_timeout = timeout_ms > 0 ? timeout_ms : 0;
+}
+
 tapi_bool has_interface(guint32 interfaces, enum ofono_api api)
 {
   if ((interfaces & (1 << api)) != 0)
@@ -79,19 +178,23 @@ void on_response_common(GObject *obj, GAsyncResult *result, gpointer user_data)
   g_variant_unref(resp);
 }
 
-void ofono_set_property(struct ofono_modem *modem, const char *iface,
+ofono_request ofono_set_property(struct ofono_modem *modem, const char *iface,
                 char *path, const char *key, GVariant *value,
                 response_cb cb, void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
   GVariant *val;
 
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
   val = g_variant_new("(sv)", key, value);
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, path, iface,
-      "SetProperty", val, NULL, G_DBUS_CALL_FLAGS_NONE, 120000,
-      NULL, on_response_common, cbd);
+  dispatch_call(modem->conn, OFONO_SERVICE, path, iface,
+      "SetProperty", val, NULL, G_DBUS_CALL_FLAGS_NONE,
+      request_timeout(modem), cbd->cancellable, on_response_common, cbd);
+
+  return id;
 }
 
 unsigned int ofono_get_call_id_from_obj_path(char *obj_path)
@@ -112,61 +215,183 @@ unsigned int ofono_get_call_id_from_obj_path(char *obj_path)
   return atoi(p + strlen("/voicecall"));
 }
 
-enum ofono_call_status ofono_str_to_call_status(const char *str)
+int str_table_lookup(struct str_table *table, const char *str, int def)
 {
-  if (g_strcmp0(str, "active") == 0)
-    return CALL_STATUS_ACTIVE;
+  gpointer val;
 
-  else if (g_strcmp0(str, "held") == 0)
-    return CALL_STATUS_HELD;
+  if (g_once_init_enter(&table->index)) {
+    GHashTable *index = g_hash_table_new(g_str_hash, g_str_equal);
+    const struct str_map *map;
 
-  else if (g_strcmp0(str, "dialing") == 0)
-    return CALL_STATUS_DIALING;
+    for (map = table->map; map->str != NULL; map++)
+      g_hash_table_insert(index, (gpointer) map->str,
+            GINT_TO_POINTER(map->val));
 
-  else if (g_strcmp0(str, "alerting") == 0)
-    return CALL_STATUS_ALERTING;
+    g_once_init_leave(&table->index, index);
+  }
 
-  else if (g_strcmp0(str, "incoming") == 0)
-    return CALL_STATUS_INCOMING;
+  if (str == NULL)
+    return def;
 
-  else if (g_strcmp0(str, "waiting") == 0)
-    return CALL_STATUS_WAITING;
+  if (!g_hash_table_lookup_extended(table->index, str, NULL, &val))
+    return def;
 
-  else if (g_strcmp0(str, "disconnected") == 0)
+  return GPOINTER_TO_INT(val);
+}
+
+static const struct str_map call_status_map[] = {
+  {"active", CALL_STATUS_ACTIVE},
+  {"held", CALL_STATUS_HELD},
+  {"dialing", CALL_STATUS_DIALING},
+  {"alerting", CALL_STATUS_ALERTING},
+  {"incoming", CALL_STATUS_INCOMING},
+  {"waiting", CALL_STATUS_WAITING},
+  {"disconnected", CALL_STATUS_DISCONNECTED},
+  {NULL, 0}
+};
+
+static struct str_table call_status_table = STR_TABLE_INIT(call_status_map);
+
+enum ofono_call_status ofono_str_to_call_status(const char *str)
+{
+  int status = str_table_lookup(&call_status_table, str, -1);
+
+  if (status < 0) {
+    tapi_warn("unknown call state: %s", str);
     return CALL_STATUS_DISCONNECTED;
+  }
 
-  tapi_warn("unknown call state: %s", str);
-  return CALL_STATUS_DISCONNECTED;
+  return status;
 }
 
+static const struct str_map tech_map[] = {
+  {"gsm", ACCESS_TECH_GSM},
+  {"gprs", ACCESS_TECH_GSM},
+  {"umts", ACCESS_TECH_UTRAN},
+  {"edge", ACCESS_TECH_EDGE},
+  {"hsdpa", ACCESS_TECH_UTRAN_HSDPA},
+  {"hsupa", ACCESS_TECH_UTRAN_HSUPA},
+  {"hspa", ACCESS_TECH_UTRAN_HSDPA_HSUPA},
+  {"lte", ACCESS_TECH_EUTRAN},
+  {NULL, 0}
+};
+
+static struct str_table tech_table = STR_TABLE_INIT(tech_map);
+
 enum access_tech ofono_str_to_tech(const char *tech)
 {
+  int val;
+
   if (tech == NULL) {
     tapi_error("access technology stirng is null");
     return ACCESS_TECH_UNKNOWN;
   }
 
-  if (g_strcmp0(tech, "gsm") == 0 || g_strcmp0(tech, "gprs") == 0)
-    return ACCESS_TECH_GSM;
+  val = str_table_lookup(&tech_table, tech, -1);
+  if (val < 0) {
+    tapi_warn("Unknown access technology: %s", tech);
+    return ACCESS_TECH_UNKNOWN;
+  }
+
+  return val;
+}
+
+/* reads exactly "n" digits */
+static tapi_bool _parse_digits(const char **str, int n, int *val)
+{
+  const char *p = *str;
+  int v = 0;
+
+  for (; n > 0; n--, p++) {
+    if (*p < '0' || *p > '9')
+      return FALSE;
+    v = v * 10 + (*p - '0');
+  }
+
+  *str = p;
+  *val = v;
+
+  return TRUE;
+}
+
+/* days since 1970-01-01 of a proleptic Gregorian date */
+static gint64 _days_from_civil(int year, int month, int day)
+{
+  gint64 era, yoe, doy, doe;
 
-  if (g_strcmp0(tech, "umts") == 0)
-    return ACCESS_TECH_UTRAN;
+  year -= month <= 2;
+  era = (year >= 0 ? year : year - 399) / 400;
+  yoe = year - era * 400;
+  doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+  doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
 
-  if (g_strcmp0(tech, "edge") == 0)
-    return ACCESS_TECH_EDGE;
+  return era * 146097 + doe - 719468;
+}
+
+tapi_bool time_parse_iso8601(const char *str, time_t *time, int *offset)
+{
+  static const unsigned char mdays[] = {
+    31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
+  };
+  int year, mon, day, hour, min, sec, off_h = 0, off_m = 0, sign = 1;
+  tapi_bool leap;
+
+  if (str == NULL)
+    return FALSE;
+
+  if (!_parse_digits(&str, 4, &year) || *str++ != '-' ||
+      !_parse_digits(&str, 2, &mon) || *str++ != '-' ||
+      !_parse_digits(&str, 2, &day) || (*str != 'T' && *str != ' '))
+    return FALSE;
+  str++;
+
+  if (!_parse_digits(&str, 2, &hour) || *str++ != ':' ||
+      !_parse_digits(&str, 2, &min) || *str++ != ':' ||
+      !_parse_digits(&str, 2, &sec))
+    return FALSE;
+
+  /* oFono sends "+HHMM", accept the other ISO 8601 forms too */
+  switch (*str) {
+  case '\0':
+    break;
+  case 'Z':
+    str++;
+    break;
+  case '-':
+    sign = -1;
+    /* fall through */
+  case '+':
+    str++;
+    if (!_parse_digits(&str, 2, &off_h))
+      return FALSE;
+    if (*str == ':') {
+      str++;
+      if (!_parse_digits(&str, 2, &off_m))
+        return FALSE;
+    } else if (*str != '\0' && !_parse_digits(&str, 2, &off_m)) {
+      return FALSE;
+    }
+    break;
+  default:
+    return FALSE;
+  }
 
-  if (g_strcmp0(tech, "hsdpa") == 0)
-    return ACCESS_TECH_UTRAN_HSDPA;
+  if (*str != '\0')
+    return FALSE;
 
-  if (g_strcmp0(tech, "hsupa") == 0)
-    return ACCESS_TECH_UTRAN_HSUPA;
+  leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+  if (mon < 1 || mon > 12 || day < 1 || day > mdays[mon - 1] ||
+      (mon == 2 && day == 29 && !leap) ||
+      hour > 23 || min > 59 || sec > 60 || off_h > 23 || off_m > 59)
+    return FALSE;
 
-  if (g_strcmp0(tech, "hspa") == 0)
-    return ACCESS_TECH_UTRAN_HSDPA_HSUPA;
+  if (offset != NULL)
+    *offset = sign * (off_h * 3600 + off_m * 60);
 
-  if (g_strcmp0(tech, "lte") == 0)
-    return ACCESS_TECH_EUTRAN;
+  if (time != NULL)
+    *time = (time_t) (_days_from_civil(year, mon, day) * 86400 +
+          hour * 3600 + min * 60 + sec -
+          sign * (off_h * 3600 + off_m * 60));
 
-  tapi_warn("Unknown access technology: %s", tech);
-  return ACCESS_TECH_UNKNOWN;
+  return TRUE;
 }
@@ -21,11 +21,16 @@
 #include "ofono-call.h"
 #include "ofono-sim.h"
 #include "ofono-network.h"
+#include "ofono-modem.h"
 
 #include <glib.h>
 #include <gio/gio.h>
 #include <malloc.h>
 
+#include "ofono-sms.h"
+#include "ofono-ss.h"
+#include "ofono-netmon.h"
+
 #ifdef  __cplusplus
 extern "C" {
 #endif
@@ -75,7 +80,30 @@ extern "C" {
 #define OFONO_CDMA_NETWORK_REGISTRATION_IFACE \
   "org.ofono.cdma.NetworkRegistration"
 
+struct ps_reg_status;
+
+/* interfaces whose properties are cached per modem */
+enum prop_cache_iface {
+  PROP_CACHE_MODEM,
+  PROP_CACHE_SIM,
+  PROP_CACHE_NETREG,
+  PROP_CACHE_CONNMAN,
+  PROP_CACHE_CALL_VOL,
+  PROP_CACHE_MAX,
+};
+
+struct prop_cache {
+  struct ofono_modem *modem;
+  enum prop_cache_iface iface;
+  GHashTable *props; /* property name -> GVariant value */
+  tapi_bool valid; /* TRUE once GetProperties has been merged in */
+  guint watch; /* PropertyChanged subscription */
+};
+
 struct ofono_modem {
+  /* ofono_modem_deinit() drops the first, the running handlers hold one */
+  gint refs;
+
   GDBusConnection *conn;
   gchar *path; /* modem object path */
 
@@ -85,12 +113,49 @@ struct ofono_modem {
 
   guint prop_changed_watch;
 
-  GList *noti_list; /* notification handle data (struct ofono_noti_data) list */
+  /* notification handle data, NULL if nobody registered for it */
+  struct ofono_noti_data *noti[OFONO_NOTI_MAX];
+  /* guards noti, callbacks run with it held; taken before the signal lock */
+  GRecMutex noti_lock;
+
+  GCancellable *cancellable; /* cancelled on deinit for internal calls */
+
+  int request_timeout; /* ms, 0 for the global default */
+
+  /* call snapshot: call id -> struct ofono_call_info, guarded by noti_lock */
+  GHashTable *calls;
+  /*
+   * Ids of the calls unknown to the snapshot that changed while it is
+   * seeded, NULL when no seed is pending. Guarded by noti_lock.
+   */
+  GHashTable *calls_held;
+  int calls_seeding; /* GetCalls seeds pending, guarded by noti_lock */
+
+  GMutex cache_lock; /* protects cache, cache_stats and contexts */
+  struct prop_cache cache[PROP_CACHE_MAX];
+  struct ofono_cache_stats cache_stats;
+
+  /* context path -> GHashTable of property name -> GVariant value */
+  GHashTable *contexts;
+  guint context_watches[3]; /* PropertyChanged, ContextAdded, ContextRemoved */
+
+  struct ofono_sms_queue *sms_queue; /* guarded by noti_lock */
+
+  struct sms_batch_state *sms_batch; /* OFONO_NOTI_INCOMING_SMS_BATCH */
+
+  struct signal_state *signal; /* OFONO_NOTI_SIGNAL_STRENTH_CHANGED filters */
+
+  GMutex sms_lock; /* protects sms_tracker */
+  struct sms_tracker *sms_tracker; /* NULL unless enabled */
+
+  struct operator_scan *scan; /* shared Scan and its cached result */
 };
 
 struct response_cb_data {
   response_cb cb;
   void *user_data;
+  ofono_request id; /* handle returned to the caller */
+  GCancellable *cancellable; /* for the D-Bus calls made for the request */
 };
 
 struct interm_response_cb_data {
@@ -101,18 +166,25 @@ struct interm_response_cb_data {
 
 TResult ofono_error_parse(GError *err);
 
+/*
+ * Pending requests, looked up by ofono_request_cancel(). Allocated by
+ * NEW_RSP_CB_DATA and released by CALL_RESP_CALLBACK or CHECK_RESULT.
+ */
+struct response_cb_data *request_new(response_cb cb, void *user_data);
+void request_free(struct response_cb_data *cbd);
+/* D-Bus call timeout of the requests sent to "modem", -1 for the default */
+int request_timeout(struct ofono_modem *modem);
+
 #define CHECK_PARAMETERS(cond, cb, user_data) \
   if(!(cond)) { \
     tapi_error("invalid parameter"); \
     if(cb) \
       cb(TAPI_RESULT_INVALID_ARGS, NULL, user_data); \
-    return; \
+    return 0; \
   } \
 
 #define NEW_RSP_CB_DATA(_cbd, _cb, _user_data) \
-  _cbd = g_new0(struct response_cb_data, 1); \
-  _cbd->cb = _cb; \
-  _cbd->user_data = _user_data; \
+  _cbd = request_new(_cb, _user_data); \
 
 #define NEW_INTERM_RSP_CB_DATA(_icbd, _cbd, _modem, _user_data) \
   _icbd = g_new0(struct interm_response_cb_data, 1); \
@@ -124,7 +196,7 @@ TResult ofono_error_parse(GError *err);
 #define CALL_RESP_CALLBACK(_ret, _resp_data, _cbd) \
   if (_cbd->cb) \
     _cbd->cb(_ret, _resp_data, _cbd->user_data); \
-  g_free(_cbd);
+  request_free(_cbd);
 
 
 #define CHECK_RESULT(_ret, _error, _cbd, _resp) \
@@ -133,7 +205,7 @@ TResult ofono_error_parse(GError *err);
     if (_ret != TAPI_RESULT_OK) { \
       if (_cbd->cb) \
         _cbd->cb(_ret, NULL, _cbd->user_data); \
-      g_free(_cbd); \
+      request_free(_cbd); \
       g_error_free(_error); \
       if (_resp != NULL) \
         g_variant_unref(_resp); \
@@ -141,16 +213,268 @@ TResult ofono_error_parse(GError *err);
     } \
   } while (0)
 
+/* points into "path", NULL if it isn't a message path */
+const char *sms_uuid_from_path(const char *path);
+
+/*
+ * Parses oFono's "YYYY-MM-DDTHH:MM:SS+HHMM" timestamps (also "Z", "+HH",
+ * "+HH:MM" or no offset for UTC) without allocating nor touching the libc
+ * timezone state. "time" is the UTC instant, "offset" the seconds east of
+ * UTC the time was given in; either may be NULL.
+ */
+tapi_bool time_parse_iso8601(const char *str, time_t *time, int *offset);
+
+/*
+ * Outgoing message tracker, see ofono_sms_tracker_enable(). The updates
+ * are ignored while it is disabled. "submitted" is a monotonic time.
+ */
+void sms_tracker_init(struct ofono_modem *modem);
+void sms_tracker_deinit(struct ofono_modem *modem);
+void sms_tracker_add(struct ofono_modem *modem, const char *uuid,
+                gint64 submitted);
+void sms_tracker_state(struct ofono_modem *modem, const char *uuid,
+                enum ofono_sms_sent_state state);
+void sms_tracker_delivered(struct ofono_modem *modem, const char *uuid);
+
+/*
+ * Operator scan shared by the concurrent ofono_network_scan_operators()
+ * callers, see ofono_network_set_scan_cache().
+ */
+void network_scan_init(struct ofono_modem *modem);
+void network_scan_deinit(struct ofono_modem *modem);
+
+/*
+ * Held by the internal handlers which may run on another thread while
+ * ofono_modem_deinit() is called, the last one frees the modem.
+ */
+struct ofono_modem *modem_ref(struct ofono_modem *modem);
+void modem_unref(struct ofono_modem *modem);
+
 tapi_bool has_interface(guint32 interfaces, enum ofono_api api);
 
 void on_response_common(GObject *source_object,
                 GAsyncResult *result,
                 gpointer user_data);
 
-void ofono_set_property(struct ofono_modem *modem, const char *iface,
+ofono_request ofono_set_property(struct ofono_modem *modem, const char *iface,
                 char *path, const char *key, GVariant *value,
                 response_cb cb, void *user_data);
 
+/*
+ * Shared signal subscriptions: one match rule per connection, interface
+ * and member, demultiplexed on object path and arg0. "path_prefix" also
+ * delivers the signals of the objects below "path" (calls, contexts...).
+ * Returns 0 on failure.
+ */
+guint signal_watch_add(GDBusConnection *conn, const char *iface,
+                const char *member, const char *path, tapi_bool path_prefix,
+                const char *arg0, GDBusSignalCallback callback,
+                gpointer user_data);
+/*
+ * Same, "ref" and "unref" are called on "user_data" around each callback:
+ * a callback running on another thread may outlive signal_watch_remove().
+ */
+guint signal_watch_add_full(GDBusConnection *conn, const char *iface,
+                const char *member, const char *path, tapi_bool path_prefix,
+                const char *arg0, GDBusSignalCallback callback,
+                gpointer user_data, GBoxedCopyFunc ref, GDestroyNotify unref);
+void signal_watch_remove(guint id);
+
+/*
+ * Library threads, see ofono_dispatch_start(). Without them all of these
+ * run their work inline.
+ */
+tapi_bool dispatch_threaded(void);
+/* TRUE if the modems are spread over several connections */
+tapi_bool dispatch_sharded(void);
+/* TRUE if dispatch_post() hands the work over to the callback context */
+tapi_bool dispatch_deferred(void);
+/*
+ * Runs "func" on the thread of "conn", where its D-Bus calls are issued.
+ * NULL stands for the default connection.
+ */
+void dispatch_run(GDBusConnection *conn, void (*func)(gpointer data),
+                gpointer data);
+/* Runs "func" where the response and notification callbacks are called */
+void dispatch_post(void (*func)(gpointer data), gpointer data);
+/*
+ * GAsyncReadyCallback forwarding to "callback" through dispatch_post(),
+ * pass dispatch_ready_new(callback, user_data) as its user data.
+ */
+struct dispatch_ready *dispatch_ready_new(GAsyncReadyCallback callback,
+                gpointer user_data);
+void dispatch_ready(GObject *source, GAsyncResult *result,
+                gpointer user_data);
+/*
+ * Create the shard connections to the bus at "addr", the missing ones or
+ * those closed by dispatch_disconnect(). A shard failing to connect serves
+ * its modems on the default connection.
+ */
+void dispatch_connect(const char *addr);
+/* same without blocking, "done" is called once they are all created */
+void dispatch_connect_async(const char *addr, GCancellable *cancellable,
+                void (*done)(gpointer data), gpointer data);
+/*
+ * New reference on the connection serving the modem "path": "conn", the
+ * default one, unless sharded.
+ */
+GDBusConnection *dispatch_connection(GDBusConnection *conn, const char *path);
+void dispatch_disconnect(void);
+/*
+ * Context of the thread of "conn", the thread default context of the
+ * caller when there are no library threads (NULL for the global default).
+ * D-Bus calls made from a source attached to it reply there.
+ */
+GMainContext *dispatch_context(GDBusConnection *conn);
+/* g_timeout_add() on dispatch_context() */
+void dispatch_timeout_add(GDBusConnection *conn, guint interval,
+                GSourceFunc func, gpointer data);
+/* g_dbus_connection_call() issued on the thread of "conn" */
+void dispatch_call(GDBusConnection *conn, const gchar *bus_name,
+                const gchar *path, const gchar *iface, const gchar *method,
+                GVariant *params, const GVariantType *reply_type,
+                GDBusCallFlags flags, int timeout, GCancellable *cancellable,
+                GAsyncReadyCallback callback, gpointer user_data);
+/*
+ * dispatch_call() for read-only methods: joins the identical call in
+ * flight, if any, and gets its reply. The callback must take the reply
+ * with dispatch_call_finish().
+ */
+void dispatch_call_shared(GDBusConnection *conn, const gchar *bus_name,
+                const gchar *path, const gchar *iface, const gchar *method,
+                GVariant *params, const GVariantType *reply_type,
+                GDBusCallFlags flags, int timeout, GCancellable *cancellable,
+                GAsyncReadyCallback callback, gpointer user_data);
+/* g_dbus_connection_call_finish() also taking dispatch_call_shared() replies */
+GVariant *dispatch_call_finish(GObject *source, GAsyncResult *result,
+                GError **error);
+
+/*
+ * Modem registry, filled by GetModems and kept up to date by ModemAdded,
+ * ModemRemoved and the modems' PropertyChanged.
+ */
+tapi_bool manager_start(GDBusConnection *conn);
+/* same as manager_start() without blocking, response data: NULL */
+void manager_start_async(GDBusConnection *conn, response_cb cb,
+                void *user_data);
+void manager_stop(void);
+struct str_list *manager_get_modems(void);
+/* Returns a copy of "path" if it exists, of the first modem if NULL */
+gchar *manager_find_modem(const char *path);
+/* Returns the modem properties as a new a{sv}, NULL if unknown */
+GVariant *manager_modem_properties(const char *path);
+
+void prop_cache_init(struct ofono_modem *modem);
+/* stops the signals, on deinit, the values go with the last reference */
+void prop_cache_unwatch(struct ofono_modem *modem);
+void prop_cache_deinit(struct ofono_modem *modem);
+
+/* merge an "a{sv}" dictionary, keeps values updated since the fetch began */
+void prop_cache_fill(struct ofono_modem *modem, enum prop_cache_iface iface,
+                GVariant *dict);
+void prop_cache_update(struct ofono_modem *modem, enum prop_cache_iface iface,
+                const char *key, GVariant *value);
+void prop_cache_interfaces_changed(struct ofono_modem *modem);
+
+/*
+ * Returns the property table of "iface" with the cache lock held, fetching
+ * it from ofono on the first use. Values are borrowed, the caller must call
+ * prop_cache_unlock() when done. Returns NULL (unlocked) on failure.
+ */
+GHashTable *prop_cache_lock(struct ofono_modem *modem,
+                enum prop_cache_iface iface);
+void prop_cache_unlock(struct ofono_modem *modem);
+
+/*
+ * Same as prop_cache_lock() but never blocks on D-Bus: the table may be
+ * partial if the initial fetch hasn't completed yet. For signal handlers.
+ */
+GHashTable *prop_cache_peek(struct ofono_modem *modem,
+                enum prop_cache_iface iface);
+
+/* start watching "iface" and fill its table asynchronously */
+void prop_cache_prefetch(struct ofono_modem *modem,
+                enum prop_cache_iface iface);
+
+/*
+ * Context properties, kept from the GetContexts replies and updated by
+ * the context signals once context_cache_watch() has been called.
+ */
+void context_cache_watch(struct ofono_modem *modem);
+void context_cache_fill(struct ofono_modem *modem, const char *path,
+                GVariant *dict);
+/* Returns a new reference, NULL if the property isn't known */
+GVariant *context_cache_lookup(struct ofono_modem *modem, const char *path,
+                const char *key);
+
+/*
+ * Call snapshot (call id -> struct ofono_call_info) kept up to date from
+ * CallAdded and VoiceCall.PropertyChanged, with the modem noti_lock held.
+ * "held_cb" is called from the seed reply for the calls whose changes were
+ * held back, see call_snapshot_hold().
+ */
+typedef void (*call_snapshot_cb)(struct ofono_modem *modem,
+                const struct ofono_call_info *info);
+void call_snapshot_seed(struct ofono_modem *modem, call_snapshot_cb held_cb);
+/*
+ * TRUE if the change of "call_id" is held back until the seed reply, which
+ * reports the call complete.
+ */
+tapi_bool call_snapshot_hold(struct ofono_modem *modem, unsigned int call_id);
+struct ofono_call_info *call_snapshot_update(struct ofono_modem *modem,
+                unsigned int call_id, const char *key, GVariant *val);
+void call_snapshot_remove(struct ofono_modem *modem, unsigned int call_id);
+
+/* parsers shared by the sync getters and the notification handlers */
+void ofono_call_parse_property(struct ofono_call_info *info,
+                const char *key, GVariant *val);
+void ofono_network_parse_registration_info(GHashTable *props,
+                struct registration_info *info);
+void ofono_sim_parse_info(GHashTable *props, struct sim_info *info);
+void ofono_connman_parse_status(GHashTable *props,
+                struct ps_reg_status *status);
+
+/*
+ * Reply and signal decoders, split from the D-Bus plumbing so that they
+ * can be run on recorded messages (see bench/).
+ */
+tapi_bool ofono_call_parse_calls(GVariant *result, struct ofono_calls *calls);
+/*
+ * The names and paths of "ops" point into "resp", which must outlive it.
+ * "ops" must be released with ofono_network_free_operators().
+ */
+void ofono_network_parse_operators(GVariant *resp,
+                struct operators_info *ops);
+void ofono_network_free_operators(struct operators_info *ops);
+void ofono_netmon_parse_cell_info(struct cell_info *info, GVariantIter *iter);
+/* "settings" has SS_CF_CONDITION_CFNRC + 1 entries */
+void ofono_ss_parse_call_forward(GVariant *props,
+                struct call_forward_setting *settings);
+/* "noti" message and sender point into "parameters" */
+tapi_bool ofono_sms_parse_incoming(GVariant *parameters,
+                struct ofono_sms_incoming_noti *noti);
+
+/* string -> integer map, terminated by a NULL "str" */
+struct str_map {
+  const char *str;
+  int val;
+};
+
+/* a str_map with a hash index built on the first lookup */
+struct str_table {
+  const struct str_map *map;
+  GHashTable *index;
+};
+
+#define STR_TABLE_INIT(_map) { _map, NULL }
+
+/*
+ * Decode "str" with one hash lookup: property keys into a per-parser key
+ * id for a switch, or enum strings into their value. Returns "def" if
+ * "str" is NULL or unknown. Thread safe.
+ */
+int str_table_lookup(struct str_table *table, const char *str, int def);
+
 unsigned int ofono_get_call_id_from_obj_path(char *obj_path);
 enum ofono_call_status ofono_str_to_call_status(const char *str);
 enum access_tech ofono_str_to_tech(const char *tech);
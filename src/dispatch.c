@@ -0,0 +1,902 @@
+/*
+ * Copyright (C) 2013 Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include <string.h>
+
+#include "common.h"
+#include "log.h"
+
+/*
+ * Optional library threads, see ofono_dispatch_start().
+ *
+ * The D-Bus calls and the signal subscriptions are attached to the
+ * thread-default context of the thread issuing them, so they are all
+ * issued from the thread of their connection: other threads hand them
+ * over through a lock-free job queue. The reply and signal handlers then
+ * run on the callback context chosen by the application, or on the thread
+ * of the connection.
+ *
+ * With several shards, each one owns a connection and a thread and the
+ * modems are spread over them by object path. Shard 0 uses the default
+ * connection, the one of the modem registry.
+ */
+
+struct dispatch_job {
+  struct dispatch_job *next;
+  void (*func)(gpointer data);
+  gpointer data;
+};
+
+struct dispatch_shard {
+  GMainContext *context;
+  GMainLoop *loop;
+  GThread *thread;
+  GSource *job_source;
+  /* pushed by any thread, taken all at once by the shard thread */
+  struct dispatch_job *jobs;
+  GDBusConnection *conn; /* NULL for shard 0 and until dispatch_connect() */
+};
+
+struct job_source {
+  GSource source;
+  struct dispatch_shard *shard;
+};
+
+struct dispatch_call {
+  GDBusConnection *conn;
+  gchar *bus_name;
+  gchar *path;
+  gchar *iface;
+  gchar *method;
+  GVariant *params;
+  GVariantType *reply_type;
+  GDBusCallFlags flags;
+  int timeout;
+  GCancellable *cancellable;
+  GAsyncReadyCallback callback;
+  gpointer user_data;
+};
+
+struct dispatch_ready {
+  GAsyncReadyCallback callback;
+  gpointer user_data;
+  GObject *source;
+  GAsyncResult *result;
+};
+
+static struct dispatch_shard *s_shards;
+static guint s_n_shards; /* 0 if not running */
+static GMainContext *s_callback_context; /* NULL for the shard threads */
+static GMutex s_conn_lock; /* protects the shard connections */
+
+static void _job_push(struct dispatch_shard *shard,
+      void (*func)(gpointer), gpointer data)
+{
+  struct dispatch_job *job, *head;
+
+  job = g_new(struct dispatch_job, 1);
+  job->func = func;
+  job->data = data;
+
+  do {
+    head = g_atomic_pointer_get(&shard->jobs);
+    job->next = head;
+  } while (!g_atomic_pointer_compare_and_exchange(&shard->jobs, head, job));
+
+  /* the queue was empty: the shard thread may be sleeping in poll() */
+  if (head == NULL)
+    g_main_context_wakeup(shard->context);
+}
+
+static void _job_run_all(struct dispatch_shard *shard)
+{
+  struct dispatch_job *jobs, *job, *fifo = NULL;
+
+  jobs = __atomic_exchange_n(&shard->jobs, NULL, __ATOMIC_ACQ_REL);
+
+  /* the list is LIFO, run the jobs in submission order */
+  while (jobs != NULL) {
+    job = jobs;
+    jobs = job->next;
+    job->next = fifo;
+    fifo = job;
+  }
+
+  while (fifo != NULL) {
+    job = fifo;
+    fifo = job->next;
+
+    job->func(job->data);
+    g_free(job);
+  }
+}
+
+static gboolean _job_source_prepare(GSource *source, gint *timeout)
+{
+  struct dispatch_shard *shard = ((struct job_source *) source)->shard;
+
+  *timeout = -1;
+  return g_atomic_pointer_get(&shard->jobs) != NULL;
+}
+
+static gboolean _job_source_check(GSource *source)
+{
+  struct dispatch_shard *shard = ((struct job_source *) source)->shard;
+
+  return g_atomic_pointer_get(&shard->jobs) != NULL;
+}
+
+static gboolean _job_source_dispatch(GSource *source, GSourceFunc callback,
+      gpointer user_data)
+{
+  _job_run_all(((struct job_source *) source)->shard);
+  return G_SOURCE_CONTINUE;
+}
+
+static GSourceFuncs job_source_funcs = {
+  _job_source_prepare,
+  _job_source_check,
+  _job_source_dispatch,
+  NULL,
+};
+
+static gpointer _dispatch_thread(gpointer data)
+{
+  struct dispatch_shard *shard = data;
+
+  g_main_context_push_thread_default(shard->context);
+
+  g_main_loop_run(shard->loop);
+
+  /* the jobs queued by ofono_deinit() and before */
+  _job_run_all(shard);
+
+  g_main_context_pop_thread_default(shard->context);
+
+  return NULL;
+}
+
+tapi_bool dispatch_threaded(void)
+{
+  return s_n_shards > 0;
+}
+
+tapi_bool dispatch_sharded(void)
+{
+  return s_n_shards > 1;
+}
+
+tapi_bool dispatch_deferred(void)
+{
+  return s_n_shards > 0 && s_callback_context != NULL;
+}
+
+/* shard 0 for the default connection and anything unknown */
+static struct dispatch_shard *_shard_of(GDBusConnection *conn)
+{
+  guint i;
+
+  for (i = 1; i < s_n_shards; i++) {
+    if (conn != NULL && s_shards[i].conn == conn)
+      return &s_shards[i];
+  }
+
+  return &s_shards[0];
+}
+
+/* the shard running on the calling thread, NULL if none */
+static struct dispatch_shard *_current_shard(void)
+{
+  guint i;
+
+  for (i = 0; i < s_n_shards; i++) {
+    if (g_main_context_is_owner(s_shards[i].context))
+      return &s_shards[i];
+  }
+
+  return NULL;
+}
+
+void dispatch_run(GDBusConnection *conn, void (*func)(gpointer),
+      gpointer data)
+{
+  struct dispatch_shard *shard;
+
+  if (s_n_shards == 0) {
+    func(data);
+    return;
+  }
+
+  shard = _shard_of(conn);
+  if (g_main_context_is_owner(shard->context))
+    func(data);
+  else
+    _job_push(shard, func, data);
+}
+
+#define SHARD_CONN_FLAGS (G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT | \
+      G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION)
+
+/* the shard connections missing, or closed by a previous ofono_deinit() */
+static tapi_bool _shard_needs_conn(struct dispatch_shard *shard)
+{
+  tapi_bool needs;
+
+  g_mutex_lock(&s_conn_lock);
+  needs = shard->conn == NULL || g_dbus_connection_is_closed(shard->conn);
+  g_mutex_unlock(&s_conn_lock);
+
+  return needs;
+}
+
+/*
+ * The modems of a closed connection keep their own reference, the shard
+ * only drops its one.
+ */
+static void _shard_set_conn(struct dispatch_shard *shard,
+      GDBusConnection *conn)
+{
+  g_mutex_lock(&s_conn_lock);
+
+  if (shard->conn != NULL)
+    g_object_unref(shard->conn);
+  shard->conn = conn;
+
+  g_mutex_unlock(&s_conn_lock);
+}
+
+void dispatch_connect(const char *addr)
+{
+  GError *error = NULL;
+  GDBusConnection *conn;
+  guint i;
+
+  for (i = 1; i < s_n_shards; i++) {
+    if (!_shard_needs_conn(&s_shards[i]))
+      continue;
+
+    conn = g_dbus_connection_new_for_address_sync(addr, SHARD_CONN_FLAGS,
+          NULL, NULL, &error);
+    if (conn == NULL) {
+      tapi_error("fail to create shard connection: %s", error->message);
+      g_error_free(error);
+      continue;
+    }
+
+    _shard_set_conn(&s_shards[i], conn);
+  }
+}
+
+struct shard_connect {
+  gint pending; /* connections not created yet, plus one while issuing */
+  gchar *addr;
+  GCancellable *cancellable;
+  void (*done)(gpointer data);
+  gpointer data;
+};
+
+struct shard_connect_job {
+  struct shard_connect *sc;
+  struct dispatch_shard *shard;
+};
+
+static void _shard_connect_unref(struct shard_connect *sc)
+{
+  if (!g_atomic_int_dec_and_test(&sc->pending))
+    return;
+
+  sc->done(sc->data);
+
+  g_free(sc->addr);
+  if (sc->cancellable != NULL)
+    g_object_unref(sc->cancellable);
+  g_free(sc);
+}
+
+/* on the shard thread */
+static void _on_shard_connected(GObject *obj, GAsyncResult *result,
+      gpointer user_data)
+{
+  struct shard_connect_job *job = user_data;
+  GError *error = NULL;
+  GDBusConnection *conn;
+
+  conn = g_dbus_connection_new_for_address_finish(result, &error);
+  if (conn == NULL) {
+    if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+      tapi_error("fail to create shard connection: %s", error->message);
+    g_error_free(error);
+  } else
+    _shard_set_conn(job->shard, conn);
+
+  _shard_connect_unref(job->sc);
+  g_free(job);
+}
+
+/* the I/O of the connection is attached to the thread creating it */
+static void _shard_connect_run(gpointer data)
+{
+  struct shard_connect_job *job = data;
+
+  g_dbus_connection_new_for_address(job->sc->addr, SHARD_CONN_FLAGS, NULL,
+        job->sc->cancellable, _on_shard_connected, job);
+}
+
+void dispatch_connect_async(const char *addr, GCancellable *cancellable,
+      void (*done)(gpointer data), gpointer data)
+{
+  struct shard_connect *sc;
+  struct shard_connect_job *job;
+  guint i;
+
+  sc = g_new0(struct shard_connect, 1);
+  sc->pending = 1;
+  sc->addr = g_strdup(addr);
+  sc->cancellable = cancellable ? g_object_ref(cancellable) : NULL;
+  sc->done = done;
+  sc->data = data;
+
+  for (i = 1; i < s_n_shards; i++) {
+    if (!_shard_needs_conn(&s_shards[i]))
+      continue;
+
+    job = g_new0(struct shard_connect_job, 1);
+    job->sc = sc;
+    job->shard = &s_shards[i];
+
+    g_atomic_int_inc(&sc->pending);
+    _job_push(job->shard, _shard_connect_run, job);
+  }
+
+  _shard_connect_unref(sc);
+}
+
+GDBusConnection *dispatch_connection(GDBusConnection *conn, const char *path)
+{
+  struct dispatch_shard *shard;
+  GDBusConnection *shard_conn = NULL;
+
+  if (s_n_shards > 1 && path != NULL) {
+    shard = &s_shards[g_str_hash(path) % s_n_shards];
+
+    g_mutex_lock(&s_conn_lock);
+    if (shard->conn != NULL && !g_dbus_connection_is_closed(shard->conn))
+      shard_conn = g_object_ref(shard->conn);
+    g_mutex_unlock(&s_conn_lock);
+  }
+
+  /* shard 0, or a shard which failed to connect */
+  return shard_conn ? shard_conn : g_object_ref(conn);
+}
+
+void dispatch_disconnect(void)
+{
+  guint i;
+
+  g_mutex_lock(&s_conn_lock);
+
+  for (i = 1; i < s_n_shards; i++) {
+    if (s_shards[i].conn != NULL)
+      g_dbus_connection_close_sync(s_shards[i].conn, NULL, NULL);
+  }
+
+  g_mutex_unlock(&s_conn_lock);
+}
+
+GMainContext *dispatch_context(GDBusConnection *conn)
+{
+  if (s_n_shards > 0)
+    return _shard_of(conn)->context;
+
+  return g_main_context_get_thread_default();
+}
+
+void dispatch_timeout_add(GDBusConnection *conn, guint interval,
+      GSourceFunc func, gpointer data)
+{
+  GSource *source;
+
+  source = g_timeout_source_new(interval);
+  g_source_set_callback(source, func, data, NULL);
+  g_source_attach(source, dispatch_context(conn));
+  g_source_unref(source);
+}
+
+struct dispatch_post {
+  void (*func)(gpointer data);
+  gpointer data;
+};
+
+static gboolean _post_cb(gpointer user_data)
+{
+  struct dispatch_post *post = user_data;
+
+  post->func(post->data);
+  g_free(post);
+
+  return G_SOURCE_REMOVE;
+}
+
+void dispatch_post(void (*func)(gpointer), gpointer data)
+{
+  struct dispatch_post *post;
+
+  if (s_n_shards == 0) {
+    func(data);
+    return;
+  }
+
+  /* stay on the shard thread the work comes from */
+  if (s_callback_context == NULL) {
+    if (_current_shard() != NULL)
+      func(data);
+    else
+      _job_push(&s_shards[0], func, data);
+    return;
+  }
+
+  if (g_main_context_is_owner(s_callback_context)) {
+    func(data);
+    return;
+  }
+
+  post = g_new(struct dispatch_post, 1);
+  post->func = func;
+  post->data = data;
+
+  g_main_context_invoke(s_callback_context, _post_cb, post);
+}
+
+static void _ready_run(gpointer data)
+{
+  struct dispatch_ready *dr = data;
+
+  dr->callback(dr->source, dr->result, dr->user_data);
+
+  if (dr->source != NULL)
+    g_object_unref(dr->source);
+  g_object_unref(dr->result);
+  g_free(dr);
+}
+
+struct dispatch_ready *dispatch_ready_new(GAsyncReadyCallback callback,
+      gpointer user_data)
+{
+  struct dispatch_ready *dr;
+
+  dr = g_new0(struct dispatch_ready, 1);
+  dr->callback = callback;
+  dr->user_data = user_data;
+
+  return dr;
+}
+
+void dispatch_ready(GObject *source, GAsyncResult *result, gpointer user_data)
+{
+  struct dispatch_ready *dr = user_data;
+
+  dr->source = source ? g_object_ref(source) : NULL;
+  dr->result = g_object_ref(result);
+
+  dispatch_post(_ready_run, dr);
+}
+
+static void _call_run(gpointer data)
+{
+  struct dispatch_call *dc = data;
+
+  g_dbus_connection_call(dc->conn, dc->bus_name, dc->path, dc->iface,
+        dc->method, dc->params, dc->reply_type, dc->flags, dc->timeout,
+        dc->cancellable, dc->callback ? dispatch_ready : NULL,
+        dc->callback ? dispatch_ready_new(dc->callback, dc->user_data) : NULL);
+
+  g_object_unref(dc->conn);
+  g_free(dc->bus_name);
+  g_free(dc->path);
+  g_free(dc->iface);
+  g_free(dc->method);
+  if (dc->params != NULL)
+    g_variant_unref(dc->params);
+  if (dc->reply_type != NULL)
+    g_variant_type_free(dc->reply_type);
+  if (dc->cancellable != NULL)
+    g_object_unref(dc->cancellable);
+  g_free(dc);
+}
+
+void dispatch_call(GDBusConnection *conn, const gchar *bus_name,
+      const gchar *path, const gchar *iface, const gchar *method,
+      GVariant *params, const GVariantType *reply_type,
+      GDBusCallFlags flags, int timeout, GCancellable *cancellable,
+      GAsyncReadyCallback callback, gpointer user_data)
+{
+  struct dispatch_call *dc;
+
+  if (s_n_shards == 0) {
+    g_dbus_connection_call(conn, bus_name, path, iface, method, params,
+          reply_type, flags, timeout, cancellable, callback, user_data);
+    return;
+  }
+
+  dc = g_new0(struct dispatch_call, 1);
+  dc->conn = g_object_ref(conn);
+  dc->bus_name = g_strdup(bus_name);
+  dc->path = g_strdup(path);
+  dc->iface = g_strdup(iface);
+  dc->method = g_strdup(method);
+  dc->params = params ? g_variant_ref_sink(params) : NULL;
+  dc->reply_type = reply_type ? g_variant_type_copy(reply_type) : NULL;
+  dc->flags = flags;
+  dc->timeout = timeout;
+  dc->cancellable = cancellable ? g_object_ref(cancellable) : NULL;
+  dc->callback = callback;
+  dc->user_data = user_data;
+
+  dispatch_run(conn, _call_run, dc);
+}
+
+/*
+ * Identical read-only calls in flight, keyed on the connection, object
+ * path, interface, method, arguments, reply type and timeout. The first
+ * caller issues the call, the reply is handed to all of them.
+ */
+struct shared_call {
+  gchar *key;
+  GQueue waiters; /* struct shared_waiter */
+  GCancellable *cancellable; /* cancelled once all the waiters are */
+};
+
+struct shared_waiter {
+  struct shared_call *sc; /* NULL once taken off the waiters */
+  GDBusConnection *conn;
+  GAsyncReadyCallback callback;
+  gpointer user_data;
+  GCancellable *cancellable;
+  gulong cancel_id; /* 0 once the cancel handler has run */
+};
+
+static GMutex s_shared_lock; /* protects the call waiters and the two below */
+static GHashTable *s_shared_calls; /* key -> struct shared_call */
+static struct ofono_shared_call_stats s_shared_stats;
+
+static gchar *_shared_key(GDBusConnection *conn, const gchar *path,
+      const gchar *iface, const gchar *method, GVariant *params,
+      const GVariantType *reply_type, int timeout)
+{
+  gchar *args, *type, *key;
+
+  args = params != NULL ? g_variant_print(params, TRUE) : NULL;
+  type = reply_type != NULL ? g_variant_type_dup_string(reply_type) : NULL;
+  key = g_strdup_printf("%p %s %s.%s %s %s %d", conn, path, iface, method,
+        args != NULL ? args : "()", type != NULL ? type : "", timeout);
+  g_free(args);
+  g_free(type);
+
+  return key;
+}
+
+/* must be called with the shared lock held */
+static void _shared_call_unlink(struct shared_call *sc)
+{
+  if (g_hash_table_lookup(s_shared_calls, sc->key) == sc)
+    g_hash_table_remove(s_shared_calls, sc->key);
+}
+
+static void _shared_call_free(struct shared_call *sc)
+{
+  g_object_unref(sc->cancellable);
+  g_free(sc->key);
+  g_free(sc);
+}
+
+/* hands "reply" or "error" over to the callback of "w" and frees it */
+static void _shared_waiter_done(struct shared_waiter *w, GVariant *reply,
+      GError *error)
+{
+  GTask *task;
+
+  /* waits for a cancel handler running in another thread */
+  if (w->cancel_id > 0)
+    g_cancellable_disconnect(w->cancellable, w->cancel_id);
+
+  /* a cancelled caller gets G_IO_ERROR_CANCELLED from the task */
+  task = g_task_new(w->conn, w->cancellable, NULL, NULL);
+  g_task_set_source_tag(task, dispatch_call_shared);
+
+  if (reply != NULL)
+    g_task_return_pointer(task, g_variant_ref(reply),
+          (GDestroyNotify) g_variant_unref);
+  else
+    g_task_return_error(task, g_error_copy(error));
+
+  w->callback(G_OBJECT(w->conn), G_ASYNC_RESULT(task), w->user_data);
+
+  g_object_unref(task);
+  if (w->cancellable != NULL)
+    g_object_unref(w->cancellable);
+  g_object_unref(w->conn);
+  g_free(w);
+}
+
+static void _shared_waiter_cancelled_run(gpointer data)
+{
+  GError *error;
+
+  error = g_error_new_literal(G_IO_ERROR, G_IO_ERROR_CANCELLED,
+        "Operation was cancelled");
+  _shared_waiter_done(data, NULL, error);
+  g_error_free(error);
+}
+
+static gboolean _on_shared_waiter_timeout(gpointer data)
+{
+  dispatch_post(_shared_waiter_cancelled_run, data);
+
+  return G_SOURCE_REMOVE;
+}
+
+/*
+ * The caller gives up and completes at once, the call goes on for the
+ * others. Runs from g_cancellable_cancel(), where the handler can't be
+ * disconnected: it stays connected to a cancellable that can't fire again.
+ */
+static void _on_shared_waiter_cancelled(GCancellable *cancellable,
+      gpointer data)
+{
+  struct shared_waiter *w = data;
+  struct shared_call *sc;
+  GCancellable *call = NULL;
+
+  g_mutex_lock(&s_shared_lock);
+
+  sc = w->sc;
+  if (sc != NULL) {
+    g_queue_remove(&sc->waiters, w);
+    w->sc = NULL;
+
+    /* nobody wants the reply any more, the next caller starts afresh */
+    if (g_queue_is_empty(&sc->waiters)) {
+      _shared_call_unlink(sc);
+      call = g_object_ref(sc->cancellable);
+    }
+  }
+
+  g_mutex_unlock(&s_shared_lock);
+
+  /* otherwise it is being completed */
+  if (sc == NULL)
+    return;
+
+  if (call != NULL) {
+    g_cancellable_cancel(call);
+    g_object_unref(call);
+  }
+
+  w->cancel_id = 0;
+  dispatch_timeout_add(w->conn, 0, _on_shared_waiter_timeout, w);
+}
+
+/* runs where the response callbacks are called */
+static void _on_shared_reply(GObject *source, GAsyncResult *result,
+      gpointer user_data)
+{
+  struct shared_call *sc = user_data;
+  GError *error = NULL;
+  GVariant *reply;
+  GList *waiters, *l;
+
+  reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), result,
+        &error);
+
+  /* from now on the identical calls go to the bus again */
+  g_mutex_lock(&s_shared_lock);
+
+  _shared_call_unlink(sc);
+  waiters = sc->waiters.head;
+  g_queue_init(&sc->waiters);
+  for (l = waiters; l != NULL; l = l->next)
+    ((struct shared_waiter *) l->data)->sc = NULL;
+
+  g_mutex_unlock(&s_shared_lock);
+
+  for (l = waiters; l != NULL; l = l->next)
+    _shared_waiter_done(l->data, reply, error);
+
+  g_list_free(waiters);
+  if (reply != NULL)
+    g_variant_unref(reply);
+  if (error != NULL)
+    g_error_free(error);
+  _shared_call_free(sc);
+}
+
+void dispatch_call_shared(GDBusConnection *conn, const gchar *bus_name,
+      const gchar *path, const gchar *iface, const gchar *method,
+      GVariant *params, const GVariantType *reply_type,
+      GDBusCallFlags flags, int timeout, GCancellable *cancellable,
+      GAsyncReadyCallback callback, gpointer user_data)
+{
+  struct shared_call *sc;
+  struct shared_waiter *w;
+  gchar *key;
+
+  if (params != NULL)
+    g_variant_ref_sink(params);
+
+  key = _shared_key(conn, path, iface, method, params, reply_type, timeout);
+
+  w = g_new0(struct shared_waiter, 1);
+  w->conn = g_object_ref(conn);
+  w->callback = callback;
+  w->user_data = user_data;
+  w->cancellable = cancellable ? g_object_ref(cancellable) : NULL;
+  /* before it is queued, the handler takes the shared lock */
+  if (w->cancellable != NULL)
+    w->cancel_id = g_cancellable_connect(w->cancellable,
+          G_CALLBACK(_on_shared_waiter_cancelled), w, NULL);
+
+  g_mutex_lock(&s_shared_lock);
+
+  if (s_shared_calls == NULL)
+    s_shared_calls = g_hash_table_new(g_str_hash, g_str_equal);
+
+  sc = g_hash_table_lookup(s_shared_calls, key);
+  if (sc != NULL) {
+    g_queue_push_tail(&sc->waiters, w);
+    w->sc = sc;
+    s_shared_stats.saved++;
+    g_mutex_unlock(&s_shared_lock);
+
+    tapi_debug("joining %s", key);
+    g_free(key);
+  } else {
+    sc = g_new0(struct shared_call, 1);
+    sc->key = key;
+    sc->cancellable = g_cancellable_new();
+    g_queue_init(&sc->waiters);
+    g_queue_push_tail(&sc->waiters, w);
+    w->sc = sc;
+    g_hash_table_insert(s_shared_calls, sc->key, sc);
+    s_shared_stats.calls++;
+    g_mutex_unlock(&s_shared_lock);
+
+    dispatch_call(conn, bus_name, path, iface, method, params, reply_type,
+        flags, timeout, sc->cancellable, _on_shared_reply, sc);
+  }
+
+  if (params != NULL)
+    g_variant_unref(params);
+}
+
+GVariant *dispatch_call_finish(GObject *source, GAsyncResult *result,
+      GError **error)
+{
+  if (g_async_result_is_tagged(result, dispatch_call_shared))
+    return g_task_propagate_pointer(G_TASK(result), error);
+
+  return g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), result,
+        error);
+}
+
+EXPORT_API tapi_bool ofono_get_shared_call_stats(
+      struct ofono_shared_call_stats *stats)
+{
+  if (stats == NULL) {
+    tapi_error("Invalid parameter");
+    return FALSE;
+  }
+
+  g_mutex_lock(&s_shared_lock);
+  *stats = s_shared_stats;
+  g_mutex_unlock(&s_shared_lock);
+
+  return TRUE;
+}
+
+EXPORT_API tapi_bool ofono_dispatch_start_sharded(void *callback_context,
+      unsigned int shards)
+{
+  guint i;
+
+  tapi_debug("shards: %u", shards);
+
+  if (s_n_shards > 0) {
+    tapi_error("the dispatch thread is already running");
+    return FALSE;
+  }
+
+  if (shards == 0) {
+    tapi_error("invalid parameter");
+    return FALSE;
+  }
+
+  s_shards = g_new0(struct dispatch_shard, shards);
+  s_callback_context = callback_context ?
+        g_main_context_ref(callback_context) : NULL;
+
+  for (i = 0; i < shards; i++) {
+    struct dispatch_shard *shard = &s_shards[i];
+
+    shard->context = g_main_context_new();
+    shard->loop = g_main_loop_new(shard->context, FALSE);
+
+    shard->job_source = g_source_new(&job_source_funcs,
+          sizeof(struct job_source));
+    ((struct job_source *) shard->job_source)->shard = shard;
+    g_source_attach(shard->job_source, shard->context);
+  }
+
+  /* the shards are looked up without lock from now on */
+  s_n_shards = shards;
+
+  for (i = 0; i < shards; i++)
+    s_shards[i].thread = g_thread_new("ofono-dispatch", _dispatch_thread,
+          &s_shards[i]);
+
+  return TRUE;
+}
+
+EXPORT_API tapi_bool ofono_dispatch_start(void *callback_context)
+{
+  return ofono_dispatch_start_sharded(callback_context, 1);
+}
+
+static void _quit(gpointer data)
+{
+  struct dispatch_shard *shard = data;
+
+  g_main_loop_quit(shard->loop);
+}
+
+EXPORT_API void ofono_dispatch_stop()
+{
+  guint i;
+
+  tapi_debug("");
+
+  if (s_n_shards == 0 || _current_shard() != NULL) {
+    tapi_error("not running or called from the dispatch thread");
+    return;
+  }
+
+  for (i = 0; i < s_n_shards; i++) {
+    struct dispatch_shard *shard = &s_shards[i];
+
+    _job_push(shard, _quit, shard);
+    g_thread_join(shard->thread);
+  }
+
+  for (i = 0; i < s_n_shards; i++) {
+    struct dispatch_shard *shard = &s_shards[i];
+
+    g_source_destroy(shard->job_source);
+    g_source_unref(shard->job_source);
+    g_main_loop_unref(shard->loop);
+    g_main_context_unref(shard->context);
+
+    if (shard->conn != NULL)
+      g_object_unref(shard->conn);
+  }
+
+  s_n_shards = 0;
+  g_free(s_shards);
+  s_shards = NULL;
+
+  if (s_callback_context != NULL) {
+    g_main_context_unref(s_callback_context);
+    s_callback_context = NULL;
+  }
+}
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2013 Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include <stdio.h>
+#include <stdarg.h>
+#include <glib.h>
+
+#include "log.h"
+
+#if (TAPI_LOG_RING_SIZE & (TAPI_LOG_RING_SIZE - 1)) != 0
+#error "TAPI_LOG_RING_SIZE must be a power of 2"
+#endif
+
+struct log_slot {
+  gint seq; /* 2 * n + 1 while message n is written, 2 * n + 2 once done */
+  int level;
+  char msg[TAPI_LOG_MSG_SIZE];
+};
+
+static const char *level_tags[] = {
+  [TAPI_LOG_FATAL] = "<Fatal> ",
+  [TAPI_LOG_ERROR] = "<Error> ",
+  [TAPI_LOG_WARN] = "<Warn> ",
+  [TAPI_LOG_INFO] = "<",
+  [TAPI_LOG_DEBUG] = "<",
+};
+
+EXPORT_API int tapi_log_runtime_level = TAPI_LOG_DEBUG;
+
+static void _log_stdout(int level, const char *msg, void *user_data);
+
+static tapi_log_sink s_sink = _log_stdout;
+static void *s_sink_data;
+
+static struct log_slot s_ring[TAPI_LOG_RING_SIZE];
+static gint s_ring_head; /* number of messages ever written */
+
+static void _log_stdout(int level, const char *msg, void *user_data)
+{
+  printf("%s\n", msg);
+}
+
+EXPORT_API void tapi_log_set_level(int level)
+{
+  if (level < TAPI_LOG_NONE)
+    level = TAPI_LOG_NONE;
+  else if (level > TAPI_LOG_DEBUG)
+    level = TAPI_LOG_DEBUG;
+
+  g_atomic_int_set(&tapi_log_runtime_level, level);
+}
+
+EXPORT_API void tapi_log_set_sink(tapi_log_sink sink, void *user_data)
+{
+  if (sink == NULL) {
+    s_sink = _log_stdout;
+    s_sink_data = NULL;
+    return;
+  }
+
+  s_sink_data = user_data;
+  s_sink = sink;
+}
+
+EXPORT_API void tapi_log_write(int level, const char *file, const char *func,
+      int line, const char *fmt, ...)
+{
+  char msg[TAPI_LOG_MSG_SIZE];
+  va_list ap;
+  int len;
+
+  if (level <= TAPI_LOG_NONE || level > TAPI_LOG_DEBUG)
+    return;
+
+  len = snprintf(msg, sizeof(msg), "%s%s %s:%d> ", level_tags[level], file,
+        func, line);
+  if (len < 0)
+    return;
+
+  if (len < (int) sizeof(msg)) {
+    va_start(ap, fmt);
+    vsnprintf(msg + len, sizeof(msg) - len, fmt, ap);
+    va_end(ap);
+  }
+
+  s_sink(level, msg, s_sink_data);
+}
+
+EXPORT_API void tapi_log_write_bin(const void *bin, int size)
+{
+  const unsigned char *data = bin;
+  char msg[TAPI_LOG_MSG_SIZE];
+  int i, len = 0;
+
+  /* "XX " per byte, one message per full buffer */
+  for (i = 0; i < size; i++) {
+    if (len + 4 > (int) sizeof(msg)) {
+      s_sink(TAPI_LOG_DEBUG, msg, s_sink_data);
+      len = 0;
+    }
+
+    len += snprintf(msg + len, sizeof(msg) - len, "%02X ", data[i]);
+  }
+
+  if (len > 0)
+    s_sink(TAPI_LOG_DEBUG, msg, s_sink_data);
+}
+
+EXPORT_API void tapi_log_ring_sink(int level, const char *msg, void *user_data)
+{
+  struct log_slot *slot;
+  guint n;
+  gint seq;
+
+  n = (guint) g_atomic_int_add(&s_ring_head, 1);
+  slot = &s_ring[n & (TAPI_LOG_RING_SIZE - 1)];
+
+  /*
+   * A writer which has lapped the ring owns the slot, drop the message
+   * rather than mixing both of them.
+   */
+  seq = g_atomic_int_get(&slot->seq);
+  if ((seq & 1) || !g_atomic_int_compare_and_exchange(&slot->seq, seq,
+        (gint) (2 * n + 1)))
+    return;
+
+  slot->level = level;
+  g_strlcpy(slot->msg, msg, sizeof(slot->msg));
+
+  g_atomic_int_set(&slot->seq, (gint) (2 * n + 2));
+}
+
+EXPORT_API unsigned int tapi_log_ring_dump(tapi_log_sink sink,
+      void *user_data)
+{
+  char msg[TAPI_LOG_MSG_SIZE];
+  guint head, n, count;
+  unsigned int dumped = 0;
+
+  if (sink == NULL)
+    return 0;
+
+  head = (guint) g_atomic_int_get(&s_ring_head);
+  count = MIN(head, TAPI_LOG_RING_SIZE);
+
+  for (n = head - count; n != head; n++) {
+    struct log_slot *slot = &s_ring[n & (TAPI_LOG_RING_SIZE - 1)];
+    gint seq = (gint) (2 * n + 2);
+    int level;
+
+    /* still being written, or already overwritten */
+    if (g_atomic_int_get(&slot->seq) != seq)
+      continue;
+
+    level = slot->level;
+    g_strlcpy(msg, slot->msg, sizeof(msg));
+
+    if (g_atomic_int_get(&slot->seq) != seq)
+      continue;
+
+    sink(level, msg, user_data);
+    dumped++;
+  }
+
+  return dumped;
+}
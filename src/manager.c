@@ -0,0 +1,534 @@
+/*
+ * Copyright (C) 2013 Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include <string.h>
+
+#include "common.h"
+#include "log.h"
+#include "ofono-common.h"
+
+/*
+ * Registry of the modems exported by ofono: filled from the GetModems
+ * reply and kept up to date by ModemAdded, ModemRemoved and the modems'
+ * PropertyChanged, so neither the modem list nor the modem properties
+ * need another round trip.
+ */
+struct modem_entry {
+  gchar *path;
+  GHashTable *props; /* property name -> GVariant value */
+};
+
+struct modem_listener {
+  guint id;
+  modem_listener_cb cb;
+  void *user_data;
+  destroy_notify user_data_free_func;
+};
+
+static GMutex s_manager_lock;
+static GHashTable *s_modems; /* path -> struct modem_entry */
+static GPtrArray *s_modem_order; /* struct modem_entry, in ofono order */
+static guint s_watches[3]; /* ModemAdded, ModemRemoved, PropertyChanged */
+
+static GArray *s_listeners; /* struct modem_listener */
+static guint s_last_listener_id;
+
+/* listener installed by ofono_set_modems_changed_callback() */
+static guint s_modems_changed_listener;
+
+static void _modem_entry_free(gpointer data)
+{
+  struct modem_entry *entry = data;
+
+  g_hash_table_destroy(entry->props);
+  g_free(entry->path);
+  g_free(entry);
+}
+
+/* must be called with the manager lock held, "dict" is an a{sv} */
+static tapi_bool _modem_entry_add(const char *path, GVariant *dict)
+{
+  struct modem_entry *entry;
+  GVariantIter iter;
+  const gchar *key;
+  GVariant *value;
+
+  if (g_hash_table_contains(s_modems, path))
+    return FALSE;
+
+  entry = g_new0(struct modem_entry, 1);
+  entry->path = g_strdup(path);
+  entry->props = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+        (GDestroyNotify) g_variant_unref);
+
+  g_variant_iter_init(&iter, dict);
+  while (g_variant_iter_next(&iter, "{&sv}", &key, &value))
+    g_hash_table_insert(entry->props, g_strdup(key), value);
+
+  g_hash_table_insert(s_modems, entry->path, entry);
+  g_ptr_array_add(s_modem_order, entry);
+
+  return TRUE;
+}
+
+/* must be called with the manager lock held */
+static tapi_bool _modem_entry_remove(const char *path)
+{
+  struct modem_entry *entry;
+
+  entry = g_hash_table_lookup(s_modems, path);
+  if (entry == NULL)
+    return FALSE;
+
+  g_ptr_array_remove(s_modem_order, entry);
+  g_hash_table_remove(s_modems, path);
+
+  return TRUE;
+}
+
+static void _notify_listeners(const char *path, tapi_bool add)
+{
+  GArray *ids;
+  guint i, j;
+
+  ids = g_array_new(FALSE, FALSE, sizeof(guint));
+
+  g_mutex_lock(&s_manager_lock);
+  for (i = 0; s_listeners && i < s_listeners->len; i++)
+    g_array_append_val(ids,
+          g_array_index(s_listeners, struct modem_listener, i).id);
+  g_mutex_unlock(&s_manager_lock);
+
+  /* listeners may remove listeners, look each one up again before calling */
+  for (i = 0; i < ids->len; i++) {
+    modem_listener_cb cb = NULL;
+    void *user_data = NULL;
+
+    g_mutex_lock(&s_manager_lock);
+    for (j = 0; s_listeners && j < s_listeners->len; j++) {
+      struct modem_listener *l;
+
+      l = &g_array_index(s_listeners, struct modem_listener, j);
+      if (l->id == g_array_index(ids, guint, i)) {
+        cb = l->cb;
+        user_data = l->user_data;
+        break;
+      }
+    }
+    g_mutex_unlock(&s_manager_lock);
+
+    if (cb != NULL)
+      cb(path, add, user_data);
+  }
+
+  g_array_free(ids, TRUE);
+}
+
+static void _modem_added(GDBusConnection *conn,
+     const gchar *sender_name,
+     const gchar *object_path, const gchar *iface,
+     const gchar *signal_name, GVariant *parameters,
+     gpointer user_data)
+{
+  const gchar *path;
+  GVariant *dict;
+  tapi_bool added;
+
+  g_variant_get(parameters, "(&o@a{sv})", &path, &dict);
+
+  tapi_debug("modem added: %s", path);
+
+  g_mutex_lock(&s_manager_lock);
+  added = s_modems != NULL && _modem_entry_add(path, dict);
+  g_mutex_unlock(&s_manager_lock);
+
+  if (added)
+    _notify_listeners(path, TRUE);
+
+  g_variant_unref(dict);
+}
+
+static void _modem_removed(GDBusConnection *conn,
+     const gchar *sender_name,
+     const gchar *object_path, const gchar *iface,
+     const gchar *signal_name, GVariant *parameters,
+     gpointer user_data)
+{
+  const gchar *path;
+  tapi_bool removed;
+
+  g_variant_get(parameters, "(&o)", &path);
+
+  tapi_debug("modem removed: %s", path);
+
+  g_mutex_lock(&s_manager_lock);
+  removed = s_modems != NULL && _modem_entry_remove(path);
+  g_mutex_unlock(&s_manager_lock);
+
+  if (removed)
+    _notify_listeners(path, FALSE);
+}
+
+static void _modem_property_changed(GDBusConnection *conn,
+     const gchar *sender_name,
+     const gchar *object_path, const gchar *iface,
+     const gchar *signal_name, GVariant *parameters,
+     gpointer user_data)
+{
+  struct modem_entry *entry;
+  const gchar *key;
+  GVariant *value;
+
+  g_variant_get(parameters, "(&sv)", &key, &value);
+
+  g_mutex_lock(&s_manager_lock);
+
+  entry = s_modems ? g_hash_table_lookup(s_modems, object_path) : NULL;
+  if (entry != NULL)
+    g_hash_table_replace(entry->props, g_strdup(key), g_variant_ref(value));
+
+  g_mutex_unlock(&s_manager_lock);
+
+  g_variant_unref(value);
+}
+
+/* Returns FALSE if the registry is already started */
+static tapi_bool _manager_watch(GDBusConnection *conn)
+{
+  g_mutex_lock(&s_manager_lock);
+
+  if (s_modems != NULL) {
+    g_mutex_unlock(&s_manager_lock);
+    return FALSE;
+  }
+
+  s_modems = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+        _modem_entry_free);
+  s_modem_order = g_ptr_array_new();
+
+  /* subscribe first so that nothing is lost while GetModems is pending */
+  s_watches[0] = signal_watch_add(conn, OFONO_MANAGER_IFACE, "ModemAdded",
+        OFONO_MANAGER_PATH, FALSE, NULL, _modem_added, NULL);
+  s_watches[1] = signal_watch_add(conn, OFONO_MANAGER_IFACE, "ModemRemoved",
+        OFONO_MANAGER_PATH, FALSE, NULL, _modem_removed, NULL);
+  s_watches[2] = signal_watch_add(conn, OFONO_MODEM_IFACE, "PropertyChanged",
+        "/", TRUE, NULL, _modem_property_changed, NULL);
+
+  g_mutex_unlock(&s_manager_lock);
+
+  return TRUE;
+}
+
+/* merge the GetModems reply, "start" is when the registry was started */
+static void _manager_fill(GVariant *resp, gint64 start)
+{
+  GVariantIter *iter;
+  const gchar *path;
+  GVariant *dict;
+
+  g_mutex_lock(&s_manager_lock);
+
+  /* manager_stop() may have been called meanwhile */
+  if (s_modems != NULL) {
+    g_variant_get(resp, "(a(oa{sv}))", &iter);
+    while (g_variant_iter_next(iter, "(&o@a{sv})", &path, &dict)) {
+      /* a ModemAdded handled meanwhile is newer */
+      _modem_entry_add(path, dict);
+      g_variant_unref(dict);
+    }
+    g_variant_iter_free(iter);
+
+    tapi_info("%u modems registered in %" G_GINT64_FORMAT " us",
+          s_modem_order->len, g_get_monotonic_time() - start);
+  }
+
+  g_mutex_unlock(&s_manager_lock);
+}
+
+tapi_bool manager_start(GDBusConnection *conn)
+{
+  GError *error = NULL;
+  GVariant *resp;
+  gint64 start;
+
+  if (conn == NULL)
+    return FALSE;
+
+  start = g_get_monotonic_time();
+
+  if (!_manager_watch(conn))
+    return TRUE;
+
+  resp = g_dbus_connection_call_sync(conn, OFONO_SERVICE, OFONO_MANAGER_PATH,
+        OFONO_MANAGER_IFACE, "GetModems", NULL,
+        G_VARIANT_TYPE("(a(oa{sv}))"), G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+        &error);
+
+  if (resp == NULL) {
+    /* ofono may not run yet, ModemAdded will fill the registry */
+    tapi_warn("dbus call failed (%s)", error->message);
+    g_error_free(error);
+    return TRUE;
+  }
+
+  _manager_fill(resp, start);
+  g_variant_unref(resp);
+
+  return TRUE;
+}
+
+struct manager_start_data {
+  struct response_cb_data *cbd;
+  gint64 start;
+};
+
+static void _on_response_get_modems(GObject *obj, GAsyncResult *result,
+      gpointer user_data)
+{
+  struct manager_start_data *msd = user_data;
+  struct response_cb_data *cbd = msd->cbd;
+  GError *error = NULL;
+  GVariant *resp;
+
+  resp = g_dbus_connection_call_finish(G_DBUS_CONNECTION(obj), result, &error);
+  if (resp == NULL) {
+    /* same as manager_start(), ModemAdded will fill the registry */
+    tapi_warn("dbus call failed (%s)", error->message);
+    g_error_free(error);
+  } else {
+    _manager_fill(resp, msd->start);
+    g_variant_unref(resp);
+  }
+
+  CALL_RESP_CALLBACK(TAPI_RESULT_OK, NULL, cbd);
+  g_free(msd);
+}
+
+void manager_start_async(GDBusConnection *conn, response_cb cb,
+      void *user_data)
+{
+  struct manager_start_data *msd;
+  gint64 start;
+
+  if (conn == NULL) {
+    tapi_error("invalid parameter");
+    if (cb)
+      cb(TAPI_RESULT_INVALID_ARGS, NULL, user_data);
+    return;
+  }
+
+  start = g_get_monotonic_time();
+
+  if (!_manager_watch(conn)) {
+    if (cb)
+      cb(TAPI_RESULT_OK, NULL, user_data);
+    return;
+  }
+
+  msd = g_new0(struct manager_start_data, 1);
+  NEW_RSP_CB_DATA(msd->cbd, cb, user_data);
+  msd->start = start;
+
+  dispatch_call(conn, OFONO_SERVICE, OFONO_MANAGER_PATH,
+      OFONO_MANAGER_IFACE, "GetModems", NULL,
+      G_VARIANT_TYPE("(a(oa{sv}))"), G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      _on_response_get_modems, msd);
+}
+
+void manager_stop(void)
+{
+  guint i;
+
+  g_mutex_lock(&s_manager_lock);
+
+  if (s_modems == NULL) {
+    g_mutex_unlock(&s_manager_lock);
+    return;
+  }
+
+  for (i = 0; i < G_N_ELEMENTS(s_watches); i++) {
+    signal_watch_remove(s_watches[i]);
+    s_watches[i] = 0;
+  }
+
+  g_ptr_array_free(s_modem_order, TRUE);
+  s_modem_order = NULL;
+  g_hash_table_destroy(s_modems);
+  s_modems = NULL;
+
+  g_mutex_unlock(&s_manager_lock);
+}
+
+struct str_list *manager_get_modems(void)
+{
+  struct str_list *modems;
+  guint i;
+
+  modems = g_new0(struct str_list, 1);
+
+  g_mutex_lock(&s_manager_lock);
+
+  if (s_modem_order != NULL && s_modem_order->len > 0) {
+    modems->count = s_modem_order->len;
+    modems->data = g_new(char *, modems->count);
+    for (i = 0; i < s_modem_order->len; i++) {
+      struct modem_entry *entry = g_ptr_array_index(s_modem_order, i);
+      modems->data[i] = g_strdup(entry->path);
+    }
+  }
+
+  g_mutex_unlock(&s_manager_lock);
+
+  return modems;
+}
+
+gchar *manager_find_modem(const char *path)
+{
+  struct modem_entry *entry = NULL;
+  gchar *found = NULL;
+
+  g_mutex_lock(&s_manager_lock);
+
+  if (s_modems != NULL) {
+    if (path != NULL)
+      entry = g_hash_table_lookup(s_modems, path);
+    else if (s_modem_order->len > 0)
+      entry = g_ptr_array_index(s_modem_order, 0);
+  }
+
+  if (entry != NULL)
+    found = g_strdup(entry->path);
+
+  g_mutex_unlock(&s_manager_lock);
+
+  return found;
+}
+
+GVariant *manager_modem_properties(const char *path)
+{
+  struct modem_entry *entry;
+  GVariantBuilder builder;
+  GHashTableIter iter;
+  gpointer key, value;
+  GVariant *dict = NULL;
+
+  g_mutex_lock(&s_manager_lock);
+
+  entry = s_modems ? g_hash_table_lookup(s_modems, path) : NULL;
+  if (entry != NULL) {
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("a{sv}"));
+
+    g_hash_table_iter_init(&iter, entry->props);
+    while (g_hash_table_iter_next(&iter, &key, &value))
+      g_variant_builder_add(&builder, "{sv}", key, value);
+
+    dict = g_variant_ref_sink(g_variant_builder_end(&builder));
+  }
+
+  g_mutex_unlock(&s_manager_lock);
+
+  return dict;
+}
+
+EXPORT_API tapi_bool ofono_manager_has_modem(const char *modem)
+{
+  tapi_bool found;
+
+  if (modem == NULL)
+    return FALSE;
+
+  g_mutex_lock(&s_manager_lock);
+  found = s_modems != NULL && g_hash_table_contains(s_modems, modem);
+  g_mutex_unlock(&s_manager_lock);
+
+  return found;
+}
+
+EXPORT_API unsigned int ofono_manager_add_listener(modem_listener_cb cb,
+      void *user_data, destroy_notify user_data_free_func)
+{
+  struct modem_listener listener;
+
+  if (cb == NULL) {
+    tapi_error("invalid parameter");
+    return 0;
+  }
+
+  g_mutex_lock(&s_manager_lock);
+
+  if (s_listeners == NULL)
+    s_listeners = g_array_new(FALSE, FALSE, sizeof(struct modem_listener));
+
+  /* 0 means failure to the callers */
+  if (++s_last_listener_id == 0)
+    s_last_listener_id++;
+
+  listener.id = s_last_listener_id;
+  listener.cb = cb;
+  listener.user_data = user_data;
+  listener.user_data_free_func = user_data_free_func;
+  g_array_append_val(s_listeners, listener);
+
+  g_mutex_unlock(&s_manager_lock);
+
+  return listener.id;
+}
+
+EXPORT_API void ofono_manager_remove_listener(unsigned int id)
+{
+  struct modem_listener listener;
+  guint i;
+
+  g_mutex_lock(&s_manager_lock);
+
+  for (i = 0; s_listeners && i < s_listeners->len; i++) {
+    listener = g_array_index(s_listeners, struct modem_listener, i);
+    if (listener.id == id)
+      break;
+  }
+
+  if (s_listeners == NULL || i == s_listeners->len) {
+    g_mutex_unlock(&s_manager_lock);
+    tapi_warn("unknown modem listener %u", id);
+    return;
+  }
+
+  g_array_remove_index(s_listeners, i);
+
+  g_mutex_unlock(&s_manager_lock);
+
+  if (listener.user_data_free_func)
+    listener.user_data_free_func(listener.user_data);
+}
+
+static void _modems_changed(const char *modem, tapi_bool add, void *user_data)
+{
+  modems_changed_cb cb = (modems_changed_cb) user_data;
+
+  cb(modem, add);
+}
+
+EXPORT_API void ofono_set_modems_changed_callback(modems_changed_cb cb)
+{
+  if (!cb)
+    return;
+
+  if (s_modems_changed_listener)
+    ofono_manager_remove_listener(s_modems_changed_listener);
+
+  s_modems_changed_listener = ofono_manager_add_listener(_modems_changed,
+        (void *) cb, NULL);
+}
@@ -62,14 +62,39 @@ static void _on_response_dial(GObject *obj,
   g_free(path);
 }
 
+static struct str_list *_parse_ecc(GVariant *var_properties)
+{
+  struct str_list *ecc = NULL;
+  GVariantIter iter;
+  GVariant *dict, *var_val;
+  char *em;
+  int i = 0;
+
+  dict = g_variant_get_child_value(var_properties, 0);
+  var_val = g_variant_lookup_value(dict, "EmergencyNumbers",
+        G_VARIANT_TYPE_STRING_ARRAY);
+  g_variant_unref(dict);
+
+  if (var_val == NULL)
+    return NULL;
+
+  g_variant_iter_init(&iter, var_val);
+  ecc = g_malloc(sizeof(struct str_list));
+  ecc->count = g_variant_iter_n_children(&iter);
+  ecc->data = g_malloc(sizeof(char *) * ecc->count);
+  while(g_variant_iter_next(&iter, "s", &em)) {
+    ecc->data[i++] = em;
+    tapi_info("Ecc: %s", em);
+  }
+
+  g_variant_unref(var_val);
+  return ecc;
+}
+
 EXPORT_API tapi_bool ofono_call_get_ecc(struct ofono_modem *modem, struct str_list** ecc)
 {
   GError *error = NULL;
   GVariant *var_properties;
-  GVariantIter *iter;
-  char *key;
-  GVariant *var_val;
-  int i = 0;
 
   tapi_debug("");
 
@@ -95,44 +120,64 @@ EXPORT_API tapi_bool ofono_call_get_ecc(struct ofono_modem *modem, struct str_li
     return FALSE;
   }
 
-  g_variant_get(var_properties, "(a{sv})", &iter);
-  while (g_variant_iter_next(iter, "{sv}", &key, &var_val)) {
-    if (g_strcmp0(key, "EmergencyNumbers") == 0) {
-      GVariantIter iter;
-      char *em;
-      g_variant_iter_init(&iter, var_val);
-      *ecc = g_malloc(sizeof(struct str_list));
-      (*ecc)->count = g_variant_iter_n_children(&iter);
-      (*ecc)->data = g_malloc(sizeof(char *) * (*ecc)->count);
-      while(g_variant_iter_next(&iter, "s", &em)) {
-      	(*ecc)->data[i++] = em;
-        tapi_info("Ecc: %s", em);
-      }
-
-      g_free(key);
-      g_variant_unref(var_val);
-      break;
-    }
+  *ecc = _parse_ecc(var_properties);
 
-    g_free(key);
-    g_variant_unref(var_val);
-  }
-
-  g_variant_iter_free(iter);
   g_variant_unref(var_properties);
   return TRUE;
 }
 
-EXPORT_API void ofono_call_dial(struct ofono_modem *modem,
+static void _on_response_get_ecc(GObject *obj,
+                GAsyncResult *result, gpointer user_data)
+{
+  TResult ret;
+  GVariant *resp;
+  GError *error = NULL;
+  struct response_cb_data *cbd = user_data;
+  struct str_list *ecc;
+
+  resp = dispatch_call_finish(obj, result, &error);
+
+  CHECK_RESULT(ret, error, cbd, resp);
+
+  ecc = _parse_ecc(resp);
+
+  CALL_RESP_CALLBACK(ret, ecc, cbd);
+  ofono_string_list_free(ecc);
+  g_variant_unref(resp);
+}
+
+EXPORT_API ofono_request ofono_call_get_ecc_async(struct ofono_modem *modem,
+                response_cb cb, void *user_data)
+{
+  struct response_cb_data *cbd;
+  ofono_request id;
+
+  tapi_debug("");
+
+  CHECK_PARAMETERS(modem, cb, user_data);
+  NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
+
+  dispatch_call_shared(modem->conn, OFONO_SERVICE, modem->path,
+      OFONO_VOICECALL_MANAGER_IFACE, "GetProperties", NULL, NULL,
+      G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
+      _on_response_get_ecc, cbd);
+
+  return id;
+}
+
+EXPORT_API ofono_request ofono_call_dial(struct ofono_modem *modem,
                 char *number, enum clir_dev_status clir,
                 response_cb cb, void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
   GVariant *val;
   char *str_clir;
 
   CHECK_PARAMETERS(modem && number, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
   switch(clir) {
   case SS_CLIR_DEV_STATUS_ENABLED:
@@ -149,16 +194,19 @@ EXPORT_API void ofono_call_dial(struct ofono_modem *modem,
   tapi_debug("Numeber: %s, clir(%d): %s", number, clir, str_clir);
 
   val = g_variant_new("(ss)", number, str_clir);
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_VOICECALL_MANAGER_IFACE, "Dial", val, NULL,
-      G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       _on_response_dial, cbd);
+
+  return id;
 }
 
-EXPORT_API void ofono_call_answer(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_call_answer(struct ofono_modem *modem,
                 response_cb cb, void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
   struct ofono_calls calls;
   char *path;
 
@@ -166,150 +214,184 @@ EXPORT_API void ofono_call_answer(struct ofono_modem *modem,
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
   ofono_call_get_calls(modem, &calls);
 
   if (calls.count != 1) {
     tapi_warn("there should be only one incoming call");
-    return;
+    CALL_RESP_CALLBACK(TAPI_RESULT_FAIL, NULL, cbd);
+    return 0;
   }
 
   if (calls.calls[0].status != CALL_STATUS_INCOMING) {
     tapi_warn("there should be one incoming call");
-    return;
+    CALL_RESP_CALLBACK(TAPI_RESULT_FAIL, NULL, cbd);
+    return 0;
   }
 
   path = _call_id_to_path(modem, calls.calls[0].call_id);
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, path,
+  dispatch_call(modem->conn, OFONO_SERVICE, path,
       OFONO_VOICECALL_IFACE, "Answer", NULL, NULL,
-      G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       on_response_common, cbd);
 
   g_free(path);
+
+  return id;
 }
 
-EXPORT_API void ofono_call_release_specific(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_call_release_specific(struct ofono_modem *modem,
                 unsigned int call_id, response_cb cb,
                 void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
   char *path;
 
   tapi_debug("");
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
   path = _call_id_to_path(modem, call_id);
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, path,
+  dispatch_call(modem->conn, OFONO_SERVICE, path,
       OFONO_VOICECALL_IFACE, "Hangup", NULL, NULL,
-      G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       on_response_common, cbd);
 
   g_free(path);
+
+  return id;
 }
 
-EXPORT_API void ofono_call_release_all(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_call_release_all(struct ofono_modem *modem,
                 response_cb cb, void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
 
   tapi_debug("");
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_VOICECALL_MANAGER_IFACE, "HangupAll", NULL, NULL,
-      G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       on_response_common, cbd);
+
+  return id;
 }
 
-EXPORT_API void ofono_call_swap(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_call_swap(struct ofono_modem *modem,
                 response_cb cb, void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
 
   tapi_debug("");
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_VOICECALL_MANAGER_IFACE, "SwapCalls", NULL, NULL,
-      G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       on_response_common, cbd);
+
+  return id;
 }
 
-EXPORT_API void ofono_call_release_and_answer(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_call_release_and_answer(struct ofono_modem *modem,
                 response_cb cb, void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
 
   tapi_debug("");
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_VOICECALL_MANAGER_IFACE, "ReleaseAndAnswer", NULL,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       on_response_common, cbd);
+
+  return id;
 }
 
-EXPORT_API void ofono_call_release_and_swap(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_call_release_and_swap(struct ofono_modem *modem,
                 response_cb cb, void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
 
   tapi_debug("");
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_VOICECALL_MANAGER_IFACE, "ReleaseAndSwap", NULL,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       on_response_common, cbd);
+
+  return id;
 }
 
-EXPORT_API void ofono_call_hold_and_answer(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_call_hold_and_answer(struct ofono_modem *modem,
                 response_cb cb, void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
 
   tapi_debug("");
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_VOICECALL_MANAGER_IFACE, "HoldAndAnswer", NULL,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       on_response_common, cbd);
+
+  return id;
 }
 
-EXPORT_API void ofono_call_transfer(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_call_transfer(struct ofono_modem *modem,
                 response_cb cb, void *user_data)
 {
 
   struct response_cb_data *cbd;
+  ofono_request id;
 
   tapi_debug("");
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_VOICECALL_MANAGER_IFACE, "Transfer", NULL, NULL,
-      G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       on_response_common, cbd);
+
+  return id;
 }
 
-EXPORT_API void ofono_call_deflect(struct ofono_modem *modem, char *number,
+EXPORT_API ofono_request ofono_call_deflect(struct ofono_modem *modem, char *number,
                 response_cb cb, void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
   struct ofono_calls calls;
   GVariant *var;
   char *path;
@@ -318,6 +400,7 @@ EXPORT_API void ofono_call_deflect(struct ofono_modem *modem, char *number,
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
   tapi_debug("Number: %s", number);
 
@@ -325,7 +408,8 @@ EXPORT_API void ofono_call_deflect(struct ofono_modem *modem, char *number,
 
   if (calls.count <= 0) {
     tapi_error("no call exists");
-    return;
+    CALL_RESP_CALLBACK(TAPI_RESULT_FAIL, NULL, cbd);
+    return 0;
   }
 
   for (i = 0; i < calls.count; i++) {
@@ -338,56 +422,68 @@ EXPORT_API void ofono_call_deflect(struct ofono_modem *modem, char *number,
 
   if (call_id < 0) {
     tapi_error("no incoming or waiting call found");
-    return;
+    CALL_RESP_CALLBACK(TAPI_RESULT_FAIL, NULL, cbd);
+    return 0;
   }
 
   path = _call_id_to_path(modem, call_id);
   var = g_variant_new("(s)", number);
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, path,
+  dispatch_call(modem->conn, OFONO_SERVICE, path,
       OFONO_VOICECALL_MANAGER_IFACE, "Deflect", var, NULL,
-      G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       on_response_common, cbd);
 
   g_free(path);
+
+  return id;
 }
 
-EXPORT_API void ofono_call_create_multiparty(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_call_create_multiparty(struct ofono_modem *modem,
                 response_cb cb, void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
 
   tapi_debug("");
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_VOICECALL_MANAGER_IFACE, "CreateMultiparty", NULL,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       on_response_common, cbd);
+
+  return id;
 }
 
-EXPORT_API void ofono_call_hangup_multiparty(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_call_hangup_multiparty(struct ofono_modem *modem,
                 response_cb cb, void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
 
   tapi_debug("");
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_VOICECALL_MANAGER_IFACE, "HangupMultiparty", NULL,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       on_response_common, cbd);
+
+  return id;
 }
 
-EXPORT_API void ofono_call_private_chat(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_call_private_chat(struct ofono_modem *modem,
                 unsigned int call_id, response_cb cb,
                 void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
   char *path;
   GVariant *var;
 
@@ -395,44 +491,144 @@ EXPORT_API void ofono_call_private_chat(struct ofono_modem *modem,
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
   path = _call_id_to_path(modem, call_id);
   var = g_variant_new("(o)", path);
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_VOICECALL_MANAGER_IFACE, "PrivateChat", var,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       on_response_common, cbd);
 
   g_free(path);
+
+  return id;
 }
 
-EXPORT_API void ofono_call_send_tones(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_call_send_tones(struct ofono_modem *modem,
                 const gchar *tones, response_cb cb,
                 void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
   GVariant *val;
 
   CHECK_PARAMETERS(modem && tones, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
   tapi_debug("tones: %s", tones);
 
   val = g_variant_new("(s)", tones);
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_VOICECALL_MANAGER_IFACE, "SendTones", val, NULL,
-      G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       on_response_common, cbd);
+
+  return id;
+}
+
+enum call_key {
+  CALL_KEY_LINE_ID,
+  CALL_KEY_STATE,
+  CALL_KEY_NAME,
+  CALL_KEY_MULTIPARTY,
+  CALL_KEY_EMERGENCY,
+};
+
+static const struct str_map call_key_map[] = {
+  {"LineIdentification", CALL_KEY_LINE_ID},
+  {"State", CALL_KEY_STATE},
+  {"Name", CALL_KEY_NAME},
+  {"Multiparty", CALL_KEY_MULTIPARTY},
+  {"Emergency", CALL_KEY_EMERGENCY},
+  {NULL, 0}
+};
+
+static struct str_table call_key_table = STR_TABLE_INIT(call_key_map);
+
+void ofono_call_parse_property(struct ofono_call_info *info,
+                const char *key, GVariant *val)
+{
+  const char *str;
+
+  switch (str_table_lookup(&call_key_table, key, -1)) {
+  case CALL_KEY_LINE_ID:
+    str = g_variant_get_string(val, NULL);
+    g_strlcpy(info->line_id, str, sizeof(info->line_id));
+    tapi_debug("LineIdentification: %s", str);
+    break;
+  case CALL_KEY_STATE:
+    str = g_variant_get_string(val, NULL);
+    info->status = ofono_str_to_call_status(str);
+    tapi_debug("State: %s", str);
+    break;
+  case CALL_KEY_NAME:
+    str = g_variant_get_string(val, NULL);
+    g_strlcpy(info->name, str, sizeof(info->name));
+    tapi_debug("Name: %s", str);
+    break;
+  case CALL_KEY_MULTIPARTY:
+    g_variant_get(val, "b", &info->multiparty);
+    tapi_debug("Multiparty: %d", info->multiparty);
+    break;
+  case CALL_KEY_EMERGENCY:
+    g_variant_get(val, "b", &info->emergency);
+    tapi_debug("Emergency: %d", info->emergency);
+    break;
+  }
+}
+
+tapi_bool ofono_call_parse_calls(GVariant *result, struct ofono_calls *calls)
+{
+  GVariant *val, *list, *props;
+  GVariantIter iter, iter_val;
+  const char *path, *key;
+  struct ofono_call_info *p_call;
+
+  memset(calls, 0, sizeof(*calls));
+  list = g_variant_get_child_value(result, 0);
+  g_variant_iter_init(&iter, list);
+
+  calls->count = g_variant_iter_n_children(&iter);
+  if (calls->count == 0) {
+    tapi_debug("No call");
+    g_variant_unref(list);
+    return TRUE;
+  }
+
+  if (calls->count > MAX_CALL_PARTIES) {
+    tapi_error("too much calls: %d", calls->count);
+    calls->count = 0;
+    g_variant_unref(list);
+    return FALSE;
+  }
+
+  p_call = calls->calls;
+  while (g_variant_iter_loop(&iter, "(&o@a{sv})", &path, &props)) {
+    p_call->call_id = ofono_get_call_id_from_obj_path((char *) path);
+
+    g_variant_iter_init(&iter_val, props);
+    while (g_variant_iter_loop(&iter_val, "{&sv}", &key, &val))
+      ofono_call_parse_property(p_call, key, val);
+
+    tapi_debug("id: %d, status: %d, multiparty: %d, Emergency: %d",
+        p_call->call_id, p_call->status,
+        p_call->multiparty, p_call->emergency);
+
+    p_call++;
+  }
+  g_variant_unref(list);
+
+  return TRUE;
 }
 
 EXPORT_API tapi_bool ofono_call_get_calls(struct ofono_modem *modem,
                 struct ofono_calls *calls)
 {
   GError *error = NULL;
-  GVariant *result, *val;
-  GVariantIter *iter, *iter_val;
-  char *path, *key;
-  struct ofono_call_info *p_call;
+  GVariant *result;
+  tapi_bool ret;
 
   tapi_debug("");
 
@@ -452,61 +648,67 @@ EXPORT_API tapi_bool ofono_call_get_calls(struct ofono_modem *modem,
     return FALSE;
   }
 
-  g_variant_get(result, "(a(oa{sv}))", &iter);
+  ret = ofono_call_parse_calls(result, calls);
+  g_variant_unref(result);
 
-  calls->count = g_variant_iter_n_children(iter);
-  if (calls->count == 0) {
-    tapi_debug("No call");
-    g_variant_iter_free(iter);
-    g_variant_unref(result);
-    return TRUE;
-  }
+  return ret;
+}
 
-  if (calls->count > MAX_CALL_PARTIES) {
-    tapi_error("too much calls: %d", calls->count);
-    calls->count = 0;
-    g_variant_iter_free(iter);
-    g_variant_unref(result);
-    return FALSE;
-  }
+static void _on_response_get_calls(GObject *obj,
+                GAsyncResult *result, gpointer user_data)
+{
+  TResult ret;
+  GVariant *resp;
+  GError *error = NULL;
+  struct response_cb_data *cbd = user_data;
+  struct ofono_calls calls;
 
-  p_call = calls->calls;
-  while (g_variant_iter_loop(iter, "(oa{sv})", &path, &iter_val)) {
-    p_call->call_id = ofono_get_call_id_from_obj_path(path);
-
-    while (g_variant_iter_loop(iter_val, "{sv}", &key, &val)) {
-      if (g_strcmp0(key, "LineIdentification") == 0) {
-        const char *num;
-        num = g_variant_get_string(val, NULL);
-        g_strlcpy(p_call->line_id, num, sizeof(p_call->line_id));
-        tapi_debug("cli: %s", num);
-      } else if (g_strcmp0(key, "State") == 0) {
-        const char *str;
-        str = g_variant_get_string(val, NULL);
-        p_call->status = ofono_str_to_call_status(str);
-        tapi_debug("status: %s", str);
-      } else if (g_strcmp0(key, "Name") == 0) {
-        const char *name;
-        name = g_variant_get_string(val, NULL);
-        g_strlcpy(p_call->name, name, sizeof(p_call->name));
-        tapi_debug("name: %s", name);
-      } else if (g_strcmp0(key, "Multiparty") == 0) {
-        g_variant_get(val, "b", &p_call->multiparty);
-      } else if (g_strcmp0(key, "Emergency") == 0) {
-        g_variant_get(val, "b", &p_call->emergency);
-      }
-    }
+  resp = g_dbus_connection_call_finish(G_DBUS_CONNECTION(obj), result, &error);
 
-    tapi_debug("id: %d, status: %d, multiparty: %d, Emergency: %d",
-        p_call->call_id, p_call->status,
-        p_call->multiparty, p_call->emergency);
+  CHECK_RESULT(ret, error, cbd, resp);
 
-    p_call++;
+  if (!ofono_call_parse_calls(resp, &calls))
+    ret = TAPI_RESULT_FAIL;
+
+  CALL_RESP_CALLBACK(ret, &calls, cbd);
+  g_variant_unref(resp);
+}
+
+EXPORT_API ofono_request ofono_call_get_calls_async(struct ofono_modem *modem,
+                response_cb cb, void *user_data)
+{
+  struct response_cb_data *cbd;
+  ofono_request id;
+
+  tapi_debug("");
+
+  CHECK_PARAMETERS(modem, cb, user_data);
+  NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
+
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
+      OFONO_VOICECALL_MANAGER_IFACE, "GetCalls", NULL, NULL,
+      G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
+      _on_response_get_calls, cbd);
+
+  return id;
+}
+
+static void _parse_call_info(GVariant *var_properties,
+                struct ofono_call_info *info)
+{
+  GVariantIter iter;
+  const char *key;
+  GVariant *var_val, *props;
+
+  props = g_variant_get_child_value(var_properties, 0);
+  g_variant_iter_init(&iter, props);
+  while (g_variant_iter_next(&iter, "{&sv}", &key, &var_val)) {
+    ofono_call_parse_property(info, key, var_val);
+    g_variant_unref(var_val);
   }
-  g_variant_iter_free(iter);
-  g_variant_unref(result);
 
-  return TRUE;
+  g_variant_unref(props);
 }
 
 EXPORT_API tapi_bool ofono_call_get_call_info(struct ofono_modem *modem,
@@ -514,11 +716,7 @@ EXPORT_API tapi_bool ofono_call_get_call_info(struct ofono_modem *modem,
 {
   GError *error = NULL;
   GVariant *var_properties;
-  GVariantIter *iter;
-  char *key;
-  GVariant *var_val;
   char *path;
-  const char *val;
 
   tapi_debug("");
 
@@ -547,44 +745,195 @@ EXPORT_API tapi_bool ofono_call_get_call_info(struct ofono_modem *modem,
     return FALSE;
   }
 
-  g_variant_get(var_properties, "(a{sv})", &iter);
-  while (g_variant_iter_next(iter, "{sv}", &key, &var_val)) {
-    if (g_strcmp0(key, "LineIdentification") == 0) {
-      val = g_variant_get_string(var_val, NULL);
-      g_strlcpy(info->line_id, val, sizeof(info->line_id));
-      tapi_debug("LineIdentification: %s", val);
-    } else if (g_strcmp0(key, "State") == 0) {
-        val = g_variant_get_string(var_val, NULL);
-        info->status = ofono_str_to_call_status(val);
-    } else if (g_strcmp0(key, "Name") == 0) {
-        val = g_variant_get_string(var_val, NULL);
-        g_strlcpy(info->name, val, sizeof(info->name));
-        tapi_debug("Name %s", info->name);
-    } else if (g_strcmp0(key, "Multiparty") == 0) {
-        g_variant_get(var_val, "b", &info->multiparty);
-        tapi_debug("Multiparty: %d", info->multiparty);
-    } else if (g_strcmp0(key, "Emergency") == 0) {
-        g_variant_get(var_val, "b", &info->emergency);
-        tapi_debug("Emergency %d", info->emergency);
+  _parse_call_info(var_properties, info);
+  g_variant_unref(var_properties);
+
+  return TRUE;
+}
+
+static void _on_response_get_call_info(GObject *obj,
+                GAsyncResult *result, gpointer user_data)
+{
+  TResult ret;
+  GVariant *resp;
+  GError *error = NULL;
+  struct interm_response_cb_data *icbd = user_data;
+  struct response_cb_data *cbd = icbd->cbd;
+  struct ofono_call_info info;
+
+  resp = dispatch_call_finish(obj, result, &error);
+
+  memset(&info, 0, sizeof(info));
+  info.call_id = GPOINTER_TO_UINT(icbd->user_data);
+  g_free(icbd);
+
+  CHECK_RESULT(ret, error, cbd, resp);
+
+  _parse_call_info(resp, &info);
+
+  CALL_RESP_CALLBACK(ret, &info, cbd);
+  g_variant_unref(resp);
+}
+
+EXPORT_API ofono_request ofono_call_get_call_info_async(struct ofono_modem *modem,
+                unsigned int call_id, response_cb cb, void *user_data)
+{
+  struct response_cb_data *cbd;
+  ofono_request id;
+  struct interm_response_cb_data *icbd;
+  char *path;
+
+  tapi_debug("call_id: %d", call_id);
+
+  CHECK_PARAMETERS(modem, cb, user_data);
+  NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
+  NEW_INTERM_RSP_CB_DATA(icbd, cbd, modem, GUINT_TO_POINTER(call_id));
+
+  path = _call_id_to_path(modem, call_id);
+  dispatch_call_shared(modem->conn, OFONO_SERVICE, path,
+      OFONO_VOICECALL_IFACE, "GetProperties", NULL, NULL,
+      G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
+      _on_response_get_call_info, icbd);
+
+  g_free(path);
+
+  return id;
+}
+
+struct ofono_call_info *call_snapshot_update(struct ofono_modem *modem,
+                unsigned int call_id, const char *key, GVariant *val)
+{
+  struct ofono_call_info *info;
+
+  info = g_hash_table_lookup(modem->calls, GUINT_TO_POINTER(call_id));
+  if (info == NULL) {
+    info = g_new0(struct ofono_call_info, 1);
+    info->call_id = call_id;
+    g_hash_table_insert(modem->calls, GUINT_TO_POINTER(call_id), info);
+  }
+
+  if (key != NULL)
+    ofono_call_parse_property(info, key, val);
+
+  return info;
+}
+
+void call_snapshot_remove(struct ofono_modem *modem, unsigned int call_id)
+{
+  g_hash_table_remove(modem->calls, GUINT_TO_POINTER(call_id));
+}
+
+struct call_seed {
+  struct ofono_modem *modem; /* referenced */
+  call_snapshot_cb held_cb;
+};
+
+tapi_bool call_snapshot_hold(struct ofono_modem *modem, unsigned int call_id)
+{
+  if (modem->calls_held == NULL ||
+      g_hash_table_contains(modem->calls, GUINT_TO_POINTER(call_id)))
+    return FALSE;
+
+  g_hash_table_add(modem->calls_held, GUINT_TO_POINTER(call_id));
+  return TRUE;
+}
+
+/* noti lock held */
+static void _call_seed_done(struct ofono_modem *modem)
+{
+  if (--modem->calls_seeding > 0)
+    return;
+
+  /* the changes of the calls gone meanwhile are dropped */
+  g_hash_table_destroy(modem->calls_held);
+  modem->calls_held = NULL;
+}
+
+static void _on_response_seed_calls(GObject *obj,
+                GAsyncResult *result, gpointer user_data)
+{
+  struct call_seed *seed = user_data;
+  struct ofono_modem *modem = seed->modem;
+  struct ofono_call_info *info;
+  GError *error = NULL;
+  GVariant *resp, *val;
+  GVariantIter *iter, *iter_val;
+  const char *path, *key;
+  unsigned int call_id;
+
+  resp = g_dbus_connection_call_finish(G_DBUS_CONNECTION(obj), result, &error);
+  if (resp == NULL) {
+    /* cancelled means the modem has been released, don't touch it */
+    if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+      tapi_error("dbus call failed (%s)", error->message);
+
+      g_rec_mutex_lock(&modem->noti_lock);
+      _call_seed_done(modem);
+      g_rec_mutex_unlock(&modem->noti_lock);
     }
 
-    g_free(key);
-    g_variant_unref(var_val);
+    g_error_free(error);
+    modem_unref(modem);
+    g_free(seed);
+    return;
   }
 
+  g_rec_mutex_lock(&modem->noti_lock);
+
+  g_variant_get(resp, "(a(oa{sv}))", &iter);
+  while (g_variant_iter_loop(iter, "(&oa{sv})", &path, &iter_val)) {
+    call_id = ofono_get_call_id_from_obj_path((char *) path);
+
+    /* an entry created by a signal is newer than this reply */
+    if (g_hash_table_lookup(modem->calls, GUINT_TO_POINTER(call_id)))
+      continue;
+
+    info = call_snapshot_update(modem, call_id, NULL, NULL);
+    while (g_variant_iter_loop(iter_val, "{&sv}", &key, &val))
+      call_snapshot_update(modem, call_id, key, val);
+
+    /* the reply was sent after the held changes, it has them all */
+    if (g_hash_table_remove(modem->calls_held, GUINT_TO_POINTER(call_id)))
+      seed->held_cb(modem, info);
+  }
+
+  _call_seed_done(modem);
+
+  g_rec_mutex_unlock(&modem->noti_lock);
+
   g_variant_iter_free(iter);
-  g_variant_unref(var_properties);
+  g_variant_unref(resp);
 
-  return TRUE;
+  modem_unref(modem);
+  g_free(seed);
+}
+
+/* noti lock held */
+void call_snapshot_seed(struct ofono_modem *modem, call_snapshot_cb held_cb)
+{
+  struct call_seed *seed;
+
+  tapi_debug("");
+
+  if (modem->calls_held == NULL)
+    modem->calls_held = g_hash_table_new(g_direct_hash, g_direct_equal);
+  modem->calls_seeding++;
+
+  seed = g_new0(struct call_seed, 1);
+  seed->modem = modem_ref(modem);
+  seed->held_cb = held_cb;
+
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
+      OFONO_VOICECALL_MANAGER_IFACE, "GetCalls", NULL,
+      G_VARIANT_TYPE("(a(oa{sv}))"), G_DBUS_CALL_FLAGS_NONE, -1,
+      modem->cancellable, _on_response_seed_calls, seed);
 }
 
 EXPORT_API tapi_bool ofono_call_get_mute_status(struct ofono_modem *modem,
                 tapi_bool *muted)
 {
-  GError *error = NULL;
-  GVariant *var_properties;
-  GVariantIter *iter;
-  char *key;
+  GHashTable *props;
   GVariant *var_val;
 
   tapi_debug("");
@@ -599,64 +948,47 @@ EXPORT_API tapi_bool ofono_call_get_mute_status(struct ofono_modem *modem,
     return FALSE;
   }
 
-  var_properties = g_dbus_connection_call_sync(modem->conn,
-      OFONO_SERVICE, modem->path,
-      OFONO_CALL_VOLUME_IFACE,
-      "GetProperties", NULL, NULL,
-      G_DBUS_SEND_MESSAGE_FLAGS_NONE, -1, NULL, &error);
-
-  if (var_properties == NULL) {
-    tapi_error("dbus call failed (%s)", error->message);
-    g_error_free(error);
+  props = prop_cache_lock(modem, PROP_CACHE_CALL_VOL);
+  if (props == NULL)
     return FALSE;
-  }
-
-  g_variant_get(var_properties, "(a{sv})", &iter);
-  while (g_variant_iter_next(iter, "{sv}", &key, &var_val)) {
-    if (g_strcmp0(key, "Muted") == 0) {
-      g_variant_get(var_val, "b", muted);
-      tapi_debug("Muted: %d", *muted);
 
-      g_free(key);
-      g_variant_unref(var_val);
-      break;
-    }
-
-    g_free(key);
-    g_variant_unref(var_val);
+  var_val = g_hash_table_lookup(props, "Muted");
+  if (var_val != NULL) {
+    g_variant_get(var_val, "b", muted);
+    tapi_debug("Muted: %d", *muted);
   }
 
-  g_variant_iter_free(iter);
-  g_variant_unref(var_properties);
+  prop_cache_unlock(modem);
 
   return TRUE;
 }
 
-EXPORT_API void ofono_call_set_mute_status(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_call_set_mute_status(struct ofono_modem *modem,
                 tapi_bool mute, response_cb cb, void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
   GVariant *val;
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
   tapi_debug("Mute: %d", mute);
 
   val = g_variant_new("(sv)", "Muted", g_variant_new_boolean(mute));
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_CALL_VOLUME_IFACE, "SetProperty", val, NULL,
-      G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       on_response_common, cbd);
+
+  return id;
 }
 
 static tapi_bool ofono_call_get_volume(struct ofono_modem *modem,
                 const char *vol_name, unsigned char *vol)
 {
-  GError *error = NULL;
-  GVariant *var_properties;
-  GVariantIter *iter;
-  char *key;
+  GHashTable *props;
   GVariant *var_val;
 
   tapi_debug("");
@@ -671,35 +1003,17 @@ static tapi_bool ofono_call_get_volume(struct ofono_modem *modem,
     return FALSE;
   }
 
-  var_properties = g_dbus_connection_call_sync(modem->conn,
-      OFONO_SERVICE, modem->path,
-      OFONO_CALL_VOLUME_IFACE,
-      "GetProperties", NULL, NULL,
-      G_DBUS_SEND_MESSAGE_FLAGS_NONE, -1, NULL, &error);
-
-  if (var_properties == NULL) {
-    tapi_error("dbus call failed (%s)", error->message);
-    g_error_free(error);
+  props = prop_cache_lock(modem, PROP_CACHE_CALL_VOL);
+  if (props == NULL)
     return FALSE;
-  }
-
-  g_variant_get(var_properties, "(a{sv})", &iter);
-  while (g_variant_iter_next(iter, "{sv}", &key, &var_val)) {
-    if (g_strcmp0(key, vol_name) == 0) {
-      g_variant_get(var_val, "y", vol);
-      tapi_debug("Vol: %d", *vol);
 
-      g_free(key);
-      g_variant_unref(var_val);
-      break;
-    }
-
-    g_free(key);
-    g_variant_unref(var_val);
+  var_val = g_hash_table_lookup(props, vol_name);
+  if (var_val != NULL) {
+    g_variant_get(var_val, "y", vol);
+    tapi_debug("Vol: %d", *vol);
   }
 
-  g_variant_iter_free(iter);
-  g_variant_unref(var_properties);
+  prop_cache_unlock(modem);
 
   return TRUE;
 }
@@ -712,23 +1026,27 @@ EXPORT_API tapi_bool ofono_call_get_speaker_volume(struct ofono_modem *modem,
   return ofono_call_get_volume(modem, "SpeakerVolume", vol);
 }
 
-EXPORT_API void ofono_call_set_speaker_volume(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_call_set_speaker_volume(struct ofono_modem *modem,
                 unsigned char vol, response_cb cb, void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
   GVariant *val;
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
   tapi_debug("Speaker vol: %d", vol);
 
   val = g_variant_new("(sv)", "SpeakerVolume", g_variant_new("y", vol));
 
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_CALL_VOLUME_IFACE, "SetProperty", val, NULL,
-      G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       on_response_common, cbd);
+
+  return id;
 }
 
 EXPORT_API tapi_bool ofono_call_get_microphone_volume(struct ofono_modem *modem,
@@ -739,58 +1057,70 @@ EXPORT_API tapi_bool ofono_call_get_microphone_volume(struct ofono_modem *modem,
   return ofono_call_get_volume(modem, "MicrophoneVolume", vol);
 }
 
-EXPORT_API void ofono_call_set_microphone_volume(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_call_set_microphone_volume(struct ofono_modem *modem,
                 unsigned char vol, response_cb cb, void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
   GVariant *val;
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
   tapi_debug("Microphone vol: %d", vol);
 
   val = g_variant_new("(sv)", "MicrophoneVolume", g_variant_new("y", vol));
 
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_CALL_VOLUME_IFACE, "SetProperty", val, NULL,
-      G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       on_response_common, cbd);
+
+  return id;
 }
 
-EXPORT_API void ofono_call_set_volume_by_alsa(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_call_set_volume_by_alsa(struct ofono_modem *modem,
                 unsigned char vol, response_cb cb, void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
   GVariant *val;
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
   tapi_debug("Volume(alsa): %d", vol);
 
   val = g_variant_new("(y)", vol);
 
-  g_dbus_connection_call(modem->conn, OFONO_SERVER_SERVICE, "/",
+  dispatch_call(modem->conn, OFONO_SERVER_SERVICE, "/",
       "org.ofono.server.AudioSettings", "SetVolumeLev", val,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       on_response_common, cbd);
+
+  return id;
 }
 
-EXPORT_API void ofono_call_set_sound_path(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_call_set_sound_path(struct ofono_modem *modem,
                 const char *path, response_cb cb, void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
   GVariant *val;
 
   CHECK_PARAMETERS(modem && path, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
   tapi_debug("sound path: %s", path);
 
   val = g_variant_new("(s)", path);
-  g_dbus_connection_call(modem->conn, OFONO_SERVER_SERVICE, "/",
+  dispatch_call(modem->conn, OFONO_SERVER_SERVICE, "/",
       "org.ofono.server.AudioSettings", "EnablePCM", val,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       on_response_common, cbd);
+
+  return id;
 }
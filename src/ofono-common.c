@@ -33,46 +33,54 @@
 #define MAX_WATCHES_NUM 2
 
 static GDBusConnection *s_bus_conn = NULL;
-static guint s_modem_added_watch = 0;
-static guint s_modem_removed_watch = 0;
 
-static modems_changed_cb s_modems_changed_cb = NULL;
-
-struct ofono_api_map {
-  enum ofono_api api_bit;
-  const gchar *api_name;
+/* pending ofono_init_async() or ofono_modem_init_async() */
+struct init_waiter {
+  tapi_bool modem_init;
+  char *path; /* modem to init, NULL for the first one */
+  struct response_cb_data *cbd;
 };
 
-static const struct ofono_api_map OFONO_API_MAPS[] = {
-  {OFONO_API_SIM, OFONO_SIM_MANAGER_IFACE},
-  {OFONO_API_NETREG, OFONO_NETWORK_REGISTRATION_IFACE},
-  {OFONO_API_VOICE, OFONO_VOICECALL_MANAGER_IFACE},
-  {OFONO_API_MSG, OFONO_MESSAGE_MANAGER_IFACE},
-  {OFONO_API_MSG_WAITING, OFONO_MESSAGE_WAITING_IFACE},
-  {OFONO_API_SMART_MSG, OFONO_SMART_MESSAGE_IFACE},
-  {OFONO_API_STK, OFONO_STK_IFACE},
-  {OFONO_API_CALL_FW, OFONO_CALL_FORWARDING_IFACE},
-  {OFONO_API_CALL_VOL, OFONO_CALL_VOLUME_IFACE},
-  {OFONO_API_CALL_METER, OFONO_CALL_METER_IFACE},
-  {OFONO_API_CALL_SET, OFONO_CALL_SETTINGS_IFACE},
-  {OFONO_API_CALL_BAR, OFONO_CALL_BARRING_IFACE},
-  {OFONO_API_SUPPL_SERV, OFONO_SUPPLEMENTARY_SERVICES_IFACE},
-  {OFONO_API_TXT_TEL, OFONO_TEXT_TELEPHONY_IFACE},
-  {OFONO_API_CELL_BROAD, OFONO_CELL_BROADCAST_IFACE},
-  {OFONO_API_CONNMAN, OFONO_CONNMAN_IFACE},
-  {OFONO_API_PUSH_NOTIF, OFONO_PUSH_NOTIFICATION_IFACE},
-  {OFONO_API_PHONEBOOK, OFONO_PHONEBOOK_IFACE},
-  {OFONO_API_ASN, OFONO_GNSS_IFACE},
-  {OFONO_API_RADIO_SETTING, OFONO_RADIO_SETTINGS_IFACE},
-  {OFONO_API_NETMON, OFONO_NETMON_INTERFACE},
-  {OFONO_API_LTE, OFONO_LTE_INTERFACE},
-  {0, NULL},
+/* guards the init state below, the API may be called from any thread */
+static GMutex s_init_lock;
+/* not NULL while ofono_init_async() is in progress */
+static GCancellable *s_init_cancellable = NULL;
+static GSList *s_init_waiters = NULL;
+static gint64 s_init_start; /* monotonic, for the bring-up time log */
+
+static const struct str_map OFONO_API_MAPS[] = {
+  {OFONO_SIM_MANAGER_IFACE, OFONO_API_SIM},
+  {OFONO_NETWORK_REGISTRATION_IFACE, OFONO_API_NETREG},
+  {OFONO_VOICECALL_MANAGER_IFACE, OFONO_API_VOICE},
+  {OFONO_MESSAGE_MANAGER_IFACE, OFONO_API_MSG},
+  {OFONO_MESSAGE_WAITING_IFACE, OFONO_API_MSG_WAITING},
+  {OFONO_SMART_MESSAGE_IFACE, OFONO_API_SMART_MSG},
+  {OFONO_STK_IFACE, OFONO_API_STK},
+  {OFONO_CALL_FORWARDING_IFACE, OFONO_API_CALL_FW},
+  {OFONO_CALL_VOLUME_IFACE, OFONO_API_CALL_VOL},
+  {OFONO_CALL_METER_IFACE, OFONO_API_CALL_METER},
+  {OFONO_CALL_SETTINGS_IFACE, OFONO_API_CALL_SET},
+  {OFONO_CALL_BARRING_IFACE, OFONO_API_CALL_BAR},
+  {OFONO_SUPPLEMENTARY_SERVICES_IFACE, OFONO_API_SUPPL_SERV},
+  {OFONO_TEXT_TELEPHONY_IFACE, OFONO_API_TXT_TEL},
+  {OFONO_CELL_BROADCAST_IFACE, OFONO_API_CELL_BROAD},
+  {OFONO_CONNMAN_IFACE, OFONO_API_CONNMAN},
+  {OFONO_PUSH_NOTIFICATION_IFACE, OFONO_API_PUSH_NOTIF},
+  {OFONO_PHONEBOOK_IFACE, OFONO_API_PHONEBOOK},
+  {OFONO_GNSS_IFACE, OFONO_API_ASN},
+  {OFONO_RADIO_SETTINGS_IFACE, OFONO_API_RADIO_SETTING},
+  {OFONO_NETMON_INTERFACE, OFONO_API_NETMON},
+  {OFONO_LTE_INTERFACE, OFONO_API_LTE},
+  {NULL, 0},
 };
 
+static struct str_table api_table = STR_TABLE_INIT(OFONO_API_MAPS);
+
 struct noti_cb_data {
   noti_cb cb;
   void *user_data;
   destroy_notify user_data_free_func;
+  struct signal_filter *filter; /* OFONO_NOTI_SIGNAL_STRENTH_CHANGED only */
 };
 
 struct ofono_noti_data {
@@ -80,17 +88,17 @@ struct ofono_noti_data {
   enum ofono_noti noti;
   /* may need subscribe multiply signal for a notification */
   guint watches[MAX_WATCHES_NUM];
-  GList *cb_list;
+  GArray *cbs; /* struct noti_cb_data, in registration order */
+  guint dispatching; /* nesting depth of _notify() for this notification */
+  tapi_bool stale; /* cbs has entries unregistered during dispatch */
 };
 
-static GDBusConnection *_get_dbus_connection()
+/* no round trip, only reads the environment */
+static char *_get_dbus_address()
 {
   GError *error = NULL;
   char *addr;
 
-  if (s_bus_conn != NULL)
-    return s_bus_conn;
-
 #if !GLIB_CHECK_VERSION(2,35,0)
   g_type_init();
 #endif
@@ -99,9 +107,23 @@ static GDBusConnection *_get_dbus_connection()
   if (addr == NULL) {
     tapi_error("fail to get dbus addr: %s\n", error->message);
     g_free(error);
-    return NULL;
   }
 
+  return addr;
+}
+
+static GDBusConnection *_get_dbus_connection()
+{
+  GError *error = NULL;
+  char *addr;
+
+  if (s_bus_conn != NULL)
+    return s_bus_conn;
+
+  addr = _get_dbus_address();
+  if (addr == NULL)
+    return NULL;
+
   s_bus_conn = g_dbus_connection_new_for_address_sync(addr,
         G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
         G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION,
@@ -110,47 +132,17 @@ static GDBusConnection *_get_dbus_connection()
   if (s_bus_conn == NULL) {
     tapi_error("fail to create dbus connection: %s\n", error->message);
     g_free(error);
-  }
+  } else
+    dispatch_connect(addr);
+
+  g_free(addr);
 
   return s_bus_conn;
 }
 
 EXPORT_API struct str_list *ofono_get_modems()
 {
-  struct str_list *modems;
-  GError *error = NULL;
-  GVariant *var_resp, *var_val;
-  GVariantIter *iter;
-  char *path;
-  int i = 0;
-
-  modems = g_malloc(sizeof(struct str_list));
-  modems->count = 0;
-  modems->data = NULL;
-
-  var_resp = g_dbus_connection_call_sync(s_bus_conn,
-          OFONO_SERVICE, OFONO_MANAGER_PATH,
-          OFONO_MANAGER_IFACE, "GetModems", NULL, NULL,
-          G_DBUS_SEND_MESSAGE_FLAGS_NONE, -1, NULL, &error);
-
-  if (var_resp == NULL) {
-    tapi_error("dbus call failed (%s)", error->message);
-    g_error_free(error);
-    return modems;
-  }
-
-  g_variant_get(var_resp, "(a(oa{sv}))", &iter);
-  modems->count = g_variant_iter_n_children(iter);
-  modems->data = g_malloc(sizeof(char *) * modems->count);
-  while (g_variant_iter_next(iter, "(o@a{sv})", &path, &var_val)) {
-    modems->data[i++] = path;
-    g_variant_unref(var_val);
-  }
-
-  g_variant_iter_free(iter);
-  g_variant_unref(var_resp);
-
-  return modems;
+  return manager_get_modems();
 }
 
 EXPORT_API void ofono_string_list_free(struct str_list *list)
@@ -177,35 +169,53 @@ static guint32 _modem_interfaces_extract(GVariant *array)
 
   g_variant_iter_init(&iter, array);
   while ((value = g_variant_iter_next_value(&iter)) != NULL) {
-    const struct ofono_api_map *maps;
     const gchar *iface = g_variant_get_string(value, NULL);
+    int api;
 
     tapi_info("Interface: %s", iface);
 
-    for (maps = OFONO_API_MAPS; maps->api_name != NULL; maps++) {
-      if (g_strcmp0(iface, maps->api_name) == 0) {
-        interfaces |= (1 << maps->api_bit);
-        break;
-      }
-    }
+    api = str_table_lookup(&api_table, iface, -1);
+    if (api >= 0)
+      interfaces |= (1 << api);
+
     g_variant_unref(value);
   }
 
   return interfaces;
 }
 
+enum modem_key {
+  MODEM_KEY_POWERED,
+  MODEM_KEY_ONLINE,
+  MODEM_KEY_INTERFACES,
+};
+
+static const struct str_map modem_key_map[] = {
+  {"Powered", MODEM_KEY_POWERED},
+  {"Online", MODEM_KEY_ONLINE},
+  {"Interfaces", MODEM_KEY_INTERFACES},
+  {NULL, 0}
+};
+
+static struct str_table modem_key_table = STR_TABLE_INIT(modem_key_map);
+
 static void _update_modem_property(struct ofono_modem *modem,
      const gchar *key, GVariant *value)
 {
-  if (g_strcmp0(key, "Powered") == 0) {
+  switch (str_table_lookup(&modem_key_table, key, -1)) {
+  case MODEM_KEY_POWERED:
     modem->powered = g_variant_get_boolean(value);
     tapi_debug("modem: %s Powered %hhu", modem->path, modem->powered);
-  } else if (g_strcmp0(key, "Online") == 0) {
+    break;
+  case MODEM_KEY_ONLINE:
     modem->online = g_variant_get_boolean(value);
     tapi_debug("modem: %s Online %hhu", modem->path, modem->online);
-  } else if (g_strcmp0(key, "Interfaces") == 0) {
+    break;
+  case MODEM_KEY_INTERFACES:
     modem->interfaces = _modem_interfaces_extract(value);
     tapi_debug("modem: %s Interfaces 0x%02x", modem->path, modem->interfaces);
+    prop_cache_interfaces_changed(modem);
+    break;
   }
 }
 
@@ -215,29 +225,42 @@ static void _modem_property_changed(GDBusConnection *conn,
      const gchar *signal_name, GVariant *parameters,
      gpointer data)
 {
-  gchar *key;
+  const gchar *key;
   GVariant *value;
   struct ofono_modem *modem = data;
 
   tapi_debug("");
 
-  g_variant_get(parameters, "(sv)", &key, &value);
+  g_variant_get(parameters, "(&sv)", &key, &value);
+  prop_cache_update(modem, PROP_CACHE_MODEM, key, value);
   _update_modem_property(modem, key, value);
 
   g_variant_unref(value);
-  g_free(key);
 }
 
 static void _modem_update_properties(struct ofono_modem *modem)
 {
   GError *error = NULL;
 
-  GVariantIter *iter;
-  GVariant *ret, *value;
-  gchar *key;
+  GVariantIter *iter, dict_iter;
+  GVariant *ret, *value, *dict;
+  const gchar *key;
 
   tapi_debug("");
 
+  /* the registry already has them from GetModems or ModemAdded */
+  ret = manager_modem_properties(modem->path);
+  if (ret != NULL) {
+    prop_cache_fill(modem, PROP_CACHE_MODEM, ret);
+
+    g_variant_iter_init(&dict_iter, ret);
+    while (g_variant_iter_loop(&dict_iter, "{&sv}", &key, &value))
+      _update_modem_property(modem, key, value);
+
+    g_variant_unref(ret);
+    return;
+  }
+
   ret = g_dbus_connection_call_sync(modem->conn, OFONO_SERVICE,
         modem->path,
         OFONO_MODEM_IFACE,
@@ -253,98 +276,289 @@ static void _modem_update_properties(struct ofono_modem *modem)
     return;
   }
 
+  dict = g_variant_get_child_value(ret, 0);
+  prop_cache_fill(modem, PROP_CACHE_MODEM, dict);
+  g_variant_unref(dict);
+
   g_variant_get(ret, "(a{sv})", &iter);
-  while (g_variant_iter_loop(iter, "{sv}", &key, &value))
+  while (g_variant_iter_loop(iter, "{&sv}", &key, &value))
     _update_modem_property(modem, key, value);
 
   g_variant_iter_free(iter);
   g_variant_unref(ret);
 }
 
-EXPORT_API struct ofono_modem *ofono_modem_init(const char *obj_path)
+#define SMS_BATCH_WINDOW 200 /* ms */
+#define SMS_BATCH_MAX_COUNT 32
+
+/*
+ * Incoming messages waiting for OFONO_NOTI_INCOMING_SMS_BATCH. Shared with
+ * the window timers, which may fire after the modem is gone.
+ */
+struct sms_batch_state {
+  gint refs;
+  GRecMutex lock; /* held while the batch is notified */
+  struct ofono_modem *modem; /* NULL once deinitialized */
+  unsigned int window;
+  unsigned int max_count;
+  GArray *messages; /* struct ofono_sms_incoming_noti, strings owned */
+  guint generation; /* bumped by every flush */
+  tapi_bool timer; /* a timer is armed for this generation */
+};
+
+struct sms_batch_timer {
+  struct sms_batch_state *state;
+  guint generation;
+};
+
+static struct sms_batch_state *_sms_batch_new(struct ofono_modem *modem)
+{
+  struct sms_batch_state *state;
+
+  state = g_new0(struct sms_batch_state, 1);
+  state->refs = 1;
+  g_rec_mutex_init(&state->lock);
+  state->modem = modem;
+  state->window = SMS_BATCH_WINDOW;
+  state->max_count = SMS_BATCH_MAX_COUNT;
+  state->messages = g_array_new(FALSE, FALSE,
+        sizeof(struct ofono_sms_incoming_noti));
+
+  return state;
+}
+
+static void _sms_batch_clear(GArray *messages)
+{
+  struct ofono_sms_incoming_noti *msg;
+  guint i;
+
+  for (i = 0; i < messages->len; i++) {
+    msg = &g_array_index(messages, struct ofono_sms_incoming_noti, i);
+    g_free(msg->sender);
+    g_free(msg->message);
+  }
+
+  g_array_set_size(messages, 0);
+}
+
+static void _sms_batch_unref(struct sms_batch_state *state)
+{
+  if (!g_atomic_int_dec_and_test(&state->refs))
+    return;
+
+  _sms_batch_clear(state->messages);
+  g_array_free(state->messages, TRUE);
+  g_rec_mutex_clear(&state->lock);
+  g_free(state);
+}
+
+/* the modem is going away, the pending messages are dropped */
+static void _sms_batch_release(struct sms_batch_state *state)
+{
+  g_rec_mutex_lock(&state->lock);
+  state->modem = NULL;
+  state->generation++;
+  _sms_batch_clear(state->messages);
+  g_rec_mutex_unlock(&state->lock);
+
+  _sms_batch_unref(state);
+}
+
+/*
+ * Signal strength filters, see ofono_network_set_signal_filter(). The
+ * filters are kept with their callback, this is shared with the timers
+ * passing the held back values on, which may fire after the modem is gone.
+ */
+struct signal_state {
+  gint refs;
+  GRecMutex lock; /* held while a held back value is notified */
+  struct ofono_modem *modem; /* NULL once deinitialized */
+  /* the fields below are protected by the noti_lock of the modem */
+  guint timer_seq;
+  struct ofono_signal_filter_stats stats;
+};
+
+struct signal_filter {
+  struct ofono_signal_filter options;
+  tapi_bool started; /* a value has been passed on */
+  int ewma; /* smoothed strength, 8 bits fraction */
+  unsigned int value; /* last value passed on */
+  gint64 time; /* when it was, monotonic */
+  tapi_bool pending; /* "pending_value" waits for the end of min_interval */
+  unsigned int pending_value;
+  guint timer; /* id of the armed timer, 0 if none */
+};
+
+struct signal_timer {
+  struct signal_state *state;
+  noti_cb cb;
+  guint id;
+};
+
+static struct signal_state *_signal_state_new(struct ofono_modem *modem)
+{
+  struct signal_state *state;
+
+  state = g_new0(struct signal_state, 1);
+  state->refs = 1;
+  g_rec_mutex_init(&state->lock);
+  state->modem = modem;
+
+  return state;
+}
+
+static void _signal_state_unref(struct signal_state *state)
+{
+  if (!g_atomic_int_dec_and_test(&state->refs))
+    return;
+
+  g_rec_mutex_clear(&state->lock);
+  g_free(state);
+}
+
+/* the modem is going away, the held back values are dropped */
+static void _signal_state_release(struct signal_state *state)
+{
+  g_rec_mutex_lock(&state->lock);
+  state->modem = NULL;
+  g_rec_mutex_unlock(&state->lock);
+
+  _signal_state_unref(state);
+}
+
+/* "path" is taken over */
+static struct ofono_modem *_modem_new(gchar *path)
 {
-  struct str_list *modems = ofono_get_modems();
   struct ofono_modem *modem;
 
+  modem = g_new0(struct ofono_modem, 1);
+
+  modem->refs = 1;
+  modem->path = path;
+  /* kept even if the connection is closed and replaced meanwhile */
+  modem->conn = dispatch_connection(s_bus_conn, path);
+  modem->cancellable = g_cancellable_new();
+  g_rec_mutex_init(&modem->noti_lock);
+  modem->calls = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+        NULL, g_free);
+  prop_cache_init(modem);
+  sms_tracker_init(modem);
+  network_scan_init(modem);
+  modem->sms_batch = _sms_batch_new(modem);
+  modem->signal = _signal_state_new(modem);
+
+  modem->prop_changed_watch = signal_watch_add_full(modem->conn,
+        OFONO_MODEM_IFACE, "PropertyChanged", modem->path, FALSE, NULL,
+        _modem_property_changed, modem, (GBoxedCopyFunc) modem_ref,
+        (GDestroyNotify) modem_unref);
+
+  _modem_update_properties(modem);
+
+  return modem;
+}
+
+EXPORT_API struct ofono_modem *ofono_modem_init(const char *obj_path)
+{
+  gchar *path;
+
   tapi_debug("");
-  if (modems->count <= 0) {
-    tapi_warn("There is no modem");
-    return NULL;
-  }
 
   if (s_bus_conn == NULL) {
     tapi_error("Fail to get dbus connection");
     return NULL;
   }
 
-  if (obj_path == NULL)
-    obj_path = modems->data[0];
-  else {
-    int i;
-    tapi_bool found;
-    for (i = 0; i < modems->count; i++) {
-      if (modems->data[i] == NULL) {
-        tapi_error("it's abnormal");
-        continue;
-      }
-
-      if (g_strcmp0(modems->data[i], obj_path) == 0) {
-      	found = TRUE;
-        break;
-      }
-    }
-    if (!found) {
+  /* NULL selects the first modem */
+  path = manager_find_modem(obj_path);
+  if (path == NULL) {
+    if (obj_path == NULL)
+      tapi_warn("There is no modem");
+    else
       tapi_error("Don't find modem: %s", obj_path);
-      return NULL;
-    }
+    return NULL;
   }
 
-  modem = g_new0(struct ofono_modem, 1);
+  return _modem_new(path);
+}
 
-  modem->path = g_strdup(obj_path);
-  modem->conn = s_bus_conn;
+/*
+ * Create the modem and start fetching the properties of its interfaces in
+ * parallel, the getters then find them in the cache.
+ */
+static struct ofono_modem *_modem_init_lookup(const char *obj_path)
+{
+  struct ofono_modem *modem;
+  gchar *path;
+  int i;
 
-  modem->prop_changed_watch = g_dbus_connection_signal_subscribe(
-        modem->conn,
-        OFONO_SERVICE,
-        OFONO_MODEM_IFACE,
-        "PropertyChanged",
-        modem->path,
-        NULL,
-        G_DBUS_SIGNAL_FLAGS_NONE,
-        _modem_property_changed,
-        modem,
-        NULL);
+  path = manager_find_modem(obj_path);
+  if (path == NULL) {
+    tapi_error("Don't find modem: %s", obj_path ? obj_path : "(first)");
+    return NULL;
+  }
 
-  _modem_update_properties(modem);
+  modem = _modem_new(path);
+
+  for (i = 0; i < PROP_CACHE_MAX; i++)
+    prop_cache_prefetch(modem, i);
 
   return modem;
 }
 
-static void _noti_data_free(gpointer data)
+/* unsubscribe the signals and drop the handle, callbacks must be gone */
+static void _noti_data_release(struct ofono_modem *modem,
+      struct ofono_noti_data *nd)
 {
-  GList *list;
-  struct ofono_noti_data *nd = data;
+  int i;
 
-  tapi_debug("");
+  for (i = 0; i < MAX_WATCHES_NUM; i++)
+    signal_watch_remove(nd->watches[i]);
 
-  if (nd == NULL)
-    return;
+  modem->noti[nd->noti] = NULL;
+
+  g_array_free(nd->cbs, TRUE);
+  g_free(nd);
+}
 
-  for (list = nd->cb_list; list; list = g_list_next(list)) {
-    struct noti_cb_data *cbd = list->data;
+static void _noti_data_free(struct ofono_modem *modem,
+      struct ofono_noti_data *nd)
+{
+  guint i;
+
+  tapi_debug("");
 
-    if (cbd != NULL && cbd->user_data_free_func)
+  for (i = 0; i < nd->cbs->len; i++) {
+    struct noti_cb_data *cbd = &g_array_index(nd->cbs, struct noti_cb_data, i);
+
+    if (cbd->cb != NULL && cbd->user_data_free_func)
       cbd->user_data_free_func(cbd->user_data);
+    g_free(cbd->filter);
   }
 
-  g_list_free(nd->cb_list);
-  g_free(nd);
+  _noti_data_release(modem, nd);
+}
+
+/* drop the entries unregistered while the notification was dispatched */
+static void _noti_data_compact(struct ofono_modem *modem,
+      struct ofono_noti_data *nd)
+{
+  guint i = 0;
+
+  while (i < nd->cbs->len) {
+    if (g_array_index(nd->cbs, struct noti_cb_data, i).cb == NULL)
+      g_array_remove_index(nd->cbs, i);
+    else
+      i++;
+  }
+
+  nd->stale = FALSE;
+
+  if (nd->cbs->len == 0)
+    _noti_data_release(modem, nd);
 }
 
 EXPORT_API void ofono_modem_deinit(struct ofono_modem *modem)
 {
-  GList *list;
   int i;
 
   tapi_debug("");
@@ -352,170 +566,202 @@ EXPORT_API void ofono_modem_deinit(struct ofono_modem *modem)
   if (modem == NULL)
     return;
 
-  g_dbus_connection_signal_unsubscribe(s_bus_conn, modem->prop_changed_watch);
+  signal_watch_remove(modem->prop_changed_watch);
+  /* waits for a batch being notified */
+  _sms_batch_release(modem->sms_batch);
+  /* waits for a held back signal strength being notified */
+  _signal_state_release(modem->signal);
 
-  for (list = modem->noti_list; list; list = g_list_next(list)) {
-    struct ofono_noti_data *nd = list->data;
+  g_rec_mutex_lock(&modem->noti_lock);
+  for (i = 0; i < OFONO_NOTI_MAX; i++) {
+    if (modem->noti[i] != NULL)
+      _noti_data_free(modem, modem->noti[i]);
+  }
+  g_rec_mutex_unlock(&modem->noti_lock);
 
-    if (nd == NULL)
-      continue;
+  prop_cache_unwatch(modem);
 
-    for (i = 0; i < MAX_WATCHES_NUM; i++) {
-      if (nd->watches[i] > 0)
-        g_dbus_connection_signal_unsubscribe(modem->conn, nd->watches[i]);
-    }
-  }
+  /* pending internal calls must not touch the modem any more */
+  g_cancellable_cancel(modem->cancellable);
+
+  network_scan_deinit(modem);
+
+  /* handlers running on the dispatch thread may still hold it */
+  modem_unref(modem);
+}
+
+struct ofono_modem *modem_ref(struct ofono_modem *modem)
+{
+  g_atomic_int_inc(&modem->refs);
+
+  return modem;
+}
+
+void modem_unref(struct ofono_modem *modem)
+{
+  if (!g_atomic_int_dec_and_test(&modem->refs))
+    return;
+
+  g_object_unref(modem->cancellable);
+  g_object_unref(modem->conn);
+
+  prop_cache_deinit(modem);
+  sms_tracker_deinit(modem);
+  g_hash_table_destroy(modem->calls);
+  if (modem->calls_held != NULL)
+    g_hash_table_destroy(modem->calls_held);
+  g_rec_mutex_clear(&modem->noti_lock);
 
   g_free(modem->path);
-  g_list_free_full(modem->noti_list, _noti_data_free);
   g_free(modem);
 }
 
-static struct ofono_noti_data *_find_noti_data(GList *list,
+static struct ofono_noti_data *_find_noti_data(struct ofono_modem *modem,
      enum ofono_noti noti)
 {
-  struct ofono_noti_data *noti_data;
+  if ((unsigned int) noti >= OFONO_NOTI_MAX)
+    return NULL;
 
-  for(; list; list = g_list_next(list)) {
-    noti_data = list->data;
+  return modem->noti[noti];
+}
 
-    if (noti_data == NULL)
-      continue;
+/* return the index of cb in the callback vector, -1 if not found */
+static int _find_noti_cb_data(struct ofono_noti_data *data, noti_cb cb)
+{
+  guint i;
 
-    if (noti_data->noti == noti)
-      return noti_data;
+  for (i = 0; i < data->cbs->len; i++) {
+    if (g_array_index(data->cbs, struct noti_cb_data, i).cb == cb)
+      return i;
   }
 
-  return NULL;
+  return -1;
 }
 
-static struct noti_cb_data *_find_noti_cb_data(
-     struct ofono_noti_data *data,
-     noti_cb cb)
+static gboolean _on_signal_timeout(gpointer data);
+
+/*
+ * Runs "strength" through the filter of "ncbd", with the noti_lock held.
+ * Returns FALSE if it isn't passed on now, "value" is the one to pass.
+ */
+static tapi_bool _signal_filter_apply(struct ofono_modem *modem,
+      struct noti_cb_data *ncbd, unsigned int strength, unsigned int *value)
 {
-  struct noti_cb_data *cb_data;
-  GList *list;
+  struct signal_state *state = modem->signal;
+  struct signal_filter *f = ncbd->filter;
+  struct signal_timer *timer;
+  unsigned int v, delta;
+  gint64 now, elapsed;
 
-  tapi_debug("");
+  *value = strength;
 
-  if (data == NULL)
-    return NULL;
+  if (f == NULL) {
+    state->stats.delivered++;
+    return TRUE;
+  }
 
-  for (list = data->cb_list; list; list = g_list_next(list)) {
-    cb_data = list->data;
+  if (!f->started || strength == 0 || f->options.smoothing == 0)
+    f->ewma = strength << 8;
+  else
+    f->ewma += (((int) strength << 8) - f->ewma) *
+          (int) f->options.smoothing / 100;
+
+  v = (f->ewma + 128) >> 8;
+  delta = v > f->value ? v - f->value : f->value - v;
+  now = g_get_monotonic_time();
+  elapsed = (now - f->time) / 1000;
+
+  /* within the hysteresis band of the value passed on */
+  if (f->started &&
+      (delta == 0 || (strength != 0 && delta < f->options.min_delta))) {
+    f->pending = FALSE;
+    state->stats.suppressed++;
+    return FALSE;
+  }
 
-    if (cb_data == NULL)
-      continue;
+  if (!f->started || strength == 0 || elapsed >= f->options.min_interval) {
+    f->started = TRUE;
+    f->value = v;
+    f->time = now;
+    f->pending = FALSE;
+    state->stats.delivered++;
+    *value = v;
+    return TRUE;
+  }
 
-    if (cb_data->cb == cb)
-      return cb_data;
+  /* the last change of the interval is passed on at its end */
+  f->pending = TRUE;
+  f->pending_value = v;
+  state->stats.suppressed++;
+
+  if (f->timer == 0) {
+    /* 0 stands for no timer */
+    if (++state->timer_seq == 0)
+      state->timer_seq++;
+    f->timer = state->timer_seq;
+
+    timer = g_new(struct signal_timer, 1);
+    timer->state = state;
+    timer->cb = ncbd->cb;
+    timer->id = f->timer;
+    g_atomic_int_inc(&state->refs);
+
+    dispatch_timeout_add(modem->conn,
+          (guint) (f->options.min_interval - elapsed),
+          _on_signal_timeout, timer);
   }
 
-  return NULL;
+  return FALSE;
 }
 
 static void _notify(struct ofono_modem *modem, void *data,
      enum ofono_noti noti)
 {
-  GList *list;
   struct ofono_noti_data *nd;
   struct noti_cb_data *ncbd;
+  unsigned int value;
+  void *payload;
+  guint i;
 
   tapi_debug("");
 
-  nd = _find_noti_data(modem->noti_list, noti);
-  if (nd == NULL)
-    return;
-
-  for (list = nd->cb_list; list; list = g_list_next(list)) {
-    ncbd = list->data;
-
-    if (ncbd == NULL) {
-      tapi_warn("there is an empty callback data record");
-      continue;
-    }
+  g_rec_mutex_lock(&modem->noti_lock);
 
-    if (ncbd->cb)
-      ncbd->cb(noti, data, ncbd->user_data);
+  nd = _find_noti_data(modem, noti);
+  if (nd == NULL) {
+    g_rec_mutex_unlock(&modem->noti_lock);
+    return;
   }
-}
-
-static void _modem_added_notify(GDBusConnection *connection,
-     const gchar *sender_name,
-     const gchar *object_path,
-     const gchar *interface_name,
-     const gchar *signal_name,
-     GVariant *parameters,
-     gpointer user_data)
-{
-  const gchar *path;
-  GVariant *value;
-  GVariantIter iter;
-
-  tapi_debug("");
 
-  g_variant_iter_init(&iter, parameters);
-  value = g_variant_iter_next_value(&iter);
-  path = g_variant_get_string(value, NULL);
+  /*
+   * A callback may register or unregister callbacks, so the vector is
+   * indexed afresh on every iteration and removals are deferred. Other
+   * threads wait on the lock until the callbacks are done.
+   */
+  nd->dispatching++;
 
-  if (s_modems_changed_cb)
-    s_modems_changed_cb(path, TRUE);
-
-  g_variant_unref(value);
-}
-
-static void _modem_removed_notify(GDBusConnection *connection,
-     const gchar *sender_name,
-     const gchar *object_path,
-     const gchar *interface_name,
-     const gchar *signal_name,
-     GVariant *parameters,
-     gpointer user_data)
-{
-  struct ofono_modem *modem = user_data;
-  char *path;
+  for (i = 0; i < nd->cbs->len; i++) {
+    ncbd = &g_array_index(nd->cbs, struct noti_cb_data, i);
 
-  tapi_debug("");
-
-  g_variant_get(parameters, "(o)", &path);
+    if (ncbd->cb == NULL)
+      continue;
 
-  if (s_modems_changed_cb)
-    s_modems_changed_cb(path, FALSE);
+    payload = data;
+    if (noti == OFONO_NOTI_SIGNAL_STRENTH_CHANGED) {
+      if (!_signal_filter_apply(modem, ncbd, *(unsigned *) data, &value))
+        continue;
+      payload = &value;
+    }
 
-  g_free(path);
-}
+    ncbd->cb(noti, payload, ncbd->user_data);
+  }
 
-EXPORT_API void ofono_set_modems_changed_callback(modems_changed_cb cb)
-{
-  if (!cb)
-    return;
+  nd->dispatching--;
 
-  s_modems_changed_cb = cb;
+  if (nd->dispatching == 0 && nd->stale)
+    _noti_data_compact(modem, nd);
 
-  if (!s_modem_added_watch)
-    s_modem_added_watch = g_dbus_connection_signal_subscribe(
-        s_bus_conn,
-        OFONO_SERVICE,
-        OFONO_MANAGER_IFACE,
-        "ModemAdded",
-        OFONO_MANAGER_PATH,
-        NULL,
-        G_DBUS_SIGNAL_FLAGS_NONE,
-        _modem_added_notify,
-        NULL,
-        NULL);
-  if (!s_modem_removed_watch)
-    s_modem_removed_watch = g_dbus_connection_signal_subscribe(
-        s_bus_conn,
-        OFONO_SERVICE,
-        OFONO_MANAGER_IFACE,
-        "ModemRemoved",
-        OFONO_MANAGER_PATH,
-        NULL,
-        G_DBUS_SIGNAL_FLAGS_NONE,
-        _modem_removed_notify,
-        NULL,
-        NULL);
+  g_rec_mutex_unlock(&modem->noti_lock);
 }
 
 static void _modem_status_notify(GDBusConnection *connection,
@@ -528,12 +774,12 @@ static void _modem_status_notify(GDBusConnection *connection,
 {
   struct ofono_modem *modem = user_data;
   GVariant *var;
-  gchar *key;
+  const gchar *key;
   enum modem_status status;
 
   tapi_debug("");
 
-  g_variant_get(parameters, "(sv)", &key, &var);
+  g_variant_get(parameters, "(&sv)", &key, &var);
   if (g_strcmp0(key, "Online") == 0) {
     modem->online = g_variant_get_boolean(var);
 
@@ -562,7 +808,6 @@ static void _modem_status_notify(GDBusConnection *connection,
   }
 
   g_variant_unref(var);
-  g_free(key);
 }
 
 static void _modem_interfaces_notify(GDBusConnection *connection,
@@ -575,18 +820,18 @@ static void _modem_interfaces_notify(GDBusConnection *connection,
 {
   struct ofono_modem *modem = user_data;
   GVariant *var;
-  gchar *key;
+  const gchar *key;
 
   tapi_debug("");
 
-  g_variant_get(parameters, "(sv)", &key, &var);
+  g_variant_get(parameters, "(&sv)", &key, &var);
   modem->interfaces = _modem_interfaces_extract(var);
   tapi_debug("modem: %s Interfaces 0x%02x", modem->path, modem->interfaces);
+  prop_cache_interfaces_changed(modem);
 
   _notify(modem, &modem->interfaces, OFONO_NOTI_INTERFACES_CHANGED);
 
   g_variant_unref(var);
-  g_free(key);
 }
 
 static void _network_signal_strength_notify(GDBusConnection *connection,
@@ -599,19 +844,145 @@ static void _network_signal_strength_notify(GDBusConnection *connection,
 {
   struct ofono_modem *modem = user_data;
   GVariant *var;
-  char *key;
+  const char *key;
   unsigned signal;
 
   tapi_debug("");
 
-  g_variant_get(parameters, "(sv)", &key, &var);
-  g_variant_get(var, "y", &signal);
+  g_variant_get(parameters, "(&sv)", &key, &var);
+  signal = g_variant_get_byte(var);
   _notify(modem, &signal, OFONO_NOTI_SIGNAL_STRENTH_CHANGED);
 
-  g_free(key);
   g_variant_unref(var);
 }
 
+/* passes the value held back by the filter of "cb" on */
+static void _signal_filter_flush(struct ofono_modem *modem, noti_cb cb,
+      guint id)
+{
+  struct ofono_noti_data *nd;
+  struct noti_cb_data *ncbd;
+  struct signal_filter *f;
+  unsigned int value;
+  int index;
+
+  g_rec_mutex_lock(&modem->noti_lock);
+
+  nd = _find_noti_data(modem, OFONO_NOTI_SIGNAL_STRENTH_CHANGED);
+  index = nd != NULL ? _find_noti_cb_data(nd, cb) : -1;
+  if (index < 0) {
+    g_rec_mutex_unlock(&modem->noti_lock);
+    return;
+  }
+
+  ncbd = &g_array_index(nd->cbs, struct noti_cb_data, index);
+  f = ncbd->filter;
+
+  /* the filter has been replaced, or the timer is an old one */
+  if (f == NULL || f->timer != id) {
+    g_rec_mutex_unlock(&modem->noti_lock);
+    return;
+  }
+
+  f->timer = 0;
+  if (!f->pending) {
+    g_rec_mutex_unlock(&modem->noti_lock);
+    return;
+  }
+
+  f->pending = FALSE;
+  f->value = f->pending_value;
+  f->time = g_get_monotonic_time();
+  modem->signal->stats.delivered++;
+  value = f->value;
+
+  nd->dispatching++;
+  ncbd->cb(OFONO_NOTI_SIGNAL_STRENTH_CHANGED, &value, ncbd->user_data);
+  nd->dispatching--;
+
+  if (nd->dispatching == 0 && nd->stale)
+    _noti_data_compact(modem, nd);
+
+  g_rec_mutex_unlock(&modem->noti_lock);
+}
+
+static void _signal_timer_run(gpointer data)
+{
+  struct signal_timer *timer = data;
+  struct signal_state *state = timer->state;
+
+  g_rec_mutex_lock(&state->lock);
+  if (state->modem != NULL)
+    _signal_filter_flush(state->modem, timer->cb, timer->id);
+  g_rec_mutex_unlock(&state->lock);
+
+  _signal_state_unref(state);
+  g_free(timer);
+}
+
+/* runs on the thread of the connection, notify where the callbacks run */
+static gboolean _on_signal_timeout(gpointer data)
+{
+  dispatch_post(_signal_timer_run, data);
+
+  return G_SOURCE_REMOVE;
+}
+
+EXPORT_API tapi_bool ofono_network_set_signal_filter(struct ofono_modem *modem,
+      noti_cb cb,
+      const struct ofono_signal_filter *filter)
+{
+  struct ofono_noti_data *nd;
+  struct noti_cb_data *ncbd;
+  int index;
+
+  if (modem == NULL || cb == NULL ||
+      (filter != NULL && filter->smoothing > 100)) {
+    tapi_error("Invalid parameter");
+    return FALSE;
+  }
+
+  g_rec_mutex_lock(&modem->noti_lock);
+
+  nd = _find_noti_data(modem, OFONO_NOTI_SIGNAL_STRENTH_CHANGED);
+  index = nd != NULL ? _find_noti_cb_data(nd, cb) : -1;
+  if (index < 0) {
+    g_rec_mutex_unlock(&modem->noti_lock);
+    tapi_error("callback isn't registered");
+    return FALSE;
+  }
+
+  /* a timer armed for the previous filter finds nothing to do */
+  ncbd = &g_array_index(nd->cbs, struct noti_cb_data, index);
+  g_free(ncbd->filter);
+  ncbd->filter = NULL;
+
+  if (filter != NULL) {
+    ncbd->filter = g_new0(struct signal_filter, 1);
+    ncbd->filter->options = *filter;
+  }
+
+  g_rec_mutex_unlock(&modem->noti_lock);
+
+  return TRUE;
+}
+
+EXPORT_API tapi_bool ofono_network_get_signal_filter_stats(
+      struct ofono_modem *modem,
+      struct ofono_signal_filter_stats *stats)
+{
+  if (modem == NULL || stats == NULL) {
+    tapi_error("Invalid parameter");
+    return FALSE;
+  }
+
+  g_rec_mutex_lock(&modem->noti_lock);
+  *stats = modem->signal->stats;
+  g_rec_mutex_unlock(&modem->noti_lock);
+
+  return TRUE;
+}
+
 static void _network_status_notify(GDBusConnection *connection,
      const gchar *sender_name,
      const gchar *object_path,
@@ -622,21 +993,25 @@ static void _network_status_notify(GDBusConnection *connection,
 {
   struct ofono_modem *modem = user_data;
   GVariant *var;
-  char *key;
+  const char *key;
+  GHashTable *props;
   struct registration_info info;
 
   tapi_debug("");
 
-  g_variant_get(parameters, "(sv)", &key, &var);
+  g_variant_get(parameters, "(&sv)", &key, &var);
+  prop_cache_update(modem, PROP_CACHE_NETREG, key, var);
 
   /* Signal strength is handled in another callback */
   if (g_strcmp0(key, "Strength") != 0) {
-    ofono_network_get_registration_info(modem, &info);
+    props = prop_cache_peek(modem, PROP_CACHE_NETREG);
+    ofono_network_parse_registration_info(props, &info);
+    prop_cache_unlock(modem);
+
     _notify(modem, &info,
         OFONO_NOTI_REGISTRATION_STATUS_CHANGED);
   }
 
-  g_free(key);
   g_variant_unref(var);
 }
 
@@ -650,22 +1025,26 @@ static void _sim_status_notify(GDBusConnection *connection,
 {
   struct ofono_modem *modem = user_data;
   GVariant *val;
-  gchar *key;
+  const gchar *key;
+  GHashTable *props;
   struct sim_info info;
 
   tapi_debug("");
 
-  g_variant_get(parameters, "(sv)", &key, &val);
+  g_variant_get(parameters, "(&sv)", &key, &val);
+  prop_cache_update(modem, PROP_CACHE_SIM, key, val);
 
   if (g_strcmp0(key, "Present") == 0 || g_strcmp0(key, "PinRequired") == 0 ||
       g_strcmp0(key, "Retries") == 0 ||
       g_strcmp0(key, "SubscriberIdentity") == 0) {
-    ofono_sim_get_info(modem, &info);
+    props = prop_cache_peek(modem, PROP_CACHE_SIM);
+    ofono_sim_parse_info(props, &info);
+    prop_cache_unlock(modem);
+
     _notify(modem, &info.status, OFONO_NOTI_SIM_STATUS_CHANGED);
   }
 
   g_variant_unref(val);
-  g_free(key);
 }
 
 static void _call_added_notify(GDBusConnection *connection,
@@ -677,22 +1056,41 @@ static void _call_added_notify(GDBusConnection *connection,
       gpointer user_data)
 {
   struct ofono_modem *modem = user_data;
-  GVariantIter *info_iter;
-  char *path;
+  GVariantIter info_iter;
+  const char *path, *key;
+  GVariant *val, *props;
+  struct ofono_call_info *info;
   struct ofono_call_info call_info;
   unsigned int call_id;
 
   tapi_debug("");
 
-  memset(&call_info, 0, sizeof(call_info));
+  /* the signal carries all the properties of the new call */
+  g_variant_get(parameters, "(&o@a{sv})", &path, &props);
+  call_id = ofono_get_call_id_from_obj_path((char *)path);
+
+  g_rec_mutex_lock(&modem->noti_lock);
+
+  call_snapshot_remove(modem, call_id);
+  info = call_snapshot_update(modem, call_id, NULL, NULL);
+  g_variant_iter_init(&info_iter, props);
+  while (g_variant_iter_loop(&info_iter, "{&sv}", &key, &val))
+    ofono_call_parse_property(info, key, val);
+
+  call_info = *info;
 
-  g_variant_get(parameters, "(oa{sv})", &path, &info_iter);
-  call_id = ofono_get_call_id_from_obj_path(path);
-  ofono_call_get_call_info(modem, call_id, &call_info);
-  call_info.call_id = call_id;
+  g_rec_mutex_unlock(&modem->noti_lock);
 
-  g_variant_iter_free(info_iter);
-  g_free(path);
+  g_variant_unref(props);
+
+  _notify(modem, &call_info, OFONO_NOTI_CALL_STATUS_CHANGED);
+}
+
+/* a call which existed before the subscription, reported by the seed */
+static void _call_held_notify(struct ofono_modem *modem,
+      const struct ofono_call_info *info)
+{
+  struct ofono_call_info call_info = *info;
 
   _notify(modem, &call_info, OFONO_NOTI_CALL_STATUS_CHANGED);
 }
@@ -707,10 +1105,9 @@ static void _call_status_changed_notify(GDBusConnection *connection,
 {
   struct ofono_modem *modem = user_data;
   GVariant *var_val;
-  char *key;
+  const char *key;
   struct ofono_call_info call_info;
   unsigned int call_id;
-  enum ofono_call_status status;
 
   tapi_debug("");
 
@@ -718,34 +1115,40 @@ static void _call_status_changed_notify(GDBusConnection *connection,
   if (strncmp(object_path, modem->path, strlen(modem->path)) != 0)
     return;
 
-  memset(&call_info, 0, sizeof(call_info));
-
   /* ofono report property one by one, we'd like get all once otherwise
-     may trouble UI layer */
+     may trouble UI layer, so merge it into the call snapshot */
   call_id = ofono_get_call_id_from_obj_path((char*)object_path);
 
-  g_variant_get(parameters, "(sv)", &key, &var_val);
-  if (g_strcmp0(key, "State") == 0) {
-    char *str;
-    g_variant_get(var_val, "s", &str);
-    status = ofono_str_to_call_status(str);
-    g_free(str);
+  g_rec_mutex_lock(&modem->noti_lock);
+
+  /* a call older than the subscription is complete once seeded */
+  if (call_snapshot_hold(modem, call_id)) {
+    g_rec_mutex_unlock(&modem->noti_lock);
+    return;
   }
 
-  g_free(key);
+  g_variant_get(parameters, "(&sv)", &key, &var_val);
+  call_info = *call_snapshot_update(modem, call_id, key, var_val);
   g_variant_unref(var_val);
 
-  /* if call is disconnected, the call may have been removed, so can't
-     get its information */
-  if (status != CALL_STATUS_DISCONNECTED)
-    ofono_call_get_call_info(modem, call_id, &call_info);
+  /* the call will be removed by ofono right after */
+  if (call_info.status == CALL_STATUS_DISCONNECTED)
+    call_snapshot_remove(modem, call_id);
 
-  call_info.call_id = call_id;
-  call_info.status = status;
+  g_rec_mutex_unlock(&modem->noti_lock);
 
   _notify(modem, &call_info, OFONO_NOTI_CALL_STATUS_CHANGED);
 }
 
+static const struct str_map disconnect_reason_map[] = {
+  {"local", CALL_DISCONNECT_REASON_LOCAL_HANGUP},
+  {"remote", CALL_DISCONNECT_REASON_REMOTE_HANGUP},
+  {NULL, 0}
+};
+
+static struct str_table disconnect_reason_table =
+      STR_TABLE_INIT(disconnect_reason_map);
+
 static void _call_disconnect_reason_cb(GDBusConnection *connection,
       const gchar *sender_name,
       const gchar *object_path,
@@ -755,7 +1158,7 @@ static void _call_disconnect_reason_cb(GDBusConnection *connection,
       gpointer user_data)
 {
   struct ofono_modem *modem = user_data;
-  char *reason;
+  const char *reason;
   struct ofono_call_disconnect_reason cdr;
 
   /* avoid signal from other modem */
@@ -764,23 +1167,17 @@ static void _call_disconnect_reason_cb(GDBusConnection *connection,
 
   memset(&cdr, 0, sizeof(struct ofono_call_disconnect_reason));
   cdr.call_id = ofono_get_call_id_from_obj_path((gchar *)object_path);
-  g_variant_get(parameters, "(s)", &reason);
+  g_variant_get(parameters, "(&s)", &reason);
 
   if (reason == NULL) {
     tapi_error("");
     return;
   }
 
-  if (g_strcmp0(reason, "local") == 0)
-    cdr.reason = CALL_DISCONNECT_REASON_LOCAL_HANGUP;
-  else if (g_strcmp0(reason, "remote") == 0)
-    cdr.reason = CALL_DISCONNECT_REASON_REMOTE_HANGUP;
-  else
-    cdr.reason = CALL_DISCONNECT_REASON_UNKNOWN;
+  cdr.reason = str_table_lookup(&disconnect_reason_table, reason,
+        CALL_DISCONNECT_REASON_UNKNOWN);
 
   _notify(modem, &cdr, OFONO_NOTI_CALL_DISCONNECT_REASON);
-
-  g_free(reason);
 }
 
 static void _stk_idle_mode_text_notify(GDBusConnection *connection,
@@ -792,18 +1189,15 @@ static void _stk_idle_mode_text_notify(GDBusConnection *connection,
       gpointer user_data)
 {
   struct ofono_modem *modem = user_data;
-  char *key;
+  const char *key;
   GVariant *val;
-  char *text;
 
   tapi_debug("");
 
-  g_variant_get(parameters, "(sv)", &key, &val);
-  g_variant_get(val, "s", &text);
-  _notify(modem, text, OFONO_NOTI_SAT_IDLE_MODE_TEXT);
+  g_variant_get(parameters, "(&sv)", &key, &val);
+  _notify(modem, (char *) g_variant_get_string(val, NULL),
+        OFONO_NOTI_SAT_IDLE_MODE_TEXT);
 
-  g_free(text);
-  g_free(key);
   g_variant_unref(val);
 }
 
@@ -816,53 +1210,202 @@ static void _stk_main_menu_notify(GDBusConnection *connection,
       gpointer user_data)
 {
   struct ofono_modem *modem = user_data;
-  char *key;
-  GVariant *val;
 
   tapi_debug("");
 
-  g_variant_get(parameters, "(sv)", &key, &val);
-  _notify(modem, NULL, OFONO_NOTI_SAT_MAIN_MENU);
+  _notify(modem, NULL, OFONO_NOTI_SAT_MAIN_MENU);
+}
+
+static const struct str_map sms_sent_state_map[] = {
+  {"pending", OFONO_SMS_SENT_STATE_PENDING},
+  {"failed", OFONO_SMS_SENT_STATE_FAILED},
+  {"sent", OFONO_SMS_SENT_STATE_SENT},
+  {NULL, 0}
+};
+
+static struct str_table sms_sent_state_table =
+      STR_TABLE_INIT(sms_sent_state_map);
+
+/* keys of the incoming message and status report dictionaries */
+enum sms_key {
+  SMS_KEY_SENDER,
+  SMS_KEY_LOCAL_SENT_TIME,
+  SMS_KEY_SENT_TIME,
+  SMS_KEY_UUID,
+};
+
+static const struct str_map sms_key_map[] = {
+  {"Sender", SMS_KEY_SENDER},
+  {"LocalSentTime", SMS_KEY_LOCAL_SENT_TIME},
+  {"SentTime", SMS_KEY_SENT_TIME},
+  {"UUID", SMS_KEY_UUID},
+  {NULL, 0}
+};
+
+static struct str_table sms_key_table = STR_TABLE_INIT(sms_key_map);
+
+static void _sms_sending_status_notify(GDBusConnection *connection,
+      const gchar *sender_name,
+      const gchar *object_path,
+      const gchar *interface_name,
+      const gchar *signal_name,
+      GVariant *parameters,
+      gpointer user_data)
+{
+  struct ofono_modem *modem = user_data;
+  const char *uuid;
+  int sent_state;
+  const char *key;
+  GVariant *val;
+  struct ofono_sms_sent_staus_noti noti;
+  const char *state;
+
+  /* avoid signal from other modem */
+  if (strncmp(object_path, modem->path, strlen(modem->path)) != 0)
+    return;
+
+  tapi_debug("");
+
+  memset(&noti, 0, sizeof(noti));
+
+  g_variant_get(parameters, "(&sv)", &key, &val);
+
+  state = g_variant_get_string(val, NULL);
+  tapi_debug("SMS State: %s", state);
+
+  sent_state = str_table_lookup(&sms_sent_state_table, state, -1);
+  if (sent_state >= 0)
+    noti.state = sent_state;
+  else {
+    tapi_error("unknown message state: %s", state);
+
+    g_variant_unref(val);
+    return;
+  }
+
+  g_variant_unref(val);
+
+  uuid = sms_uuid_from_path(object_path);
+  if (uuid == NULL) {
+    tapi_error("get uuid failed");
+    return;
+  }
+
+  tapi_debug("uuid=%s", uuid);
+  noti.uuid = (char *) uuid;
+
+  sms_tracker_state(modem, uuid, noti.state);
+  _notify(modem, &noti, OFONO_NOTI_MSG_STATUS_CHANGED);
+}
+
+tapi_bool ofono_sms_parse_incoming(GVariant *parameters,
+      struct ofono_sms_incoming_noti *noti)
+{
+  GVariantIter iter;
+  GVariant *var, *dict;
+  const char *key;
+  tapi_bool ret = TRUE;
+
+  g_variant_get(parameters, "(&s@a{sv})", &noti->message, &dict);
+  g_variant_iter_init(&iter, dict);
+  while (ret && g_variant_iter_next(&iter, "{&sv}", &key, &var)) {
+    switch (str_table_lookup(&sms_key_table, key, -1)) {
+    case SMS_KEY_SENDER:
+      noti->sender = (char *) g_variant_get_string(var, NULL);
+      if (noti->sender == NULL) {
+        ret = FALSE;
+        break;
+      }
+      tapi_debug("Sender: %s", noti->sender);
+      break;
+    case SMS_KEY_LOCAL_SENT_TIME: {
+      const char *val = g_variant_get_string(var, NULL);
+      if (val == NULL) {
+        ret = FALSE;
+        break;
+      }
+      tapi_debug("LocalSentTime: %s", val);
+      if (!time_parse_iso8601(val, &noti->timestamp,
+            &noti->timestamp_offset))
+        tapi_warn("invalid time: %s", val);
+      break;
+    }
+    case SMS_KEY_SENT_TIME:
+      tapi_debug("SentTime: %s", g_variant_get_string(var, NULL));
+      break;
+    }
+
+    g_variant_unref(var);
+  }
+
+  g_variant_unref(dict);
+  return ret;
+}
+
+static void _sms_notify(tapi_bool class0, GVariant *parameters,
+      gpointer user_data)
+{
+  struct ofono_modem *modem = user_data;
+  struct ofono_sms_incoming_noti noti;
+
+  tapi_debug("");
+
+  memset(&noti, 0, sizeof(noti));
+  noti.class0 = class0;
 
-  g_free(key);
-  g_variant_unref(val);
+  if (ofono_sms_parse_incoming(parameters, &noti))
+    _notify(modem, &noti, OFONO_NOTI_INCOMING_SMS);
 }
 
-static gchar *_ofono_sms_get_uuid_from_path(const gchar *path)
+/* lock held */
+static void _sms_batch_flush(struct sms_batch_state *state)
 {
-  gchar **token;
-  gchar *uuid;
+  struct ofono_sms_incoming_batch batch;
+  GArray *messages = state->messages;
 
-  tapi_debug("");
+  state->generation++;
+  state->timer = FALSE;
 
-  token = g_strsplit(path, "message_", 2);
+  if (messages->len == 0 || state->modem == NULL)
+    return;
 
-  if (token[1] == NULL) {
-    tapi_error("Invalid UUID in path");
-    return NULL;
-  }
+  /* a message arriving from a callback starts the next batch */
+  state->messages = g_array_new(FALSE, FALSE,
+        sizeof(struct ofono_sms_incoming_noti));
 
-  uuid = g_strdup(token[1]);
+  batch.count = messages->len;
+  batch.messages = (struct ofono_sms_incoming_noti *) messages->data;
 
-  g_strfreev(token);
+  tapi_debug("%u messages", batch.count);
+  _notify(state->modem, &batch, OFONO_NOTI_INCOMING_SMS_BATCH);
 
-  return uuid;
+  _sms_batch_clear(messages);
+  g_array_free(messages, TRUE);
 }
 
-static time_t _sms_time_parse(const gchar *str)
+static void _sms_batch_timer_run(gpointer data)
 {
-  struct tm tm;
-  time_t zonediff;
+  struct sms_batch_timer *timer = data;
+  struct sms_batch_state *state = timer->state;
 
-  memset(&tm, 0, sizeof(tm));
+  g_rec_mutex_lock(&state->lock);
+  if (timer->generation == state->generation)
+    _sms_batch_flush(state);
+  g_rec_mutex_unlock(&state->lock);
+
+  _sms_batch_unref(state);
+  g_free(timer);
+}
 
-  strptime(str, "%Y-%m-%dT%H:%M:%S%z", &tm);
-  zonediff = tm.tm_gmtoff; /* mktime reset it */
+/* runs on the thread of the connection, flush where the callbacks run */
+static gboolean _on_sms_batch_timeout(gpointer data)
+{
+  dispatch_post(_sms_batch_timer_run, data);
 
-  return mktime(&tm) - zonediff - timezone;
+  return G_SOURCE_REMOVE;
 }
 
-static void _sms_sending_status_notify(GDBusConnection *connection,
+static void _sms_incoming_batch_notify(GDBusConnection *connection,
       const gchar *sender_name,
       const gchar *object_path,
       const gchar *interface_name,
@@ -871,103 +1414,58 @@ static void _sms_sending_status_notify(GDBusConnection *connection,
       gpointer user_data)
 {
   struct ofono_modem *modem = user_data;
-  char *uuid;
-  char *key;
-  GVariant *val;
-  struct ofono_sms_sent_staus_noti noti;
-  const char *state;
-
-  /* avoid signal from other modem */
-  if (strncmp(object_path, modem->path, strlen(modem->path)) != 0)
-    return;
+  struct sms_batch_state *state = modem->sms_batch;
+  struct ofono_sms_incoming_noti noti;
+  struct sms_batch_timer *timer;
 
   tapi_debug("");
 
   memset(&noti, 0, sizeof(noti));
+  if (!ofono_sms_parse_incoming(parameters, &noti))
+    return;
 
-  g_variant_get(parameters, "(sv)", &key, &val);
+  noti.sender = g_strdup(noti.sender);
+  noti.message = g_strdup(noti.message);
 
-  state = g_variant_get_string(val, NULL);
-  tapi_debug("SMS State: %s", state);
+  g_rec_mutex_lock(&state->lock);
 
-  if (g_strcmp0(state, "pending") == 0)
-    noti.state =  OFONO_SMS_SENT_STATE_PENDING;
-  else if (g_strcmp0(state, "failed") == 0)
-    noti.state =  OFONO_SMS_SENT_STATE_FAILED;
-  else if (g_strcmp0(state, "sent") == 0)
-    noti.state =  OFONO_SMS_SENT_STATE_SENT;
-  else {
-    tapi_error("unknown message state: %s", state);
+  g_array_append_val(state->messages, noti);
 
-    g_free(key);
-    g_variant_unref(val);
-    return;
-  }
+  if (state->messages->len >= state->max_count) {
+    _sms_batch_flush(state);
+  } else if (!state->timer) {
+    state->timer = TRUE;
 
-  g_free(key);
-  g_variant_unref(val);
+    timer = g_new(struct sms_batch_timer, 1);
+    timer->state = state;
+    timer->generation = state->generation;
+    g_atomic_int_inc(&state->refs);
 
-  uuid = _ofono_sms_get_uuid_from_path(object_path);
-  if (uuid == NULL) {
-    tapi_error("get uuid failed");
-    return;
+    dispatch_timeout_add(modem->conn, state->window,
+          _on_sms_batch_timeout, timer);
   }
 
-  tapi_debug("uuid=%s", uuid);
-  noti.uuid = uuid;
-
-  _notify(modem, &noti, OFONO_NOTI_MSG_STATUS_CHANGED);
-
-  g_free(uuid);
+  g_rec_mutex_unlock(&state->lock);
 }
 
-static void _sms_notify(tapi_bool class0, GVariant *parameters,
-      gpointer user_data)
+EXPORT_API tapi_bool ofono_sms_set_incoming_batch(struct ofono_modem *modem,
+      unsigned int window, unsigned int max_count)
 {
-  struct ofono_modem *modem = user_data;
-  GVariantIter *iter;
-  GVariant *var;
-  char *key;
-  struct ofono_sms_incoming_noti noti;
-
-  tapi_debug("");
-
-  memset(&noti, 0, sizeof(noti));
-  noti.class0 = class0;
+  struct sms_batch_state *state;
 
-  g_variant_get(parameters, "(sa{sv})", &noti.message, &iter);
-  while (g_variant_iter_next(iter, "{sv}", &key, &var)) {
-    if (g_strcmp0(key, "Sender") == 0) {
-      noti.sender = g_variant_dup_string(var, NULL);
-      if (noti.sender == NULL) {
-        g_variant_unref(var);
-        g_free(key);
-        goto error;
-      }
-      tapi_debug("Sender: %s", noti.sender);
-    } else if (g_strcmp0(key, "LocalSentTime") == 0) {
-      const char *val = g_variant_get_string(var, NULL);
-      if (val == NULL) {
-        g_variant_unref(var);
-        g_free(key);
-        goto error;
-      }
-      tapi_debug("LocalSentTime: %s", val);
-      noti.timestamp = _sms_time_parse(val);
-    } else if (g_strcmp0(key, "SentTime") == 0) {
-      tapi_debug("SentTime: %s", g_variant_get_string(var, NULL));
-    }
-
-    g_variant_unref(var);
-    g_free(key);
+  if (modem == NULL) {
+    tapi_error("Invalid parameter");
+    return FALSE;
   }
 
-  _notify(modem, &noti, OFONO_NOTI_INCOMING_SMS);
+  state = modem->sms_batch;
 
-error:
-  g_free(noti.message);
-  g_free(noti.sender);
-  g_variant_iter_free(iter);
+  g_rec_mutex_lock(&state->lock);
+  state->window = window ? window : SMS_BATCH_WINDOW;
+  state->max_count = max_count ? max_count : SMS_BATCH_MAX_COUNT;
+  g_rec_mutex_unlock(&state->lock);
+
+  return TRUE;
 }
 
 static void _sms_immediate_msg_notify(GDBusConnection *connection,
@@ -1003,41 +1501,46 @@ static void _msg_delivery_report_notify(GDBusConnection *connection,
       gpointer user_data)
 {
   struct ofono_modem *modem = user_data;
-  GVariantIter *iter;
-  gchar *key;
-  GVariant *val;
+  GVariantIter iter;
+  const gchar *key;
+  GVariant *val, *dict;
   struct ofono_sms_status_report_noti noti;
 
   tapi_debug("");
 
   memset(&noti, 0, sizeof(noti));
 
-  g_variant_get(parameters, "(sa{sv})", &noti.message, &iter);
-  while (g_variant_iter_next(iter, "{sv}", &key, &val)) {
-    if (g_strcmp0(key, "LocalSentTime") == 0) {
+  g_variant_get(parameters, "(&s@a{sv})", &noti.message, &dict);
+  g_variant_iter_init(&iter, dict);
+  while (g_variant_iter_next(&iter, "{&sv}", &key, &val)) {
+    switch (str_table_lookup(&sms_key_table, key, -1)) {
+    case SMS_KEY_LOCAL_SENT_TIME: {
       const char *lsTime = g_variant_get_string(val, NULL);
       if (lsTime == NULL) {
         tapi_error("local send time is null.");
         g_variant_unref(val);
-        g_free(key);
         goto erorr;
       }
       tapi_debug("LocalSentTime: %s", lsTime);
-      noti.timestamp = _sms_time_parse(lsTime);
-    } else if (g_strcmp0(key, "UUID") == 0) {
-      noti.uuid = g_variant_dup_string(val, NULL);
+      if (!time_parse_iso8601(lsTime, &noti.timestamp,
+            &noti.timestamp_offset))
+        tapi_warn("invalid time: %s", lsTime);
+      break;
+    }
+    case SMS_KEY_UUID:
+      noti.uuid = (char *) g_variant_get_string(val, NULL);
+      break;
     }
 
     g_variant_unref(val);
-    g_free(key);
   }
 
+  if (noti.uuid != NULL)
+    sms_tracker_delivered(modem, noti.uuid);
   _notify(modem, &noti, OFONO_NOTI_SMS_DELIVERY_REPORT);
 
 erorr:
-  g_variant_iter_free(iter);
-  g_free(noti.message);
-  g_free(noti.uuid);
+  g_variant_unref(dict);
 }
 
 static void _cbs_incoming_notify(GDBusConnection *connection,
@@ -1050,22 +1553,47 @@ static void _cbs_incoming_notify(GDBusConnection *connection,
 {
   struct ofono_modem *modem = user_data;
   guint16 channel;
-  gchar *message;
+  const gchar *message;
   struct ofono_cbs_incoming_noti noti;
 
   tapi_debug("");
 
   memset(&noti, 0, sizeof(noti));
 
-  g_variant_get(parameters, "(sq)", &message, &channel);
-  noti.message = message;
+  g_variant_get(parameters, "(&sq)", &message, &channel);
+  noti.message = (char *) message;
   noti.channel = channel;
 
   _notify(modem, &noti, OFONO_NOTI_INCOMING_CBS);
-
-  g_free(noti.message);
 }
 
+enum cbs_emergency_key {
+  CBS_KEY_EMERGENCY_TYPE,
+  CBS_KEY_POPUP,
+  CBS_KEY_EMERGENCY_ALERT,
+};
+
+static const struct str_map cbs_emergency_key_map[] = {
+  {"EmergencyType", CBS_KEY_EMERGENCY_TYPE},
+  {"Popup", CBS_KEY_POPUP},
+  {"EmergencyAlert", CBS_KEY_EMERGENCY_ALERT},
+  {NULL, 0}
+};
+
+static struct str_table cbs_emergency_key_table =
+      STR_TABLE_INIT(cbs_emergency_key_map);
+
+static const struct str_map cbs_emergency_type_map[] = {
+  {"Earthquake", OFONO_CBS_EMERG_TYPE_EARTHQUAKE},
+  {"Tsunami", OFONO_CBS_EMERG_TYPE_TSUNAMI},
+  {"Earthquake+Tsunami", OFONO_CBS_EMERG_TYPE_EARTHQUAKE_TSUNAMI},
+  {"Other", OFONO_CBS_EMERG_TYPE_OTHER},
+  {NULL, 0}
+};
+
+static struct str_table cbs_emergency_type_table =
+      STR_TABLE_INIT(cbs_emergency_type_map);
+
 static void _cbs_emergency_notify(GDBusConnection *connection,
       const gchar *sender_name,
       const gchar *object_path,
@@ -1075,49 +1603,44 @@ static void _cbs_emergency_notify(GDBusConnection *connection,
       gpointer user_data)
 {
   struct ofono_modem *modem = user_data;
-  GVariantIter *iter;
-  gchar *key;
-  GVariant *var;
+  GVariantIter iter;
+  const gchar *key;
+  GVariant *var, *dict;
   struct ofono_cbs_emergency_noti noti;
 
   tapi_debug("");
 
   memset(&noti, 0, sizeof(noti));
 
-  g_variant_get(parameters, "(sa{sv})", &noti.message, &iter);
-  while (g_variant_iter_next(iter, "{sv}", &key, &var)) {
-    if (g_strcmp0("EmergencyType", key) == 0) {
+  g_variant_get(parameters, "(&s@a{sv})", &noti.message, &dict);
+  g_variant_iter_init(&iter, dict);
+  while (g_variant_iter_next(&iter, "{&sv}", &key, &var)) {
+    switch (str_table_lookup(&cbs_emergency_key_table, key, -1)) {
+    case CBS_KEY_EMERGENCY_TYPE: {
       const char *type = g_variant_get_string(var, NULL);
       tapi_debug("cbs emergency type [%s]", type);
 
-      if (g_strcmp0(type, "Earthquake") == 0)
-        noti.type = OFONO_CBS_EMERG_TYPE_EARTHQUAKE;
-      else if (g_strcmp0(type, "Tsunami") == 0)
-        noti.type = OFONO_CBS_EMERG_TYPE_TSUNAMI;
-      else if (g_strcmp0(type, "Earthquake+Tsunami") == 0)
-        noti.type = OFONO_CBS_EMERG_TYPE_EARTHQUAKE_TSUNAMI;
-      else if (g_strcmp0(type, "Other") == 0)
-        noti.type = OFONO_CBS_EMERG_TYPE_OTHER;
-      else {
+      noti.type = str_table_lookup(&cbs_emergency_type_table, type,
+            OFONO_CBS_EMERG_TYPE_UNKNOWN);
+      if (noti.type == OFONO_CBS_EMERG_TYPE_UNKNOWN)
         tapi_error("Unknown cbs emergency type");
-        noti.type = OFONO_CBS_EMERG_TYPE_UNKNOWN;
-      }
-    } else if (g_strcmp0("Popup", key) == 0) {
+      break;
+    }
+    case CBS_KEY_POPUP:
       noti.popup= g_variant_get_boolean(var);
       tapi_debug("cbs emergency popup [%d]", noti.popup);
-    } else if (g_strcmp0("EmergencyAlert", key) == 0) {
+      break;
+    case CBS_KEY_EMERGENCY_ALERT:
       noti.alert = g_variant_get_boolean(var);
       tapi_debug("cbs emergency alert [%d]", noti.alert);
+      break;
     }
 
     g_variant_unref(var);
-    g_free(key);
   }
-  g_variant_iter_free(iter);
+  g_variant_unref(dict);
 
   _notify(modem, &noti, OFONO_NOTI_EMERGENCY_CBS);
-
-  g_free(noti.message);
 }
 
 static void _ussd_notify(GDBusConnection *connection,
@@ -1134,7 +1657,7 @@ static void _ussd_notify(GDBusConnection *connection,
 
   tapi_debug("");
 
-  g_variant_get(parameters, "s", &noti.message);
+  g_variant_get(parameters, "(&s)", &noti.message);
 
   if (g_strcmp0(signal_name, "NotificationReceived") == 0) {
     noti.response_required = FALSE;
@@ -1145,10 +1668,17 @@ static void _ussd_notify(GDBusConnection *connection,
   }
 
   _notify(modem, &noti, noti_id);
-
-  g_free(noti.message);
 }
 
+static const struct str_map ussd_status_map[] = {
+  {"idle", SS_USSD_STATUS_IDLE},
+  {"active", SS_USSD_STATUS_ACTIVE},
+  {"user-response", SS_USSD_STATUS_ACTION_REQUIRE},
+  {NULL, 0}
+};
+
+static struct str_table ussd_status_table = STR_TABLE_INIT(ussd_status_map);
+
 static void _ussd_status_notify(GDBusConnection *connection,
       const gchar *sender_name,
       const gchar *object_path,
@@ -1159,31 +1689,27 @@ static void _ussd_status_notify(GDBusConnection *connection,
 {
   struct ofono_modem *modem = user_data;
   GVariant *var;
-  char *key;
+  const char *key;
   const char *state;
   enum ussd_status status;
+  int val;
 
   tapi_debug("");
 
-  g_variant_get(parameters, "(sv)", &key, &var);
+  g_variant_get(parameters, "(&sv)", &key, &var);
 
   state = g_variant_get_string(var, NULL);
-  if (g_strcmp0(state, "idle") == 0)
-    status = SS_USSD_STATUS_IDLE;
-  else if (g_strcmp0(state, "active") == 0)
-    status = SS_USSD_STATUS_ACTIVE;
-  else if (g_strcmp0(state, "user-response") == 0)
-    status = SS_USSD_STATUS_ACTION_REQUIRE;
+  val = str_table_lookup(&ussd_status_table, state, -1);
+  if (val >= 0)
+    status = val;
   else {
     tapi_error("Unknown USSD status");
-    g_free(key);
     g_variant_unref(var);
     return;
   }
 
   _notify(modem, &status, OFONO_NOTI_USSD_STATUS_CHANGED);
 
-  g_free(key);
   g_variant_unref(var);
 }
 
@@ -1197,20 +1723,24 @@ static void _connman_status_notify(GDBusConnection *connection,
 {
   struct ofono_modem *modem = user_data;
   GVariant *val;
-  gchar *key;
+  const gchar *key;
+  GHashTable *props;
   struct ps_reg_status status;
 
   tapi_debug("");
 
-  g_variant_get(parameters, "(sv)", &key, &val);
+  g_variant_get(parameters, "(&sv)", &key, &val);
+  prop_cache_update(modem, PROP_CACHE_CONNMAN, key, val);
 
   if (g_strcmp0(key, "Attached") == 0 || g_strcmp0(key, "Bearer") == 0) {
-    ofono_connman_get_status(modem, &status);
+    props = prop_cache_peek(modem, PROP_CACHE_CONNMAN);
+    ofono_connman_parse_status(props, &status);
+    prop_cache_unlock(modem);
+
     _notify(modem, &status, OFONO_NOTI_CONNMAN_STATUS);
   }
 
   g_variant_unref(val);
-  g_free(key);
 }
 
 static void _connman_context_actived_notify(GDBusConnection *connection,
@@ -1223,7 +1753,7 @@ static void _connman_context_actived_notify(GDBusConnection *connection,
 {
   struct ofono_modem *modem = user_data;
   GVariant *val;
-  gchar *key;
+  const gchar *key;
   struct context_actived_noti noti;
 
   tapi_debug("%s", object_path);
@@ -1232,292 +1762,166 @@ static void _connman_context_actived_notify(GDBusConnection *connection,
   if (strncmp(object_path, modem->path, strlen(modem->path)) != 0)
     return;
 
-  noti.path = g_strdup(object_path);
-  g_variant_get(parameters, "(sv)", &key, &val);
+  noti.path = (char *) object_path;
+  g_variant_get(parameters, "(&sv)", &key, &val);
 
   noti.actived = g_variant_get_boolean(val);
   _notify(modem, &noti, OFONO_NOTI_CONNMAN_CONTEXT_ACTIVED);
 
   g_variant_unref(val);
-  g_free(key);
-  g_free(noti.path);
 }
 
-static void _subscribe_notification(struct ofono_modem *modem,
-          enum ofono_noti noti, guint *watches)
-{
-  int count = 0;
-
-  tapi_debug("");
+struct noti_signal {
+  const char *iface;
+  const char *member;
+  const char *arg0; /* property name for "PropertyChanged", may be NULL */
+  tapi_bool children; /* emitted by the objects below the modem */
+  GDBusSignalCallback handler;
+};
 
-  switch (noti) {
-  case OFONO_NOTI_MODEM_STATUS_CHAANGED:
-    watches[count++] = g_dbus_connection_signal_subscribe(
-      modem->conn,
-      OFONO_SERVICE,
-      OFONO_MODEM_IFACE,
-      "PropertyChanged",
-      modem->path,
-      NULL,
-      G_DBUS_SIGNAL_FLAGS_NONE,
-      _modem_status_notify,
-      modem,
-      NULL);
-    break;
-  case OFONO_NOTI_INTERFACES_CHANGED:
-    watches[count++] = g_dbus_connection_signal_subscribe(
-      modem->conn,
-      OFONO_SERVICE,
-      OFONO_MODEM_IFACE,
-      "PropertyChanged",
-      modem->path,
-      "Interfaces",
-      G_DBUS_SIGNAL_FLAGS_NONE,
-      _modem_interfaces_notify,
-      modem,
-      NULL);
-    break;
+/* signals backing each notification, unused slots have a NULL iface */
+static const struct noti_signal noti_signals[OFONO_NOTI_MAX][MAX_WATCHES_NUM] = {
+  /* modem */
+  [OFONO_NOTI_MODEM_STATUS_CHAANGED] = {
+    {OFONO_MODEM_IFACE, "PropertyChanged", NULL, FALSE,
+      _modem_status_notify},
+  },
+  [OFONO_NOTI_INTERFACES_CHANGED] = {
+    {OFONO_MODEM_IFACE, "PropertyChanged", "Interfaces", FALSE,
+      _modem_interfaces_notify},
+  },
 
   /* network */
-  case OFONO_NOTI_SIGNAL_STRENTH_CHANGED:
-    watches[count++] = g_dbus_connection_signal_subscribe(
-      modem->conn,
-      OFONO_SERVICE,
-      OFONO_NETWORK_REGISTRATION_IFACE,
-      "PropertyChanged",
-      modem->path,
-      "Strength",
-      G_DBUS_SIGNAL_FLAGS_NONE,
-      _network_signal_strength_notify,
-      modem,
-      NULL);
-    break;
-  case OFONO_NOTI_REGISTRATION_STATUS_CHANGED:
-    watches[count++] = g_dbus_connection_signal_subscribe(
-      modem->conn,
-      OFONO_SERVICE,
-      OFONO_NETWORK_REGISTRATION_IFACE,
-      "PropertyChanged",
-      modem->path,
-      NULL,
-      G_DBUS_SIGNAL_FLAGS_NONE,
-      _network_status_notify,
-      modem,
-      NULL);
-    break;
+  [OFONO_NOTI_SIGNAL_STRENTH_CHANGED] = {
+    {OFONO_NETWORK_REGISTRATION_IFACE, "PropertyChanged", "Strength", FALSE,
+      _network_signal_strength_notify},
+  },
+  [OFONO_NOTI_REGISTRATION_STATUS_CHANGED] = {
+    {OFONO_NETWORK_REGISTRATION_IFACE, "PropertyChanged", NULL, FALSE,
+      _network_status_notify},
+  },
+
   /* Call */
-  case OFONO_NOTI_CALL_STATUS_CHANGED:
-    watches[count++] = g_dbus_connection_signal_subscribe(modem->conn,
-      OFONO_SERVICE,
-      OFONO_VOICECALL_IFACE,
-      "PropertyChanged",
-      NULL,
-      NULL,
-      G_DBUS_SIGNAL_FLAGS_NONE,
-      _call_status_changed_notify,
-      modem,
-      NULL);
+  [OFONO_NOTI_CALL_STATUS_CHANGED] = {
+    {OFONO_VOICECALL_IFACE, "PropertyChanged", NULL, TRUE,
+      _call_status_changed_notify},
     /* dialing and incomming call is reported by "CallAdded" signal */
-    watches[count++] = g_dbus_connection_signal_subscribe(modem->conn,
-      OFONO_SERVICE,
-      OFONO_VOICECALL_MANAGER_IFACE,
-      "CallAdded",
-      modem->path,
-      NULL,
-      G_DBUS_SIGNAL_FLAGS_NONE,
-      _call_added_notify,
-      modem,
-      NULL);
-    break;
-  case OFONO_NOTI_CALL_DISCONNECT_REASON:
-    watches[count++] = g_dbus_connection_signal_subscribe(modem->conn,
-      OFONO_SERVICE,
-      OFONO_VOICECALL_IFACE,
-      "DisconnectReason",
-      NULL,
-      NULL,
-      G_DBUS_SIGNAL_FLAGS_NONE,
-      _call_disconnect_reason_cb,
-      modem,
-      NULL);
-    break;
+    {OFONO_VOICECALL_MANAGER_IFACE, "CallAdded", NULL, FALSE,
+      _call_added_notify},
+  },
+  [OFONO_NOTI_CALL_DISCONNECT_REASON] = {
+    {OFONO_VOICECALL_IFACE, "DisconnectReason", NULL, TRUE,
+      _call_disconnect_reason_cb},
+  },
 
   /* SMS */
-  case OFONO_NOTI_INCOMING_SMS_CLASS_0:
-    /* class 0 sms arrives */
-    watches[count++] = g_dbus_connection_signal_subscribe(modem->conn,
-      OFONO_SERVICE,
-      OFONO_MESSAGE_MANAGER_IFACE,
-      "ImmediateMessage",
-      modem->path,
-      NULL,
-      G_DBUS_SIGNAL_FLAGS_NONE,
-      _sms_immediate_msg_notify,
-      modem,
-      NULL);
-    break;
-  case OFONO_NOTI_INCOMING_SMS:
-    /* normal sms arrives */
-    watches[count++] = g_dbus_connection_signal_subscribe(modem->conn,
-      OFONO_SERVICE,
-      OFONO_MESSAGE_MANAGER_IFACE,
-      "IncomingMessage",
-      modem->path,
-      NULL,
-      G_DBUS_SIGNAL_FLAGS_NONE,
-      _sms_incoming_msg_notify,
-      modem,
-      NULL);
-    break;
-  case OFONO_NOTI_MSG_STATUS_CHANGED:
-    watches[count++] = g_dbus_connection_signal_subscribe(modem->conn,
-      OFONO_SERVICE,
-      OFONO_MESSAGE_IFACE,
-      "PropertyChanged",
-      NULL,
-      "State",
-      G_DBUS_SIGNAL_FLAGS_NONE,
-      _sms_sending_status_notify,
-      modem,
-      NULL);
-    break;
-  case OFONO_NOTI_SMS_DELIVERY_REPORT:
-    watches[count++] = g_dbus_connection_signal_subscribe(modem->conn,
-      OFONO_SERVICE,
-      OFONO_MESSAGE_MANAGER_IFACE,
-      "SendStatusReport",
-      modem->path,
-      NULL,
-      G_DBUS_SIGNAL_FLAGS_NONE,
-      _msg_delivery_report_notify,
-      modem,
-      NULL);
-    break;
-  case OFONO_NOTI_INCOMING_CBS:
-    watches[count++] = g_dbus_connection_signal_subscribe(modem->conn,
-      OFONO_SERVICE,
-      OFONO_CELL_BROADCAST_IFACE,
-      "IncomingBroadcast",
-      modem->path,
-      NULL,
-      G_DBUS_SIGNAL_FLAGS_NONE,
-      _cbs_incoming_notify,
-      modem,
-      NULL);
-    break;
-  case OFONO_NOTI_EMERGENCY_CBS:
-    watches[count++] = g_dbus_connection_signal_subscribe(modem->conn,
-      OFONO_SERVICE,
-      OFONO_CELL_BROADCAST_IFACE,
-      "EmergencyBroadcast",
-      modem->path,
-      NULL,
-      G_DBUS_SIGNAL_FLAGS_NONE,
-      _cbs_emergency_notify,
-      modem,
-      NULL);
-    break;
+  [OFONO_NOTI_INCOMING_SMS_CLASS_0] = {
+    {OFONO_MESSAGE_MANAGER_IFACE, "ImmediateMessage", NULL, FALSE,
+      _sms_immediate_msg_notify},
+  },
+  [OFONO_NOTI_INCOMING_SMS] = {
+    {OFONO_MESSAGE_MANAGER_IFACE, "IncomingMessage", NULL, FALSE,
+      _sms_incoming_msg_notify},
+  },
+  [OFONO_NOTI_MSG_STATUS_CHANGED] = {
+    {OFONO_MESSAGE_IFACE, "PropertyChanged", "State", TRUE,
+      _sms_sending_status_notify},
+  },
+  [OFONO_NOTI_SMS_DELIVERY_REPORT] = {
+    {OFONO_MESSAGE_MANAGER_IFACE, "SendStatusReport", NULL, FALSE,
+      _msg_delivery_report_notify},
+  },
+  [OFONO_NOTI_INCOMING_CBS] = {
+    {OFONO_CELL_BROADCAST_IFACE, "IncomingBroadcast", NULL, FALSE,
+      _cbs_incoming_notify},
+  },
+  [OFONO_NOTI_EMERGENCY_CBS] = {
+    {OFONO_CELL_BROADCAST_IFACE, "EmergencyBroadcast", NULL, FALSE,
+      _cbs_emergency_notify},
+  },
 
   /* SIM */
-  case OFONO_NOTI_SIM_STATUS_CHANGED:
-    watches[count++] = g_dbus_connection_signal_subscribe(modem->conn,
-      OFONO_SERVICE,
-      OFONO_SIM_MANAGER_IFACE,
-      "PropertyChanged",
-      modem->path,
-      NULL,
-      G_DBUS_SIGNAL_FLAGS_NONE,
-      _sim_status_notify,
-      modem,
-      NULL);
-    break;
+  [OFONO_NOTI_SIM_STATUS_CHANGED] = {
+    {OFONO_SIM_MANAGER_IFACE, "PropertyChanged", NULL, FALSE,
+      _sim_status_notify},
+  },
 
   /* USSD */
-  case OFONO_NOTI_USSD_NOTIFICATION:
-    watches[count++] = g_dbus_connection_signal_subscribe(modem->conn,
-      OFONO_SERVICE,
-      OFONO_SUPPLEMENTARY_SERVICES_IFACE,
-      "NotificationReceived",
-      modem->path,
-      NULL,
-      G_DBUS_SIGNAL_FLAGS_NONE,
-      _ussd_notify,
-      modem,
-      NULL);
-    break;
-  case OFONO_NOTI_USSD_REQ:
-    watches[count++] = g_dbus_connection_signal_subscribe(modem->conn,
-      OFONO_SERVICE,
-      OFONO_SUPPLEMENTARY_SERVICES_IFACE,
-      "RequestReceived",
-      modem->path,
-      NULL,
-      G_DBUS_SIGNAL_FLAGS_NONE,
-      _ussd_notify,
-      modem,
-      NULL);
+  [OFONO_NOTI_USSD_NOTIFICATION] = {
+    {OFONO_SUPPLEMENTARY_SERVICES_IFACE, "NotificationReceived", NULL, FALSE,
+      _ussd_notify},
+  },
+  [OFONO_NOTI_USSD_REQ] = {
+    {OFONO_SUPPLEMENTARY_SERVICES_IFACE, "RequestReceived", NULL, FALSE,
+      _ussd_notify},
+  },
+  [OFONO_NOTI_USSD_STATUS_CHANGED] = {
+    {OFONO_SUPPLEMENTARY_SERVICES_IFACE, "PropertyChanged", "State", FALSE,
+      _ussd_status_notify},
+  },
+
+  /* connman */
+  [OFONO_NOTI_CONNMAN_STATUS] = {
+    {OFONO_CONNMAN_IFACE, "PropertyChanged", NULL, FALSE,
+      _connman_status_notify},
+  },
+  [OFONO_NOTI_CONNMAN_CONTEXT_ACTIVED] = {
+    {OFONO_CONTEXT_IFACE, "PropertyChanged", "Active", TRUE,
+      _connman_context_actived_notify},
+  },
+
+  /* STK */
+  [OFONO_NOTI_SAT_IDLE_MODE_TEXT] = {
+    {OFONO_STK_IFACE, "PropertyChanged", "IdleModeText", FALSE,
+      _stk_idle_mode_text_notify},
+  },
+  [OFONO_NOTI_SAT_MAIN_MENU] = {
+    {OFONO_STK_IFACE, "PropertyChanged", "MainMenu", FALSE,
+      _stk_main_menu_notify},
+  },
+
+  /* SMS, batched */
+  [OFONO_NOTI_INCOMING_SMS_BATCH] = {
+    {OFONO_MESSAGE_MANAGER_IFACE, "IncomingMessage", NULL, FALSE,
+      _sms_incoming_batch_notify},
+  },
+};
+
+static void _subscribe_notification(struct ofono_modem *modem,
+          enum ofono_noti noti, guint *watches)
+{
+  const struct noti_signal *sig;
+  int i;
+
+  tapi_debug("");
+
+  for (i = 0; i < MAX_WATCHES_NUM; i++) {
+    sig = &noti_signals[noti][i];
+    if (sig->iface == NULL)
+      break;
+
+    watches[i] = signal_watch_add_full(modem->conn, sig->iface,
+          sig->member, modem->path, sig->children, sig->arg0, sig->handler,
+          modem, (GBoxedCopyFunc) modem_ref, (GDestroyNotify) modem_unref);
+  }
+
+  /* payloads built from cached state need it complete before the first
+     signal arrives */
+  switch (noti) {
+  case OFONO_NOTI_REGISTRATION_STATUS_CHANGED:
+    prop_cache_prefetch(modem, PROP_CACHE_NETREG);
     break;
-  case OFONO_NOTI_USSD_STATUS_CHANGED:
-    watches[count++] = g_dbus_connection_signal_subscribe(modem->conn,
-      OFONO_SERVICE,
-      OFONO_SUPPLEMENTARY_SERVICES_IFACE,
-      "PropertyChanged",
-      modem->path,
-      "State",
-      G_DBUS_SIGNAL_FLAGS_NONE,
-      _ussd_status_notify,
-      modem,
-      NULL);
+  case OFONO_NOTI_SIM_STATUS_CHANGED:
+    prop_cache_prefetch(modem, PROP_CACHE_SIM);
     break;
-  /* connman */
   case OFONO_NOTI_CONNMAN_STATUS:
-    watches[count++] = g_dbus_connection_signal_subscribe(modem->conn,
-      OFONO_SERVICE,
-      OFONO_CONNMAN_IFACE,
-      "PropertyChanged",
-      modem->path,
-      NULL,
-      G_DBUS_SIGNAL_FLAGS_NONE,
-      _connman_status_notify,
-      modem,
-      NULL);
+    prop_cache_prefetch(modem, PROP_CACHE_CONNMAN);
     break;
-  case OFONO_NOTI_CONNMAN_CONTEXT_ACTIVED:
-    watches[count++] = g_dbus_connection_signal_subscribe(modem->conn,
-      OFONO_SERVICE,
-      OFONO_CONTEXT_IFACE,
-      "PropertyChanged",
-      NULL,
-      "Active",
-      G_DBUS_SIGNAL_FLAGS_NONE,
-      _connman_context_actived_notify,
-      modem,
-      NULL);
-    break;
-  /* STK */
-  case OFONO_NOTI_SAT_IDLE_MODE_TEXT:
-    watches[count++] = g_dbus_connection_signal_subscribe(modem->conn,
-      OFONO_SERVICE,
-      OFONO_STK_IFACE,
-      "PropertyChanged",
-      modem->path,
-      "IdleModeText",
-      G_DBUS_SIGNAL_FLAGS_NONE,
-      _stk_idle_mode_text_notify,
-      modem,
-      NULL);
+  case OFONO_NOTI_CALL_STATUS_CHANGED:
+    /* calls which exist already aren't reported by "CallAdded" */
+    call_snapshot_seed(modem, _call_held_notify);
     break;
-  case OFONO_NOTI_SAT_MAIN_MENU:
-    watches[count++] = g_dbus_connection_signal_subscribe(modem->conn,
-      OFONO_SERVICE,
-      OFONO_STK_IFACE,
-      "PropertyChanged",
-      modem->path,
-      "MainMenu",
-      G_DBUS_SIGNAL_FLAGS_NONE,
-      _stk_main_menu_notify,
-      modem,
-      NULL);
+  default:
     break;
   }
 }
@@ -1528,44 +1932,40 @@ EXPORT_API tapi_bool ofono_register_notification_callback(struct ofono_modem *mo
       void *user_data,
       destroy_notify user_data_free_func)
 {
-  struct noti_cb_data *cb_data;
+  struct noti_cb_data cb_data;
   struct ofono_noti_data *nd;
-  GList *list;
   guint watches[MAX_WATCHES_NUM];
 
   tapi_debug("");
 
-  if (modem == NULL || cb == NULL) {
+  if (modem == NULL || cb == NULL || (unsigned int) noti >= OFONO_NOTI_MAX) {
     tapi_error("Invalid parameters");
     return FALSE;
   }
 
-  cb_data = g_new0(struct noti_cb_data, 1);
+  cb_data.cb = cb;
+  cb_data.user_data = user_data;
+  cb_data.user_data_free_func = user_data_free_func;
+  cb_data.filter = NULL;
 
-  cb_data->cb = cb;
-  cb_data->user_data = user_data;
-  cb_data->user_data_free_func = user_data_free_func;
+  g_rec_mutex_lock(&modem->noti_lock);
 
-  list = modem->noti_list;
-  nd = _find_noti_data(list, noti);
+  nd = _find_noti_data(modem, noti);
   if (nd != NULL) {
-    if (_find_noti_cb_data(nd, cb) != NULL) {
-      g_free(cb_data);
-
+    if (_find_noti_cb_data(nd, cb) >= 0)
       tapi_warn("callback alreay exist");
-      return TRUE;
-    }
+    else
+      g_array_append_val(nd->cbs, cb_data);
 
-    nd->cb_list = g_list_append(nd->cb_list, cb_data);
+    g_rec_mutex_unlock(&modem->noti_lock);
     return TRUE;
   }
 
   memset(watches, 0, sizeof(watches));
   _subscribe_notification(modem, noti, watches);
   if (watches[0] == 0) {
+    g_rec_mutex_unlock(&modem->noti_lock);
     tapi_error("fail to subscribe notification");
-    g_free(cb_data);
-
     return FALSE;
   }
 
@@ -1573,10 +1973,13 @@ EXPORT_API tapi_bool ofono_register_notification_callback(struct ofono_modem *mo
 
   nd->modem = modem;
   nd->noti = noti;
-  nd->cb_list = g_list_append(nd->cb_list, cb_data);
+  nd->cbs = g_array_sized_new(FALSE, FALSE, sizeof(struct noti_cb_data), 1);
+  g_array_append_val(nd->cbs, cb_data);
   memcpy(nd->watches, watches, sizeof(watches));
 
-  modem->noti_list = g_list_append(modem->noti_list, nd);
+  modem->noti[noti] = nd;
+
+  g_rec_mutex_unlock(&modem->noti_lock);
 
   return TRUE;
 }
@@ -1587,70 +1990,305 @@ EXPORT_API void ofono_unregister_notification_callback(struct ofono_modem *modem
 {
   struct ofono_noti_data *nd;
   struct noti_cb_data *ncbd;
+  int index;
 
   tapi_debug("");
 
-  if (modem == NULL) {
+  if (modem == NULL || cb == NULL) {
     tapi_error("Invalid parameter");
     return;
   }
 
-  nd = _find_noti_data(modem->noti_list, noti);
+  g_rec_mutex_lock(&modem->noti_lock);
+
+  nd = _find_noti_data(modem, noti);
   if (nd == NULL) {
+    g_rec_mutex_unlock(&modem->noti_lock);
     tapi_warn("Don't find notification data");
     return;
   }
 
-  ncbd = _find_noti_cb_data(nd, cb);
-  if (ncbd != NULL) {
-    nd->cb_list = g_list_remove(nd->cb_list, ncbd);
+  index = _find_noti_cb_data(nd, cb);
+  if (index < 0) {
+    g_rec_mutex_unlock(&modem->noti_lock);
+    return;
+  }
 
-    if (ncbd->user_data_free_func)
-      ncbd->user_data_free_func(ncbd->user_data);
+  ncbd = &g_array_index(nd->cbs, struct noti_cb_data, index);
+  if (ncbd->user_data_free_func)
+    ncbd->user_data_free_func(ncbd->user_data);
+  g_free(ncbd->filter);
+  ncbd->filter = NULL;
 
-    g_free(ncbd);
-  }
+  /* _notify() is walking the vector, let it compact once done */
+  if (nd->dispatching > 0) {
+    ncbd->cb = NULL;
+    nd->stale = TRUE;
+  } else {
+    g_array_remove_index(nd->cbs, index);
 
-  if (nd->cb_list == NULL) {
-    int i;
-    for (i = 0; i < MAX_WATCHES_NUM; i++) {
-      if (nd->watches[i] > 0)
-        g_dbus_connection_signal_unsubscribe(modem->conn, nd->watches[i]);
-    }
-    modem->noti_list = g_list_remove(modem->noti_list, nd);
-    g_free(nd);
+    if (nd->cbs->len == 0)
+      _noti_data_release(modem, nd);
   }
+
+  g_rec_mutex_unlock(&modem->noti_lock);
 }
 
 EXPORT_API tapi_bool ofono_init()
 {
   tapi_debug("");
 
+  if (s_init_cancellable != NULL) {
+    tapi_error("ofono_init_async() is in progress");
+    return FALSE;
+  }
+
   if (_get_dbus_connection() == NULL) {
     tapi_error("fail to get dbus connection");
     return FALSE;
   }
 
-  return TRUE;
+  return manager_start(s_bus_conn);
 }
 
-EXPORT_API void ofono_deinit()
+/* complete the ofono_init_async() and ofono_modem_init_async() waiters */
+static void _init_done(TResult ret)
+{
+  GSList *waiters, *l;
+
+  g_mutex_lock(&s_init_lock);
+
+  if (s_init_cancellable != NULL) {
+    g_object_unref(s_init_cancellable);
+    s_init_cancellable = NULL;
+  }
+
+  waiters = s_init_waiters;
+  s_init_waiters = NULL;
+
+  g_mutex_unlock(&s_init_lock);
+
+  for (l = waiters; l; l = l->next) {
+    struct init_waiter *w = l->data;
+    struct ofono_modem *modem = NULL;
+    TResult r = ret;
+
+    if (w->modem_init && r == TAPI_RESULT_OK) {
+      modem = _modem_init_lookup(w->path);
+      if (modem == NULL)
+        r = TAPI_RESULT_FAIL;
+    }
+
+    CALL_RESP_CALLBACK(r, modem, w->cbd);
+
+    g_free(w->path);
+    g_free(w);
+  }
+
+  g_slist_free(waiters);
+}
+
+static void _on_modems_ready(TResult ret, const void *resp_data,
+      const void *user_data)
+{
+  GCancellable *cancellable = (GCancellable *) user_data;
+  tapi_bool cancelled = g_cancellable_is_cancelled(cancellable);
+
+  g_object_unref(cancellable);
+
+  /* ofono_deinit() was called meanwhile */
+  if (cancelled)
+    return;
+
+  tapi_info("ofono is ready in %" G_GINT64_FORMAT " us",
+        g_get_monotonic_time() - s_init_start);
+  _init_done(ret);
+}
+
+/* the shard connections are there, the modems can be created */
+static void _on_shards_ready(gpointer data)
+{
+  GCancellable *cancellable = data;
+
+  /* cancelled by ofono_deinit(), the waiters are already completed */
+  if (g_cancellable_is_cancelled(cancellable)) {
+    g_object_unref(cancellable);
+    return;
+  }
+
+  /* GetModems carries the modem properties, nothing else to fetch */
+  manager_start_async(s_bus_conn, _on_modems_ready, cancellable);
+}
+
+struct init_connect {
+  char *addr;
+  GCancellable *cancellable;
+};
+
+static void _init_connect_free(struct init_connect *ic)
+{
+  g_free(ic->addr);
+  g_free(ic);
+}
+
+static void _on_connection_ready(GObject *obj, GAsyncResult *result,
+      gpointer user_data)
+{
+  struct init_connect *ic = user_data;
+  GCancellable *cancellable = ic->cancellable;
+  GError *error = NULL;
+  GDBusConnection *conn;
+
+  conn = g_dbus_connection_new_for_address_finish(result, &error);
+
+  /* cancelled by ofono_deinit(), the waiters are already completed */
+  if (g_cancellable_is_cancelled(cancellable)) {
+    if (conn != NULL)
+      g_object_unref(conn);
+    else
+      g_error_free(error);
+
+    g_object_unref(cancellable);
+    _init_connect_free(ic);
+    return;
+  }
+
+  if (conn == NULL) {
+    tapi_error("fail to create dbus connection: %s", error->message);
+    g_error_free(error);
+    g_object_unref(cancellable);
+    _init_connect_free(ic);
+    _init_done(TAPI_RESULT_FAIL);
+    return;
+  }
+
+  g_mutex_lock(&s_init_lock);
+  s_bus_conn = conn;
+  g_mutex_unlock(&s_init_lock);
+
+  /* the shards connect to the same bus, the modems are spread over them */
+  dispatch_connect_async(ic->addr, cancellable, _on_shards_ready,
+        cancellable);
+  _init_connect_free(ic);
+}
+
+/* on the dispatch thread, so that the connection I/O is attached there */
+static void _init_connect(gpointer data)
+{
+  struct init_connect *ic = data;
+
+  g_dbus_connection_new_for_address(ic->addr,
+        G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+        G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION,
+        NULL, ic->cancellable, dispatch_ready,
+        dispatch_ready_new(_on_connection_ready, ic));
+}
+
+/* must be called with the init lock held */
+static void _add_init_waiter(tapi_bool modem_init, const char *path,
+      response_cb cb, void *user_data)
+{
+  struct init_waiter *w;
+
+  w = g_new0(struct init_waiter, 1);
+  w->modem_init = modem_init;
+  w->path = g_strdup(path);
+  NEW_RSP_CB_DATA(w->cbd, cb, user_data);
+
+  s_init_waiters = g_slist_append(s_init_waiters, w);
+}
+
+EXPORT_API void ofono_init_async(response_cb cb, void *user_data)
 {
+  struct init_connect *ic;
+  char *addr;
+
   tapi_debug("");
 
-  if (!s_bus_conn)
+  g_mutex_lock(&s_init_lock);
+
+  /* already initialized */
+  if (s_bus_conn != NULL && s_init_cancellable == NULL) {
+    g_mutex_unlock(&s_init_lock);
+    if (cb)
+      cb(TAPI_RESULT_OK, NULL, user_data);
+    return;
+  }
+
+  _add_init_waiter(FALSE, NULL, cb, user_data);
+
+  if (s_init_cancellable != NULL) {
+    g_mutex_unlock(&s_init_lock);
+    return;
+  }
+
+  addr = _get_dbus_address();
+  if (addr == NULL) {
+    g_mutex_unlock(&s_init_lock);
+    _init_done(TAPI_RESULT_FAIL);
     return;
+  }
+
+  s_init_cancellable = g_cancellable_new();
+  s_init_start = g_get_monotonic_time();
+
+  ic = g_new0(struct init_connect, 1);
+  ic->addr = addr;
+  ic->cancellable = g_object_ref(s_init_cancellable);
+
+  g_mutex_unlock(&s_init_lock);
+
+  dispatch_run(NULL, _init_connect, ic);
+}
+
+EXPORT_API void ofono_modem_init_async(const char *modem, response_cb cb,
+      void *user_data)
+{
+  struct ofono_modem *m;
+
+  tapi_debug("");
 
-  if (s_modem_added_watch > 0) {
-    g_dbus_connection_signal_unsubscribe(s_bus_conn, s_modem_added_watch);
-		s_modem_added_watch = 0;
+  g_mutex_lock(&s_init_lock);
+
+  if (s_bus_conn == NULL && s_init_cancellable == NULL) {
+    g_mutex_unlock(&s_init_lock);
+    tapi_error("invalid parameter");
+    if (cb)
+      cb(TAPI_RESULT_INVALID_ARGS, NULL, user_data);
+    return;
   }
 
-	if (s_modem_removed_watch > 0) {
-    g_dbus_connection_signal_unsubscribe(s_bus_conn, s_modem_removed_watch);
-		s_modem_removed_watch = 0;
+  /* wait for the modem registry */
+  if (s_init_cancellable != NULL) {
+    _add_init_waiter(TRUE, modem, cb, user_data);
+    g_mutex_unlock(&s_init_lock);
+    return;
   }
 
+  g_mutex_unlock(&s_init_lock);
+
+  m = _modem_init_lookup(modem);
+  if (cb)
+    cb(m ? TAPI_RESULT_OK : TAPI_RESULT_FAIL, m, user_data);
+}
+
+EXPORT_API void ofono_deinit()
+{
+  tapi_debug("");
+
+  g_mutex_lock(&s_init_lock);
+  if (s_init_cancellable != NULL)
+    g_cancellable_cancel(s_init_cancellable);
+  g_mutex_unlock(&s_init_lock);
+
+  _init_done(TAPI_RESULT_FAIL);
+
+  if (!s_bus_conn)
+    return;
+
+  manager_stop();
+
+  dispatch_disconnect();
   g_dbus_connection_close_sync(s_bus_conn, NULL, NULL);
   s_bus_conn = NULL;
 }
@@ -20,9 +20,27 @@
 #include "common.h"
 #include "log.h"
 
-struct set_context_interm_info {
-  char *path;
-  struct pdp_context context;
+/* one ofono_connman_set_context() request */
+struct set_context_data {
+  struct response_cb_data *cbd;
+  gint pending; /* SetProperty calls not answered yet, atomic */
+  TResult ret;
+  const char *failed; /* first property which failed */
+};
+
+struct set_context_call {
+  struct set_context_data *scd;
+  const char *key;
+};
+
+/* set in this order by ofono_connman_set_context() */
+static const char *context_set_keys[] = {
+  "Protocol",
+  "AccessPointName",
+  "Username",
+  "Password",
+  "MessageProxy",
+  "MessageCenter",
 };
 
 static const char *_context_type_to_str(enum context_type type)
@@ -42,27 +60,32 @@ static const char *_context_type_to_str(enum context_type type)
   }
 }
 
+static const struct str_map context_type_map[] = {
+  {"mms", CONTEXT_TYPE_MMS},
+  {"internet", CONTEXT_TYPE_INTERNET},
+  {"wap", CONTEXT_TYPE_WAP},
+  {"ims", CONTEXT_TYPE_IMS},
+  {NULL, 0}
+};
+
+static struct str_table context_type_table = STR_TABLE_INIT(context_type_map);
+
 static enum context_type _str_to_context_type(const char *type)
 {
+  int val;
+
   if (type == NULL) {
     tapi_error("context type string is null");
     return CONTEXT_TYPE_UNKNOWN;
   }
 
-  if (g_strcmp0(type, "mms") == 0)
-    return CONTEXT_TYPE_MMS;
-
-  if (g_strcmp0(type, "internet") == 0)
-    return CONTEXT_TYPE_INTERNET;
-
-  if (g_strcmp0(type, "wap") == 0)
-    return CONTEXT_TYPE_WAP;
-
-  if (g_strcmp0(type, "ims") == 0)
-    return CONTEXT_TYPE_IMS;
+  val = str_table_lookup(&context_type_table, type, -1);
+  if (val < 0) {
+    tapi_warn("unknown context type: %s", type);
+    return CONTEXT_TYPE_UNKNOWN;
+  }
 
-  tapi_warn("unknown context type: %s", type);
-  return CONTEXT_TYPE_UNKNOWN;
+  return val;
 }
 
 static const char *_context_ip_type_to_str(enum ip_protocol protocol)
@@ -101,182 +124,372 @@ static void _on_response_add_context(GObject *obj, GAsyncResult *result,
   g_free(path);
 }
 
-EXPORT_API void ofono_connman_add_context(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_connman_add_context(struct ofono_modem *modem,
       enum context_type type, response_cb cb,
       void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
   GVariant *var;
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
   tapi_debug("Type: %d", type);
 
   var = g_variant_new("(s)", _context_type_to_str(type));
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_CONNMAN_IFACE, "AddContext", var,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       _on_response_add_context, cbd);
+
+  return id;
 }
 
-EXPORT_API void ofono_connman_remove_context(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_connman_remove_context(struct ofono_modem *modem,
       const char *path, response_cb cb,
       void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
   GVariant *var;
 
   CHECK_PARAMETERS(modem && path, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
   tapi_debug("Path: %s", path);
 
   var = g_variant_new("(o)", path);
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_CONNMAN_IFACE, "RemoveContext", var,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       on_response_common, cbd);
+
+  return id;
 }
 
 static void _on_response_set_context(GObject *obj, GAsyncResult *result,
     gpointer user_data)
 {
   TResult ret;
-  GVariant *dbus_result, *var, *val;
+  GVariant *dbus_result;
   GError *error = NULL;
-  struct interm_response_cb_data *icbd = user_data;
-  struct response_cb_data *cbd = icbd->cbd;
-  struct set_context_interm_info *iinfo = icbd->user_data;
+  struct set_context_call *call = user_data;
+  struct set_context_data *scd = call->scd;
 
   dbus_result = g_dbus_connection_call_finish(G_DBUS_CONNECTION(obj), result,
        &error);
-  g_variant_unref(dbus_result);
+  if (dbus_result != NULL)
+    g_variant_unref(dbus_result);
 
   ret = ofono_error_parse(error);
   if (error)
     g_error_free(error);
-  if (ret != TAPI_RESULT_OK)
-    goto done;
-
-  if (iinfo->context.apn != NULL) {
-    tapi_debug("APN: %s", iinfo->context.apn);
-    var = g_variant_new_string(iinfo->context.apn);
-    val = g_variant_new("(sv)", "AccessPointName", var);
-    g_dbus_connection_call(icbd->modem->conn, OFONO_SERVICE, iinfo->path,
-        OFONO_CONTEXT_IFACE, "SetProperty", val, NULL, G_DBUS_CALL_FLAGS_NONE,
-        -1, NULL, _on_response_set_context, icbd);
-    g_free(iinfo->context.apn);
-    iinfo->context.apn = NULL;
-    return;
-  }
 
-  if (iinfo->context.user_name != NULL) {
-    tapi_debug("User: %s", iinfo->context.user_name);
-    var = g_variant_new_string(iinfo->context.user_name);
-    val = g_variant_new("(sv)", "Username", var);
-    g_dbus_connection_call(icbd->modem->conn, OFONO_SERVICE, iinfo->path,
-        OFONO_CONTEXT_IFACE, "SetProperty", val, NULL, G_DBUS_CALL_FLAGS_NONE,
-        -1, NULL, _on_response_set_context, icbd);
-    g_free(iinfo->context.user_name);
-    iinfo->context.user_name = NULL;
-    return;
+  /* report the first property which failed */
+  if (ret != TAPI_RESULT_OK && scd->ret == TAPI_RESULT_OK) {
+    tapi_error("%s failed: %d", call->key, ret);
+    scd->ret = ret;
+    scd->failed = call->key;
   }
 
-  if (iinfo->context.pwd != NULL) {
-    tapi_debug("Password: %s", iinfo->context.pwd);
-    var = g_variant_new_string(iinfo->context.pwd);
-    val = g_variant_new("(sv)", "Password", var);
-    g_dbus_connection_call(icbd->modem->conn, OFONO_SERVICE, iinfo->path,
-        OFONO_CONTEXT_IFACE, "SetProperty", val, NULL, G_DBUS_CALL_FLAGS_NONE,
-        -1, NULL, _on_response_set_context, icbd);
-    g_free(iinfo->context.pwd);
-    iinfo->context.pwd = NULL;
-    return;
-  }
+  g_free(call);
 
-  if (iinfo->context.proxy != NULL) {
-    tapi_debug("MessageProxy: %s", iinfo->context.proxy);
-    var = g_variant_new_string(iinfo->context.proxy);
-    val = g_variant_new("(sv)", "MessageProxy", var);
-    g_dbus_connection_call(icbd->modem->conn, OFONO_SERVICE, iinfo->path,
-        OFONO_CONTEXT_IFACE, "SetProperty", val, NULL, G_DBUS_CALL_FLAGS_NONE,
-        -1, NULL, _on_response_set_context, icbd);
-    g_free(iinfo->context.proxy);
-    iinfo->context.proxy = NULL;
+  if (!g_atomic_int_dec_and_test(&scd->pending))
     return;
-  }
 
-  if (iinfo->context.mmsc != NULL) {
-    tapi_debug("MessageCenter: %s", iinfo->context.mmsc);
-    var = g_variant_new_string(iinfo->context.mmsc);
-    val = g_variant_new("(sv)", "MessageCenter", var);
-    g_dbus_connection_call(icbd->modem->conn, OFONO_SERVICE, iinfo->path,
-        OFONO_CONTEXT_IFACE, "SetProperty", val, NULL, G_DBUS_CALL_FLAGS_NONE,
-        -1, NULL, _on_response_set_context, icbd);
-    g_free(iinfo->context.mmsc);
-    iinfo->context.mmsc = NULL;
-    return;
+  CALL_RESP_CALLBACK(scd->ret, scd->failed, scd->cbd);
+  g_free(scd);
+}
+
+static void _set_context_unchanged_run(gpointer data)
+{
+  struct set_context_data *scd = data;
+
+  if (g_cancellable_is_cancelled(scd->cbd->cancellable))
+    scd->ret = TAPI_RESULT_CANCELLED;
+
+  CALL_RESP_CALLBACK(scd->ret, scd->failed, scd->cbd);
+  g_free(scd);
+}
+
+static gboolean _on_set_context_unchanged(gpointer data)
+{
+  dispatch_post(_set_context_unchanged_run, data);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* sends "key" unless the cached value is already "value" */
+static void _set_context_property(struct ofono_modem *modem,
+      const char *path, const char *key, const char *value,
+      struct set_context_data *scd)
+{
+  struct set_context_call *call;
+  GVariant *var, *cached;
+
+  var = g_variant_ref_sink(g_variant_new_string(value));
+
+  cached = context_cache_lookup(modem, path, key);
+  if (cached != NULL) {
+    tapi_bool same = g_variant_equal(cached, var);
+
+    g_variant_unref(cached);
+    if (same) {
+      tapi_debug("%s unchanged", key);
+      g_variant_unref(var);
+      return;
+    }
   }
 
-done:
-  if (cbd->cb != NULL)
-    cbd->cb(ret, NULL, cbd->user_data);
+  tapi_debug("%s: %s", key, value);
 
-  g_free(cbd);
-  g_free(icbd);
-  g_free(iinfo->path);
-  g_free(iinfo->context.apn);
-  g_free(iinfo->context.user_name);
-  g_free(iinfo->context.pwd);
-  g_free(iinfo->context.proxy);
-  g_free(iinfo->context.mmsc);
-  g_free(iinfo);
+  call = g_new0(struct set_context_call, 1);
+  call->scd = scd;
+  call->key = key;
+  g_atomic_int_inc(&scd->pending);
+
+  dispatch_call(modem->conn, OFONO_SERVICE, path,
+      OFONO_CONTEXT_IFACE, "SetProperty", g_variant_new("(sv)", key, var),
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem),
+      scd->cbd->cancellable, _on_response_set_context, call);
+
+  g_variant_unref(var);
 }
 
-EXPORT_API void ofono_connman_set_context(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_connman_set_context(struct ofono_modem *modem,
       char *path, struct pdp_context *context,
       response_cb cb, void *user_data)
 {
-  GVariant *var, *val;
+  struct set_context_data *scd;
   struct response_cb_data *cbd;
-  struct interm_response_cb_data *icbd;
-  struct set_context_interm_info *iinfo;
+  ofono_request id;
+  const char *values[G_N_ELEMENTS(context_set_keys)];
+  unsigned int i;
 
   CHECK_PARAMETERS(modem && path && context, cb, user_data);
   tapi_debug("Path: %s", path);
 
-  iinfo = g_new0(struct set_context_interm_info, 1);
-  memset(iinfo, 0, sizeof(struct set_context_interm_info));
-  iinfo->path = g_strdup(path);
-  if (context->apn)
-    iinfo->context.apn = g_strdup(context->apn);
-  if (context->user_name)
-    iinfo->context.user_name = g_strdup(context->user_name);
-  if (context->pwd)
-    iinfo->context.pwd = g_strdup(context->pwd);
-  if (context->proxy)
-    iinfo->context.proxy = g_strdup(context->proxy);
-  if (context->mmsc)
-    iinfo->context.mmsc = g_strdup(context->mmsc);
+  values[0] = _context_ip_type_to_str(context->protocol);
+  values[1] = context->apn;
+  values[2] = context->user_name;
+  values[3] = context->pwd;
+  values[4] = context->proxy;
+  values[5] = context->mmsc;
+
   NEW_RSP_CB_DATA(cbd, cb, user_data);
-  NEW_INTERM_RSP_CB_DATA(icbd, cbd, modem, iinfo);
+  id = cbd->id;
+
+  scd = g_new0(struct set_context_data, 1);
+  scd->cbd = cbd;
+  scd->ret = TAPI_RESULT_OK;
+
+  /*
+   * All the calls are sent at once, the replies are counted down, on the
+   * dispatch thread while the calls are still being sent. The extra
+   * reference keeps scd alive until every call has been sent.
+   */
+  scd->pending = 1;
+  for (i = 0; i < G_N_ELEMENTS(context_set_keys); i++) {
+    if (values[i] != NULL)
+      _set_context_property(modem, path, context_set_keys[i], values[i], scd);
+  }
+
+  if (!g_atomic_int_dec_and_test(&scd->pending))
+    return id;
+
+  /*
+   * nothing to change, or every reply is already in: still answered later
+   * like any other request
+   */
+  dispatch_timeout_add(modem->conn, 0, _on_set_context_unchanged, scd);
+  return id;
+}
+
+/* keys of the context properties and of its "Settings" dictionaries */
+enum context_key {
+  CONTEXT_KEY_TYPE,
+  CONTEXT_KEY_ACTIVE,
+  CONTEXT_KEY_SETTINGS,
+  CONTEXT_KEY_IPV6_SETTINGS,
+  CONTEXT_KEY_INTERFACE,
+  CONTEXT_KEY_ADDRESS,
+  CONTEXT_KEY_NETMASK,
+  CONTEXT_KEY_PREFIX_LENGTH,
+  CONTEXT_KEY_GATEWAY,
+  CONTEXT_KEY_PROXY,
+  CONTEXT_KEY_DNS,
+};
+
+static const struct str_map context_key_map[] = {
+  {"Type", CONTEXT_KEY_TYPE},
+  {"Active", CONTEXT_KEY_ACTIVE},
+  {"Settings", CONTEXT_KEY_SETTINGS},
+  {"IPv6.Settings", CONTEXT_KEY_IPV6_SETTINGS},
+  {"Interface", CONTEXT_KEY_INTERFACE},
+  {"Address", CONTEXT_KEY_ADDRESS},
+  {"Netmask", CONTEXT_KEY_NETMASK},
+  {"PrefixLength", CONTEXT_KEY_PREFIX_LENGTH},
+  {"Gateway", CONTEXT_KEY_GATEWAY},
+  {"Proxy", CONTEXT_KEY_PROXY},
+  {"DomainNameServers", CONTEXT_KEY_DNS},
+  {NULL, 0}
+};
 
-  tapi_debug("Protocol: %d", context->protocol);
+static struct str_table context_key_table = STR_TABLE_INIT(context_key_map);
 
-  var = g_variant_new_string(_context_ip_type_to_str(context->protocol));
-  val = g_variant_new("(sv)", "Protocol", var);
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, path, OFONO_CONTEXT_IFACE,
-      "SetProperty", val, NULL, G_DBUS_CALL_FLAGS_NONE, -1,
-      NULL, _on_response_set_context, icbd);
+/*
+ * The parsers below leave the strings of "info" pointing into the reply,
+ * see _context_info_own() to keep them.
+ */
+static void _parse_context_dns(GVariant *v, char **dns)
+{
+  GVariantIter dns_iter;
+  tapi_bool next;
+
+  g_variant_iter_init(&dns_iter, v);
+  next = g_variant_iter_next(&dns_iter, "&s", &dns[0]);
+  tapi_debug("DNS: %s", dns[0]);
+  if (next) {
+    g_variant_iter_next(&dns_iter, "&s", &dns[1]);
+    tapi_debug("DNS: %s", dns[1]);
+  }
+}
+
+static void _parse_context_ipv4(GVariant *var_val,
+      struct pdp_context_info *info)
+{
+  const char *k;
+  GVariant *v;
+  GVariantIter v4_iter;
+
+  g_variant_iter_init(&v4_iter, var_val);
+  while(g_variant_iter_next(&v4_iter, "{&sv}", &k, &v)) {
+    switch (str_table_lookup(&context_key_table, k, -1)) {
+    case CONTEXT_KEY_INTERFACE:
+      info->ipv4.iface = (char *) g_variant_get_string(v, NULL);
+      tapi_debug("Interface: %s", info->ipv4.iface);
+      break;
+    case CONTEXT_KEY_ADDRESS:
+      info->ipv4.ip = (char *) g_variant_get_string(v, NULL);
+      tapi_debug("Address: %s", info->ipv4.ip);
+      break;
+    case CONTEXT_KEY_NETMASK:
+      info->ipv4.netmask = (char *) g_variant_get_string(v, NULL);
+      tapi_debug("Netmask: %s", info->ipv4.netmask);
+      break;
+    case CONTEXT_KEY_GATEWAY:
+      info->ipv4.gateway = (char *) g_variant_get_string(v, NULL);
+      tapi_debug("Gateway: %s", info->ipv4.gateway);
+      break;
+    case CONTEXT_KEY_PROXY:
+      info->ipv4.proxy = (char *) g_variant_get_string(v, NULL);
+      tapi_debug("Proxy: %s", info->ipv4.proxy);
+      break;
+    case CONTEXT_KEY_DNS:
+      _parse_context_dns(v, info->ipv4.dns);
+      break;
+    }
+
+    g_variant_unref(v);
+  }
+}
+
+static void _parse_context_ipv6(GVariant *var_val,
+      struct pdp_context_info *info)
+{
+  const char *k;
+  GVariant *v;
+  GVariantIter v6_iter;
+
+  g_variant_iter_init(&v6_iter, var_val);
+  while(g_variant_iter_next(&v6_iter, "{&sv}", &k, &v)) {
+    switch (str_table_lookup(&context_key_table, k, -1)) {
+    case CONTEXT_KEY_INTERFACE:
+      info->ipv6.iface = (char *) g_variant_get_string(v, NULL);
+      tapi_debug("Interface: %s", info->ipv6.iface);
+      break;
+    case CONTEXT_KEY_ADDRESS:
+      info->ipv6.ip = (char *) g_variant_get_string(v, NULL);
+      tapi_debug("Address: %s", info->ipv6.ip);
+      break;
+    case CONTEXT_KEY_PREFIX_LENGTH:
+      g_variant_get(v, "y", &info->ipv6.prefix_len);
+      tapi_debug("PrefixLength: %d", info->ipv6.prefix_len);
+      break;
+    case CONTEXT_KEY_GATEWAY:
+      info->ipv6.gateway = (char *) g_variant_get_string(v, NULL);
+      tapi_debug("Gateway: %s", info->ipv6.gateway);
+      break;
+    case CONTEXT_KEY_DNS:
+      _parse_context_dns(v, info->ipv6.dns);
+      break;
+    }
+
+    g_variant_unref(v);
+  }
+}
+
+static void _parse_context_info(GVariant *var_properties,
+      struct pdp_context_info *info)
+{
+  GVariant *var_val, *props;
+  GVariantIter iter;
+  const char *key;
+
+  memset(info, 0, sizeof(struct pdp_context_info));
+  props = g_variant_get_child_value(var_properties, 0);
+  g_variant_iter_init(&iter, props);
+  while (g_variant_iter_next(&iter, "{&sv}", &key, &var_val)) {
+    switch (str_table_lookup(&context_key_table, key, -1)) {
+    case CONTEXT_KEY_TYPE: {
+      const char *type = g_variant_get_string(var_val, NULL);
+      info->type = _str_to_context_type(type);
+      tapi_debug("Type(%d): %s", info->type, type);
+      break;
+    }
+    case CONTEXT_KEY_ACTIVE:
+      g_variant_get(var_val, "b", &info->actived);
+      tapi_debug("Actived: %d", info->actived);
+      break;
+    case CONTEXT_KEY_SETTINGS:
+      _parse_context_ipv4(var_val, info);
+      break;
+    case CONTEXT_KEY_IPV6_SETTINGS:
+      _parse_context_ipv6(var_val, info);
+      break;
+    }
+
+    g_variant_unref(var_val);
+  }
+
+  g_variant_unref(props);
+}
+
+/* copy the strings borrowed from the reply, for the caller to keep */
+static void _context_info_own(struct pdp_context_info *info)
+{
+  info->ipv4.iface = g_strdup(info->ipv4.iface);
+  info->ipv4.ip = g_strdup(info->ipv4.ip);
+  info->ipv4.netmask = g_strdup(info->ipv4.netmask);
+  info->ipv4.gateway = g_strdup(info->ipv4.gateway);
+  info->ipv4.proxy = g_strdup(info->ipv4.proxy);
+  info->ipv4.dns[0] = g_strdup(info->ipv4.dns[0]);
+  info->ipv4.dns[1] = g_strdup(info->ipv4.dns[1]);
+
+  info->ipv6.iface = g_strdup(info->ipv6.iface);
+  info->ipv6.ip = g_strdup(info->ipv6.ip);
+  info->ipv6.gateway = g_strdup(info->ipv6.gateway);
+  info->ipv6.dns[0] = g_strdup(info->ipv6.dns[0]);
+  info->ipv6.dns[1] = g_strdup(info->ipv6.dns[1]);
 }
 
 EXPORT_API tapi_bool ofono_connman_get_context_info(struct ofono_modem *modem,
       char *path, struct pdp_context_info *info)
 {
   GError *error = NULL;
-  GVariant *var_properties, *var_val;
-  GVariantIter *iter;
-  char *key;
+  GVariant *var_properties;
 
   if (modem == NULL || info == NULL || path == NULL) {
     tapi_error("Invalid parameter");
@@ -301,111 +514,84 @@ EXPORT_API tapi_bool ofono_connman_get_context_info(struct ofono_modem *modem,
     return FALSE;
   }
 
-  memset(info, 0, sizeof(struct pdp_context_info));
-  g_variant_get(var_properties, "(a{sv})", &iter);
-  while (g_variant_iter_next(iter, "{sv}", &key, &var_val)) {
-    if (g_strcmp0(key, "Type") == 0) {
-      const char *type = g_variant_get_string(var_val, NULL);
-      info->type = _str_to_context_type(type);
-      tapi_debug("Type(%d): %s", info->type, type);
-    } else if (g_strcmp0(key, "Active") == 0) {
-      g_variant_get(var_val, "b", &info->actived);
-      tapi_debug("Actived: %d", info->actived);
-    } else if (g_strcmp0(key, "Settings") == 0) {
-      char *k;
-      GVariant *v;
-      GVariantIter *v4_iter;
-
-      g_variant_get(var_val, "a{sv}", &v4_iter);
-      while(g_variant_iter_next(v4_iter, "{sv}", &k, &v)) {
-        if (g_strcmp0(k, "Interface") == 0) {
-          g_variant_get(v, "s", &info->ipv4.iface);
-          tapi_debug("Interface: %s", info->ipv4.iface);
-        } else if (g_strcmp0(k, "Address") == 0) {
-          g_variant_get(v, "s", &info->ipv4.ip);
-          tapi_debug("Address: %s", info->ipv4.ip);
-        } else if (g_strcmp0(k, "Netmask") == 0) {
-          g_variant_get(v, "s", &info->ipv4.netmask);
-          tapi_debug("Netmask: %s", info->ipv4.netmask);
-        } else if (g_strcmp0(k, "Gateway") == 0) {
-          g_variant_get(v, "s", &info->ipv4.gateway);
-          tapi_debug("Gateway: %s", info->ipv4.gateway);
-        } else if (g_strcmp0(k, "Proxy") == 0) {
-          g_variant_get(v, "s", &info->ipv4.proxy);
-          tapi_debug("Proxy: %s", info->ipv4.proxy);
-        } else if (g_strcmp0(k, "DomainNameServers") == 0) {
-          GVariantIter *dns_iter;
-          tapi_bool next;
-          g_variant_get(v, "as", &dns_iter);
-          next = g_variant_iter_next(dns_iter, "s", &info->ipv4.dns[0]);
-          tapi_debug("DNS: %s", info->ipv4.dns[0]);
-          if (next) {
-            g_variant_iter_next(dns_iter, "s", &info->ipv4.dns[1]);
-            tapi_debug("DNS: %s", info->ipv4.dns[1]);
-          }
-          g_variant_iter_free(dns_iter);
-        }
-
-        g_free(k);
-        g_variant_unref(v);
-      }
-      g_variant_iter_free(v4_iter);
-    } else if (g_strcmp0(key, "IPv6.Settings") == 0) {
-      char *k;
-      GVariant *v;
-      GVariantIter *v6_iter;
-
-      g_variant_get(var_val, "a{sv}", &v6_iter);
-      while(g_variant_iter_next(v6_iter, "{sv}", &k, &v)) {
-        if (g_strcmp0(k, "Interface") == 0) {
-          g_variant_get(v, "s", &info->ipv6.iface);
-          tapi_debug("Interface: %s", info->ipv6.iface);
-        } else if (g_strcmp0(k, "Address") == 0) {
-          g_variant_get(v, "s", &info->ipv6.ip);
-          tapi_debug("Address: %s", info->ipv6.ip);
-        } else if (g_strcmp0(k, "PrefixLength") == 0) {
-          g_variant_get(v, "y", &info->ipv6.prefix_len);
-          tapi_debug("PrefixLength: %d", info->ipv6.prefix_len);
-        } else if (g_strcmp0(k, "Gateway") == 0) {
-          g_variant_get(v, "s", &info->ipv6.gateway);
-          tapi_debug("Gateway: %s", info->ipv6.gateway);
-        } else if (g_strcmp0(k, "DomainNameServers") == 0) {
-          GVariantIter *dns_iter;
-          tapi_bool next;
-          g_variant_get(v, "as", &dns_iter);
-          next = g_variant_iter_next(dns_iter, "s", &info->ipv6.dns[0]);
-          tapi_debug("DNS: %s", info->ipv6.dns[0]);
-          if (next) {
-            g_variant_iter_next(dns_iter, "s", &info->ipv6.dns[1]);
-            tapi_debug("DNS: %s", info->ipv6.dns[1]);
-          }
-          g_variant_iter_free(dns_iter);
-        }
-        g_free(k);
-        g_variant_unref(v);
-      }
-      g_variant_iter_free(v6_iter);
-    }
-
-    g_free(key);
-    g_variant_unref(var_val);
-  }
-
-  g_variant_iter_free(iter);
+  _parse_context_info(var_properties, info);
+  _context_info_own(info);
   g_variant_unref(var_properties);
 
   return TRUE;
 }
 
-EXPORT_API tapi_bool ofono_connman_get_contexts(struct ofono_modem *modem,
-      struct str_list **contexts)
+static void _on_response_get_context_info(GObject *obj,
+      GAsyncResult *result, gpointer user_data)
 {
+  TResult ret;
+  GVariant *resp;
   GError *error = NULL;
-  GVariant *var, *var_props;
+  struct response_cb_data *cbd = user_data;
+  struct pdp_context_info info;
+
+  resp = dispatch_call_finish(obj, result, &error);
+
+  CHECK_RESULT(ret, error, cbd, resp);
+
+  _parse_context_info(resp, &info);
+
+  CALL_RESP_CALLBACK(ret, &info, cbd);
+  g_variant_unref(resp);
+}
+
+EXPORT_API ofono_request ofono_connman_get_context_info_async(
+      struct ofono_modem *modem, char *path,
+      response_cb cb, void *user_data)
+{
+  struct response_cb_data *cbd;
+  ofono_request id;
+
+  CHECK_PARAMETERS(modem && path, cb, user_data);
+  NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
+
+  tapi_debug("Path: %s", path);
+
+  dispatch_call_shared(modem->conn, OFONO_SERVICE, path,
+      OFONO_CONTEXT_IFACE, "GetProperties", NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
+      _on_response_get_context_info, cbd);
+
+  return id;
+}
+
+static struct str_list *_parse_contexts(struct ofono_modem *modem,
+      GVariant *var)
+{
+  struct str_list *contexts;
+  GVariant *var_props;
   GVariantIter *iter;
   char *path;
   int i = 0;
 
+  g_variant_get(var, "(a(oa{sv}))", &iter);
+  contexts = g_malloc(sizeof(struct str_list));
+  contexts->count = g_variant_iter_n_children(iter);
+  contexts->data = g_malloc(sizeof(char *) * contexts->count);
+  while (g_variant_iter_next(iter, "(o@a{sv})", &path, &var_props)) {
+    tapi_debug("Path: %s", path);
+    contexts->data[i++] = path;
+
+    context_cache_fill(modem, path, var_props);
+    g_variant_unref(var_props);
+  }
+  g_variant_iter_free(iter);
+
+  return contexts;
+}
+
+EXPORT_API tapi_bool ofono_connman_get_contexts(struct ofono_modem *modem,
+      struct str_list **contexts)
+{
+  GError *error = NULL;
+  GVariant *var;
+
   if (modem == NULL || contexts == NULL) {
     tapi_error("Invalid parameter");
     return FALSE;
@@ -421,28 +607,75 @@ EXPORT_API tapi_bool ofono_connman_get_contexts(struct ofono_modem *modem,
     return FALSE;
   }
 
+  context_cache_watch(modem);
+
   var = g_dbus_connection_call_sync(modem->conn,
       OFONO_SERVICE, modem->path, OFONO_CONNMAN_IFACE,
       "GetContexts", NULL, NULL,
       G_DBUS_SEND_MESSAGE_FLAGS_NONE, -1, NULL, &error);
 
-  g_variant_get(var, "(a(oa{sv}))", &iter);
-  *contexts = g_malloc(sizeof(struct str_list));
-  (*contexts)->count = g_variant_iter_n_children(iter);
-  (*contexts)->data = g_malloc(sizeof(char *) * (*contexts)->count);
-  while (g_variant_iter_next(iter, "(o@a{sv})", &path, &var_props)) {
-    tapi_debug("Path: %s", path);
-    (*contexts)->data[i++] = path;
-
-    g_variant_unref(var_props);
+  if (var == NULL) {
+    tapi_error("dbus call failed (%s)", error->message);
+    g_error_free(error);
+    return FALSE;
   }
-  g_variant_iter_free(iter);
+
+  *contexts = _parse_contexts(modem, var);
   g_variant_unref(var);
 
   return TRUE;
 }
 
-EXPORT_API void ofono_connman_activate_context(struct ofono_modem *modem,
+static void _on_response_get_contexts(GObject *obj,
+      GAsyncResult *result, gpointer user_data)
+{
+  TResult ret;
+  GVariant *resp;
+  GError *error = NULL;
+  struct interm_response_cb_data *icbd = user_data;
+  struct response_cb_data *cbd = icbd->cbd;
+  struct ofono_modem *modem = icbd->modem;
+  struct str_list *contexts;
+
+  g_free(icbd);
+
+  resp = g_dbus_connection_call_finish(G_DBUS_CONNECTION(obj), result, &error);
+
+  CHECK_RESULT(ret, error, cbd, resp);
+
+  contexts = _parse_contexts(modem, resp);
+
+  CALL_RESP_CALLBACK(ret, contexts, cbd);
+  ofono_string_list_free(contexts);
+  g_variant_unref(resp);
+}
+
+EXPORT_API ofono_request ofono_connman_get_contexts_async(struct ofono_modem *modem,
+      response_cb cb, void *user_data)
+{
+  struct response_cb_data *cbd;
+  ofono_request id;
+  struct interm_response_cb_data *icbd;
+
+  tapi_debug("");
+
+  CHECK_PARAMETERS(modem, cb, user_data);
+  NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
+  NEW_INTERM_RSP_CB_DATA(icbd, cbd, modem, NULL);
+
+  context_cache_watch(modem);
+
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
+      OFONO_CONNMAN_IFACE, "GetContexts", NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE,
+      request_timeout(modem), cbd->cancellable,
+      _on_response_get_contexts, icbd);
+
+  return id;
+}
+
+EXPORT_API ofono_request ofono_connman_activate_context(struct ofono_modem *modem,
       char *path, response_cb cb, void *user_data)
 {
   GVariant *var;
@@ -452,11 +685,11 @@ EXPORT_API void ofono_connman_activate_context(struct ofono_modem *modem,
   tapi_debug("Path: %s", path);
 
   var = g_variant_new_boolean(TRUE);
-  ofono_set_property(modem, OFONO_CONTEXT_IFACE, path, "Active",
+  return ofono_set_property(modem, OFONO_CONTEXT_IFACE, path, "Active",
         var, cb, user_data);
 }
 
-EXPORT_API void ofono_connman_deactivate_context(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_connman_deactivate_context(struct ofono_modem *modem,
       char *path, response_cb cb, void *user_data)
 {
   GVariant *var;
@@ -465,33 +698,34 @@ EXPORT_API void ofono_connman_deactivate_context(struct ofono_modem *modem,
   tapi_debug("Path: %s", path);
 
   var = g_variant_new_boolean(FALSE);
-  ofono_set_property(modem, OFONO_CONTEXT_IFACE, path, "Active",
+  return ofono_set_property(modem, OFONO_CONTEXT_IFACE, path, "Active",
         var, cb, user_data);
 }
 
-EXPORT_API void ofono_connman_deactivate_all_contexts(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_connman_deactivate_all_contexts(struct ofono_modem *modem,
       response_cb cb, void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
   tapi_debug("");
 
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_CONNMAN_IFACE, "DeactivateAll", NULL,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       on_response_common, cbd);
+
+  return id;
 }
 
 static tapi_bool _get_bool(struct ofono_modem *modem, char *property,
       tapi_bool *b)
 {
-  GError *error = NULL;
-  GVariant *var_properties;
-  GVariantIter *iter;
-  char *key;
+  GHashTable *props;
   GVariant *var_val;
 
   if (modem == NULL || property == NULL || b == NULL) {
@@ -504,35 +738,17 @@ static tapi_bool _get_bool(struct ofono_modem *modem, char *property,
     return FALSE;
   }
 
-  var_properties = g_dbus_connection_call_sync(modem->conn,
-      OFONO_SERVICE, modem->path,
-      OFONO_CONNMAN_IFACE,
-      "GetProperties", NULL, NULL,
-      G_DBUS_SEND_MESSAGE_FLAGS_NONE, -1, NULL, &error);
-
-  if (var_properties == NULL) {
-    tapi_error("dbus call failed (%s)", error->message);
-    g_error_free(error);
+  props = prop_cache_lock(modem, PROP_CACHE_CONNMAN);
+  if (props == NULL)
     return FALSE;
-  }
 
-  g_variant_get(var_properties, "(a{sv})", &iter);
-  while (g_variant_iter_next(iter, "{sv}", &key, &var_val)) {
-    if (g_strcmp0(key, property) == 0) {
-      g_variant_get(var_val, "b", b);
-      tapi_info("%s: %d", property, *b);
-
-      g_free(key);
-      g_variant_unref(var_val);
-      break;
-    }
-
-    g_free(key);
-    g_variant_unref(var_val);
+  var_val = g_hash_table_lookup(props, property);
+  if (var_val != NULL) {
+    g_variant_get(var_val, "b", b);
+    tapi_info("%s: %d", property, *b);
   }
 
-  g_variant_iter_free(iter);
-  g_variant_unref(var_properties);
+  prop_cache_unlock(modem);
 
   return TRUE;
 }
@@ -544,7 +760,7 @@ EXPORT_API tapi_bool ofono_connman_get_powered(struct ofono_modem *modem,
   return _get_bool(modem, "Powered", powered);
 }
 
-EXPORT_API void ofono_connman_set_powered(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_connman_set_powered(struct ofono_modem *modem,
       tapi_bool powered, response_cb cb,
       void *user_data)
 {
@@ -554,7 +770,7 @@ EXPORT_API void ofono_connman_set_powered(struct ofono_modem *modem,
   tapi_debug("Powered: %d", powered);
 
   var = g_variant_new_boolean(powered);
-  ofono_set_property(modem, OFONO_CONNMAN_IFACE, modem->path, "Powered",
+  return ofono_set_property(modem, OFONO_CONNMAN_IFACE, modem->path, "Powered",
         var, cb, user_data);
 }
 
@@ -565,7 +781,7 @@ EXPORT_API tapi_bool ofono_connman_get_roaming_allowed(struct ofono_modem *modem
   return _get_bool(modem, "RoamingAllowed", allowed);
 }
 
-EXPORT_API void ofono_connman_set_roaming_allowed(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_connman_set_roaming_allowed(struct ofono_modem *modem,
       tapi_bool allowed, response_cb cb,
       void *user_data)
 {
@@ -575,19 +791,37 @@ EXPORT_API void ofono_connman_set_roaming_allowed(struct ofono_modem *modem,
   tapi_debug("Allowed: %d", allowed);
 
   var = g_variant_new_boolean(allowed);
-  ofono_set_property(modem, OFONO_CONNMAN_IFACE, modem->path,
+  return ofono_set_property(modem, OFONO_CONNMAN_IFACE, modem->path,
       "RoamingAllowed", var, cb, user_data);
 }
 
-EXPORT_API tapi_bool ofono_connman_get_status(struct ofono_modem *modem,
+void ofono_connman_parse_status(GHashTable *props,
       struct ps_reg_status *status)
 {
-  GError *error = NULL;
-  GVariant *var_properties;
-  GVariantIter *iter;
-  char *key;
   GVariant *var_val;
 
+  status->attached = FALSE;
+  status->tech = ACCESS_TECH_UNKNOWN;
+
+  var_val = g_hash_table_lookup(props, "Attached");
+  if (var_val != NULL) {
+    g_variant_get(var_val, "b", &status->attached);
+    tapi_info("Attached: %d", status->attached);
+  }
+
+  var_val = g_hash_table_lookup(props, "Bearer");
+  if (var_val != NULL) {
+    const char *tech_str = g_variant_get_string(var_val, NULL);
+    tapi_info("tech: %s", tech_str);
+    status->tech = ofono_str_to_tech(tech_str);
+  }
+}
+
+EXPORT_API tapi_bool ofono_connman_get_status(struct ofono_modem *modem,
+      struct ps_reg_status *status)
+{
+  GHashTable *props;
+
   tapi_debug("");
   if (modem == NULL || status == NULL) {
     tapi_error("Invalid parmeter");
@@ -599,38 +833,13 @@ EXPORT_API tapi_bool ofono_connman_get_status(struct ofono_modem *modem,
     return FALSE;
   }
 
-  var_properties = g_dbus_connection_call_sync(modem->conn,
-      OFONO_SERVICE, modem->path,
-      OFONO_CONNMAN_IFACE,
-      "GetProperties", NULL, NULL,
-      G_DBUS_SEND_MESSAGE_FLAGS_NONE, -1, NULL, &error);
-
-  if (var_properties == NULL) {
-    tapi_error("dbus call failed (%s)", error->message);
-    g_error_free(error);
+  props = prop_cache_lock(modem, PROP_CACHE_CONNMAN);
+  if (props == NULL)
     return FALSE;
-  }
-
-  status->attached = FALSE;
-  status->tech = ACCESS_TECH_UNKNOWN;
-
-  g_variant_get(var_properties, "(a{sv})", &iter);
-  while (g_variant_iter_next(iter, "{sv}", &key, &var_val)) {
-    if (g_strcmp0(key, "Attached") == 0) {
-      g_variant_get(var_val, "b", &status->attached);
-      tapi_info("Attached: %d", status->attached);
-    } else if (g_strcmp0(key, "Bearer") == 0) {
-      const char *tech_str = g_variant_get_string(var_val, NULL);
-      tapi_info("tech: %s", tech_str);
-      status->tech = ofono_str_to_tech(tech_str);
-    }
 
-    g_free(key);
-    g_variant_unref(var_val);
-  }
+  ofono_connman_parse_status(props, status);
 
-  g_variant_iter_free(iter);
-  g_variant_unref(var_properties);
+  prop_cache_unlock(modem);
 
   return TRUE;
 }
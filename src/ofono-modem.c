@@ -31,23 +31,27 @@ EXPORT_API tapi_bool ofono_modem_get_online(struct ofono_modem *modem)
   return modem->online;
 }
 
-EXPORT_API void ofono_modem_set_online(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_modem_set_online(struct ofono_modem *modem,
         tapi_bool online,
         response_cb cb, void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
   GVariant *var;
 
   tapi_debug("Online: %d", online);
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
   var = g_variant_new("(sv)", "Online", g_variant_new_boolean(online));
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_MODEM_IFACE, "SetProperty", var,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       on_response_common, cbd);
+
+  return id;
 }
 
 EXPORT_API tapi_bool ofono_modem_get_powered(struct ofono_modem *modem)
@@ -61,34 +65,102 @@ EXPORT_API tapi_bool ofono_modem_get_powered(struct ofono_modem *modem)
   return modem->powered;
 }
 
-EXPORT_API void ofono_modem_set_powered(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_modem_set_powered(struct ofono_modem *modem,
         tapi_bool powered,
         response_cb cb, void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
   GVariant *var;
 
   tapi_debug("powered: %d", powered);
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
   var = g_variant_new("(sv)", "Powered", g_variant_new_boolean(powered));
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_MODEM_IFACE, "SetProperty", var,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       on_response_common, cbd);
+
+  return id;
+}
+
+enum modem_info_key {
+  MODEM_KEY_MANUFACTURER,
+  MODEM_KEY_MODEL,
+  MODEM_KEY_REVISION,
+  MODEM_KEY_SERIAL,
+  MODEM_KEY_TYPE,
+};
+
+static const struct str_map modem_info_key_map[] = {
+  {"Manufacturer", MODEM_KEY_MANUFACTURER},
+  {"Model", MODEM_KEY_MODEL},
+  {"Revision", MODEM_KEY_REVISION},
+  {"Serial", MODEM_KEY_SERIAL},
+  {"Type", MODEM_KEY_TYPE},
+  {NULL, 0}
+};
+
+static struct str_table modem_info_key_table =
+      STR_TABLE_INIT(modem_info_key_map);
+
+static const struct str_map modem_type_map[] = {
+  {"test", MODEM_TYPE_TEST},
+  {"hfp", MODEM_TYPE_HFP},
+  {"sap", MODEM_TYPE_SAP},
+  {"hardware", MODEM_TYPE_HARDWARE},
+  {NULL, 0}
+};
+
+static struct str_table modem_type_table = STR_TABLE_INIT(modem_type_map);
+
+static void _parse_modem_info(struct modem_info *info,
+      const char *key, GVariant *var_val)
+{
+  const char* val;
+  int type;
+
+  switch (str_table_lookup(&modem_info_key_table, key, -1)) {
+  case MODEM_KEY_MANUFACTURER:
+    val = g_variant_get_string(var_val, NULL);
+    g_strlcpy(info->manufacturer, val,
+        sizeof(info->manufacturer));
+    break;
+  case MODEM_KEY_MODEL:
+    val = g_variant_get_string(var_val, NULL);
+    g_strlcpy(info->model, val, sizeof(info->model));
+    break;
+  case MODEM_KEY_REVISION:
+    val = g_variant_get_string(var_val, NULL);
+    g_strlcpy(info->revision, val,
+        sizeof(info->revision));
+    break;
+  case MODEM_KEY_SERIAL:
+    val = g_variant_get_string(var_val, NULL);
+    g_strlcpy(info->serial, val, sizeof(info->serial));
+    break;
+  case MODEM_KEY_TYPE:
+    val = g_variant_get_string(var_val, NULL);
+    type = str_table_lookup(&modem_type_table, val, -1);
+    if (type >= 0)
+      info->type = type;
+    else
+      tapi_error("Unknown modem type: %s", val);
+    break;
+  }
 }
 
 EXPORT_API tapi_bool ofono_modem_get_info(struct ofono_modem *modem,
       struct modem_info* info)
 {
-  GError *error = NULL;
-  GVariant *var_properties;
-  GVariantIter *iter;
-  char *key;
+  GHashTable *props;
+  GHashTableIter iter;
+  gpointer key;
   GVariant *var_val;
-  const char* val;
 
   tapi_debug("");
 
@@ -96,58 +168,69 @@ EXPORT_API tapi_bool ofono_modem_get_info(struct ofono_modem *modem,
     return FALSE;
 
   memset(info, 0, sizeof(*info));
-  var_properties = g_dbus_connection_call_sync(modem->conn,
-      OFONO_SERVICE, modem->path, OFONO_MODEM_IFACE,
-      "GetProperties", NULL, NULL,
-      G_DBUS_SEND_MESSAGE_FLAGS_NONE, -1, NULL, &error);
-
-  if (var_properties == NULL) {
-    tapi_error("dbus call failed (%s)", error->message);
-    g_error_free(error);
+  props = prop_cache_lock(modem, PROP_CACHE_MODEM);
+  if (props == NULL)
     return FALSE;
-  }
 
-  g_variant_get(var_properties, "(a{sv})", &iter);
-  while (g_variant_iter_next(iter, "{sv}", &key, &var_val)) {
-    if (g_strcmp0(key, "Manufacturer") == 0) {
-      val = g_variant_get_string(var_val, NULL);
-      g_strlcpy(info->manufacturer, val,
-          sizeof(info->manufacturer));
-    } else if (g_strcmp0(key, "Model") == 0) {
-      val = g_variant_get_string(var_val, NULL);
-      g_strlcpy(info->model, val, sizeof(info->model));
-    } else if (g_strcmp0(key, "Revision") == 0) {
-      val = g_variant_get_string(var_val, NULL);
-      g_strlcpy(info->revision, val,
-          sizeof(info->revision));
-    } else if (g_strcmp0(key, "Serial") == 0) {
-      val = g_variant_get_string(var_val, NULL);
-      g_strlcpy(info->serial, val, sizeof(info->serial));
-    } else if (g_strcmp0(key, "Type") == 0) {
-      val = g_variant_get_string(var_val, NULL);
-      if (g_strcmp0(val, "test") == 0)
-        info->type = MODEM_TYPE_TEST;
-      else if (g_strcmp0(val, "hfp") == 0)
-        info->type = MODEM_TYPE_HFP;
-      else if (g_strcmp0(val, "sap") == 0)
-        info->type = MODEM_TYPE_SAP;
-      else if (g_strcmp0(val, "hardware") == 0)
-        info->type = MODEM_TYPE_HARDWARE;
-      else
-        tapi_error("Unknown modem type: %s", val);
-    }
-
-    g_free(key);
-    g_variant_unref(var_val);
-  }
+  g_hash_table_iter_init(&iter, props);
+  while (g_hash_table_iter_next(&iter, &key, (gpointer *) &var_val))
+    _parse_modem_info(info, key, var_val);
+
+  prop_cache_unlock(modem);
 
   tapi_debug("Manufacturer: %s", info->manufacturer);
   tapi_debug("Model: %s", info->model);
   tapi_debug("Revision: %s", info->revision);
   tapi_debug("Serial: %s", info->serial);
 
+  return TRUE;
+}
+
+static void _on_response_get_info(GObject *obj, GAsyncResult *result,
+      gpointer user_data)
+{
+  TResult ret;
+  GVariant *resp, *var_val;
+  GError *error = NULL;
+  struct response_cb_data *cbd = user_data;
+  struct modem_info *info;
+  GVariantIter *iter;
+  const char *key;
+
+  resp = dispatch_call_finish(obj, result, &error);
+
+  CHECK_RESULT(ret, error, cbd, resp);
+
+  /* struct modem_info is too big for the stack */
+  info = g_new0(struct modem_info, 1);
+
+  g_variant_get(resp, "(a{sv})", &iter);
+  while (g_variant_iter_loop(iter, "{&sv}", &key, &var_val))
+    _parse_modem_info(info, key, var_val);
   g_variant_iter_free(iter);
-  g_variant_unref(var_properties);
 
-  return TRUE;
+  CALL_RESP_CALLBACK(ret, info, cbd);
+  g_free(info);
+  g_variant_unref(resp);
+}
+
+EXPORT_API ofono_request ofono_modem_get_info_async(struct ofono_modem *modem,
+      response_cb cb,
+      void *user_data)
+{
+  struct response_cb_data *cbd;
+  ofono_request id;
+
+  tapi_debug("");
+
+  CHECK_PARAMETERS(modem, cb, user_data);
+  NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
+
+  dispatch_call_shared(modem->conn, OFONO_SERVICE, modem->path,
+      OFONO_MODEM_IFACE, "GetProperties", NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
+      _on_response_get_info, cbd);
+
+  return id;
 }
@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2013 Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "log.h"
+#include "ofono-netmon.h"
+
+#define DEFAULT_CAPACITY 64
+
+/* cell identity, for the unique cell count */
+struct cell_key {
+  guint64 area; /* plmn << 16 | lac */
+  unsigned int cid;
+};
+
+static void _columns_resize(struct netmon_columns *c, unsigned int capacity)
+{
+  c->cid = g_renew(unsigned int, c->cid, capacity);
+  c->plmn = g_renew(unsigned int, c->plmn, capacity);
+  c->lac = g_renew(unsigned short, c->lac, capacity);
+  c->channel = g_renew(unsigned short, c->channel, capacity);
+  c->rssi = g_renew(unsigned char, c->rssi, capacity);
+  c->ber = g_renew(unsigned char, c->ber, capacity);
+  c->ta = g_renew(unsigned char, c->ta, capacity);
+  c->type = g_renew(unsigned char, c->type, capacity);
+  c->registered = g_renew(unsigned char, c->registered, capacity);
+  c->capacity = capacity;
+}
+
+/* "001" -> NETMON_PLMN(1, ...), 0 if not a 2 or 3 digit MNC */
+static unsigned int _plmn_pack(const char *mcc, const char *mnc)
+{
+  unsigned int m = 0, n = 0, len = 0;
+  int i;
+
+  for (i = 0; i < MAX_MCC_LEN; i++) {
+    if (mcc[i] < '0' || mcc[i] > '9')
+      return 0;
+    m = m * 10 + (mcc[i] - '0');
+  }
+
+  for (; len < MAX_MNC_LEN && mnc[len] >= '0' && mnc[len] <= '9'; len++)
+    n = n * 10 + (mnc[len] - '0');
+
+  if (len < 2 || mnc[len] != '\0')
+    return 0;
+
+  return NETMON_PLMN(m, n, len);
+}
+
+EXPORT_API struct netmon_columns *ofono_netmon_columns_new(
+      unsigned int capacity)
+{
+  struct netmon_columns *c;
+
+  c = g_new0(struct netmon_columns, 1);
+  _columns_resize(c, capacity ? capacity : DEFAULT_CAPACITY);
+
+  return c;
+}
+
+EXPORT_API void ofono_netmon_columns_free(struct netmon_columns *columns)
+{
+  if (columns == NULL)
+    return;
+
+  g_free(columns->cid);
+  g_free(columns->plmn);
+  g_free(columns->lac);
+  g_free(columns->channel);
+  g_free(columns->rssi);
+  g_free(columns->ber);
+  g_free(columns->ta);
+  g_free(columns->type);
+  g_free(columns->registered);
+  g_free(columns);
+}
+
+EXPORT_API void ofono_netmon_columns_clear(struct netmon_columns *columns)
+{
+  if (columns != NULL)
+    columns->count = 0;
+}
+
+EXPORT_API tapi_bool ofono_netmon_columns_append(
+      struct netmon_columns *columns,
+      const struct cell_info *cells, unsigned int count)
+{
+  unsigned int capacity, i, n;
+
+  if (columns == NULL || (cells == NULL && count > 0))
+    return FALSE;
+
+  if (columns->count + count > columns->capacity) {
+    capacity = columns->capacity;
+    while (capacity < columns->count + count)
+      capacity *= 2;
+    _columns_resize(columns, capacity);
+  }
+
+  n = columns->count;
+  for (i = 0; i < count; i++, n++) {
+    columns->cid[n] = cells[i].cid;
+    columns->plmn[n] = _plmn_pack(cells[i].mcc, cells[i].mnc);
+    columns->lac[n] = cells[i].lac;
+    columns->channel[n] = cells[i].arfcn;
+    columns->rssi[n] = cells[i].rssi;
+    columns->ber[n] = cells[i].ber;
+    columns->ta[n] = cells[i].ta;
+    columns->type[n] = cells[i].type;
+    columns->registered[n] = cells[i].registered != FALSE;
+  }
+
+  columns->count = n;
+
+  return TRUE;
+}
+
+EXPORT_API int ofono_netmon_columns_best_cell(
+      const struct netmon_columns *columns)
+{
+  const unsigned char *rssi;
+  unsigned int i, n;
+  int best = -1;
+  unsigned char max = 0;
+
+  if (columns == NULL || columns->count == 0)
+    return -1;
+
+  rssi = columns->rssi;
+  n = columns->count;
+
+  /* branch free max reduction first, the compiler vectorizes it */
+  for (i = 0; i < n; i++) {
+    unsigned char v = rssi[i] <= NETMON_RSSI_MAX ? rssi[i] : 0;
+    max = v > max ? v : max;
+  }
+
+  /* unknown values never equal "max", -1 if they are all unknown */
+  for (i = 0; i < n; i++) {
+    if (rssi[i] == max) {
+      best = i;
+      break;
+    }
+  }
+
+  return best;
+}
+
+EXPORT_API unsigned int ofono_netmon_columns_rssi_histogram(
+      const struct netmon_columns *columns, unsigned int *histogram)
+{
+  /* the unknown values land in the last slot */
+  unsigned int counts[NETMON_RSSI_MAX + 2];
+  const unsigned char *rssi;
+  unsigned int i, n;
+
+  if (columns == NULL || histogram == NULL)
+    return 0;
+
+  memset(counts, 0, sizeof(counts));
+  rssi = columns->rssi;
+  n = columns->count;
+
+  for (i = 0; i < n; i++)
+    counts[MIN(rssi[i], NETMON_RSSI_MAX + 1)]++;
+
+  memcpy(histogram, counts, (NETMON_RSSI_MAX + 1) * sizeof(unsigned int));
+
+  return counts[NETMON_RSSI_MAX + 1];
+}
+
+static int _cell_key_cmp(const void *a, const void *b)
+{
+  const struct cell_key *ka = a, *kb = b;
+
+  if (ka->area != kb->area)
+    return ka->area < kb->area ? -1 : 1;
+  if (ka->cid != kb->cid)
+    return ka->cid < kb->cid ? -1 : 1;
+
+  return 0;
+}
+
+EXPORT_API unsigned int ofono_netmon_columns_unique_cells(
+      const struct netmon_columns *columns)
+{
+  struct cell_key *keys;
+  unsigned int i, n, unique;
+
+  if (columns == NULL || columns->count == 0)
+    return 0;
+
+  n = columns->count;
+  keys = g_new(struct cell_key, n);
+
+  for (i = 0; i < n; i++) {
+    keys[i].area = ((guint64) columns->plmn[i] << 16) | columns->lac[i];
+    keys[i].cid = columns->cid[i];
+  }
+
+  qsort(keys, n, sizeof(struct cell_key), _cell_key_cmp);
+
+  unique = 1;
+  for (i = 1; i < n; i++)
+    unique += _cell_key_cmp(&keys[i - 1], &keys[i]) != 0;
+
+  g_free(keys);
+
+  return unique;
+}
@@ -0,0 +1,423 @@
+/*
+ * Copyright (C) 2013 Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include <string.h>
+
+#include "common.h"
+#include "log.h"
+#include "ofono-netmon.h"
+
+#define EWMA_WEIGHT 8 /* new sample counts for 1/EWMA_WEIGHT */
+
+struct ofono_netmon_sampler {
+  gint refs; /* owner, poll source and call in flight */
+  GDBusConnection *conn;
+  gchar *path;
+  GCancellable *cancellable;
+  GSource *source;
+  unsigned int interval; /* ms */
+  tapi_bool neighbours;
+  tapi_bool polling; /* only touched on the sampler context */
+
+  GMutex lock; /* protects everything below, read by the getters */
+  struct netmon_sample *ring; /* preallocated, "capacity" samples */
+  unsigned int capacity;
+  unsigned int head; /* next sample written */
+  unsigned int count;
+  unsigned long samples;
+  unsigned long failures;
+  double ewma_rssi;
+  double ewma_ber;
+  double ewma_ta;
+  /* neighbour cell ids of the last two samples, "current" is the last */
+  unsigned int cells[2][NETMON_MAX_NEIGHBOURS];
+  unsigned int n_cells[2];
+  unsigned int current;
+  struct netmon_neighbour_diff diff;
+};
+
+struct sampler_source {
+  GSource source;
+  struct ofono_netmon_sampler *sampler;
+};
+
+static void _sampler_unref(struct ofono_netmon_sampler *sampler)
+{
+  if (!g_atomic_int_dec_and_test(&sampler->refs))
+    return;
+
+  g_object_unref(sampler->conn);
+  g_object_unref(sampler->cancellable);
+  g_mutex_clear(&sampler->lock);
+  g_free(sampler->ring);
+  g_free(sampler->path);
+  g_free(sampler);
+}
+
+/* next poll in "interval" ms, plus or minus a tenth of it */
+static void _sampler_arm(struct ofono_netmon_sampler *sampler, GSource *source)
+{
+  gint32 jitter = sampler->interval / 10;
+  gint64 delay = sampler->interval;
+
+  if (jitter > 0)
+    delay += g_random_int_range(-jitter, jitter + 1);
+
+  g_source_set_ready_time(source, g_source_get_time(source) + delay * 1000);
+}
+
+static void _ewma_add(double *ewma, unsigned char val, unsigned long n)
+{
+  if (n == 1)
+    *ewma = val;
+  else
+    *ewma += (val - *ewma) / EWMA_WEIGHT;
+}
+
+static tapi_bool _cell_in(unsigned int cid, const unsigned int *cells,
+      unsigned int n)
+{
+  unsigned int i;
+
+  for (i = 0; i < n; i++) {
+    if (cells[i] == cid)
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+/* lock held, the neighbours of the new sample are in cells[!current] */
+static void _sampler_record(struct ofono_netmon_sampler *sampler,
+      const struct cell_info *serving)
+{
+  struct netmon_sample *sample = &sampler->ring[sampler->head];
+  struct netmon_neighbour_diff *diff = &sampler->diff;
+  const unsigned int *old = sampler->cells[sampler->current];
+  const unsigned int *new = sampler->cells[!sampler->current];
+  unsigned int n_old = sampler->n_cells[sampler->current];
+  unsigned int n_new = sampler->n_cells[!sampler->current];
+  unsigned int i;
+
+  diff->n_added = 0;
+  for (i = 0; i < n_new; i++) {
+    if (!_cell_in(new[i], old, n_old))
+      diff->added[diff->n_added++] = new[i];
+  }
+
+  diff->n_removed = 0;
+  for (i = 0; i < n_old; i++) {
+    if (!_cell_in(old[i], new, n_new))
+      diff->removed[diff->n_removed++] = old[i];
+  }
+
+  sampler->current = !sampler->current;
+
+  sample->time = g_get_monotonic_time() / 1000;
+  sample->cid = serving->cid;
+  sample->lac = serving->lac;
+  sample->channel = serving->arfcn;
+  sample->type = serving->type;
+  sample->rssi = serving->rssi;
+  sample->ber = serving->ber;
+  sample->ta = serving->ta;
+  sample->neighbours = n_new;
+  sample->added = diff->n_added;
+  sample->removed = diff->n_removed;
+
+  sampler->head = (sampler->head + 1) % sampler->capacity;
+  if (sampler->count < sampler->capacity)
+    sampler->count++;
+
+  sampler->samples++;
+  _ewma_add(&sampler->ewma_rssi, sample->rssi, sampler->samples);
+  _ewma_add(&sampler->ewma_ber, sample->ber, sampler->samples);
+  _ewma_add(&sampler->ewma_ta, sample->ta, sampler->samples);
+}
+
+/*
+ * Parses a GetCellsInformation reply with stack iterators. The serving
+ * cell is the registered one, the first cell until one is flagged.
+ */
+static tapi_bool _parse_cells(GVariant *list, struct cell_info *serving,
+      unsigned int *cells, unsigned int *n_cells)
+{
+  GVariantIter iter, props;
+  GVariant *cell, *dict;
+  struct cell_info ci;
+  tapi_bool have = FALSE, registered = FALSE;
+  unsigned int n = 0;
+
+  g_variant_iter_init(&iter, list);
+  while ((cell = g_variant_iter_next_value(&iter)) != NULL) {
+    dict = g_variant_get_child_value(cell, 0);
+    g_variant_iter_init(&props, dict);
+
+    memset(&ci, 0, sizeof(ci));
+    ofono_netmon_parse_cell_info(&ci, &props);
+
+    if (!registered && ci.registered) {
+      /* the first cell taken as serving was a neighbour */
+      if (have && n < NETMON_MAX_NEIGHBOURS)
+        cells[n++] = serving->cid;
+      *serving = ci;
+      have = registered = TRUE;
+    } else if (!have) {
+      *serving = ci;
+      have = TRUE;
+    } else if (n < NETMON_MAX_NEIGHBOURS) {
+      cells[n++] = ci.cid;
+    }
+
+    g_variant_unref(dict);
+    g_variant_unref(cell);
+  }
+
+  *n_cells = n;
+
+  return have;
+}
+
+static void _on_sample(GObject *obj, GAsyncResult *result, gpointer user_data)
+{
+  struct ofono_netmon_sampler *sampler = user_data;
+  GError *error = NULL;
+  GVariant *resp, *child;
+  GVariantIter props;
+  struct cell_info serving;
+  unsigned int *cells = sampler->cells[!sampler->current];
+  unsigned int n_cells = 0;
+  tapi_bool ok;
+
+  resp = g_dbus_connection_call_finish(G_DBUS_CONNECTION(obj), result, &error);
+
+  sampler->polling = FALSE;
+
+  if (resp == NULL) {
+    if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+      tapi_debug("poll failed: %s", error->message);
+      g_mutex_lock(&sampler->lock);
+      sampler->failures++;
+      g_mutex_unlock(&sampler->lock);
+    }
+
+    g_error_free(error);
+    _sampler_unref(sampler);
+    return;
+  }
+
+  memset(&serving, 0, sizeof(serving));
+  child = g_variant_get_child_value(resp, 0);
+
+  if (sampler->neighbours) {
+    ok = _parse_cells(child, &serving, cells, &n_cells);
+  } else {
+    g_variant_iter_init(&props, child);
+    ofono_netmon_parse_cell_info(&serving, &props);
+    ok = TRUE;
+  }
+
+  g_variant_unref(child);
+  g_variant_unref(resp);
+
+  g_mutex_lock(&sampler->lock);
+
+  if (ok) {
+    sampler->n_cells[!sampler->current] = n_cells;
+    _sampler_record(sampler, &serving);
+  } else {
+    sampler->failures++;
+  }
+
+  g_mutex_unlock(&sampler->lock);
+
+  _sampler_unref(sampler);
+}
+
+static gboolean _sampler_dispatch(GSource *source, GSourceFunc callback,
+      gpointer user_data)
+{
+  struct ofono_netmon_sampler *sampler =
+        ((struct sampler_source *) source)->sampler;
+
+  _sampler_arm(sampler, source);
+
+  /* the previous poll is still waiting for its reply */
+  if (sampler->polling) {
+    g_mutex_lock(&sampler->lock);
+    sampler->failures++;
+    g_mutex_unlock(&sampler->lock);
+    return G_SOURCE_CONTINUE;
+  }
+
+  sampler->polling = TRUE;
+  g_atomic_int_inc(&sampler->refs);
+
+  /* issued from the sampler context, the reply comes back there */
+  g_dbus_connection_call(sampler->conn, OFONO_SERVICE, sampler->path,
+      OFONO_NETMON_INTERFACE, sampler->neighbours ?
+        "GetCellsInformation" : "GetServingCellInformation",
+      NULL, NULL, G_DBUS_CALL_FLAGS_NONE, -1, sampler->cancellable,
+      _on_sample, sampler);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void _sampler_finalize(GSource *source)
+{
+  _sampler_unref(((struct sampler_source *) source)->sampler);
+}
+
+static GSourceFuncs sampler_source_funcs = {
+  NULL,
+  NULL,
+  _sampler_dispatch,
+  _sampler_finalize,
+};
+
+EXPORT_API struct ofono_netmon_sampler *ofono_netmon_sampler_new(
+      struct ofono_modem *modem, unsigned int interval,
+      unsigned int capacity, tapi_bool neighbours)
+{
+  struct ofono_netmon_sampler *sampler;
+  struct sampler_source *ss;
+
+  if (modem == NULL || interval == 0 || capacity == 0) {
+    tapi_error("invalid parameter");
+    return NULL;
+  }
+
+  sampler = g_new0(struct ofono_netmon_sampler, 1);
+  sampler->refs = 2; /* owner and source */
+  sampler->conn = g_object_ref(modem->conn);
+  sampler->path = g_strdup(modem->path);
+  sampler->cancellable = g_cancellable_new();
+  sampler->interval = MIN(interval, G_MAXINT32 / 2);
+  sampler->neighbours = neighbours;
+  g_mutex_init(&sampler->lock);
+  sampler->ring = g_new0(struct netmon_sample, capacity);
+  sampler->capacity = capacity;
+
+  ss = (struct sampler_source *) g_source_new(&sampler_source_funcs,
+        sizeof(struct sampler_source));
+  ss->sampler = sampler;
+  sampler->source = &ss->source;
+
+  /* random phase, the modems started together don't poll together */
+  g_source_set_ready_time(sampler->source, g_get_monotonic_time() +
+        (gint64) g_random_int_range(0, sampler->interval) * 1000);
+  g_source_attach(sampler->source, dispatch_context(modem->conn));
+
+  return sampler;
+}
+
+EXPORT_API void ofono_netmon_sampler_free(struct ofono_netmon_sampler *sampler)
+{
+  if (sampler == NULL)
+    return;
+
+  g_cancellable_cancel(sampler->cancellable);
+  g_source_destroy(sampler->source);
+  g_source_unref(sampler->source);
+
+  _sampler_unref(sampler);
+}
+
+EXPORT_API unsigned int ofono_netmon_sampler_read(
+      struct ofono_netmon_sampler *sampler,
+      struct netmon_sample *samples, unsigned int max)
+{
+  unsigned int n, i, pos;
+
+  if (sampler == NULL || samples == NULL)
+    return 0;
+
+  g_mutex_lock(&sampler->lock);
+
+  n = MIN(max, sampler->count);
+  pos = (sampler->head + sampler->capacity - n) % sampler->capacity;
+  for (i = 0; i < n; i++) {
+    samples[i] = sampler->ring[pos];
+    pos = (pos + 1) % sampler->capacity;
+  }
+
+  g_mutex_unlock(&sampler->lock);
+
+  return n;
+}
+
+static void _aggregate_init(struct netmon_aggregate *agg, double ewma)
+{
+  agg->min = G_MAXUINT8;
+  agg->max = 0;
+  agg->ewma = ewma;
+}
+
+static void _aggregate_add(struct netmon_aggregate *agg, unsigned char val)
+{
+  if (val < agg->min)
+    agg->min = val;
+  if (val > agg->max)
+    agg->max = val;
+}
+
+EXPORT_API tapi_bool ofono_netmon_sampler_get_stats(
+      struct ofono_netmon_sampler *sampler,
+      struct ofono_netmon_sampler_stats *stats)
+{
+  const struct netmon_sample *sample;
+  unsigned int i;
+
+  if (sampler == NULL || stats == NULL)
+    return FALSE;
+
+  g_mutex_lock(&sampler->lock);
+
+  stats->samples = sampler->samples;
+  stats->failures = sampler->failures;
+  stats->stored = sampler->count;
+  _aggregate_init(&stats->rssi, sampler->ewma_rssi);
+  _aggregate_init(&stats->ber, sampler->ewma_ber);
+  _aggregate_init(&stats->ta, sampler->ewma_ta);
+
+  for (i = 0; i < sampler->count; i++) {
+    sample = &sampler->ring[i];
+    _aggregate_add(&stats->rssi, sample->rssi);
+    _aggregate_add(&stats->ber, sample->ber);
+    _aggregate_add(&stats->ta, sample->ta);
+  }
+
+  g_mutex_unlock(&sampler->lock);
+
+  if (stats->stored == 0)
+    stats->rssi.min = stats->ber.min = stats->ta.min = 0;
+
+  return TRUE;
+}
+
+EXPORT_API tapi_bool ofono_netmon_sampler_get_neighbour_diff(
+      struct ofono_netmon_sampler *sampler,
+      struct netmon_neighbour_diff *diff)
+{
+  if (sampler == NULL || diff == NULL)
+    return FALSE;
+
+  g_mutex_lock(&sampler->lock);
+  *diff = sampler->diff;
+  g_mutex_unlock(&sampler->lock);
+
+  return TRUE;
+}
@@ -20,55 +20,107 @@
 #include "log.h"
 #include "ofono-netmon.h"
 
-static void _parse_cell_info(struct cell_info *info, GVariantIter *iter)
+enum cell_key {
+  CELL_KEY_REGISTERED,
+  CELL_KEY_TECHNOLOGY,
+  CELL_KEY_LAC,
+  CELL_KEY_CELL_ID,
+  CELL_KEY_MNC,
+  CELL_KEY_MCC,
+  CELL_KEY_ARFCN,
+  CELL_KEY_BSIC,
+  CELL_KEY_BER,
+  CELL_KEY_PSC,
+  CELL_KEY_TIMING_ADVANCE,
+  CELL_KEY_STRENGTH,
+};
+
+static const struct str_map cell_key_map[] = {
+  {"registered", CELL_KEY_REGISTERED},
+  {"Technology", CELL_KEY_TECHNOLOGY},
+  {"LocationAreaCode", CELL_KEY_LAC},
+  {"CellId", CELL_KEY_CELL_ID},
+  {"MobileNetworkCode", CELL_KEY_MNC},
+  {"MobileCountryCode", CELL_KEY_MCC},
+  {"ARFCN", CELL_KEY_ARFCN},
+  {"BSIC", CELL_KEY_BSIC},
+  {"BitErrorRate", CELL_KEY_BER},
+  {"PrimaryScramblingCode", CELL_KEY_PSC},
+  {"TimingAdvance", CELL_KEY_TIMING_ADVANCE},
+  {"Strength", CELL_KEY_STRENGTH},
+  {NULL, 0}
+};
+
+static struct str_table cell_key_table = STR_TABLE_INIT(cell_key_map);
+
+static const struct str_map cell_type_map[] = {
+  {"umts", CELL_TYPE_3G},
+  {"lte", CELL_TYPE_4G},
+  {NULL, 0}
+};
+
+static struct str_table cell_type_table = STR_TABLE_INIT(cell_type_map);
+
+void ofono_netmon_parse_cell_info(struct cell_info *info, GVariantIter *iter)
 {
-  char *key;
+  const char *key;
   GVariant *val;
 
-  while(g_variant_iter_loop(iter, "{sv}", &key, &val)) {
-    if (g_strcmp0(key, "registered") == 0) {
+  while(g_variant_iter_loop(iter, "{&sv}", &key, &val)) {
+    switch (str_table_lookup(&cell_key_table, key, -1)) {
+    case CELL_KEY_REGISTERED:
       info->registered = g_variant_get_boolean(val);
       tapi_debug("registered: %d", info->registered);
-    } else if (g_strcmp0(key, "Technology") == 0) {
+      break;
+    case CELL_KEY_TECHNOLOGY: {
       const char *tech = g_variant_get_string(val, NULL);
-      if (strcasecmp(tech, "umts") == 0)
-        info->type = CELL_TYPE_3G;
-      if (strcasecmp(tech, "lte") == 0)
-        info->type = CELL_TYPE_4G;
-      else
-        info->type = CELL_TYPE_2G;
-    } else if (g_strcmp0(key, "LocationAreaCode") == 0) {
+      info->type = str_table_lookup(&cell_type_table, tech, CELL_TYPE_2G);
+      break;
+    }
+    case CELL_KEY_LAC:
       g_variant_get(val, "q", &info->lac);
       tapi_debug("lac: %X", info->lac);
-    } else if (g_strcmp0(key, "CellId") == 0) {
+      break;
+    case CELL_KEY_CELL_ID:
       g_variant_get(val, "u", &info->cid);
       tapi_debug("cid: %X", info->cid);
-    } else if (g_strcmp0(key, "MobileNetworkCode") == 0) {
+      break;
+    case CELL_KEY_MNC: {
       const char *mnc = g_variant_get_string(val, NULL);
       g_strlcpy(info->mnc, mnc, MAX_MNC_LEN + 1);
       tapi_debug("MNC: %s", mnc);
-    } else if (g_strcmp0(key, "MobileCountryCode") == 0) {
+      break;
+    }
+    case CELL_KEY_MCC: {
       const char *mcc = g_variant_get_string(val, NULL);
       g_strlcpy(info->mcc, mcc, MAX_MCC_LEN + 1);
       tapi_debug("MCC: %s", mcc);
-    } else if (g_strcmp0(key, "ARFCN") == 0) {
+      break;
+    }
+    case CELL_KEY_ARFCN:
       g_variant_get(val, "q", &info->arfcn);
       tapi_debug("arfcn: %X", info->arfcn);
-    } else if (g_strcmp0(key, "BSIC") == 0) {
+      break;
+    case CELL_KEY_BSIC:
       g_variant_get(val, "y", &info->bsid);
       tapi_debug("bsid: %X", info->bsid);
-    } else if (g_strcmp0(key, "BitErrorRate") == 0) {
+      break;
+    case CELL_KEY_BER:
       g_variant_get(val, "y", &info->ber);
       tapi_debug("ber: %X", info->ber);
-    } else if (g_strcmp0(key, "PrimaryScramblingCode") == 0) {
+      break;
+    case CELL_KEY_PSC:
       g_variant_get(val, "q", &info->psc);
       tapi_debug("psc: %X", info->psc);
-    } else if (g_strcmp0(key, "TimingAdvance") == 0) {
+      break;
+    case CELL_KEY_TIMING_ADVANCE:
       g_variant_get(val, "y", &info->ta);
       tapi_debug("TimingAdvance: %X", info->ta);
-    } else if (g_strcmp0(key, "Strength") == 0) {
+      break;
+    case CELL_KEY_STRENGTH:
       g_variant_get(val, "y", &info->rssi);
       tapi_debug("rssi: %d", info->rssi);
+      break;
     }
   }
 }
@@ -88,8 +140,9 @@ static void _on_response_get_serving_cell_info(GObject *obj,
 
   CHECK_RESULT(ret, error, cbd, resp);
 
-  g_variant_get(resp, "(a{sv))", &iter);
-  _parse_cell_info(&ci, iter);
+  memset(&ci, 0, sizeof(ci));
+  g_variant_get(resp, "(a{sv})", &iter);
+  ofono_netmon_parse_cell_info(&ci, iter);
 
   CALL_RESP_CALLBACK(ret, &ci, cbd);
 
@@ -115,7 +168,11 @@ static void _on_response_get_cells_info(GObject *obj,
   resp = g_dbus_connection_call_finish(G_DBUS_CONNECTION(obj), result, &error);
 
   CHECK_RESULT(ret, error, cbd, resp);
-  tapi_debug("%s", g_variant_print(resp, TRUE));
+  if (tapi_log_enabled(TAPI_LOG_DEBUG)) {
+    gchar *dump = g_variant_print(resp, TRUE);
+    tapi_debug("%s", dump);
+    g_free(dump);
+  }
 
   g_variant_get(resp, "(a(a{sv}))", &iter);
   count = g_variant_iter_n_children(iter);
@@ -131,7 +188,7 @@ static void _on_response_get_cells_info(GObject *obj,
   p_ci = cs_info.cells;
 
   while (g_variant_iter_loop(iter, "(a{sv})", &iter_cells)) {
-    _parse_cell_info(p_ci++, iter_cells);
+    ofono_netmon_parse_cell_info(p_ci++, iter_cells);
 	g_variant_iter_free(iter_cells);
   }
 
@@ -141,36 +198,44 @@ static void _on_response_get_cells_info(GObject *obj,
   g_free(cs_info.cells);
 }
 
-EXPORT_API tapi_bool ofono_netmon_get_serving_cell_info(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_netmon_get_serving_cell_info(struct ofono_modem *modem,
       response_cb cb,
       void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
 
   tapi_debug("");
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_NETMON_INTERFACE, "GetServingCellInformation", NULL,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       _on_response_get_serving_cell_info, cbd);
+
+  return id;
 }
 
-EXPORT_API tapi_bool ofono_netmon_get_cells_info(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_netmon_get_cells_info(struct ofono_modem *modem,
       response_cb cb,
       void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
 
   tapi_debug("");
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_NETMON_INTERFACE, "GetCellsInformation", NULL,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       _on_response_get_cells_info, cbd);
+
+  return id;
 }
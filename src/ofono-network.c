@@ -20,74 +20,101 @@
 #include "log.h"
 #include "ofono-network.h"
 
+static const struct str_map reg_status_map[] = {
+  {"unregistered", REG_STATUS_NOT_REGISTERED},
+  {"registered", REG_STATUS_REGISTERED_HOME},
+  {"searching", REG_STATUS_SEARCHING},
+  {"denied", REG_STATUS_DENIED},
+  {"roaming", REG_STATUS_REGISTERED_ROAMING},
+  {NULL, 0}
+};
+
+static struct str_table reg_status_table = STR_TABLE_INIT(reg_status_map);
+
 static enum registration_status _str_to_registaration_status(const char *status)
 {
+  int val;
+
   if (status == NULL) {
     tapi_error("registration status string is null");
     return REG_STATUS_UNKNOWN;
   }
 
-  if (g_strcmp0(status, "unregistered") == 0)
-    return REG_STATUS_NOT_REGISTERED;
-
-  if (g_strcmp0(status, "registered") == 0)
-    return REG_STATUS_REGISTERED_HOME;
-
-  if (g_strcmp0(status, "searching") == 0)
-    return REG_STATUS_SEARCHING;
+  val = str_table_lookup(&reg_status_table, status, -1);
+  if (val < 0) {
+    tapi_warn("Unknown registration status: %s", status);
+    return REG_STATUS_UNKNOWN;
+  }
 
-  if (g_strcmp0(status, "denied") == 0)
-    return REG_STATUS_DENIED;
+  return val;
+}
 
-  if (g_strcmp0(status, "roaming") == 0)
-    return REG_STATUS_REGISTERED_ROAMING;
+static const struct str_map operator_status_map[] = {
+  {"available", OPERATOR_STATUS_AVAILABLE},
+  {"current", OPERATOR_STATUS_CURRENT},
+  {"forbidden", OPERATOR_STATUS_FORBIDDEN},
+  {"unknown", OPERATOR_STATUS_UNKNOWN},
+  {NULL, 0}
+};
 
-  tapi_warn("Unknown registration status: %s", status);
-  return REG_STATUS_UNKNOWN;
-}
+static struct str_table operator_status_table =
+      STR_TABLE_INIT(operator_status_map);
 
 static enum operator_status _str_to_operator_status(const char *status)
 {
+  int val;
+
   if (status == NULL) {
     tapi_error("operator status string is null");
-    return REG_STATUS_UNKNOWN;
+    return OPERATOR_STATUS_UNKNOWN;
   }
 
-  if (g_strcmp0(status, "available") == 0)
-    return OPERATOR_STATUS_AVAILABLE;
-
-  if (g_strcmp0(status, "current") == 0)
-    return OPERATOR_STATUS_CURRENT;
+  val = str_table_lookup(&operator_status_table, status, -1);
+  if (val < 0) {
+    tapi_warn("Unknown operator status: %s", status);
+    return OPERATOR_STATUS_UNKNOWN;
+  }
 
-  if (g_strcmp0(status, "forbidden") == 0)
-    return OPERATOR_STATUS_FORBIDDEN;
+  return val;
+}
 
-  if (g_strcmp0(status, "unknown") == 0)
-    return REG_STATUS_DENIED;
+static const struct str_map selection_mode_map[] = {
+  {"auto", NETWORK_SELECTION_MODE_AUTO},
+  {"auto-only", NETWORK_SELECTION_MODE_AUTO_ONLY},
+  {"manual", NETWORK_SELECTION_MODE_MANUAL},
+  {NULL, 0}
+};
 
-  tapi_warn("Unknown registration status: %s", status);
-  return REG_STATUS_UNKNOWN;
-}
+static struct str_table selection_mode_table =
+      STR_TABLE_INIT(selection_mode_map);
 
 static enum network_selection_mode _str_to_selection_mode(const char *mode)
 {
+  int val;
+
   if (mode == NULL) {
     tapi_error("selection mode string is null");
     return NETWORK_SELECTION_MODE_UNKNOWN;
   }
 
-  if (g_strcmp0(mode, "auto") == 0)
-    return NETWORK_SELECTION_MODE_AUTO;
+  val = str_table_lookup(&selection_mode_table, mode, -1);
+  if (val < 0) {
+    tapi_warn("Unknown network selection mode: %s", mode);
+    return NETWORK_SELECTION_MODE_UNKNOWN;
+  }
 
-  if (g_strcmp0(mode, "auto-only") == 0)
-    return NETWORK_SELECTION_MODE_AUTO_ONLY;
+  return val;
+}
 
-  if (g_strcmp0(mode, "manual") == 0)
-    return NETWORK_SELECTION_MODE_MANUAL;
+static const struct str_map network_mode_map[] = {
+  {"any", NETWORK_MODE_AUTO},
+  {"gsm", NETWORK_MODE_2G},
+  {"umts", NETWORK_MODE_3G},
+  {"lte", NETWORK_MODE_4G},
+  {NULL, 0}
+};
 
-  tapi_warn("Unknown network selection mode: %s", mode);
-  return NETWORK_SELECTION_MODE_UNKNOWN;
-}
+static struct str_table network_mode_table = STR_TABLE_INIT(network_mode_map);
 
 static enum network_mode _str_to_network_mode(const char *mode)
 {
@@ -96,19 +123,7 @@ static enum network_mode _str_to_network_mode(const char *mode)
     return NETWORK_MODE_UNKNOWN;
   }
 
-  if (g_strcmp0(mode, "any") == 0)
-    return NETWORK_MODE_AUTO;
-
-  if (g_strcmp0(mode, "gsm") == 0)
-    return NETWORK_MODE_2G;
-
-  if (g_strcmp0(mode, "umts") == 0)
-    return NETWORK_MODE_3G;
-
-  if (g_strcmp0(mode, "lte") == 0)
-    return NETWORK_MODE_4G;
-
-  return NETWORK_MODE_UNKNOWN;
+  return str_table_lookup(&network_mode_table, mode, NETWORK_MODE_UNKNOWN);
 }
 
 static const char *_network_mode_to_str(enum network_mode mode)
@@ -125,50 +140,62 @@ static const char *_network_mode_to_str(enum network_mode mode)
   }
 }
 
-static void _get_registration_info(struct ofono_modem *modem,
-      GVariant *properties, struct registration_info *info)
+void ofono_network_parse_registration_info(GHashTable *props,
+      struct registration_info *info)
 {
-  GVariantIter *iter;
-  char *key;
   const char *value;
   GVariant *var;
 
-  g_variant_get(properties, "(a{sv})", &iter);
-  while (g_variant_iter_loop(iter, "{sv}", &key, &var)) {
-    if (g_strcmp0(key, "Status") == 0) {
-      value = g_variant_get_string(var, NULL);
-      info->status = _str_to_registaration_status(value);
-      tapi_debug("status(%d): %s", info->status, value);
-    } else if (g_strcmp0(key, "LocationAreaCode") == 0) {
-      g_variant_get(var, "q", &info->lac);
-      tapi_debug("lac: %X", info->lac);
-    } else if (g_strcmp0(key, "CellId") == 0) {
-      g_variant_get(var, "u", &info->cid);
-      tapi_debug("cid: %X", info->cid);
-    } else if (g_strcmp0(key, "Technology") == 0) {
-      value = g_variant_get_string(var, NULL);
-      info->act = ofono_str_to_tech(value);
-      tapi_debug("act(%d): %s", info->act, value);
-    } else if (g_strcmp0(key, "MobileCountryCode") == 0) {
-      value = g_variant_get_string(var, NULL);
-      g_strlcpy(info->mcc, value, sizeof(info->mcc));
-      tapi_debug("mcc: %s", info->mcc);
-    } else if (g_strcmp0(key, "MobileNetworkCode") == 0) {
-      value = g_variant_get_string(var, NULL);
-      g_strlcpy(info->mnc, value, sizeof(info->mnc));
-      tapi_debug("mnc: %s", info->mnc);
-    }
+  memset(info, 0, sizeof(struct registration_info));
+  info->status = REG_STATUS_UNKNOWN;
+  info->act = ACCESS_TECH_UNKNOWN;
+
+  var = g_hash_table_lookup(props, "Status");
+  if (var != NULL) {
+    value = g_variant_get_string(var, NULL);
+    info->status = _str_to_registaration_status(value);
+    tapi_debug("status(%d): %s", info->status, value);
   }
 
-  g_variant_iter_free(iter);
+  var = g_hash_table_lookup(props, "LocationAreaCode");
+  if (var != NULL) {
+    g_variant_get(var, "q", &info->lac);
+    tapi_debug("lac: %X", info->lac);
+  }
+
+  var = g_hash_table_lookup(props, "CellId");
+  if (var != NULL) {
+    g_variant_get(var, "u", &info->cid);
+    tapi_debug("cid: %X", info->cid);
+  }
+
+  var = g_hash_table_lookup(props, "Technology");
+  if (var != NULL) {
+    value = g_variant_get_string(var, NULL);
+    info->act = ofono_str_to_tech(value);
+    tapi_debug("act(%d): %s", info->act, value);
+  }
+
+  var = g_hash_table_lookup(props, "MobileCountryCode");
+  if (var != NULL) {
+    value = g_variant_get_string(var, NULL);
+    g_strlcpy(info->mcc, value, sizeof(info->mcc));
+    tapi_debug("mcc: %s", info->mcc);
+  }
+
+  var = g_hash_table_lookup(props, "MobileNetworkCode");
+  if (var != NULL) {
+    value = g_variant_get_string(var, NULL);
+    g_strlcpy(info->mnc, value, sizeof(info->mnc));
+    tapi_debug("mnc: %s", info->mnc);
+  }
 }
 
 EXPORT_API tapi_bool ofono_network_get_registration_info(
       struct ofono_modem *modem,
       struct registration_info *info)
 {
-  GError *error = NULL;
-  GVariant *var;
+  GHashTable *props;
 
   tapi_debug("");
 
@@ -186,30 +213,20 @@ EXPORT_API tapi_bool ofono_network_get_registration_info(
     return FALSE;
   }
 
-  var = g_dbus_connection_call_sync(modem->conn, OFONO_SERVICE,
-      modem->path, OFONO_NETWORK_REGISTRATION_IFACE,
-      "GetProperties", NULL, NULL,
-      G_DBUS_SEND_MESSAGE_FLAGS_NONE, -1, NULL, &error);
-
-  if (var == NULL) {
-    tapi_error("dbus call failed (%s)", error->message);
-    g_error_free(error);
+  props = prop_cache_lock(modem, PROP_CACHE_NETREG);
+  if (props == NULL)
     return FALSE;
-  }
 
-  _get_registration_info(modem, var, info);
+  ofono_network_parse_registration_info(props, info);
 
-  g_variant_unref(var);
+  prop_cache_unlock(modem);
   return TRUE;
 }
 
 EXPORT_API tapi_bool ofono_network_get_operator_name(struct ofono_modem *modem,
       char **name)
 {
-  GError *error = NULL;
-  GVariant *var_properties;
-  GVariantIter *iter;
-  char *key;
+  GHashTable *props;
   GVariant *var_val;
 
   tapi_debug("");
@@ -226,45 +243,24 @@ EXPORT_API tapi_bool ofono_network_get_operator_name(struct ofono_modem *modem,
     return FALSE;
   }
 
-  var_properties = g_dbus_connection_call_sync(modem->conn,
-      OFONO_SERVICE, modem->path,
-      OFONO_NETWORK_REGISTRATION_IFACE,
-      "GetProperties", NULL, NULL,
-      G_DBUS_SEND_MESSAGE_FLAGS_NONE, -1, NULL, &error);
-
-  if (var_properties == NULL) {
-    tapi_error("dbus call failed (%s)", error->message);
-    g_error_free(error);
+  props = prop_cache_lock(modem, PROP_CACHE_NETREG);
+  if (props == NULL)
     return FALSE;
-  }
-
-  g_variant_get(var_properties, "(a{sv})", &iter);
-  while (g_variant_iter_next(iter, "{sv}", &key, &var_val)) {
-    if (g_strcmp0(key, "Name") == 0) {
-      g_variant_get(var_val, "s", name);
-      tapi_info("Operator name: %s", *name);
-
-      g_free(key);
-      g_variant_unref(var_val);
-      break;
-    }
 
-    g_free(key);
-    g_variant_unref(var_val);
+  var_val = g_hash_table_lookup(props, "Name");
+  if (var_val != NULL) {
+    g_variant_get(var_val, "s", name);
+    tapi_info("Operator name: %s", *name);
   }
 
-  g_variant_iter_free(iter);
-  g_variant_unref(var_properties);
+  prop_cache_unlock(modem);
   return TRUE;
 }
 
 EXPORT_API tapi_bool ofono_network_get_signal_strength(
       struct ofono_modem *modem, unsigned char *signal)
 {
-  GError *error = NULL;
-  GVariant *var_properties;
-  GVariantIter *iter;
-  char *key;
+  GHashTable *props;
   GVariant *var_val;
 
   tapi_debug("");
@@ -279,35 +275,17 @@ EXPORT_API tapi_bool ofono_network_get_signal_strength(
     return FALSE;
   }
 
-  var_properties = g_dbus_connection_call_sync(modem->conn,
-      OFONO_SERVICE, modem->path,
-      OFONO_NETWORK_REGISTRATION_IFACE,
-      "GetProperties", NULL, NULL,
-      G_DBUS_SEND_MESSAGE_FLAGS_NONE, -1, NULL, &error);
-
-  if (var_properties == NULL) {
-    tapi_error("dbus call failed (%s)", error->message);
-    g_error_free(error);
+  props = prop_cache_lock(modem, PROP_CACHE_NETREG);
+  if (props == NULL)
     return FALSE;
-  }
-
-  g_variant_get(var_properties, "(a{sv})", &iter);
-  while (g_variant_iter_next(iter, "{sv}", &key, &var_val)) {
-    if (g_strcmp0(key, "Strength") == 0) {
-      g_variant_get(var_val, "y", signal);
-      tapi_info("Signal strength: %d", *signal);
-
-      g_free(key);
-      g_variant_unref(var_val);
-      break;
-    }
 
-    g_free(key);
-    g_variant_unref(var_val);
+  var_val = g_hash_table_lookup(props, "Strength");
+  if (var_val != NULL) {
+    g_variant_get(var_val, "y", signal);
+    tapi_info("Signal strength: %d", *signal);
   }
 
-  g_variant_iter_free(iter);
-  g_variant_unref(var_properties);
+  prop_cache_unlock(modem);
   return TRUE;
 }
 
@@ -315,10 +293,7 @@ EXPORT_API tapi_bool ofono_network_get_network_selection_mode(
       struct ofono_modem *modem,
       enum network_selection_mode *mode)
 {
-  GError *error = NULL;
-  GVariant *var_properties;
-  GVariantIter *iter;
-  char *key;
+  GHashTable *props;
   GVariant *var_val;
 
   tapi_debug("");
@@ -333,38 +308,120 @@ EXPORT_API tapi_bool ofono_network_get_network_selection_mode(
     return FALSE;
   }
 
-  var_properties = g_dbus_connection_call_sync(modem->conn,
-      OFONO_SERVICE, modem->path,
-      OFONO_NETWORK_REGISTRATION_IFACE,
-      "GetProperties", NULL, NULL,
-      G_DBUS_SEND_MESSAGE_FLAGS_NONE, -1, NULL, &error);
-
-  if (var_properties == NULL) {
-    tapi_error("dbus call failed (%s)", error->message);
-    g_error_free(error);
+  props = prop_cache_lock(modem, PROP_CACHE_NETREG);
+  if (props == NULL)
     return FALSE;
+
+  var_val = g_hash_table_lookup(props, "Mode");
+  if (var_val != NULL) {
+    const char *str_mode = g_variant_get_string(var_val, NULL);
+    *mode = _str_to_selection_mode(str_mode);
+    tapi_debug("Selection mode: %s", str_mode);
   }
 
-  g_variant_get(var_properties, "(a{sv})", &iter);
-  while (g_variant_iter_next(iter, "{sv}", &key, &var_val)) {
-    if (g_strcmp0(key, "Mode") == 0) {
-      const char *str_mode =
-          g_variant_get_string(var_val, NULL);
-      *mode = _str_to_selection_mode(str_mode);
-      tapi_debug("Selection mode: %s", str_mode);
+  prop_cache_unlock(modem);
+  return TRUE;
+}
 
-      g_free(key);
-      g_variant_unref(var_val);
-      break;
-    }
+static void _on_response_get_operator_name(GObject *obj,
+      GAsyncResult *result, gpointer user_data)
+{
+  TResult ret;
+  GVariant *resp, *dict, *var_val;
+  GError *error = NULL;
+  struct response_cb_data *cbd = user_data;
+  const char *name = NULL;
 
-    g_free(key);
+  resp = dispatch_call_finish(obj, result, &error);
+
+  CHECK_RESULT(ret, error, cbd, resp);
+
+  dict = g_variant_get_child_value(resp, 0);
+  var_val = g_variant_lookup_value(dict, "Name", G_VARIANT_TYPE_STRING);
+  if (var_val != NULL) {
+    name = g_variant_get_string(var_val, NULL);
+    tapi_info("Operator name: %s", name);
+  }
+
+  CALL_RESP_CALLBACK(ret, name, cbd);
+
+  if (var_val != NULL)
+    g_variant_unref(var_val);
+  g_variant_unref(dict);
+  g_variant_unref(resp);
+}
+
+EXPORT_API ofono_request ofono_network_get_operator_name_async(
+      struct ofono_modem *modem,
+      response_cb cb,
+      void *user_data)
+{
+  struct response_cb_data *cbd;
+  ofono_request id;
+
+  tapi_debug("");
+
+  CHECK_PARAMETERS(modem, cb, user_data);
+  NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
+
+  dispatch_call_shared(modem->conn, OFONO_SERVICE, modem->path,
+      OFONO_NETWORK_REGISTRATION_IFACE, "GetProperties", NULL,
+      G_VARIANT_TYPE("(a{sv})"), G_DBUS_CALL_FLAGS_NONE,
+      request_timeout(modem), cbd->cancellable,
+      _on_response_get_operator_name, cbd);
+
+  return id;
+}
+
+static void _on_response_get_selection_mode(GObject *obj,
+      GAsyncResult *result, gpointer user_data)
+{
+  TResult ret;
+  GVariant *resp, *dict, *var_val;
+  GError *error = NULL;
+  struct response_cb_data *cbd = user_data;
+  enum network_selection_mode mode = NETWORK_SELECTION_MODE_UNKNOWN;
+
+  resp = dispatch_call_finish(obj, result, &error);
+
+  CHECK_RESULT(ret, error, cbd, resp);
+
+  dict = g_variant_get_child_value(resp, 0);
+  var_val = g_variant_lookup_value(dict, "Mode", G_VARIANT_TYPE_STRING);
+  if (var_val != NULL) {
+    const char *str_mode = g_variant_get_string(var_val, NULL);
+    mode = _str_to_selection_mode(str_mode);
+    tapi_debug("Selection mode: %s", str_mode);
     g_variant_unref(var_val);
   }
 
-  g_variant_iter_free(iter);
-  g_variant_unref(var_properties);
-  return TRUE;
+  CALL_RESP_CALLBACK(ret, &mode, cbd);
+  g_variant_unref(dict);
+  g_variant_unref(resp);
+}
+
+EXPORT_API ofono_request ofono_network_get_network_selection_mode_async(
+      struct ofono_modem *modem,
+      response_cb cb,
+      void *user_data)
+{
+  struct response_cb_data *cbd;
+  ofono_request id;
+
+  tapi_debug("");
+
+  CHECK_PARAMETERS(modem, cb, user_data);
+  NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
+
+  dispatch_call_shared(modem->conn, OFONO_SERVICE, modem->path,
+      OFONO_NETWORK_REGISTRATION_IFACE, "GetProperties", NULL,
+      G_VARIANT_TYPE("(a{sv})"), G_DBUS_CALL_FLAGS_NONE,
+      request_timeout(modem), cbd->cancellable,
+      _on_response_get_selection_mode, cbd);
+
+  return id;
 }
 
 static void _on_response_get_mode(GObject *obj, GAsyncResult *result,
@@ -376,66 +433,58 @@ static void _on_response_get_mode(GObject *obj, GAsyncResult *result,
   struct response_cb_data *cbd = user_data;
   enum network_mode mode;
 
-  GVariantIter *iter;
-  char *key;
-  GVariant *var_val;
-  char *str_mode;
+  GVariant *dict;
+  const char *str_mode = NULL;
 
-  resp = g_dbus_connection_call_finish(G_DBUS_CONNECTION(obj), result, &error);
+  resp = dispatch_call_finish(obj, result, &error);
 
   CHECK_RESULT(ret, error, cbd, resp);
 
-  g_variant_get(resp, "(a{sv})", &iter);
-  while (g_variant_iter_next(iter, "{sv}", &key, &var_val)) {
-    if (g_strcmp0(key, "TechnologyPreference") == 0) {
-      g_variant_get(var_val, "s", &str_mode);
-      tapi_debug("Mode: %s", str_mode);
-
-      g_free(key);
-      g_variant_unref(var_val);
-      break;
-    }
-
-    g_free(key);
-    g_variant_unref(var_val);
-  }
+  dict = g_variant_get_child_value(resp, 0);
+  if (g_variant_lookup(dict, "TechnologyPreference", "&s", &str_mode))
+    tapi_debug("Mode: %s", str_mode);
 
   mode = _str_to_network_mode(str_mode);
-  g_free(str_mode);
 
   CALL_RESP_CALLBACK(ret, &mode, cbd);
-  g_variant_iter_free(iter);
+  g_variant_unref(dict);
   g_variant_unref(resp);
 }
 
-EXPORT_API void ofono_network_get_mode(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_network_get_mode(struct ofono_modem *modem,
       response_cb cb,
       void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
 
   tapi_debug("");
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call_shared(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_RADIO_SETTINGS_IFACE, "GetProperties", NULL,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       _on_response_get_mode, cbd);
+
+  return id;
 }
 
-EXPORT_API void ofono_network_set_mode(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_network_set_mode(struct ofono_modem *modem,
       enum network_mode mode,
       response_cb cb,
       void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
   GVariant *var;
   const char *str_mode;
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
   str_mode = _network_mode_to_str(mode);
   tapi_debug("Mode(%d): %s", mode, str_mode);
@@ -443,140 +492,522 @@ EXPORT_API void ofono_network_set_mode(struct ofono_modem *modem,
   var = g_variant_new("(sv)", "TechnologyPreference",
       g_variant_new_string(str_mode));
 
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_RADIO_SETTINGS_IFACE, "SetProperty", var,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       on_response_common, cbd);
+
+  return id;
 }
 
-EXPORT_API void ofono_network_register(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_network_register(struct ofono_modem *modem,
       const char *plmn,
       response_cb cb,
       void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
+  struct operator_info op;
+  char *path;
 
   CHECK_PARAMETERS(modem && plmn, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
   tapi_debug("Plmn: %s", plmn);
 
-  char *path = g_strdup_printf("%s/operator/%s", modem->path, plmn);
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, path,
+  /* the operator object of the last scan, if still cached */
+  if (ofono_network_get_cached_operator(modem, plmn, &op)) {
+    tapi_debug("Operator: %s, status: %d", op.name, op.status);
+    path = op.path;
+    g_free(op.name);
+  } else {
+    path = g_strdup_printf("%s/operator/%s", modem->path, plmn);
+  }
+
+  dispatch_call(modem->conn, OFONO_SERVICE, path,
       OFONO_NETWORK_OPERATOR_IFACE, "Register", NULL,
-      NULL, G_DBUS_CALL_FLAGS_NONE, 60000, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, 60000, cbd->cancellable,
       on_response_common, cbd);
 
   g_free(path);
+
+  return id;
 }
 
-EXPORT_API void ofono_network_auto_register(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_network_auto_register(struct ofono_modem *modem,
       response_cb cb,
       void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
 
   tapi_debug("");
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_NETWORK_REGISTRATION_IFACE, "Register", NULL,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       on_response_common, cbd);
+
+  return id;
 }
 
-static void _on_response_scan_operators(GObject *obj, GAsyncResult *result,
-      gpointer user_data)
+enum operator_key {
+  OPERATOR_KEY_NAME,
+  OPERATOR_KEY_STATUS,
+  OPERATOR_KEY_MCC,
+  OPERATOR_KEY_MNC,
+  OPERATOR_KEY_TECHNOLOGIES,
+};
+
+static const struct str_map operator_key_map[] = {
+  {"Name", OPERATOR_KEY_NAME},
+  {"Status", OPERATOR_KEY_STATUS},
+  {"MobileCountryCode", OPERATOR_KEY_MCC},
+  {"MobileNetworkCode", OPERATOR_KEY_MNC},
+  {"Technologies", OPERATOR_KEY_TECHNOLOGIES},
+  {NULL, 0}
+};
+
+static struct str_table operator_key_table = STR_TABLE_INIT(operator_key_map);
+
+void ofono_network_parse_operators(GVariant *resp, struct operators_info *ops)
 {
-  TResult ret;
-  GVariant *resp;
-  GError *error = NULL;
-  struct response_cb_data *cbd = user_data;
-
-  struct operators_info ops;
-  int count;
   struct operator_info *p_op;
   GVariantIter *iter, *iter_properites;
-  char *path;
-  char *key;
+  const char *path;
+  const char *key;
   GVariant *val;
-  int i;
 
-  resp = g_dbus_connection_call_finish(G_DBUS_CONNECTION(obj), result, &error);
-
-  CHECK_RESULT(ret, error, cbd, resp);
-  tapi_debug("%s", g_variant_print(resp, TRUE));
+  memset(ops, 0, sizeof(*ops));
 
   g_variant_get(resp, "(a(oa{sv}))", &iter);
-  count = g_variant_iter_n_children(iter);
-  if (count == 0) {
-    CALL_RESP_CALLBACK(ret, NULL, cbd);
+  ops->count = g_variant_iter_n_children(iter);
+  if (ops->count == 0) {
     g_variant_iter_free(iter);
-    g_variant_unref(resp);
     return;
   }
 
-  ops.ops = g_malloc0(sizeof(struct operator_info) * count);
-  ops.count = count;
-  p_op = ops.ops;
+  ops->ops = g_malloc0(sizeof(struct operator_info) * ops->count);
+  p_op = ops->ops;
 
-  while (g_variant_iter_loop(iter, "(oa{sv})", &path, &iter_properites)) {
-      p_op->path = g_strdup(path);
-    while(g_variant_iter_loop(iter_properites, "{sv}", &key, &val)) {
-      if (g_strcmp0(key, "Name") == 0) {
-        p_op->name = g_variant_dup_string(val, NULL);
+  while (g_variant_iter_loop(iter, "(&oa{sv})", &path, &iter_properites)) {
+    p_op->path = (char *) path;
+    while(g_variant_iter_loop(iter_properites, "{&sv}", &key, &val)) {
+      switch (str_table_lookup(&operator_key_table, key, -1)) {
+      case OPERATOR_KEY_NAME:
+        p_op->name = (char *) g_variant_get_string(val, NULL);
         tapi_debug("Name: %s", p_op->name);
-      } else if (g_strcmp0(key, "Status") == 0) {
+        break;
+      case OPERATOR_KEY_STATUS: {
         const char *s = g_variant_get_string(val, NULL);
         p_op->status = _str_to_operator_status(s);
         tapi_debug("Staus(%d): %s", p_op->status, s);
-      } else if (g_strcmp0(key, "MobileCountryCode") == 0) {
+        break;
+      }
+      case OPERATOR_KEY_MCC: {
         const char *mcc = g_variant_get_string(val, NULL);
         g_strlcpy(p_op->plmn, mcc, MAX_MCC_LEN + 1);
         tapi_debug("MCC: %s", mcc);
-      } else if (g_strcmp0(key, "MobileNetworkCode") == 0) {
+        break;
+      }
+      case OPERATOR_KEY_MNC: {
         const char *mnc = g_variant_get_string(val, NULL);
         g_strlcpy(p_op->plmn + MAX_MCC_LEN, mnc,
             MAX_MNC_LEN + 1);
         tapi_debug("MNC: %s", mnc);
-      } else if (g_strcmp0(key, "Technologies") == 0) {
-        char *tech;
+        break;
+      }
+      case OPERATOR_KEY_TECHNOLOGIES: {
+        const char *tech;
         GVariantIter iter_tech;
         g_variant_iter_init(&iter_tech, val);
-        while (g_variant_iter_loop(&iter_tech, "s", &tech)) {
+        while (g_variant_iter_next(&iter_tech, "&s", &tech)) {
           p_op->techs |= 1 << ofono_str_to_tech(tech);
           tapi_debug("ACT: %s", tech);
         }
+        break;
+      }
       }
     }
     p_op++;
   }
 
-  CALL_RESP_CALLBACK(ret, &ops, cbd);
   g_variant_iter_free(iter);
-  g_variant_unref(resp);
-  for (i = 0; i < count; i++) {
-    g_free(ops.ops[i].name);
-    g_free(ops.ops[i].path);
+}
+
+void ofono_network_free_operators(struct operators_info *ops)
+{
+  g_free(ops->ops);
+}
+
+/*
+ * Scan keeps the radio busy for tens of seconds and ofonod rejects the
+ * concurrent ones with InProgress: the callers share the scan in flight,
+ * and its result is kept "ttl" seconds for the ones coming after it.
+ */
+#define SCAN_TIMEOUT 100000 /* ms */
+#define SCAN_CACHE_TTL 60 /* s */
+
+/* a Scan reply, shared by the callers it completes and the cache */
+struct scan_result {
+  gint refs;
+  GVariant *resp; /* the names and paths of "ops" point into it */
+  struct operators_info ops;
+  GHashTable *index; /* plmn -> struct operator_info in "ops" */
+  gint64 expiry; /* monotonic time */
+};
+
+struct operator_scan {
+  gint refs;
+  GMutex lock; /* protects the fields below */
+  GDBusConnection *conn;
+  unsigned int ttl; /* seconds, 0 for no cache */
+  tapi_bool in_flight;
+  GQueue waiters; /* struct scan_waiter of the scan in flight */
+  struct scan_result *cache; /* NULL if there is no valid result */
+  tapi_bool released; /* the modem is gone */
+};
+
+struct scan_waiter {
+  struct operator_scan *scan;
+  struct response_cb_data *cbd;
+  gulong cancel_id; /* 0 once the cancel handler has run */
+  TResult ret; /* deferred completion */
+  struct scan_result *result;
+};
+
+static struct scan_result *_scan_result_new(GVariant *resp, unsigned int ttl)
+{
+  struct scan_result *res;
+  int i;
+
+  res = g_new0(struct scan_result, 1);
+  res->refs = 1;
+  res->resp = resp;
+  res->expiry = g_get_monotonic_time() + (gint64) ttl * G_USEC_PER_SEC;
+  res->index = g_hash_table_new(g_str_hash, g_str_equal);
+
+  ofono_network_parse_operators(resp, &res->ops);
+  for (i = 0; i < res->ops.count; i++)
+    g_hash_table_insert(res->index, res->ops.ops[i].plmn, &res->ops.ops[i]);
+
+  return res;
+}
+
+static struct scan_result *_scan_result_ref(struct scan_result *res)
+{
+  g_atomic_int_inc(&res->refs);
+
+  return res;
+}
+
+static void _scan_result_unref(struct scan_result *res)
+{
+  if (res == NULL || !g_atomic_int_dec_and_test(&res->refs))
+    return;
+
+  g_hash_table_destroy(res->index);
+  ofono_network_free_operators(&res->ops);
+  g_variant_unref(res->resp);
+  g_free(res);
+}
+
+static struct operator_scan *_scan_ref(struct operator_scan *scan)
+{
+  g_atomic_int_inc(&scan->refs);
+
+  return scan;
+}
+
+static void _scan_unref(struct operator_scan *scan)
+{
+  if (!g_atomic_int_dec_and_test(&scan->refs))
+    return;
+
+  _scan_result_unref(scan->cache);
+  g_object_unref(scan->conn);
+  g_mutex_clear(&scan->lock);
+  g_free(scan);
+}
+
+/* must be called with the scan lock held, returns a new reference */
+static struct scan_result *_scan_cache_get(struct operator_scan *scan)
+{
+  if (scan->cache == NULL)
+    return NULL;
+
+  if (g_get_monotonic_time() >= scan->cache->expiry) {
+    _scan_result_unref(scan->cache);
+    scan->cache = NULL;
+    return NULL;
+  }
+
+  return _scan_result_ref(scan->cache);
+}
+
+void network_scan_init(struct ofono_modem *modem)
+{
+  struct operator_scan *scan;
+
+  scan = g_new0(struct operator_scan, 1);
+  scan->refs = 1;
+  g_mutex_init(&scan->lock);
+  scan->conn = g_object_ref(modem->conn);
+  scan->ttl = SCAN_CACHE_TTL;
+  g_queue_init(&scan->waiters);
+
+  modem->scan = scan;
+}
+
+/* the scan in flight, if any, is cancelled with the modem */
+void network_scan_deinit(struct ofono_modem *modem)
+{
+  struct operator_scan *scan = modem->scan;
+
+  g_mutex_lock(&scan->lock);
+  _scan_result_unref(scan->cache);
+  scan->cache = NULL;
+  scan->released = TRUE;
+  g_mutex_unlock(&scan->lock);
+
+  modem->scan = NULL;
+  _scan_unref(scan);
+}
+
+static void _scan_waiter_done(struct scan_waiter *waiter, TResult ret,
+      struct scan_result *res)
+{
+  struct response_cb_data *cbd = waiter->cbd;
+
+  /* waits for a cancel handler running in another thread */
+  if (waiter->cancel_id > 0)
+    g_cancellable_disconnect(cbd->cancellable, waiter->cancel_id);
+
+  if (ret == TAPI_RESULT_OK && g_cancellable_is_cancelled(cbd->cancellable))
+    ret = TAPI_RESULT_CANCELLED;
+
+  if (ret == TAPI_RESULT_OK && res->ops.count > 0) {
+    CALL_RESP_CALLBACK(ret, &res->ops, cbd);
+  } else {
+    CALL_RESP_CALLBACK(ret, NULL, cbd);
+  }
+
+  _scan_unref(waiter->scan);
+  g_free(waiter);
+}
+
+static void _scan_waiter_run(gpointer data)
+{
+  struct scan_waiter *waiter = data;
+  struct scan_result *res = waiter->result;
+
+  _scan_waiter_done(waiter, waiter->ret, res);
+  _scan_result_unref(res);
+}
+
+static gboolean _on_scan_waiter_timeout(gpointer data)
+{
+  dispatch_post(_scan_waiter_run, data);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* completes "waiter" later, never from within the caller */
+static void _scan_waiter_defer(struct scan_waiter *waiter, TResult ret,
+      struct scan_result *res)
+{
+  waiter->ret = ret;
+  waiter->result = res;
+
+  dispatch_timeout_add(waiter->scan->conn, 0, _on_scan_waiter_timeout,
+      waiter);
+}
+
+/*
+ * The caller gives up, the scan goes on for the others and the cache.
+ * Runs from g_cancellable_cancel(), which must not be disconnected from
+ * here: the handler stays connected to a cancellable that can't fire
+ * again.
+ */
+static void _on_scan_waiter_cancelled(GCancellable *cancellable,
+      gpointer data)
+{
+  struct scan_waiter *waiter = data;
+  struct operator_scan *scan = waiter->scan;
+  tapi_bool waiting;
+
+  g_mutex_lock(&scan->lock);
+  waiting = g_queue_remove(&scan->waiters, waiter);
+  g_mutex_unlock(&scan->lock);
+
+  /* otherwise it is being completed */
+  if (!waiting)
+    return;
+
+  waiter->cancel_id = 0;
+  _scan_waiter_defer(waiter, TAPI_RESULT_CANCELLED, NULL);
+}
+
+static void _on_response_scan_operators(GObject *obj, GAsyncResult *result,
+      gpointer user_data)
+{
+  struct operator_scan *scan = user_data;
+  struct scan_result *res = NULL;
+  struct scan_waiter *waiter;
+  GError *error = NULL;
+  GVariant *resp;
+  GQueue waiters;
+  TResult ret;
+
+  resp = g_dbus_connection_call_finish(G_DBUS_CONNECTION(obj), result, &error);
+  ret = ofono_error_parse(error);
+
+  if (resp != NULL) {
+    if (tapi_log_enabled(TAPI_LOG_DEBUG)) {
+      gchar *dump = g_variant_print(resp, TRUE);
+      tapi_debug("%s", dump);
+      g_free(dump);
+    }
+
+    res = _scan_result_new(resp, scan->ttl);
+  }
+
+  g_mutex_lock(&scan->lock);
+
+  scan->in_flight = FALSE;
+  waiters = scan->waiters;
+  g_queue_init(&scan->waiters);
+
+  if (res != NULL && scan->ttl > 0 && !scan->released) {
+    _scan_result_unref(scan->cache);
+    scan->cache = _scan_result_ref(res);
   }
-  g_free(ops.ops);
+
+  g_mutex_unlock(&scan->lock);
+
+  tapi_debug("scan done, %u callers", waiters.length);
+
+  while ((waiter = g_queue_pop_head(&waiters)) != NULL)
+    _scan_waiter_done(waiter, ret, res);
+
+  _scan_result_unref(res);
+  if (error != NULL)
+    g_error_free(error);
+  _scan_unref(scan);
 }
 
-EXPORT_API void ofono_network_scan_operators(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_network_scan_operators(struct ofono_modem *modem,
       response_cb cb,
       void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
+  struct operator_scan *scan;
+  struct scan_waiter *waiter;
+  struct scan_result *res;
+  tapi_bool issue = FALSE;
 
   tapi_debug("");
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
+
+  scan = modem->scan;
+
+  waiter = g_new0(struct scan_waiter, 1);
+  waiter->scan = _scan_ref(scan);
+  waiter->cbd = cbd;
+  /* before it is queued, the handler takes the scan lock */
+  waiter->cancel_id = g_cancellable_connect(cbd->cancellable,
+        G_CALLBACK(_on_scan_waiter_cancelled), waiter, NULL);
+
+  g_mutex_lock(&scan->lock);
+
+  res = _scan_cache_get(scan);
+  if (res == NULL) {
+    g_queue_push_tail(&scan->waiters, waiter);
+    issue = !scan->in_flight;
+    scan->in_flight = TRUE;
+  }
+
+  g_mutex_unlock(&scan->lock);
 
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  if (res != NULL) {
+    tapi_debug("%d operators cached", res->ops.count);
+    _scan_waiter_defer(waiter, TAPI_RESULT_OK, res);
+    return id;
+  }
+
+  if (!issue) {
+    tapi_debug("joining the scan in flight");
+    return id;
+  }
+
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_NETWORK_REGISTRATION_IFACE, "Scan", NULL,
-      NULL, G_DBUS_CALL_FLAGS_NONE, 100000, NULL,
-      _on_response_scan_operators, cbd);
+      G_VARIANT_TYPE("(a(oa{sv}))"), G_DBUS_CALL_FLAGS_NONE, SCAN_TIMEOUT,
+      modem->cancellable, _on_response_scan_operators, _scan_ref(scan));
+
+  return id;
+}
+
+EXPORT_API void ofono_network_set_scan_cache(struct ofono_modem *modem,
+      unsigned int ttl)
+{
+  struct operator_scan *scan;
+
+  if (modem == NULL)
+    return;
+
+  scan = modem->scan;
+
+  g_mutex_lock(&scan->lock);
+
+  scan->ttl = ttl;
+  if (ttl == 0) {
+    _scan_result_unref(scan->cache);
+    scan->cache = NULL;
+  }
+
+  g_mutex_unlock(&scan->lock);
+}
+
+EXPORT_API tapi_bool ofono_network_get_cached_operator(
+      struct ofono_modem *modem, const char *plmn,
+      struct operator_info *info)
+{
+  struct operator_scan *scan;
+  struct scan_result *res;
+  struct operator_info *op = NULL;
+
+  if (modem == NULL || plmn == NULL || info == NULL) {
+    tapi_error("Invalid parameter");
+    return FALSE;
+  }
+
+  scan = modem->scan;
+
+  g_mutex_lock(&scan->lock);
+  res = _scan_cache_get(scan);
+  g_mutex_unlock(&scan->lock);
+
+  if (res == NULL)
+    return FALSE;
+
+  op = g_hash_table_lookup(res->index, plmn);
+  if (op != NULL) {
+    *info = *op;
+    info->name = g_strdup(op->name);
+    info->path = g_strdup(op->path);
+  }
+
+  _scan_result_unref(res);
+
+  return op != NULL;
 }
@@ -33,29 +33,33 @@ static void _on_response_import(GObject *obj,
 
   CHECK_RESULT(ret, error, cbd, resp);
 
-  g_variant_get(resp, "(s)", &vcards);
+  /* borrowed from the reply, no copy of the whole phonebook */
+  g_variant_get(resp, "(&s)", &vcards);
 
   tapi_debug("vcards: %s", vcards);
 
   CALL_RESP_CALLBACK(ret, &vcards, cbd);
   g_variant_unref(resp);
-  g_free(vcards);
 }
 
-EXPORT_API void ofono_phonebook_import(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_phonebook_import(struct ofono_modem *modem,
         response_cb cb,
         void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
 
   tapi_debug("");
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_PHONEBOOK_IFACE, "Import", NULL,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       _on_response_import, cbd);
+
+  return id;
 }
 
@@ -589,61 +589,62 @@ EXPORT_API void ofono_sat_deinit_agent(struct ofono_sat_agent *agent)
   g_free(agent);
 }
 
-EXPORT_API void ofono_sat_select_item(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_sat_select_item(struct ofono_modem *modem,
       guchar index, response_cb cb,
       void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
   GVariant *var;
 
   tapi_debug("Index: %d", index);
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
   var = g_variant_new("(yo)", index, modem->path);
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_STK_IFACE, "SelectItem", var,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       on_response_common, cbd);
-}
 
-EXPORT_API tapi_bool ofono_sat_get_main_menu(struct ofono_modem *modem,
-      struct sat_main_menu *menu)
-{
-  GError *error = NULL;
-  GVariant *resp;
-  GVariantIter *iter;
-  char *key;
-  GVariant *var_val;
+  return id;
+}
 
-  tapi_debug("");
+enum sat_key {
+  SAT_KEY_MAIN_MENU_TITLE,
+  SAT_KEY_MAIN_MENU_ICON,
+  SAT_KEY_MAIN_MENU,
+};
 
-  if (modem == NULL || menu == NULL) {
-    tapi_error("Invalid parameter");
-    return FALSE;
-  }
+static const struct str_map sat_key_map[] = {
+  {"MainMenuTitle", SAT_KEY_MAIN_MENU_TITLE},
+  {"MainMenuIcon", SAT_KEY_MAIN_MENU_ICON},
+  {"MainMenu", SAT_KEY_MAIN_MENU},
+  {NULL, 0}
+};
 
-  resp = g_dbus_connection_call_sync(modem->conn, OFONO_SERVICE,
-      modem->path, OFONO_STK_IFACE, "GetProperties",
-      NULL, NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
-      &error);
+static struct str_table sat_key_table = STR_TABLE_INIT(sat_key_map);
 
-  if (resp == NULL) {
-    tapi_error("dbus call failed (%s)", error->message);
-    g_error_free(error);
-    return FALSE;
-  }
+static void _parse_main_menu(GVariant *resp, struct sat_main_menu *menu)
+{
+  GVariantIter *iter;
+  const char *key;
+  GVariant *var_val;
 
   memset(menu, 0, sizeof(struct sat_main_menu));
   g_variant_get(resp, "(a{sv})", &iter);
-  while (g_variant_iter_next(iter, "{sv}", &key, &var_val)) {
-    if (g_strcmp0(key, "MainMenuTitle") == 0) {
+  while (g_variant_iter_next(iter, "{&sv}", &key, &var_val)) {
+    switch (str_table_lookup(&sat_key_table, key, -1)) {
+    case SAT_KEY_MAIN_MENU_TITLE:
       g_variant_get(var_val, "s", &menu->title);
       tapi_info("Title: %s", menu->title);
-    } else if (g_strcmp0(key, "MainMenuIcon") == 0) {
+      break;
+    case SAT_KEY_MAIN_MENU_ICON:
       g_variant_get(var_val, "y", &menu->icon);
-    } else if (g_strcmp0(key, "MainMenu") == 0) {
+      break;
+    case SAT_KEY_MAIN_MENU: {
       GVariantIter *iter_menu;
       struct sat_menu_item *p_item;
 
@@ -651,7 +652,6 @@ EXPORT_API tapi_bool ofono_sat_get_main_menu(struct ofono_modem *modem,
       if (menu->item_count <= 0) {
         tapi_error("Main Menu contain %d items", menu->item_count);
 
-        g_free(key);
         g_variant_unref(var_val);
         goto done;
       }
@@ -667,19 +667,92 @@ EXPORT_API tapi_bool ofono_sat_get_main_menu(struct ofono_modem *modem,
       }
 
       g_variant_iter_free(iter_menu);
+      break;
+    }
     }
 
-    g_free(key);
     g_variant_unref(var_val);
   }
 
 done:
   g_variant_iter_free(iter);
+}
+
+EXPORT_API tapi_bool ofono_sat_get_main_menu(struct ofono_modem *modem,
+      struct sat_main_menu *menu)
+{
+  GError *error = NULL;
+  GVariant *resp;
+
+  tapi_debug("");
+
+  if (modem == NULL || menu == NULL) {
+    tapi_error("Invalid parameter");
+    return FALSE;
+  }
+
+  resp = g_dbus_connection_call_sync(modem->conn, OFONO_SERVICE,
+      modem->path, OFONO_STK_IFACE, "GetProperties",
+      NULL, NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      &error);
+
+  if (resp == NULL) {
+    tapi_error("dbus call failed (%s)", error->message);
+    g_error_free(error);
+    return FALSE;
+  }
+
+  _parse_main_menu(resp, menu);
   g_variant_unref(resp);
 
   return TRUE;
 }
 
+static void _on_response_get_main_menu(GObject *obj, GAsyncResult *result,
+      gpointer user_data)
+{
+  TResult ret;
+  GVariant *resp;
+  GError *error = NULL;
+  struct response_cb_data *cbd = user_data;
+  struct sat_main_menu menu;
+  int i;
+
+  resp = dispatch_call_finish(obj, result, &error);
+
+  CHECK_RESULT(ret, error, cbd, resp);
+
+  _parse_main_menu(resp, &menu);
+
+  CALL_RESP_CALLBACK(ret, &menu, cbd);
+
+  g_free(menu.title);
+  for (i = 0; i < menu.item_count && menu.items != NULL; i++)
+    g_free(menu.items[i].text);
+  g_free(menu.items);
+  g_variant_unref(resp);
+}
+
+EXPORT_API ofono_request ofono_sat_get_main_menu_async(struct ofono_modem *modem,
+      response_cb cb, void *user_data)
+{
+  struct response_cb_data *cbd;
+  ofono_request id;
+
+  tapi_debug("");
+
+  CHECK_PARAMETERS(modem, cb, user_data);
+  NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
+
+  dispatch_call_shared(modem->conn, OFONO_SERVICE, modem->path,
+      OFONO_STK_IFACE, "GetProperties", NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
+      _on_response_get_main_menu, cbd);
+
+  return id;
+}
+
 EXPORT_API void ofono_sat_send_response(struct ofono_sat_agent *agent,
       enum sat_result result, enum sat_response_type type,
       void *data)
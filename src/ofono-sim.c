@@ -43,49 +43,44 @@ static const char *_pin_lock_type_to_str(enum pin_lock_type type)
   return pinlock_name[type];
 }
 
+static const struct str_map pinlock_map[] = {
+  {"none", PIN_LOCK_NONE},
+  {"pin", PIN_LOCK_SIM_PIN},
+  {"puk", PIN_LOCK_SIM_PUK},
+  {"phone", PIN_LOCK_PHSIM_PIN},
+  {"firstphone", PIN_LOCK_PHFSIM_PIN},
+  {"firstphonepuk", PIN_LOCK_PHFSIM_PUK},
+  {"pin2", PIN_LOCK_SIM_PIN2},
+  {"puk2", PIN_LOCK_SIM_PUK2},
+  {"network", PIN_LOCK_PHNET_PIN},
+  {"networkpuk", PIN_LOCK_PHNET_PUK},
+  {"netsub", PIN_LOCK_PHNETSUB_PIN},
+  {"netsubpuk", PIN_LOCK_PHNETSUB_PUK},
+  {"service", PIN_LOCK_PHSP_PIN},
+  {"servicepuk", PIN_LOCK_PHSP_PUK},
+  {"corp", PIN_LOCK_PHCORP_PIN},
+  {"corppuk", PIN_LOCK_PHCORP_PUK},
+  {NULL, 0}
+};
+
+static struct str_table pinlock_table = STR_TABLE_INIT(pinlock_map);
+
 static enum pin_lock_type _str_to_pin_lock_type(char *type)
 {
+  int val;
+
   if (type == NULL) {
     tapi_error("");
     return PIN_LOCK_NONE;
   }
 
-  if (g_strcmp0(type, "none") == 0)
-    return PIN_LOCK_NONE;
-  else if (g_strcmp0(type, "pin") == 0)
-    return PIN_LOCK_SIM_PIN;
-  else if (g_strcmp0(type, "puk") == 0)
-    return PIN_LOCK_SIM_PUK;
-  else if (g_strcmp0(type, "phone") == 0)
-    return PIN_LOCK_PHSIM_PIN;
-  else if (g_strcmp0(type, "firstphone") == 0)
-    return PIN_LOCK_PHFSIM_PIN;
-  else if (g_strcmp0(type, "firstphonepuk") == 0)
-    return PIN_LOCK_PHFSIM_PUK;
-  else if (g_strcmp0(type, "pin2") == 0)
-    return PIN_LOCK_SIM_PIN2;
-  else if (g_strcmp0(type, "puk2") == 0)
-    return PIN_LOCK_SIM_PUK2;
-  else if (g_strcmp0(type, "network") == 0)
-    return PIN_LOCK_PHNET_PIN;
-  else if (g_strcmp0(type, "networkpuk") == 0)
-    return PIN_LOCK_PHNET_PUK;
-  else if (g_strcmp0(type, "netsub") == 0)
-    return PIN_LOCK_PHNETSUB_PIN;
-  else if (g_strcmp0(type, "netsubpuk") == 0)
-    return PIN_LOCK_PHNETSUB_PUK;
-  else if (g_strcmp0(type, "service") == 0)
-    return PIN_LOCK_PHSP_PIN;
-  else if (g_strcmp0(type, "servicepuk") == 0)
-    return PIN_LOCK_PHSP_PUK;
-  else if (g_strcmp0(type, "corp") == 0)
-    return PIN_LOCK_PHCORP_PIN;
-  else if (g_strcmp0(type, "corppuk") == 0)
-    return PIN_LOCK_PHCORP_PUK;
-  else {
+  val = str_table_lookup(&pinlock_table, type, -1);
+  if (val < 0) {
     tapi_error("Unknown PIN Lock type");
     return PIN_LOCK_NONE;
   }
+
+  return val;
 }
 
 static tapi_bool _check_pin(char *pin)
@@ -101,70 +96,82 @@ static tapi_bool _check_pin(char *pin)
   return TRUE;
 }
 
-EXPORT_API void ofono_sim_enable_pin(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_sim_enable_pin(struct ofono_modem *modem,
       enum pin_lock_type type,
       char *pin,
       response_cb cb,
       void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
   GVariant *var;
 
   CHECK_PARAMETERS(modem && _check_pin(pin), cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
   tapi_debug("Type: %d, PIN: %s", type, pin);
 
   var = g_variant_new("(ss)", _pin_lock_type_to_str(type), pin);
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_SIM_MANAGER_IFACE, "LockPin", var,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       on_response_common, cbd);
+
+  return id;
 }
 
-EXPORT_API void ofono_sim_disable_pin(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_sim_disable_pin(struct ofono_modem *modem,
       enum pin_lock_type type,
       char *pin,
       response_cb cb,
       void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
   GVariant *var;
 
   CHECK_PARAMETERS(modem && _check_pin(pin), cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
   tapi_debug("Type: %d, PIN: %s", type, pin);
 
   var = g_variant_new("(ss)", _pin_lock_type_to_str(type), pin);
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_SIM_MANAGER_IFACE, "UnlockPin", var,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       on_response_common, cbd);
+
+  return id;
 }
 
-EXPORT_API void ofono_sim_enter_pin(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_sim_enter_pin(struct ofono_modem *modem,
       enum pin_lock_type type,
       char *pin,
       response_cb cb,
       void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
   GVariant *var;
 
   CHECK_PARAMETERS(modem && _check_pin(pin), cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
   tapi_debug("Type: %d, PIN: %s", type, pin);
 
   var = g_variant_new("(ss)", _pin_lock_type_to_str(type), pin);
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_SIM_MANAGER_IFACE, "EnterPin", var,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       on_response_common, cbd);
+
+  return id;
 }
 
-EXPORT_API void ofono_sim_reset_pin(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_sim_reset_pin(struct ofono_modem *modem,
       enum pin_lock_type type,
       char *puk,
       char *new_pin,
@@ -172,22 +179,26 @@ EXPORT_API void ofono_sim_reset_pin(struct ofono_modem *modem,
       void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
   GVariant *var;
 
   CHECK_PARAMETERS(modem && _check_pin(puk) && _check_pin(new_pin), cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
   tapi_debug("Type: %d, Old: %s, New: %s", type, puk, new_pin);
 
   var = g_variant_new("(sss)", _pin_lock_type_to_str(type), puk, new_pin);
 
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_SIM_MANAGER_IFACE, "ResetPin", var,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       on_response_common, cbd);
+
+  return id;
 }
 
-EXPORT_API void ofono_sim_change_pin(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_sim_change_pin(struct ofono_modem *modem,
       enum pin_lock_type type,
       char *old_pin,
       char *new_pin,
@@ -195,75 +206,87 @@ EXPORT_API void ofono_sim_change_pin(struct ofono_modem *modem,
       void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
   GVariant *var;
 
   CHECK_PARAMETERS(modem && _check_pin(old_pin) && _check_pin(new_pin),cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
   tapi_debug("Type: %d, Old: %s, New: %s", type, old_pin, new_pin);
 
   var = g_variant_new("(sss)", _pin_lock_type_to_str(type), old_pin, new_pin);
 
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_SIM_MANAGER_IFACE, "ChangePin", var,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       on_response_common, cbd);
+
+  return id;
 }
 
-EXPORT_API tapi_bool ofono_sim_get_info(struct ofono_modem *modem,
-      struct sim_info *info)
+enum sim_key {
+  SIM_KEY_PRESENT,
+  SIM_KEY_IMSI,
+  SIM_KEY_ICCID,
+  SIM_KEY_MCC,
+  SIM_KEY_MNC,
+  SIM_KEY_SUBSCRIBER_NUMBERS,
+  SIM_KEY_RETRIES,
+  SIM_KEY_PIN_REQUIRED,
+  SIM_KEY_LOCKED_PINS,
+};
+
+static const struct str_map sim_key_map[] = {
+  {"Present", SIM_KEY_PRESENT},
+  {"SubscriberIdentity", SIM_KEY_IMSI},
+  {"CardIdentifier", SIM_KEY_ICCID},
+  {"MobileCountryCode", SIM_KEY_MCC},
+  {"MobileNetworkCode", SIM_KEY_MNC},
+  {"SubscriberNumbers", SIM_KEY_SUBSCRIBER_NUMBERS},
+  {"Retries", SIM_KEY_RETRIES},
+  {"PinRequired", SIM_KEY_PIN_REQUIRED},
+  {"LockedPins", SIM_KEY_LOCKED_PINS},
+  {NULL, 0}
+};
+
+static struct str_table sim_key_table = STR_TABLE_INIT(sim_key_map);
+
+void ofono_sim_parse_info(GHashTable *props, struct sim_info *info)
 {
-  GError *error = NULL;
-  GVariant *var_properties;
-  GVariantIter *iter;
-  char *key;
+  GHashTableIter iter;
+  gpointer key;
   GVariant *var_val;
   const char *val;
 
-  tapi_debug("");
-
-  if (modem == NULL || info == NULL) {
-    tapi_error("Invalid parameter");
-    return FALSE;
-  }
-
   memset(info, 0, sizeof(struct sim_info));
-  if (!has_interface(modem->interfaces, OFONO_API_SIM)) {
-    info->status = SIM_STATUS_ABSENT;
-    return TRUE;
-  }
 
-  var_properties = g_dbus_connection_call_sync(modem->conn,
-      OFONO_SERVICE, modem->path, OFONO_SIM_MANAGER_IFACE,
-      "GetProperties", NULL, NULL,
-      G_DBUS_SEND_MESSAGE_FLAGS_NONE, -1, NULL, &error);
-
-  if (var_properties == NULL) {
-    tapi_error("dbus call failed (%s)", error->message);
-    g_error_free(error);
-    return FALSE;
-  }
-
-  g_variant_get(var_properties, "(a{sv})", &iter);
-  while (g_variant_iter_next(iter, "{sv}", &key, &var_val)) {
-    if (g_strcmp0(key, "Present") == 0) {
+  g_hash_table_iter_init(&iter, props);
+  while (g_hash_table_iter_next(&iter, &key, (gpointer *) &var_val)) {
+    switch (str_table_lookup(&sim_key_table, key, -1)) {
+    case SIM_KEY_PRESENT:
       if (g_variant_get_boolean(var_val) == TRUE)
         info->status = SIM_STATUS_INITIALIZING;
       else
         info->status = SIM_STATUS_ABSENT;
-    } else if (g_strcmp0(key, "SubscriberIdentity") == 0) {
+      break;
+    case SIM_KEY_IMSI:
       val = g_variant_get_string(var_val, NULL);
       g_strlcpy(info->imsi, val, sizeof(info->imsi));
-    } else if (g_strcmp0(key, "CardIdentifier") == 0) {
+      break;
+    case SIM_KEY_ICCID:
       val = g_variant_get_string(var_val, NULL);
       g_strlcpy(info->iccid, val, sizeof(info->iccid));
-    } else if (g_strcmp0(key, "MobileCountryCode") == 0) {
+      break;
+    case SIM_KEY_MCC:
       val = g_variant_get_string(var_val, NULL);
       g_strlcpy(info->mcc, val, sizeof(info->mcc));
-    } else if (g_strcmp0(key, "MobileNetworkCode") == 0) {
+      break;
+    case SIM_KEY_MNC:
       val = g_variant_get_string(var_val, NULL);
       g_strlcpy(info->mnc, val, sizeof(info->mnc));
-    } else if (g_strcmp0(key, "SubscriberNumbers") == 0) {
+      break;
+    case SIM_KEY_SUBSCRIBER_NUMBERS: {
       GVariantIter *msisdn_iter;
       char *num = NULL;
       g_variant_get(var_val, "as", &msisdn_iter);
@@ -278,7 +301,9 @@ EXPORT_API tapi_bool ofono_sim_get_info(struct ofono_modem *modem,
         g_free(num);
       }
       g_variant_iter_free(msisdn_iter);
-    } else if (g_strcmp0(key, "Retries") == 0) {
+      break;
+    }
+    case SIM_KEY_RETRIES: {
       GVariantIter *retry_iter;
       char *lock_type;
       unsigned char retry;
@@ -293,10 +318,14 @@ EXPORT_API tapi_bool ofono_sim_get_info(struct ofono_modem *modem,
       }
 
       g_variant_iter_free(retry_iter);
-    } else if (g_strcmp0(key, "PinRequired") == 0) {
+      break;
+    }
+    case SIM_KEY_PIN_REQUIRED: {
       const char *lock = g_variant_get_string(var_val, NULL);
       info->pin_required = _str_to_pin_lock_type((char *)lock);
-    }  else if (g_strcmp0(key, "LockedPins") == 0) {
+      break;
+    }
+    case SIM_KEY_LOCKED_PINS: {
       GVariantIter *pin_iter;
       char *lock_pin;
       enum pin_lock_type type;
@@ -309,15 +338,11 @@ EXPORT_API tapi_bool ofono_sim_get_info(struct ofono_modem *modem,
       }
 
       g_variant_iter_free(pin_iter);
+      break;
+    }
     }
-
-    g_free(key);
-    g_variant_unref(var_val);
   }
 
-  g_variant_iter_free(iter);
-  g_variant_unref(var_properties);
-
   tapi_debug("status: %d, pin_required: %d, IMSI: %s, ICCID: %s, MCC: %s, "\
       "MNC: %s, msisdn: %s/%s, pin_lock(%d), retries: %d-%d-%d-%d",
       info->status, info->pin_required, info->imsi, info->iccid,
@@ -326,7 +351,7 @@ EXPORT_API tapi_bool ofono_sim_get_info(struct ofono_modem *modem,
       info->retries[PIN_LOCK_SIM_PIN2], info->retries[PIN_LOCK_SIM_PUK2]);
 
   if(info->status == SIM_STATUS_ABSENT)
-    return TRUE;
+    return;
 
   info->status = SIM_STATUS_INITIALIZING;
   if (info->pin_required != PIN_LOCK_NONE)
@@ -336,7 +361,33 @@ EXPORT_API tapi_bool ofono_sim_get_info(struct ofono_modem *modem,
     if (info->imsi[0] != '\0')
       info->status = SIM_STATUS_READY;
   }
+}
+
+EXPORT_API tapi_bool ofono_sim_get_info(struct ofono_modem *modem,
+      struct sim_info *info)
+{
+  GHashTable *props;
+
+  tapi_debug("");
 
+  if (modem == NULL || info == NULL) {
+    tapi_error("Invalid parameter");
+    return FALSE;
+  }
+
+  memset(info, 0, sizeof(struct sim_info));
+  if (!has_interface(modem->interfaces, OFONO_API_SIM)) {
+    info->status = SIM_STATUS_ABSENT;
+    return TRUE;
+  }
+
+  props = prop_cache_lock(modem, PROP_CACHE_SIM);
+  if (props == NULL)
+    return FALSE;
+
+  ofono_sim_parse_info(props, info);
+
+  prop_cache_unlock(modem);
   return TRUE;
 }
 
@@ -362,22 +413,26 @@ static void _on_response_sim_io(GObject *obj, GAsyncResult *result,
   g_free(sir.response);
 }
 
-EXPORT_API void ofono_sim_io(struct ofono_modem *modem, struct sim_io_req *req,
+EXPORT_API ofono_request ofono_sim_io(struct ofono_modem *modem, struct sim_io_req *req,
       response_cb cb, void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
   GVariant *var;
 
   CHECK_PARAMETERS(modem && req, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
   var = g_variant_new("(yusyyys)", req->cmd, req->fid,
                 req->path ? req->path : "",
                 req->p1, req->p2, req->p3,
                 req->data ? req->data : "");
 
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_SIM_MANAGER_IFACE, "SIMIO", var,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       _on_response_sim_io, cbd);
+
+  return id;
 }
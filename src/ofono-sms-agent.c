@@ -21,6 +21,22 @@
 #include "common.h"
 #include "ofono-sms-agent.h"
 
+enum push_info_key {
+  PUSH_KEY_SENDER,
+  PUSH_KEY_LOCAL_SENT_TIME,
+  PUSH_KEY_SENT_TIME,
+};
+
+static const struct str_map push_info_key_map[] = {
+  {"Sender", PUSH_KEY_SENDER},
+  {"LocalSentTime", PUSH_KEY_LOCAL_SENT_TIME},
+  {"SentTime", PUSH_KEY_SENT_TIME},
+  {NULL, 0}
+};
+
+static struct str_table push_info_key_table =
+      STR_TABLE_INIT(push_info_key_map);
+
 struct ofono_push_noti_agent {
   struct ofono_modem *modem;
   GList *push_noti_cb_list; /* GList<struct push_noti_cb_data*> */
@@ -119,36 +135,43 @@ static void _ofono_unregister_agent_object(struct ofono_push_noti_agent *agent)
 static tapi_bool _handle_push_notification_received(GVariant *content,
       GVariant *info, void *user_data)
 {
-  char *key;
+  const char *key;
   gsize len = 0;
   GVariant *val;
-  GVariantIter *iter;
+  GVariantIter iter;
   GList *list;
   struct ofono_push_noti_info noti;
   struct push_noti_cb_data *cbd;
-  const char *ctx;
   struct ofono_push_noti_agent *agent = user_data;
 
+  /* everything points into the message, valid during the callbacks */
   memset(&noti, 0, sizeof(noti));
-  ctx = g_variant_get_fixed_array(content, &len, sizeof(gchar));
-  noti.content = g_malloc0(len);
-  memcpy(noti.content, ctx, len);
+  noti.content = (char *) g_variant_get_fixed_array(content, &len,
+        sizeof(gchar));
   noti.length = len;
 
-  g_variant_get(info, "a{sv}", &iter);
-  while (g_variant_iter_next(iter, "{sv}", &key, &val)) {
-    if (g_strcmp0(key, "Sender") == 0) {
-      g_variant_get(val, "s", &noti.sender);
-    } else if (g_strcmp0(key, "LocalSentTime") == 0) {
-      g_variant_get(val, "s", &noti.local_senttime);
-    } else if (g_strcmp0(key, "SentTime") == 0) {
-      g_variant_get(val, "s", &noti.senttime);
+  g_variant_iter_init(&iter, info);
+  while (g_variant_iter_next(&iter, "{&sv}", &key, &val)) {
+    switch (str_table_lookup(&push_info_key_table, key, -1)) {
+    case PUSH_KEY_SENDER:
+      noti.sender = (char *) g_variant_get_string(val, NULL);
+      break;
+    case PUSH_KEY_LOCAL_SENT_TIME:
+      noti.local_senttime = (char *) g_variant_get_string(val, NULL);
+      if (!time_parse_iso8601(noti.local_senttime, &noti.local_sent_time,
+            &noti.local_sent_offset))
+        tapi_warn("invalid time: %s", noti.local_senttime);
+      break;
+    case PUSH_KEY_SENT_TIME:
+      noti.senttime = (char *) g_variant_get_string(val, NULL);
+      if (!time_parse_iso8601(noti.senttime, &noti.sent_time,
+            &noti.sent_offset))
+        tapi_warn("invalid time: %s", noti.senttime);
+      break;
     }
 
-    g_free(key);
     g_variant_unref(val);
   }
-  g_variant_iter_free(iter);
 
   for (list = agent->push_noti_cb_list; list; list = g_list_next(list)) {
     cbd = (struct push_noti_cb_data*) list->data;
@@ -156,10 +179,6 @@ static tapi_bool _handle_push_notification_received(GVariant *content,
       cbd->cb(&noti, cbd->user_data);
   }
 
-  g_free(noti.content);
-  g_free(noti.local_senttime);
-  g_free(noti.sender);
-  g_free(noti.senttime);
   return TRUE;
 }
 
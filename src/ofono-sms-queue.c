@@ -0,0 +1,544 @@
+/*
+ * Copyright (C) 2013 Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include <string.h>
+#include <gio/gio.h>
+
+#include "log.h"
+#include "common.h"
+#include "ofono-sms.h"
+
+#define DEFAULT_WINDOW 4
+#define DEFAULT_MAX_RETRIES 3
+#define DEFAULT_RETRY_DELAY 500 /* ms */
+#define MAX_RETRY_DELAY 30000 /* ms */
+#define RATE_SECONDS 10
+
+/* message shared by the recipients of one ofono_sms_queue_send() */
+struct sms_batch {
+  gint refs;
+  gchar *message;
+  sms_queue_cb cb;
+  void *user_data;
+};
+
+struct sms_entry {
+  struct ofono_sms_queue *queue;
+  struct sms_batch *batch;
+  gchar *recipient;
+  unsigned int index;
+  unsigned int attempts;
+  gint64 submitted; /* last SendMessage call, monotonic */
+  gchar *uuid;
+};
+
+struct ofono_sms_queue {
+  gint refs; /* owner and in flight entries */
+  struct ofono_modem *modem; /* referenced, the entries outlive the owner */
+  GCancellable *cancellable;
+
+  GMutex lock; /* protects everything below */
+  tapi_bool closed;
+  unsigned int window;
+  unsigned int max_retries;
+  unsigned int retry_delay;
+  tapi_bool wait_delivery;
+
+  GQueue pending; /* struct sms_entry waiting for a slot */
+  unsigned int in_flight;
+  GHashTable *submitted; /* uuid -> struct sms_entry waiting for its state */
+
+  struct ofono_sms_queue_stats stats;
+  /* sent messages per second, slot second % RATE_SECONDS */
+  unsigned int rate[RATE_SECONDS];
+  gint64 rate_second; /* last second counted in rate */
+};
+
+static void _entry_send(struct sms_entry *entry);
+
+static void _batch_unref(struct sms_batch *batch)
+{
+  if (!g_atomic_int_dec_and_test(&batch->refs))
+    return;
+
+  g_free(batch->message);
+  g_free(batch);
+}
+
+static void _entry_free(gpointer data)
+{
+  struct sms_entry *entry = data;
+
+  _batch_unref(entry->batch);
+  g_free(entry->recipient);
+  g_free(entry->uuid);
+  g_free(entry);
+}
+
+static void _entry_report(struct sms_entry *entry,
+      enum ofono_sms_queue_state state, TResult result)
+{
+  struct ofono_sms_queue_report report;
+
+  report.recipient = entry->recipient;
+  report.index = entry->index;
+  report.state = state;
+  report.result = result;
+  report.uuid = entry->uuid;
+  report.attempts = entry->attempts;
+
+  entry->batch->cb(&report, entry->batch->user_data);
+}
+
+static void _queue_unref(struct ofono_sms_queue *queue)
+{
+  if (!g_atomic_int_dec_and_test(&queue->refs))
+    return;
+
+  g_hash_table_destroy(queue->submitted);
+  g_object_unref(queue->cancellable);
+  modem_unref(queue->modem);
+  g_mutex_clear(&queue->lock);
+  g_free(queue);
+}
+
+/* drops the seconds gone since the last update, lock held */
+static void _rate_advance(struct ofono_sms_queue *queue, gint64 second)
+{
+  gint64 s;
+
+  if (second - queue->rate_second >= RATE_SECONDS) {
+    memset(queue->rate, 0, sizeof(queue->rate));
+  } else {
+    for (s = queue->rate_second + 1; s <= second; s++)
+      queue->rate[s % RATE_SECONDS] = 0;
+  }
+
+  if (second > queue->rate_second)
+    queue->rate_second = second;
+}
+
+/* starts the pending entries fitting in the window */
+static void _queue_pump(struct ofono_sms_queue *queue)
+{
+  GSList *start = NULL, *l;
+  struct sms_entry *entry;
+
+  g_mutex_lock(&queue->lock);
+
+  while (!queue->closed && queue->in_flight < queue->window) {
+    entry = g_queue_pop_head(&queue->pending);
+    if (entry == NULL)
+      break;
+
+    queue->in_flight++;
+    g_atomic_int_inc(&queue->refs);
+    start = g_slist_prepend(start, entry);
+  }
+
+  g_mutex_unlock(&queue->lock);
+
+  start = g_slist_reverse(start);
+  for (l = start; l != NULL; l = l->next)
+    _entry_send(l->data);
+  g_slist_free(start);
+}
+
+/* an entry left the window, releasing its reference */
+static void _queue_slot_done(struct ofono_sms_queue *queue)
+{
+  g_mutex_lock(&queue->lock);
+  queue->in_flight--;
+  g_mutex_unlock(&queue->lock);
+
+  _queue_pump(queue);
+  _queue_unref(queue);
+}
+
+static void _queue_retry(gpointer data)
+{
+  struct sms_entry *entry = data;
+  struct ofono_sms_queue *queue = entry->queue;
+  tapi_bool closed;
+
+  g_mutex_lock(&queue->lock);
+  closed = queue->closed;
+  g_mutex_unlock(&queue->lock);
+
+  if (!closed) {
+    _entry_send(entry);
+    return;
+  }
+
+  _entry_report(entry, OFONO_SMS_QUEUE_FAILED, TAPI_RESULT_CANCELLED);
+  _entry_free(entry);
+  _queue_slot_done(queue);
+}
+
+/* runs on the thread of the connection, the retry goes where the replies do */
+static gboolean _on_retry_timeout(gpointer data)
+{
+  dispatch_post(_queue_retry, data);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void _on_queue_sent(GObject *source_object,
+      GAsyncResult *result, gpointer user_data)
+{
+  struct sms_entry *entry = user_data;
+  struct ofono_sms_queue *queue = entry->queue;
+  GVariant *dbus_result;
+  GError *error = NULL;
+  const char *path = NULL;
+  const char *uuid = NULL;
+  unsigned int delay;
+  tapi_bool closed;
+  TResult ret;
+
+  dbus_result = g_dbus_connection_call_finish(
+      G_DBUS_CONNECTION(source_object), result, &error);
+
+  ret = ofono_error_parse(error);
+  if (error != NULL)
+    g_error_free(error);
+
+  if (ret == TAPI_RESULT_OK) {
+    g_variant_get(dbus_result, "(&o)", &path);
+    uuid = sms_uuid_from_path(path);
+    if (uuid == NULL)
+      ret = TAPI_RESULT_FAIL;
+  }
+
+  g_mutex_lock(&queue->lock);
+
+  if ((ret == TAPI_RESULT_IN_PROGRESS || ret == TAPI_RESULT_TIMEOUT) &&
+      !queue->closed && entry->attempts <= queue->max_retries) {
+    /* oFono is busy, keep the slot and try again later */
+    delay = queue->retry_delay << MIN(entry->attempts - 1, 16);
+    if (delay > MAX_RETRY_DELAY)
+      delay = MAX_RETRY_DELAY;
+
+    queue->stats.retries++;
+    g_mutex_unlock(&queue->lock);
+
+    tapi_debug("retry %s in %u ms", entry->recipient, delay);
+    dispatch_timeout_add(queue->modem->conn, delay, _on_retry_timeout, entry);
+    return;
+  }
+
+  if (ret != TAPI_RESULT_OK)
+    queue->stats.failed++;
+
+  closed = queue->closed;
+  g_mutex_unlock(&queue->lock);
+
+  tapi_debug("%s: %d, uuid: %s", entry->recipient, ret, uuid);
+
+  if (ret != TAPI_RESULT_OK) {
+    _entry_report(entry, OFONO_SMS_QUEUE_FAILED, ret);
+    _entry_free(entry);
+  } else {
+    /*
+     * The state changes come on the same connection after the reply,
+     * the entry can be published after its callback.
+     */
+    entry->uuid = g_strdup(uuid);
+    if (!closed)
+      sms_tracker_add(queue->modem, uuid, entry->submitted);
+    _entry_report(entry, OFONO_SMS_QUEUE_SUBMITTED, ret);
+
+    g_mutex_lock(&queue->lock);
+    queue->stats.submitted++;
+    /* the state of an abandoned queue is no longer followed */
+    if (!queue->closed)
+      g_hash_table_insert(queue->submitted, entry->uuid, entry);
+    else
+      _entry_free(entry);
+    g_mutex_unlock(&queue->lock);
+  }
+
+  if (dbus_result != NULL)
+    g_variant_unref(dbus_result);
+
+  _queue_slot_done(queue);
+}
+
+static void _entry_send(struct sms_entry *entry)
+{
+  struct ofono_modem *modem = entry->queue->modem;
+
+  entry->attempts++;
+  entry->submitted = g_get_monotonic_time();
+
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
+      OFONO_MESSAGE_MANAGER_IFACE, "SendMessage",
+      g_variant_new("(ss)", entry->recipient, entry->batch->message),
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem),
+      entry->queue->cancellable, _on_queue_sent, entry);
+}
+
+static void _on_sms_status(enum ofono_noti noti, void *data, void *user_data)
+{
+  struct ofono_sms_sent_staus_noti *status = data;
+  struct ofono_sms_queue *queue = user_data;
+  struct sms_entry *entry;
+  enum ofono_sms_queue_state state;
+  tapi_bool last;
+
+  if (status->state == OFONO_SMS_SENT_STATE_PENDING)
+    return;
+
+  g_mutex_lock(&queue->lock);
+
+  entry = g_hash_table_lookup(queue->submitted, status->uuid);
+  if (entry == NULL) {
+    g_mutex_unlock(&queue->lock);
+    return;
+  }
+
+  if (status->state == OFONO_SMS_SENT_STATE_SENT) {
+    state = OFONO_SMS_QUEUE_SENT;
+    last = !queue->wait_delivery;
+    queue->stats.sent++;
+
+    _rate_advance(queue, g_get_monotonic_time() / G_USEC_PER_SEC);
+    queue->rate[queue->rate_second % RATE_SECONDS]++;
+  } else {
+    state = OFONO_SMS_QUEUE_FAILED;
+    last = TRUE;
+    queue->stats.failed++;
+  }
+
+  if (last)
+    g_hash_table_steal(queue->submitted, entry->uuid);
+
+  g_mutex_unlock(&queue->lock);
+
+  _entry_report(entry, state, state == OFONO_SMS_QUEUE_SENT ?
+        TAPI_RESULT_OK : TAPI_RESULT_FAIL);
+  if (last)
+    _entry_free(entry);
+}
+
+static void _on_sms_delivered(enum ofono_noti noti, void *data,
+      void *user_data)
+{
+  struct ofono_sms_status_report_noti *report = data;
+  struct ofono_sms_queue *queue = user_data;
+  struct sms_entry *entry;
+
+  if (report->uuid == NULL)
+    return;
+
+  g_mutex_lock(&queue->lock);
+
+  entry = g_hash_table_lookup(queue->submitted, report->uuid);
+  if (entry != NULL) {
+    g_hash_table_steal(queue->submitted, entry->uuid);
+    queue->stats.delivered++;
+  }
+
+  g_mutex_unlock(&queue->lock);
+
+  if (entry == NULL)
+    return;
+
+  _entry_report(entry, OFONO_SMS_QUEUE_DELIVERED, TAPI_RESULT_OK);
+  _entry_free(entry);
+}
+
+EXPORT_API struct ofono_sms_queue *ofono_sms_queue_new(
+      struct ofono_modem *modem, unsigned int window)
+{
+  struct ofono_sms_queue *queue;
+
+  if (modem == NULL) {
+    tapi_error("invalid parameter");
+    return NULL;
+  }
+
+  queue = g_new0(struct ofono_sms_queue, 1);
+  queue->refs = 1;
+  queue->modem = modem_ref(modem);
+  queue->cancellable = g_cancellable_new();
+  g_mutex_init(&queue->lock);
+  queue->window = window ? window : DEFAULT_WINDOW;
+  queue->max_retries = DEFAULT_MAX_RETRIES;
+  queue->retry_delay = DEFAULT_RETRY_DELAY;
+  g_queue_init(&queue->pending);
+  queue->submitted = g_hash_table_new_full(g_str_hash, g_str_equal,
+        NULL, _entry_free);
+
+  g_rec_mutex_lock(&modem->noti_lock);
+
+  if (modem->sms_queue != NULL) {
+    g_rec_mutex_unlock(&modem->noti_lock);
+    tapi_error("modem has a sms queue already");
+    _queue_unref(queue);
+    return NULL;
+  }
+
+  modem->sms_queue = queue;
+  ofono_register_notification_callback(modem, OFONO_NOTI_MSG_STATUS_CHANGED,
+        _on_sms_status, queue, NULL);
+  ofono_register_notification_callback(modem, OFONO_NOTI_SMS_DELIVERY_REPORT,
+        _on_sms_delivered, queue, NULL);
+
+  g_rec_mutex_unlock(&modem->noti_lock);
+
+  return queue;
+}
+
+EXPORT_API void ofono_sms_queue_free(struct ofono_sms_queue *queue)
+{
+  struct ofono_modem *modem;
+  struct sms_entry *entry;
+  GQueue pending;
+
+  if (queue == NULL)
+    return;
+
+  modem = queue->modem;
+
+  /* no notification runs once unregistered, they hold the noti lock */
+  g_rec_mutex_lock(&modem->noti_lock);
+  ofono_unregister_notification_callback(modem,
+        OFONO_NOTI_MSG_STATUS_CHANGED, _on_sms_status);
+  ofono_unregister_notification_callback(modem,
+        OFONO_NOTI_SMS_DELIVERY_REPORT, _on_sms_delivered);
+  modem->sms_queue = NULL;
+  g_rec_mutex_unlock(&modem->noti_lock);
+
+  g_mutex_lock(&queue->lock);
+  queue->closed = TRUE;
+  pending = queue->pending;
+  g_queue_init(&queue->pending);
+  g_hash_table_remove_all(queue->submitted);
+  g_mutex_unlock(&queue->lock);
+
+  /* the calls in flight complete with TAPI_RESULT_CANCELLED */
+  g_cancellable_cancel(queue->cancellable);
+
+  while ((entry = g_queue_pop_head(&pending)) != NULL) {
+    _entry_report(entry, OFONO_SMS_QUEUE_FAILED, TAPI_RESULT_CANCELLED);
+    _entry_free(entry);
+  }
+
+  _queue_unref(queue);
+}
+
+EXPORT_API void ofono_sms_queue_set_retry(struct ofono_sms_queue *queue,
+      unsigned int max_retries, unsigned int delay)
+{
+  if (queue == NULL)
+    return;
+
+  g_mutex_lock(&queue->lock);
+  queue->max_retries = max_retries;
+  queue->retry_delay = delay;
+  g_mutex_unlock(&queue->lock);
+}
+
+EXPORT_API void ofono_sms_queue_set_wait_delivery(
+      struct ofono_sms_queue *queue, tapi_bool wait)
+{
+  if (queue == NULL)
+    return;
+
+  g_mutex_lock(&queue->lock);
+  queue->wait_delivery = wait;
+  g_mutex_unlock(&queue->lock);
+}
+
+EXPORT_API tapi_bool ofono_sms_queue_send(struct ofono_sms_queue *queue,
+      const char *message, const char **recipients, unsigned int count,
+      sms_queue_cb cb, void *user_data)
+{
+  struct sms_batch *batch;
+  struct sms_entry *entry;
+  unsigned int i;
+
+  if (queue == NULL || message == NULL || recipients == NULL ||
+      count == 0 || cb == NULL) {
+    tapi_error("invalid parameter");
+    return FALSE;
+  }
+
+  for (i = 0; i < count; i++) {
+    if (recipients[i] == NULL) {
+      tapi_error("invalid parameter");
+      return FALSE;
+    }
+  }
+
+  batch = g_new0(struct sms_batch, 1);
+  batch->refs = count;
+  batch->message = g_strdup(message);
+  batch->cb = cb;
+  batch->user_data = user_data;
+
+  g_mutex_lock(&queue->lock);
+
+  if (queue->closed) {
+    g_mutex_unlock(&queue->lock);
+    g_free(batch->message);
+    g_free(batch);
+    return FALSE;
+  }
+
+  for (i = 0; i < count; i++) {
+    entry = g_new0(struct sms_entry, 1);
+    entry->queue = queue;
+    entry->batch = batch;
+    entry->recipient = g_strdup(recipients[i]);
+    entry->index = i;
+    g_queue_push_tail(&queue->pending, entry);
+  }
+
+  g_mutex_unlock(&queue->lock);
+
+  tapi_debug("%u recipients queued", count);
+
+  _queue_pump(queue);
+
+  return TRUE;
+}
+
+EXPORT_API tapi_bool ofono_sms_queue_get_stats(struct ofono_sms_queue *queue,
+      struct ofono_sms_queue_stats *stats)
+{
+  unsigned int sum = 0;
+  int i;
+
+  if (queue == NULL || stats == NULL)
+    return FALSE;
+
+  g_mutex_lock(&queue->lock);
+
+  _rate_advance(queue, g_get_monotonic_time() / G_USEC_PER_SEC);
+  for (i = 0; i < RATE_SECONDS; i++)
+    sum += queue->rate[i];
+
+  *stats = queue->stats;
+  stats->queued = g_queue_get_length(&queue->pending);
+  stats->in_flight = queue->in_flight;
+  stats->rate = (double) sum / RATE_SECONDS;
+
+  g_mutex_unlock(&queue->lock);
+
+  return TRUE;
+}
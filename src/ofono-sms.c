@@ -30,6 +30,19 @@
 #define CBS_PROPERTY_POWERED  "Powered"
 #define CBS_PROPERTY_TOPICS  "Topics"
 
+enum cbs_key {
+  CBS_KEY_POWERED,
+  CBS_KEY_TOPICS,
+};
+
+static const struct str_map cbs_key_map[] = {
+  {CBS_PROPERTY_POWERED, CBS_KEY_POWERED},
+  {CBS_PROPERTY_TOPICS, CBS_KEY_TOPICS},
+  {NULL, 0}
+};
+
+static struct str_table cbs_key_table = STR_TABLE_INIT(cbs_key_map);
+
 static void _on_response_get_sca(GObject *obj,
       GAsyncResult *result, gpointer user_data)
 {
@@ -37,55 +50,44 @@ static void _on_response_get_sca(GObject *obj,
   GVariant *resp;
   GError *error = NULL;
   struct response_cb_data *cbd = user_data;
-  char *sca = NULL;
+  const char *sca = NULL;
+  GVariant *dict;
 
-  GVariantIter *iter;
-  char *key;
-  GVariant *var_val;
-
-  resp = g_dbus_connection_call_finish(G_DBUS_CONNECTION(obj), result, &error);
+  resp = dispatch_call_finish(obj, result, &error);
 
   CHECK_RESULT(ret, error, cbd, resp);
 
-  g_variant_get(resp, "(a{sv})", &iter);
-  while (g_variant_iter_next(iter, "{sv}", &key, &var_val)) {
-    if (g_strcmp0(key, SMS_PROPERTY_SCA) == 0) {
-      g_variant_get(var_val, "s", &sca);
-
-      g_free(key);
-      g_variant_unref(var_val);
-      break;
-    }
-
-    g_free(key);
-    g_variant_unref(var_val);
-  }
+  dict = g_variant_get_child_value(resp, 0);
+  g_variant_lookup(dict, SMS_PROPERTY_SCA, "&s", &sca);
 
   tapi_debug("sca: %s", sca);
 
   CALL_RESP_CALLBACK(ret, sca, cbd);
-  g_variant_iter_free(iter);
+  g_variant_unref(dict);
   g_variant_unref(resp);
-  g_free(sca);
 }
 
-EXPORT_API void ofono_sms_get_sca(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_sms_get_sca(struct ofono_modem *modem,
       response_cb cb, void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
 
   tapi_debug("");
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call_shared(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_MESSAGE_MANAGER_IFACE, "GetProperties", NULL,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       _on_response_get_sca, cbd);
+
+  return id;
 }
 
-EXPORT_API void ofono_sms_set_sca(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_sms_set_sca(struct ofono_modem *modem,
       const char *sca, response_cb cb, void *user_data)
 {
   GVariant *var;
@@ -95,7 +97,7 @@ EXPORT_API void ofono_sms_set_sca(struct ofono_modem *modem,
   tapi_debug("sca: %s", sca);
 
   var = g_variant_new_string(sca);
-  ofono_set_property(modem, OFONO_MESSAGE_MANAGER_IFACE, modem->path,
+  return ofono_set_property(modem, OFONO_MESSAGE_MANAGER_IFACE, modem->path,
       SMS_PROPERTY_SCA, var, cb, user_data);
 }
 
@@ -106,55 +108,44 @@ static void _on_response_get_delivery_report(GObject *source_object,
   GVariant *dbus_result;
   GError *error = NULL;
   struct response_cb_data *cbd = user_data;
-  tapi_bool on;
+  tapi_bool on = FALSE;
+  GVariant *dict;
 
-  GVariantIter *iter;
-  char *key;
-  GVariant *var_val;
-
-  dbus_result = g_dbus_connection_call_finish(
-      G_DBUS_CONNECTION(source_object), result, &error);
+  dbus_result = dispatch_call_finish(source_object, result, &error);
 
   CHECK_RESULT(ret, error, cbd, dbus_result);
 
-  g_variant_get(dbus_result, "(a{sv})", &iter);
-  while (g_variant_iter_next(iter, "{sv}", &key, &var_val)) {
-    if (g_strcmp0(key, SMS_PROPERTY_UDR) == 0) {
-      g_variant_get(var_val, "b", &on);
-
-      g_free(key);
-      g_variant_unref(var_val);
-      break;
-    }
-
-    g_free(key);
-    g_variant_unref(var_val);
-  }
+  dict = g_variant_get_child_value(dbus_result, 0);
+  g_variant_lookup(dict, SMS_PROPERTY_UDR, "b", &on);
 
   tapi_debug("Delivery report: %d", on);
 
   CALL_RESP_CALLBACK(ret, &on, cbd);
-  g_variant_iter_free(iter);
+  g_variant_unref(dict);
   g_variant_unref(dbus_result);
 }
 
-EXPORT_API void ofono_sms_get_delivery_report(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_sms_get_delivery_report(struct ofono_modem *modem,
       response_cb cb, void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
 
   tapi_debug("");
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call_shared(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_MESSAGE_MANAGER_IFACE, "GetProperties", NULL,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       _on_response_get_delivery_report, cbd);
+
+  return id;
 }
 
-EXPORT_API void ofono_sms_set_delivery_report(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_sms_set_delivery_report(struct ofono_modem *modem,
       tapi_bool on, response_cb cb, void *user_data)
 {
   GVariant *var;
@@ -163,19 +154,58 @@ EXPORT_API void ofono_sms_set_delivery_report(struct ofono_modem *modem,
   tapi_debug("Delivery report: %d", on);
 
   var = g_variant_new_boolean(on);
-  ofono_set_property(modem, OFONO_MESSAGE_MANAGER_IFACE, modem->path,
+  return ofono_set_property(modem, OFONO_MESSAGE_MANAGER_IFACE, modem->path,
       SMS_PROPERTY_UDR, var, cb, user_data);
 }
 
+const char *sms_uuid_from_path(const char *path)
+{
+  const char *uuid;
+
+  uuid = strstr(path, "message_");
+  if (uuid == NULL) {
+    tapi_error("Invalid UUID in path");
+    return NULL;
+  }
+
+  return uuid + strlen("message_");
+}
+
+/* submission time of a message, for the tracker */
+struct sms_send_data {
+  struct response_cb_data *cbd;
+  struct ofono_modem *modem;
+  gint64 submitted;
+};
+
+static struct sms_send_data *_sms_send_data_new(struct ofono_modem *modem,
+      struct response_cb_data *cbd)
+{
+  struct sms_send_data *sd;
+
+  sd = g_new(struct sms_send_data, 1);
+  sd->cbd = cbd;
+  sd->modem = modem;
+  sd->submitted = g_get_monotonic_time();
+
+  return sd;
+}
+
 static void _on_response_send_sms(GObject *source_object,
     GAsyncResult *result, gpointer user_data)
 {
   TResult ret;
   GVariant *dbus_result;
   GError *error = NULL;
-  struct response_cb_data *cbd = user_data;
+  struct sms_send_data *sd = user_data;
+  struct response_cb_data *cbd = sd->cbd;
+  struct ofono_modem *modem = sd->modem;
+  gint64 submitted = sd->submitted;
+  const char *uuid;
   char *path = NULL;
 
+  g_free(sd);
+
   dbus_result = g_dbus_connection_call_finish(
       G_DBUS_CONNECTION(source_object), result, &error);
 
@@ -185,66 +215,83 @@ static void _on_response_send_sms(GObject *source_object,
 
   tapi_debug("path: %s", path);
 
+  /* before the callback, which may set the message context */
+  uuid = sms_uuid_from_path(path);
+  if (uuid != NULL)
+    sms_tracker_add(modem, uuid, submitted);
+
   CALL_RESP_CALLBACK(ret, path, cbd);
   g_variant_unref(dbus_result);
   g_free(path);
 }
 
-EXPORT_API void ofono_sms_send_sms(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_sms_send_sms(struct ofono_modem *modem,
       const char *number, const char *msg,
       response_cb cb, void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
   GVariant *var;
 
   CHECK_PARAMETERS(modem && number && msg, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
   tapi_debug("Number: %s, Content: %s", number, msg);
 
   var = g_variant_new("(ss)", number, msg);
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_MESSAGE_MANAGER_IFACE, "SendMessage", var,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
-      _on_response_send_sms, cbd);
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
+      _on_response_send_sms, _sms_send_data_new(modem, cbd));
+
+  return id;
 }
 
-EXPORT_API void ofono_sms_send_vcard(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_sms_send_vcard(struct ofono_modem *modem,
       const char *number, const unsigned char *msg,
       response_cb cb, void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
   GVariant *var;
 
   tapi_debug("");
 
   CHECK_PARAMETERS(modem && number && msg, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
   var = g_variant_new("(s^ay)", number, msg);
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_SMART_MESSAGE_IFACE, "SendBusinessCard", var,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
-      _on_response_send_sms, cbd);
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
+      _on_response_send_sms, _sms_send_data_new(modem, cbd));
+
+  return id;
 }
 
-EXPORT_API void ofono_sms_send_vcalendar(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_sms_send_vcalendar(struct ofono_modem *modem,
       const char *number, const unsigned char *msg,
       response_cb cb, void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
   GVariant *var;
 
   tapi_debug("");
 
   CHECK_PARAMETERS(modem && number && msg, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
   var = g_variant_new("(s^ay)", number, msg);
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_SMART_MESSAGE_IFACE, "SendAppointment", var,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
-      _on_response_send_sms, cbd);
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
+      _on_response_send_sms, _sms_send_data_new(modem, cbd));
+
+  return id;
 }
 
 static void _on_response_get_cbs_config(GObject *source_object,
@@ -256,52 +303,60 @@ static void _on_response_get_cbs_config(GObject *source_object,
   struct response_cb_data *cbd = user_data;
   struct ofono_sms_cbs_config config;
 
-  GVariantIter *iter;
-  char *key;
-  GVariant *var_val;
+  GVariantIter iter;
+  const char *key;
+  GVariant *var_val, *props;
 
-  dbus_result = g_dbus_connection_call_finish(
-      G_DBUS_CONNECTION(source_object), result, &error);
+  dbus_result = dispatch_call_finish(source_object, result, &error);
 
   CHECK_RESULT(ret, error, cbd, dbus_result);
 
-  g_variant_get(dbus_result, "(a{sv})", &iter);
-  while (g_variant_iter_next(iter, "{sv}", &key, &var_val)) {
-    if (g_strcmp0(key, CBS_PROPERTY_TOPICS) == 0) {
-      g_variant_get(var_val, "s", &config.topics);
-    } else if (g_strcmp0(key, CBS_PROPERTY_POWERED) == 0) {
+  memset(&config, 0, sizeof(config));
+
+  /* the topics point into the reply, valid during the callback */
+  props = g_variant_get_child_value(dbus_result, 0);
+  g_variant_iter_init(&iter, props);
+  while (g_variant_iter_next(&iter, "{&sv}", &key, &var_val)) {
+    switch (str_table_lookup(&cbs_key_table, key, -1)) {
+    case CBS_KEY_TOPICS:
+      config.topics = (char *) g_variant_get_string(var_val, NULL);
+      break;
+    case CBS_KEY_POWERED:
       g_variant_get(var_val, "b", &config.powered);
+      break;
     }
 
-    g_free(key);
     g_variant_unref(var_val);
   }
 
   tapi_debug("topics: %s, powered: %d", config.topics, config.powered);
 
   CALL_RESP_CALLBACK(ret, &config, cbd);
-  g_variant_iter_free(iter);
+  g_variant_unref(props);
   g_variant_unref(dbus_result);
-  g_free(config.topics);
 }
 
-EXPORT_API void ofono_sms_get_cbs_config(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_sms_get_cbs_config(struct ofono_modem *modem,
       response_cb cb, void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
 
   tapi_debug("");
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call_shared(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_CELL_BROADCAST_IFACE, "GetProperties", NULL,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       _on_response_get_cbs_config, cbd);
+
+  return id;
 }
 
-EXPORT_API void ofono_sms_set_cbs_powered(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_sms_set_cbs_powered(struct ofono_modem *modem,
       tapi_bool powered, response_cb cb, void *user_data)
 {
   GVariant *var;
@@ -310,11 +365,11 @@ EXPORT_API void ofono_sms_set_cbs_powered(struct ofono_modem *modem,
   CHECK_PARAMETERS(modem, cb, user_data);
 
   var = g_variant_new_boolean(powered);
-  ofono_set_property(modem, OFONO_CELL_BROADCAST_IFACE, modem->path,
+  return ofono_set_property(modem, OFONO_CELL_BROADCAST_IFACE, modem->path,
       CBS_PROPERTY_POWERED, var, cb, user_data);
 }
 
-EXPORT_API void ofono_sms_set_cbs_topics(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_sms_set_cbs_topics(struct ofono_modem *modem,
       const char *topics, response_cb cb, void *user_data)
 {
   GVariant *var;
@@ -323,6 +378,6 @@ EXPORT_API void ofono_sms_set_cbs_topics(struct ofono_modem *modem,
   CHECK_PARAMETERS(modem && topics, cb, user_data);
 
   var = g_variant_new_string(topics);
-  ofono_set_property(modem, OFONO_CELL_BROADCAST_IFACE, modem->path,
+  return ofono_set_property(modem, OFONO_CELL_BROADCAST_IFACE, modem->path,
       CBS_PROPERTY_TOPICS, var, cb, user_data);
 }
@@ -58,23 +58,98 @@ static const char *_condition_to_str(enum call_forward_condition cond)
   }
 }
 
-static enum cli_status _str_to_cli_status(char *status)
+static const struct str_map cli_status_map[] = {
+  {"enabled", SS_CLI_STATUS_ENABLED},
+  {"disabled", SS_CLI_STATUS_DISABLED},
+  {NULL, 0}
+};
+
+static struct str_table cli_status_table = STR_TABLE_INIT(cli_status_map);
+
+static enum cli_status _str_to_cli_status(const char *status)
 {
+  int val;
+
   if (status == NULL) {
     tapi_warn("");
     return SS_CLI_STATUS_UNKNOWN;
   }
 
-  if (g_strcmp0(status, "enabled") == 0)
-    return SS_CLI_STATUS_ENABLED;
-
-  if (g_strcmp0(status, "disabled") == 0)
-    return SS_CLI_STATUS_DISABLED;
+  val = str_table_lookup(&cli_status_table, status, -1);
+  if (val < 0) {
+    tapi_warn("cli status is unknown: %s", status);
+    return SS_CLI_STATUS_UNKNOWN;
+  }
 
-  tapi_warn("cli status is unknown: %s", status);
-  return SS_CLI_STATUS_UNKNOWN;
+  return val;
 }
 
+/* "VoiceNoReplyTimeout" isn't a condition, it belongs to the CFNRY setting */
+#define CF_KEY_NO_REPLY_TIMEOUT (SS_CF_CONDITION_CFNRC + 1)
+
+static const struct str_map cf_key_map[] = {
+  {"VoiceUnconditional", SS_CF_CONDITION_CFU},
+  {"VoiceBusy", SS_CF_CONDITION_CFB},
+  {"VoiceNotReachable", SS_CF_CONDITION_CFNRC},
+  {"VoiceNoReply", SS_CF_CONDITION_CFNRY},
+  {"VoiceNoReplyTimeout", CF_KEY_NO_REPLY_TIMEOUT},
+  {NULL, 0}
+};
+
+static struct str_table cf_key_table = STR_TABLE_INIT(cf_key_map);
+
+static const struct str_map cb_incoming_map[] = {
+  {"always", SS_CB_TYPE_BAIC},
+  {"whenroaming", SS_CB_TYPE_BIC_ROAM},
+  {NULL, 0}
+};
+
+static struct str_table cb_incoming_table = STR_TABLE_INIT(cb_incoming_map);
+
+static const struct str_map cb_outgoing_map[] = {
+  {"all", SS_CB_TYPE_BAOC},
+  {"international", SS_CB_TYPE_BOIC},
+  {"internationalnothome", SS_CB_TYPE_BOIC_NOT_HC},
+  {NULL, 0}
+};
+
+static struct str_table cb_outgoing_table = STR_TABLE_INIT(cb_outgoing_map);
+
+enum cb_key {
+  CB_KEY_INCOMING,
+  CB_KEY_OUTGOING,
+};
+
+static const struct str_map cb_key_map[] = {
+  {"VoiceIncoming", CB_KEY_INCOMING},
+  {"VoiceOutgoing", CB_KEY_OUTGOING},
+  {NULL, 0}
+};
+
+static struct str_table cb_key_table = STR_TABLE_INIT(cb_key_map);
+
+static const struct str_map cli_key_map[] = {
+  {"CallingLinePresentation", SS_CLI_CLIP},
+  {"CalledLinePresentation", SS_CLI_CDIP},
+  {"CallingNamePresentation", SS_CLI_CNAP},
+  {"ConnectedLinePresentation", SS_CLI_COLP},
+  {"ConnectedLineRestriction", SS_CLI_COLR},
+  {NULL, 0}
+};
+
+static struct str_table cli_key_table = STR_TABLE_INIT(cli_key_map);
+
+static const struct str_map clir_status_map[] = {
+  {"disabled", SS_CLIR_NW_STATUS_DISABLED},
+  {"permanent", SS_CLIR_NW_STATUS_PERMANENT},
+  {"unknown", SS_CLIR_NW_STATUS_UNKOWN},
+  {"on", SS_CLIR_NW_STATUS_ON},
+  {"off", SS_CLIR_NW_STATUS_OFF},
+  {NULL, 0}
+};
+
+static struct str_table clir_status_table = STR_TABLE_INIT(clir_status_map);
+
 static void _on_response_get_call_waiting(GObject *source_object,
     GAsyncResult *result, void *user_data)
 {
@@ -84,72 +159,60 @@ static void _on_response_get_call_waiting(GObject *source_object,
   struct response_cb_data *cbd = user_data;
   tapi_bool status;
 
-  GVariantIter *iter;
-  char *key;
-  GVariant *var_val;
-  char *str_status = NULL;
+  GVariant *dict;
+  const char *str_status = NULL;
 
-  dbus_result = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source_object),
-      result, &error);
+  dbus_result = dispatch_call_finish(source_object, result, &error);
 
   CHECK_RESULT(ret, error, cbd, dbus_result);
 
-  g_variant_get(dbus_result, "(a{sv})", &iter);
-  while (g_variant_iter_next(iter, "{sv}", &key, &var_val)) {
-    if (g_strcmp0(key, "VoiceCallWaiting") == 0) {
-      g_variant_get(var_val, "s", &str_status);
-      tapi_debug("VoiceCallWaiting: %s", str_status);
+  dict = g_variant_get_child_value(dbus_result, 0);
+  g_variant_lookup(dict, "VoiceCallWaiting", "&s", &str_status);
+  tapi_debug("VoiceCallWaiting: %s", str_status);
 
-      g_free(key);
-      g_variant_unref(var_val);
-      break;
-    }
-
-    g_free(key);
-    g_variant_unref(var_val);
-  }
-
-  if (str_status == NULL) {
-    CALL_RESP_CALLBACK(TAPI_RESULT_FAIL, NULL, cbd);
-    goto done;
-  }
-
-  if (g_strcmp0(str_status, "disabled") == 0)
+  switch (str_table_lookup(&cli_status_table, str_status, -1)) {
+  case SS_CLI_STATUS_DISABLED:
     status = FALSE;
-  else if(g_strcmp0(str_status, "enabled") == 0)
+    CALL_RESP_CALLBACK(ret, &status, cbd);
+    break;
+  case SS_CLI_STATUS_ENABLED:
     status = TRUE;
-  else {
+    CALL_RESP_CALLBACK(ret, &status, cbd);
+    break;
+  default:
     CALL_RESP_CALLBACK(TAPI_RESULT_FAIL, NULL, cbd);
-    goto done;
+    break;
   }
 
-  CALL_RESP_CALLBACK(ret, &status, cbd);
-done:
-  g_variant_iter_free(iter);
+  g_variant_unref(dict);
   g_variant_unref(dbus_result);
-  g_free(str_status);
 }
 
-EXPORT_API void ofono_ss_get_call_waiting(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_ss_get_call_waiting(struct ofono_modem *modem,
       response_cb cb, void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
 
   tapi_debug("");
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call_shared(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_CALL_SETTINGS_IFACE, "GetProperties", NULL,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       _on_response_get_call_waiting, cbd);
+
+  return id;
 }
 
-EXPORT_API void ofono_ss_set_call_waiting(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_ss_set_call_waiting(struct ofono_modem *modem,
       tapi_bool enable, response_cb cb, void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
   GVariant *var;
   const char *str;
 
@@ -157,6 +220,7 @@ EXPORT_API void ofono_ss_set_call_waiting(struct ofono_modem *modem,
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
   if(enable)
     str = "enabled";
@@ -165,112 +229,95 @@ EXPORT_API void ofono_ss_set_call_waiting(struct ofono_modem *modem,
 
   var = g_variant_new("(sv)", "VoiceCallWaiting", g_variant_new_string(str));
 
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_CALL_SETTINGS_IFACE, "SetProperty", var,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       on_response_common, cbd);
+
+  return id;
 }
 
-static void _on_response_get_call_forwarding(GObject *source_object,
-    GAsyncResult *result, void * user_data)
+void ofono_ss_parse_call_forward(GVariant *props,
+      struct call_forward_setting *settings)
 {
-  TResult ret;
-  GVariant *dbus_result;
-  GError *error = NULL;
-  struct response_cb_data *cbd = user_data;
-  struct call_forward_setting settings[SS_CF_CONDITION_CFNRC + 1];
   struct call_forward_setting *ps = NULL;
-
-  GVariantIter *iter;
-  char *key;
+  GVariantIter iter;
+  const char *key;
   GVariant *var_val;
-  char *number = NULL;
+  const char *number;
+  int cond;
 
-  memset(settings, 0, sizeof(settings));
-  dbus_result = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source_object),
-      result, &error);
+  memset(settings, 0, sizeof(*settings) * (SS_CF_CONDITION_CFNRC + 1));
 
-  CHECK_RESULT(ret, error, cbd, dbus_result);
+  g_variant_iter_init(&iter, props);
+  while (g_variant_iter_loop(&iter, "{&sv}", &key, &var_val)) {
+    cond = str_table_lookup(&cf_key_table, key, -1);
+    if (cond < 0)
+      continue;
 
-  g_variant_get(dbus_result, "(a{sv})", &iter);
-  while (g_variant_iter_next(iter, "{sv}", &key, &var_val)) {
-    number = NULL;
-    if (g_strcmp0(key, "VoiceUnconditional") == 0) {
-      ps = settings + SS_CF_CONDITION_CFU;
-      g_variant_get(var_val, "s", &number);
-      ps->condition = SS_CF_CONDITION_CFU;
-      if (number != NULL && strlen(number) > 0) {
-        ps->enable = TRUE;
-        g_strlcpy(ps->num, number, CALL_DIGIT_LEN_MAX);
-      } else {
-        ps->enable = FALSE;
-      }
-    } else if (g_strcmp0(key, "VoiceBusy") == 0) {
-      ps = settings + SS_CF_CONDITION_CFB;
-      g_variant_get(var_val, "s", &number);
-      ps->condition = SS_CF_CONDITION_CFB;
-      if (number != NULL && strlen(number) > 0) {
-        ps->enable = TRUE;
-        g_strlcpy(ps->num, number, CALL_DIGIT_LEN_MAX);
-      } else {
-        ps->enable = FALSE;
-      }
-    } else if (g_strcmp0(key, "VoiceNotReachable") == 0) {
-      ps = settings + SS_CF_CONDITION_CFNRC;
-      g_variant_get(var_val, "s", &number);
-      ps->condition = SS_CF_CONDITION_CFNRC;
-      if (number != NULL && strlen(number) > 0) {
-        ps->enable = TRUE;
-        g_strlcpy(ps->num, number, CALL_DIGIT_LEN_MAX);
-      } else {
-        ps->enable = FALSE;
-      }
-    } else if (g_strcmp0(key, "VoiceNoReply") == 0) {
+    if (cond == CF_KEY_NO_REPLY_TIMEOUT) {
+      unsigned short timeout;
       ps = settings + SS_CF_CONDITION_CFNRY;
-      g_variant_get(var_val, "s", &number);
-      ps->condition = SS_CF_CONDITION_CFNRY;
+      g_variant_get(var_val, "q", &timeout);
+      ps->timeout = (unsigned char)timeout;
+    } else {
+      ps = settings + cond;
+      number = g_variant_get_string(var_val, NULL);
+      ps->condition = cond;
       if (number != NULL && strlen(number) > 0) {
         ps->enable = TRUE;
         g_strlcpy(ps->num, number, CALL_DIGIT_LEN_MAX);
       } else {
         ps->enable = FALSE;
       }
-    }  else if (g_strcmp0(key, "VoiceNoReplyTimeout") == 0) {
-      unsigned short timeout;
-      ps = settings + SS_CF_CONDITION_CFNRY;
-      g_variant_get(var_val, "q", &timeout);
-      ps->timeout = (unsigned char)timeout;
     }
 
-    if (ps)
-      tapi_debug("%s(%d): %s %d %d", key, ps->condition, ps->num, ps->enable,
-          ps->timeout);
-
-    g_free(number);
-    g_free(key);
-    g_variant_unref(var_val);
+    tapi_debug("%s(%d): %s %d %d", key, ps->condition, ps->num, ps->enable,
+        ps->timeout);
   }
+}
+
+static void _on_response_get_call_forwarding(GObject *source_object,
+    GAsyncResult *result, void * user_data)
+{
+  TResult ret;
+  GVariant *dbus_result;
+  GVariant *props;
+  GError *error = NULL;
+  struct response_cb_data *cbd = user_data;
+  struct call_forward_setting settings[SS_CF_CONDITION_CFNRC + 1];
+
+  dbus_result = dispatch_call_finish(source_object, result, &error);
+
+  CHECK_RESULT(ret, error, cbd, dbus_result);
+
+  props = g_variant_get_child_value(dbus_result, 0);
+  ofono_ss_parse_call_forward(props, settings);
 
   CALL_RESP_CALLBACK(ret, settings, cbd);
-  g_variant_iter_free(iter);
+  g_variant_unref(props);
   g_variant_unref(dbus_result);
 }
 
-EXPORT_API void ofono_ss_get_call_forward(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_ss_get_call_forward(struct ofono_modem *modem,
       response_cb cb,
       void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
 
   tapi_debug("");
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call_shared(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_CALL_FORWARDING_IFACE, "GetProperties", NULL,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       _on_response_get_call_forwarding, cbd);
+
+  return id;
 }
 
 static void _on_response_set_call_forward_noreply(GObject *source_object,
@@ -296,7 +343,7 @@ static void _on_response_set_call_forward_noreply(GObject *source_object,
     if (cbd->cb != NULL)
       cbd->cb(ret, NULL, cbd->user_data);
 
-    g_free(cbd);
+    request_free(cbd);
     g_free(icbd);
     return;
   }
@@ -304,20 +351,22 @@ static void _on_response_set_call_forward_noreply(GObject *source_object,
   /* set no reply timeout */
   var = g_variant_new("(sv)", "VoiceNoReplyTimeout", g_variant_new("q", timeout));
 
-  g_dbus_connection_call(icbd->modem->conn, OFONO_SERVICE,
+  dispatch_call(icbd->modem->conn, OFONO_SERVICE,
         icbd->modem->path,
         OFONO_CALL_FORWARDING_IFACE, "SetProperty", var,
-        NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+        NULL, G_DBUS_CALL_FLAGS_NONE,
+        request_timeout(icbd->modem), icbd->cbd->cancellable,
         on_response_common, icbd->cbd);
   g_free(icbd);
 }
 
-EXPORT_API void ofono_ss_set_call_forward(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_ss_set_call_forward(struct ofono_modem *modem,
       struct call_forward_setting *setting,
       response_cb cb,
       void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
   GVariant *var;
   struct interm_response_cb_data *icbd;
   unsigned char *timeout;
@@ -326,25 +375,29 @@ EXPORT_API void ofono_ss_set_call_forward(struct ofono_modem *modem,
 
   CHECK_PARAMETERS(modem && _check_call_forwarding_setting(setting), cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
   var = g_variant_new("(sv)", _condition_to_str(setting->condition),
       g_variant_new_string(setting->num));
 
   if (setting->condition != SS_CF_CONDITION_CFNRY || !setting->enable) {
-    g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+    dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_CALL_FORWARDING_IFACE, "SetProperty", var,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       on_response_common, cbd);
-    return;
+    return id;
   }
 
   timeout = g_memdup(&setting->timeout, sizeof(setting->timeout));
   NEW_INTERM_RSP_CB_DATA(icbd, cbd, modem, timeout);
 
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_CALL_FORWARDING_IFACE, "SetProperty", var,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE,
+      request_timeout(modem), cbd->cancellable,
       _on_response_set_call_forward_noreply, icbd);
+
+  return id;
 }
 
 static void _on_response_get_call_barring(GObject *source_object,
@@ -357,43 +410,31 @@ static void _on_response_get_call_barring(GObject *source_object,
   struct call_barring_setting setting;
 
   GVariantIter *iter;
-  char *key;
+  const char *key;
   GVariant *var_val;
-  char *type;
+  const char *type;
 
-  dbus_result = g_dbus_connection_call_finish(
-      G_DBUS_CONNECTION(source_object), result, &error);
+  dbus_result = dispatch_call_finish(source_object, result, &error);
 
   CHECK_RESULT(ret, error, cbd, dbus_result);
 
   g_variant_get(dbus_result, "(a{sv})", &iter);
-  while (g_variant_iter_next(iter, "{sv}", &key, &var_val)) {
+  while (g_variant_iter_loop(iter, "{&sv}", &key, &var_val)) {
     type = NULL;
-    if (g_strcmp0(key, "VoiceIncoming") == 0) {
-      g_variant_get(var_val, "s", &type);
-      if (g_strcmp0(type, "always") == 0)
-        setting.incoming = SS_CB_TYPE_BAIC;
-      else if (g_strcmp0(type, "whenroaming") == 0)
-        setting.incoming = SS_CB_TYPE_BIC_ROAM;
-      else
-        setting.incoming = SS_CB_TYPE_NONE;
-    } else if (g_strcmp0(key, "VoiceOutgoing") == 0) {
-      g_variant_get(var_val, "s", &type);
-      if (g_strcmp0(type, "all") == 0)
-        setting.outgoing = SS_CB_TYPE_BAOC;
-      else if (g_strcmp0(type, "international") == 0)
-        setting.outgoing = SS_CB_TYPE_BOIC;
-      else if (g_strcmp0(type, "internationalnothome") == 0)
-        setting.outgoing = SS_CB_TYPE_BOIC_NOT_HC;
-      else
-        setting.outgoing = SS_CB_TYPE_NONE;
+    switch (str_table_lookup(&cb_key_table, key, -1)) {
+    case CB_KEY_INCOMING:
+      type = g_variant_get_string(var_val, NULL);
+      setting.incoming = str_table_lookup(&cb_incoming_table, type,
+            SS_CB_TYPE_NONE);
+      break;
+    case CB_KEY_OUTGOING:
+      type = g_variant_get_string(var_val, NULL);
+      setting.outgoing = str_table_lookup(&cb_outgoing_table, type,
+            SS_CB_TYPE_NONE);
+      break;
     }
 
     tapi_debug("%s: %s", key, type);
-
-    g_free(type);
-    g_free(key);
-    g_variant_unref(var_val);
   }
 
   CALL_RESP_CALLBACK(ret, &setting, cbd);
@@ -401,24 +442,28 @@ static void _on_response_get_call_barring(GObject *source_object,
   g_variant_unref(dbus_result);
 }
 
-EXPORT_API void ofono_ss_get_call_barring(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_ss_get_call_barring(struct ofono_modem *modem,
       response_cb cb,
       void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
 
   tapi_debug("");
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call_shared(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_CALL_BARRING_IFACE, "GetProperties", NULL,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       _on_response_get_call_barring, cbd);
+
+  return id;
 }
 
-EXPORT_API void ofono_ss_set_call_barring(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_ss_set_call_barring(struct ofono_modem *modem,
       tapi_bool enable,
       enum call_barring_type type,
       const char *pwd,
@@ -426,6 +471,7 @@ EXPORT_API void ofono_ss_set_call_barring(struct ofono_modem *modem,
       void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
   GVariant *var;
   const char *method = NULL;
   const char *prop;
@@ -487,32 +533,39 @@ EXPORT_API void ofono_ss_set_call_barring(struct ofono_modem *modem,
   }
 
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_CALL_SETTINGS_IFACE, method, var,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       on_response_common, cbd);
+
+  return id;
 }
 
-EXPORT_API void ofono_ss_change_barring_password(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_ss_change_barring_password(struct ofono_modem *modem,
       const char *old_pwd,
       const char *new_pwd,
       response_cb cb,
       void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
   GVariant *var;
 
   tapi_debug("");
 
   CHECK_PARAMETERS(modem && old_pwd && new_pwd, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
   var = g_variant_new("(ss)", old_pwd, new_pwd);
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_CALL_BARRING_IFACE, "ChangePassword", var,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       on_response_common, cbd);
+
+  return id;
 }
 
 static void _on_response_get_cli_status(GObject *source_object,
@@ -525,44 +578,25 @@ static void _on_response_get_cli_status(GObject *source_object,
   enum cli_status status[5];
 
   GVariantIter *iter;
-  char *key;
+  const char *key;
   GVariant *var_val;
-  char *val;
+  const char *val;
+  int cli;
 
   memset(status, 0, sizeof(status));
-  dbus_result = g_dbus_connection_call_finish(
-      G_DBUS_CONNECTION(source_object), result, &error);
+  dbus_result = dispatch_call_finish(source_object, result, &error);
 
   CHECK_RESULT(ret, error, cbd, dbus_result);
 
   g_variant_get(dbus_result, "(a{sv})", &iter);
-  while (g_variant_iter_next(iter, "{sv}", &key, &var_val)) {
-    val = NULL;
-    if (g_strcmp0(key, "CallingLinePresentation") == 0) {
-      g_variant_get(var_val, "s", &val);
-      status[SS_CLI_CLIP] = _str_to_cli_status(val);
-      tapi_debug("%s: %s", key, val);
-    } else if (g_strcmp0(key, "CalledLinePresentation") == 0) {
-      g_variant_get(var_val, "s", &val);
-      status[SS_CLI_CDIP] = _str_to_cli_status(val);
-      tapi_debug("%s: %s", key, val);
-    } else if (g_strcmp0(key, "CallingNamePresentation") == 0) {
-      g_variant_get(var_val, "s", &val);
-      status[SS_CLI_CNAP] = _str_to_cli_status(val);
-      tapi_debug("%s: %s", key, val);
-    } else if (g_strcmp0(key, "ConnectedLinePresentation") == 0) {
-      g_variant_get(var_val, "s", &val);
-      status[SS_CLI_COLP] = _str_to_cli_status(val);
-      tapi_debug("%s: %s", key, val);
-    }  else if (g_strcmp0(key, "ConnectedLineRestriction") == 0) {
-      g_variant_get(var_val, "s", &val);
-      status[SS_CLI_COLR] = _str_to_cli_status(val);
-      tapi_debug("%s: %s", key, val);
-    }
-
-    g_free(val);
-    g_free(key);
-    g_variant_unref(var_val);
+  while (g_variant_iter_loop(iter, "{&sv}", &key, &var_val)) {
+    cli = str_table_lookup(&cli_key_table, key, -1);
+    if (cli < 0)
+      continue;
+
+    val = g_variant_get_string(var_val, NULL);
+    status[cli] = _str_to_cli_status(val);
+    tapi_debug("%s: %s", key, val);
   }
 
   CALL_RESP_CALLBACK(ret, status, cbd);
@@ -570,20 +604,24 @@ static void _on_response_get_cli_status(GObject *source_object,
   g_variant_unref(dbus_result);
 }
 
-EXPORT_API void ofono_ss_get_cli_status(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_ss_get_cli_status(struct ofono_modem *modem,
       response_cb cb, void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
 
   tapi_debug("");
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call_shared(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_CALL_SETTINGS_IFACE, "GetProperties", NULL,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       _on_response_get_cli_status, cbd);
+
+  return id;
 }
 
 static void _on_response_get_clir(GObject *source_object,
@@ -595,71 +633,51 @@ static void _on_response_get_clir(GObject *source_object,
   struct response_cb_data *cbd = user_data;
   enum clir_network_status status;
 
-  GVariantIter *iter;
-  char *key;
-  GVariant *var_val;
-  char *val;
+  GVariant *dict;
+  const char *val = NULL;
 
-  dbus_result = g_dbus_connection_call_finish(
-      G_DBUS_CONNECTION(source_object), result, &error);
+  dbus_result = dispatch_call_finish(source_object, result, &error);
 
   CHECK_RESULT(ret, error, cbd, dbus_result);
 
-  g_variant_get(dbus_result, "(a{sv})", &iter);
-  while (g_variant_iter_next(iter, "{sv}", &key, &var_val)) {
-    val = NULL;
-    if (g_strcmp0(key, "CallingLineRestriction") == 0) {
-      g_variant_get(var_val, "s", &val);
-      if (g_strcmp0(val, "disabled") == 0)
-        status = SS_CLIR_NW_STATUS_DISABLED;
-      else if (g_strcmp0(val, "permanent") == 0)
-        status = SS_CLIR_NW_STATUS_PERMANENT;
-      else if (g_strcmp0(val, "unknown") == 0)
-        status = SS_CLIR_NW_STATUS_UNKOWN;
-      else if (g_strcmp0(val, "on") == 0)
-        status = SS_CLIR_NW_STATUS_ON;
-      else if (g_strcmp0(val, "off") == 0)
-        status = SS_CLIR_NW_STATUS_OFF;
-
-      tapi_debug("%s: %s", key, val);
-
-      g_free(val);
-      g_free(key);
-      g_variant_unref(var_val);
-      break;
-    }
-
-    g_free(key);
-    g_variant_unref(var_val);
-  }
+  dict = g_variant_get_child_value(dbus_result, 0);
+  g_variant_lookup(dict, "CallingLineRestriction", "&s", &val);
+  status = str_table_lookup(&clir_status_table, val,
+        SS_CLIR_NW_STATUS_UNKOWN);
+  tapi_debug("CallingLineRestriction: %s", val);
 
   CALL_RESP_CALLBACK(ret, &status, cbd);
-  g_variant_iter_free(iter);
+  g_variant_unref(dict);
   g_variant_unref(dbus_result);
 }
 
-EXPORT_API void ofono_ss_get_clir(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_ss_get_clir(struct ofono_modem *modem,
       response_cb cb,
       void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
 
   tapi_debug("");
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call_shared(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_CALL_SETTINGS_IFACE, "GetProperties", NULL,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       _on_response_get_clir, cbd);
+
+  return id;
 }
 
-EXPORT_API void ofono_ss_set_clir(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_ss_set_clir(struct ofono_modem *modem,
       enum clir_dev_status status, response_cb cb,
       void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
   GVariant *var;
   const char *str;
 
@@ -667,6 +685,7 @@ EXPORT_API void ofono_ss_set_clir(struct ofono_modem *modem,
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
   switch (status) {
   case SS_CLIR_DEV_STATUS_DEFAULT:
@@ -684,10 +703,12 @@ EXPORT_API void ofono_ss_set_clir(struct ofono_modem *modem,
 
   var = g_variant_new("(sv)", "HideCallerId", g_variant_new_string(str));
 
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_CALL_SETTINGS_IFACE, "SetProperty", var,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       on_response_common, cbd);
+
+  return id;
 }
 
 static void _on_response_initiate_ussd_request(GObject *source_object,
@@ -697,44 +718,48 @@ static void _on_response_initiate_ussd_request(GObject *source_object,
   GVariant *dbus_result;
   GError *error = NULL;
   struct response_cb_data *cbd = user_data;
-  char *req_type;
+  const char *req_type;
   GVariant *var_data;
-  char *rsp = NULL;
+  const char *rsp = NULL;
 
   dbus_result = g_dbus_connection_call_finish(
       G_DBUS_CONNECTION(source_object), result, &error);
 
   CHECK_RESULT(ret, error, cbd, dbus_result);
 
-  g_variant_get(dbus_result, "(sv)", &req_type, &var_data);
+  /* the response points into the reply, valid during the callback */
+  g_variant_get(dbus_result, "(&sv)", &req_type, &var_data);
   if (g_strcmp0(req_type, "USSD") == 0)
-    g_variant_get(var_data, "s", &rsp);
+    g_variant_get(var_data, "&s", &rsp);
   else
     tapi_warn("Not ussd request");
 
   CALL_RESP_CALLBACK(ret, rsp, cbd);
   g_variant_unref(dbus_result);
   g_variant_unref(var_data);
-  g_free(rsp);
 }
 
-EXPORT_API void ofono_ss_initiate_ussd_request(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_ss_initiate_ussd_request(struct ofono_modem *modem,
       char *str, response_cb cb, void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
   GVariant *var = NULL;
 
   tapi_debug("");
 
   CHECK_PARAMETERS(modem && str, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
   //#TODO: forbid MMI string here
   var = g_variant_new("(s)", str);
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_SUPPLEMENTARY_SERVICES_IFACE, "Initiate", var,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       _on_response_initiate_ussd_request, cbd);
+
+  return id;
 }
 
 static void _on_response_send_ussd_response(GObject *source_object,
@@ -751,39 +776,46 @@ static void _on_response_send_ussd_response(GObject *source_object,
 
   CHECK_RESULT(ret, error, cbd, dbus_result);
 
-  g_variant_get(dbus_result, "(s)", &rsp);
+  g_variant_get(dbus_result, "(&s)", &rsp);
 
   CALL_RESP_CALLBACK(ret, &rsp, cbd);
   g_variant_unref(dbus_result);
-  g_free(rsp);
 }
 
-EXPORT_API void ofono_ss_send_ussd_response(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_ss_send_ussd_response(struct ofono_modem *modem,
       char *str, response_cb cb, void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
   GVariant *var;
 
   CHECK_PARAMETERS(modem && str, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
   var = g_variant_new("(s)", str);
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_SUPPLEMENTARY_SERVICES_IFACE, "Respond", var,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       _on_response_send_ussd_response, cbd);
+
+  return id;
 }
 
-EXPORT_API void ofono_ss_cancel_ussd_session(struct ofono_modem *modem,
+EXPORT_API ofono_request ofono_ss_cancel_ussd_session(struct ofono_modem *modem,
       response_cb cb, void *user_data)
 {
   struct response_cb_data *cbd;
+  ofono_request id;
 
   CHECK_PARAMETERS(modem, cb, user_data);
   NEW_RSP_CB_DATA(cbd, cb, user_data);
+  id = cbd->id;
 
-  g_dbus_connection_call(modem->conn, OFONO_SERVICE, modem->path,
+  dispatch_call(modem->conn, OFONO_SERVICE, modem->path,
       OFONO_SUPPLEMENTARY_SERVICES_IFACE, "Cancel", NULL,
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+      NULL, G_DBUS_CALL_FLAGS_NONE, request_timeout(modem), cbd->cancellable,
       on_response_common, cbd);
+
+  return id;
 }
@@ -0,0 +1,514 @@
+/*
+ * Copyright (C) 2013 Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include <string.h>
+
+#include "common.h"
+#include "log.h"
+
+/*
+ * One D-Bus subscription (match rule) per connection, interface and member,
+ * shared by every modem and notification. Watches hang off it, indexed by
+ * object path, and are demultiplexed here.
+ *
+ * When the modems are sharded over several connections, a connection only
+ * asks the bus for the signals of the objects it serves: the subscriptions
+ * add no match rule and one rule per watched path namespace is added
+ * instead.
+ */
+struct signal_match {
+  GDBusConnection *conn;
+  gchar *key; /* key in s_matches */
+  gchar *iface;
+  gchar *member;
+  guint subscription;
+  GHashTable *paths; /* object path -> GSList of struct signal_watch */
+  guint refs; /* number of watches */
+};
+
+/* bus match rule of a sharded connection, shared by the watches of a path */
+struct signal_rule {
+  GDBusConnection *conn;
+  gchar *key; /* key in s_rules */
+  gchar *rule;
+  guint refs;
+};
+
+struct signal_watch {
+  guint id;
+  struct signal_match *match;
+  struct signal_rule *rule; /* NULL unless sharded */
+  gchar *path;
+  tapi_bool path_prefix; /* also match the objects below path */
+  gchar *arg0;
+  GDBusSignalCallback callback;
+  gpointer user_data;
+  GBoxedCopyFunc ref; /* NULL if "user_data" outlives the watch */
+  GDestroyNotify unref;
+};
+
+static GMutex s_signal_lock;
+static GHashTable *s_matches; /* key -> struct signal_match */
+static GHashTable *s_watches; /* watch id -> struct signal_watch */
+static GHashTable *s_rules; /* key -> struct signal_rule */
+static guint s_last_watch_id;
+
+/*
+ * Per signal scratch space, on the stack: the heap is only used past
+ * SIGNAL_STACK_IDS matching watches or a SIGNAL_STACK_PATH long path.
+ */
+#define SIGNAL_STACK_IDS 16
+#define SIGNAL_STACK_PATH 128
+
+struct signal_delivery {
+  GVariant *parameters;
+  GVariant *first; /* first argument, extracted on demand */
+  const gchar *arg0; /* NULL unless the first argument is a string */
+  tapi_bool arg0_done;
+
+  guint *ids;
+  guint len;
+  guint size;
+  guint stack_ids[SIGNAL_STACK_IDS];
+};
+
+static const gchar *_signal_arg0(struct signal_delivery *d)
+{
+  if (d->arg0_done)
+    return d->arg0;
+
+  d->arg0_done = TRUE;
+  if (g_variant_n_children(d->parameters) > 0) {
+    d->first = g_variant_get_child_value(d->parameters, 0);
+    if (g_variant_is_of_type(d->first, G_VARIANT_TYPE_STRING))
+      d->arg0 = g_variant_get_string(d->first, NULL);
+  }
+
+  return d->arg0;
+}
+
+static void _signal_add_id(struct signal_delivery *d, guint id)
+{
+  if (d->len == d->size) {
+    d->size *= 2;
+    if (d->ids == d->stack_ids) {
+      d->ids = g_new(guint, d->size);
+      memcpy(d->ids, d->stack_ids, sizeof(d->stack_ids));
+    } else
+      d->ids = g_renew(guint, d->ids, d->size);
+  }
+
+  d->ids[d->len++] = id;
+}
+
+/* must be called with the signal lock held */
+static void _signal_collect(struct signal_match *match, const gchar *path,
+      tapi_bool ancestor, struct signal_delivery *d)
+{
+  GSList *list;
+
+  list = g_hash_table_lookup(match->paths, path);
+  for (; list; list = g_slist_next(list)) {
+    struct signal_watch *watch = list->data;
+
+    if (ancestor && !watch->path_prefix)
+      continue;
+
+    if (watch->arg0 != NULL && g_strcmp0(watch->arg0, _signal_arg0(d)) != 0)
+      continue;
+
+    _signal_add_id(d, watch->id);
+  }
+}
+
+struct signal_event {
+  GDBusConnection *conn;
+  gchar *key;
+  gchar *sender_name;
+  gchar *object_path;
+  gchar *iface;
+  gchar *signal_name;
+  GVariant *parameters;
+};
+
+static void _signal_deliver(GDBusConnection *conn, const gchar *key,
+     const gchar *sender_name,
+     const gchar *object_path, const gchar *iface,
+     const gchar *signal_name, GVariant *parameters)
+{
+  struct signal_match *match;
+  struct signal_delivery d;
+  gchar stack_path[SIGNAL_STACK_PATH];
+  gchar *path, *sep;
+  gsize path_len;
+  guint i;
+
+  d.parameters = parameters;
+  d.first = NULL;
+  d.arg0 = NULL;
+  d.arg0_done = FALSE;
+  d.ids = d.stack_ids;
+  d.len = 0;
+  d.size = SIGNAL_STACK_IDS;
+
+  path_len = strlen(object_path);
+  if (path_len < sizeof(stack_path))
+    path = memcpy(stack_path, object_path, path_len + 1);
+  else
+    path = g_strdup(object_path);
+
+  g_mutex_lock(&s_signal_lock);
+
+  /* the match may be gone, or replaced, since the signal was queued */
+  match = s_matches ? g_hash_table_lookup(s_matches, key) : NULL;
+  if (match != NULL) {
+    /* exact path first, then each ancestor for the prefix watches */
+    _signal_collect(match, path, FALSE, &d);
+    while ((sep = strrchr(path, '/')) != NULL && path[1] != '\0') {
+      if (sep == path)
+        sep++;
+      *sep = '\0';
+      _signal_collect(match, path, TRUE, &d);
+    }
+  }
+
+  g_mutex_unlock(&s_signal_lock);
+
+  /*
+   * Callbacks may remove watches, look each one up again before calling.
+   * The watch can also be removed by another thread while its callback
+   * runs, hence the reference on the user data.
+   */
+  for (i = 0; i < d.len; i++) {
+    struct signal_watch *watch;
+    GDBusSignalCallback callback = NULL;
+    GDestroyNotify unref = NULL;
+    gpointer data = NULL;
+
+    g_mutex_lock(&s_signal_lock);
+    watch = g_hash_table_lookup(s_watches, GUINT_TO_POINTER(d.ids[i]));
+    if (watch != NULL) {
+      callback = watch->callback;
+      data = watch->user_data;
+      if (watch->ref != NULL)
+        data = watch->ref(data);
+      unref = watch->unref;
+    }
+    g_mutex_unlock(&s_signal_lock);
+
+    if (callback != NULL)
+      callback(conn, sender_name, object_path, iface, signal_name,
+            parameters, data);
+    if (unref != NULL)
+      unref(data);
+  }
+
+  if (path != stack_path)
+    g_free(path);
+  if (d.ids != d.stack_ids)
+    g_free(d.ids);
+  if (d.first != NULL)
+    g_variant_unref(d.first);
+}
+
+static void _signal_event_run(gpointer data)
+{
+  struct signal_event *ev = data;
+
+  _signal_deliver(ev->conn, ev->key, ev->sender_name, ev->object_path,
+        ev->iface, ev->signal_name, ev->parameters);
+
+  g_object_unref(ev->conn);
+  g_free(ev->key);
+  g_free(ev->sender_name);
+  g_free(ev->object_path);
+  g_free(ev->iface);
+  g_free(ev->signal_name);
+  g_variant_unref(ev->parameters);
+  g_free(ev);
+}
+
+static void _signal_dispatch(GDBusConnection *conn,
+     const gchar *sender_name,
+     const gchar *object_path, const gchar *iface,
+     const gchar *signal_name, GVariant *parameters,
+     gpointer user_data)
+{
+  struct signal_event *ev;
+
+  if (!dispatch_deferred()) {
+    _signal_deliver(conn, user_data, sender_name, object_path, iface,
+          signal_name, parameters);
+    return;
+  }
+
+  ev = g_new(struct signal_event, 1);
+  ev->conn = g_object_ref(conn);
+  ev->key = g_strdup(user_data);
+  ev->sender_name = g_strdup(sender_name);
+  ev->object_path = g_strdup(object_path);
+  ev->iface = g_strdup(iface);
+  ev->signal_name = g_strdup(signal_name);
+  ev->parameters = g_variant_ref(parameters);
+
+  dispatch_post(_signal_event_run, ev);
+}
+
+/* runs on the dispatch thread, the match may be gone already */
+static void _signal_match_subscribe(gpointer data)
+{
+  gchar *key = data;
+  struct signal_match *match;
+
+  g_mutex_lock(&s_signal_lock);
+
+  match = s_matches ? g_hash_table_lookup(s_matches, key) : NULL;
+  if (match != NULL && match->subscription == 0) {
+    match->subscription = g_dbus_connection_signal_subscribe(match->conn,
+          OFONO_SERVICE,
+          match->iface,
+          match->member,
+          NULL,
+          NULL,
+          dispatch_sharded() ? G_DBUS_SIGNAL_FLAGS_NO_MATCH_RULE :
+                G_DBUS_SIGNAL_FLAGS_NONE,
+          _signal_dispatch,
+          g_strdup(key),
+          g_free);
+
+    tapi_debug("subscribed %s.%s", match->iface, match->member);
+  }
+
+  g_mutex_unlock(&s_signal_lock);
+
+  g_free(key);
+}
+
+static void _signal_match_free(struct signal_match *match)
+{
+  if (match->subscription != 0)
+    g_dbus_connection_signal_unsubscribe(match->conn, match->subscription);
+  g_hash_table_remove(s_matches, match->key);
+
+  g_hash_table_destroy(match->paths);
+  g_free(match->key);
+  g_free(match->iface);
+  g_free(match->member);
+  g_free(match);
+}
+
+/*
+ * Must be called with the signal lock held. A new match is not subscribed
+ * yet, *created is set and the caller schedules _signal_match_subscribe().
+ */
+static struct signal_match *_signal_match_ref(GDBusConnection *conn,
+      const char *iface, const char *member, tapi_bool *created)
+{
+  struct signal_match *match;
+  gchar *key;
+
+  key = g_strdup_printf("%p %s.%s", conn, iface, member);
+
+  match = g_hash_table_lookup(s_matches, key);
+  if (match != NULL) {
+    g_free(key);
+    match->refs++;
+    *created = FALSE;
+    return match;
+  }
+
+  match = g_new0(struct signal_match, 1);
+
+  match->conn = conn;
+  match->key = key;
+  match->iface = g_strdup(iface);
+  match->member = g_strdup(member);
+  match->paths = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+  match->refs = 1;
+
+  g_hash_table_insert(s_matches, match->key, match);
+  *created = TRUE;
+
+  return match;
+}
+
+/* must be called with the signal lock held */
+static struct signal_rule *_signal_rule_ref(GDBusConnection *conn,
+      const char *iface, const char *member, const char *path,
+      tapi_bool *created)
+{
+  struct signal_rule *rule;
+  gchar *text, *key;
+
+  text = g_strdup_printf("type='signal',sender='%s',interface='%s',"
+        "member='%s',path_namespace='%s'", OFONO_SERVICE, iface, member, path);
+  key = g_strdup_printf("%p %s", conn, text);
+
+  rule = g_hash_table_lookup(s_rules, key);
+  if (rule != NULL) {
+    g_free(text);
+    g_free(key);
+    rule->refs++;
+    *created = FALSE;
+    return rule;
+  }
+
+  rule = g_new0(struct signal_rule, 1);
+  rule->conn = conn;
+  rule->key = key;
+  rule->rule = text;
+  rule->refs = 1;
+
+  g_hash_table_insert(s_rules, rule->key, rule);
+  *created = TRUE;
+
+  return rule;
+}
+
+static void _signal_rule_send(struct signal_rule *rule, const char *method)
+{
+  dispatch_call(rule->conn, "org.freedesktop.DBus", "/org/freedesktop/DBus",
+        "org.freedesktop.DBus", method, g_variant_new("(s)", rule->rule),
+        NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL, NULL, NULL);
+}
+
+guint signal_watch_add(GDBusConnection *conn, const char *iface,
+      const char *member, const char *path, tapi_bool path_prefix,
+      const char *arg0, GDBusSignalCallback callback, gpointer user_data)
+{
+  return signal_watch_add_full(conn, iface, member, path, path_prefix, arg0,
+        callback, user_data, NULL, NULL);
+}
+
+guint signal_watch_add_full(GDBusConnection *conn, const char *iface,
+      const char *member, const char *path, tapi_bool path_prefix,
+      const char *arg0, GDBusSignalCallback callback, gpointer user_data,
+      GBoxedCopyFunc ref, GDestroyNotify unref)
+{
+  struct signal_watch *watch;
+  gchar *subscribe = NULL;
+  tapi_bool match_created, rule_created;
+  guint id;
+  GSList *list;
+
+  if (conn == NULL || iface == NULL || member == NULL || path == NULL ||
+      callback == NULL) {
+    tapi_error("invalid parameter");
+    return 0;
+  }
+
+  g_mutex_lock(&s_signal_lock);
+
+  if (s_matches == NULL) {
+    s_matches = g_hash_table_new(g_str_hash, g_str_equal);
+    s_watches = g_hash_table_new(g_direct_hash, g_direct_equal);
+    s_rules = g_hash_table_new(g_str_hash, g_str_equal);
+  }
+
+  watch = g_new0(struct signal_watch, 1);
+
+  /* 0 means failure to the callers */
+  if (++s_last_watch_id == 0)
+    s_last_watch_id++;
+
+  watch->id = s_last_watch_id;
+  watch->match = _signal_match_ref(conn, iface, member, &match_created);
+  watch->path = g_strdup(path);
+  watch->path_prefix = path_prefix;
+  watch->arg0 = g_strdup(arg0);
+  watch->callback = callback;
+  watch->user_data = user_data;
+  watch->ref = ref;
+  watch->unref = unref;
+
+  /* sent under the lock, to keep AddMatch and RemoveMatch in order */
+  if (dispatch_sharded()) {
+    watch->rule = _signal_rule_ref(conn, iface, member, path,
+          &rule_created);
+    if (rule_created)
+      _signal_rule_send(watch->rule, "AddMatch");
+  }
+
+  list = g_hash_table_lookup(watch->match->paths, path);
+  list = g_slist_append(list, watch);
+  g_hash_table_insert(watch->match->paths, g_strdup(path), list);
+
+  g_hash_table_insert(s_watches, GUINT_TO_POINTER(watch->id), watch);
+
+  if (match_created)
+    subscribe = g_strdup(watch->match->key);
+  id = watch->id;
+
+  g_mutex_unlock(&s_signal_lock);
+
+  /* subscriptions belong to the dispatch thread context, when there is one */
+  if (subscribe != NULL)
+    dispatch_run(conn, _signal_match_subscribe, subscribe);
+
+  return id;
+}
+
+void signal_watch_remove(guint id)
+{
+  struct signal_watch *watch;
+  struct signal_match *match;
+  struct signal_rule *rule = NULL;
+  GSList *list;
+
+  if (id == 0)
+    return;
+
+  g_mutex_lock(&s_signal_lock);
+
+  watch = s_watches ? g_hash_table_lookup(s_watches, GUINT_TO_POINTER(id)) :
+        NULL;
+  if (watch == NULL) {
+    g_mutex_unlock(&s_signal_lock);
+    tapi_warn("unknown signal watch %u", id);
+    return;
+  }
+
+  g_hash_table_remove(s_watches, GUINT_TO_POINTER(id));
+
+  match = watch->match;
+  list = g_hash_table_lookup(match->paths, watch->path);
+  list = g_slist_remove(list, watch);
+  if (list == NULL)
+    g_hash_table_remove(match->paths, watch->path);
+  else
+    g_hash_table_insert(match->paths, g_strdup(watch->path), list);
+
+  if (--match->refs == 0)
+    _signal_match_free(match);
+
+  if (watch->rule != NULL && --watch->rule->refs == 0) {
+    rule = watch->rule;
+    g_hash_table_remove(s_rules, rule->key);
+    _signal_rule_send(rule, "RemoveMatch");
+  }
+
+  g_mutex_unlock(&s_signal_lock);
+
+  if (rule != NULL) {
+    g_free(rule->key);
+    g_free(rule->rule);
+    g_free(rule);
+  }
+
+  g_free(watch->path);
+  g_free(watch->arg0);
+  g_free(watch);
+}
@@ -0,0 +1,441 @@
+/*
+ * Copyright (C) 2013 Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include <string.h>
+
+#include "common.h"
+#include "log.h"
+#include "ofono-sms.h"
+
+#define DEFAULT_MAX_ENTRIES 1024
+#define DEFAULT_EXPIRY 3600 /* s */
+
+/*
+ * Log-linear latency buckets: exact below 4 ms, then 4 buckets per power
+ * of two, so a percentile is off by at most a quarter of its value.
+ */
+#define LATENCY_SUB_BITS 2
+#define LATENCY_SUBS (1 << LATENCY_SUB_BITS)
+#define LATENCY_BUCKETS ((32 - LATENCY_SUB_BITS + 1) * LATENCY_SUBS)
+
+struct latency_histogram {
+  guint32 buckets[LATENCY_BUCKETS];
+  guint32 count;
+  guint32 max; /* ms */
+};
+
+struct sms_track {
+  GList link; /* in sms_tracker.order, data is the track */
+  gchar *uuid;
+  gint64 submitted; /* monotonic us */
+  gint64 accepted; /* SendMessage returned, 0 until then */
+  gint64 sent;
+  gint64 delivered;
+  enum ofono_sms_sent_state state;
+  void *context;
+  destroy_notify context_free;
+};
+
+struct sms_tracker {
+  GHashTable *tracks; /* uuid -> struct sms_track */
+  GQueue order; /* oldest submission first */
+  unsigned int max_entries;
+  gint64 expiry; /* us */
+  struct latency_histogram latency[OFONO_SMS_LATENCY_MAX];
+};
+
+static unsigned int _latency_bucket(guint32 ms)
+{
+  unsigned int e;
+
+  if (ms < LATENCY_SUBS)
+    return ms;
+
+  e = g_bit_storage(ms) - 1;
+  return (e - LATENCY_SUB_BITS + 1) * LATENCY_SUBS +
+        ((ms >> (e - LATENCY_SUB_BITS)) & (LATENCY_SUBS - 1));
+}
+
+/* largest latency falling in "bucket" */
+static guint32 _latency_bucket_max(unsigned int bucket)
+{
+  unsigned int e, sub;
+
+  if (bucket < LATENCY_SUBS)
+    return bucket;
+
+  e = bucket / LATENCY_SUBS + LATENCY_SUB_BITS - 1;
+  sub = bucket % LATENCY_SUBS;
+
+  return (guint32) ((1ULL << e) + ((guint64) (sub + 1) << (e - LATENCY_SUB_BITS)) - 1);
+}
+
+static void _latency_add(struct sms_tracker *tracker,
+      enum ofono_sms_latency which, gint64 from, gint64 to)
+{
+  struct latency_histogram *h = &tracker->latency[which];
+  guint32 ms;
+
+  if (from == 0 || to < from)
+    return;
+
+  ms = (guint32) MIN((to - from) / 1000, G_MAXUINT32);
+
+  h->buckets[_latency_bucket(ms)]++;
+  h->count++;
+  if (ms > h->max)
+    h->max = ms;
+}
+
+static guint32 _latency_percentile(const struct latency_histogram *h,
+      unsigned int percent)
+{
+  guint64 rank, seen = 0;
+  unsigned int i;
+
+  if (h->count == 0)
+    return 0;
+
+  rank = ((guint64) h->count * percent + 99) / 100;
+
+  for (i = 0; i < LATENCY_BUCKETS; i++) {
+    seen += h->buckets[i];
+    if (seen >= rank)
+      return MIN(_latency_bucket_max(i), h->max);
+  }
+
+  return h->max;
+}
+
+static void _track_free(struct sms_track *track)
+{
+  if (track->context_free != NULL)
+    track->context_free(track->context);
+
+  g_free(track->uuid);
+  g_free(track);
+}
+
+static void _tracks_free(GSList *tracks)
+{
+  g_slist_free_full(tracks, (GDestroyNotify) _track_free);
+}
+
+/* unlinks "track", sms_lock held, the caller frees it once unlocked */
+static void _track_remove(struct sms_tracker *tracker, struct sms_track *track)
+{
+  g_hash_table_remove(tracker->tracks, track->uuid);
+  g_queue_unlink(&tracker->order, &track->link);
+}
+
+/*
+ * Drops the expired tracks and, if "room" is TRUE, the oldest ones above
+ * the budget minus one. Returns what the caller must free once unlocked.
+ */
+static GSList *_tracker_trim(struct sms_tracker *tracker, tapi_bool room)
+{
+  GSList *dropped = NULL;
+  struct sms_track *track;
+  gint64 oldest;
+  unsigned int max;
+
+  oldest = g_get_monotonic_time() - tracker->expiry;
+  max = room ? tracker->max_entries - 1 : tracker->max_entries;
+
+  while (tracker->order.head != NULL) {
+    track = tracker->order.head->data;
+    if (track->submitted >= oldest && tracker->order.length <= max)
+      break;
+
+    _track_remove(tracker, track);
+    dropped = g_slist_prepend(dropped, track);
+  }
+
+  return dropped;
+}
+
+static struct sms_track *_track_find(struct ofono_modem *modem,
+      const char *uuid)
+{
+  if (modem->sms_tracker == NULL || uuid == NULL)
+    return NULL;
+
+  return g_hash_table_lookup(modem->sms_tracker->tracks, uuid);
+}
+
+void sms_tracker_init(struct ofono_modem *modem)
+{
+  g_mutex_init(&modem->sms_lock);
+}
+
+static void _tracker_free(struct sms_tracker *tracker)
+{
+  GList *l, *next;
+
+  g_hash_table_destroy(tracker->tracks);
+
+  for (l = tracker->order.head; l != NULL; l = next) {
+    next = l->next;
+    _track_free(l->data);
+  }
+
+  g_free(tracker);
+}
+
+void sms_tracker_deinit(struct ofono_modem *modem)
+{
+  if (modem->sms_tracker != NULL)
+    _tracker_free(modem->sms_tracker);
+
+  g_mutex_clear(&modem->sms_lock);
+}
+
+void sms_tracker_add(struct ofono_modem *modem, const char *uuid,
+      gint64 submitted)
+{
+  struct sms_tracker *tracker;
+  struct sms_track *track;
+  GSList *dropped = NULL;
+
+  g_mutex_lock(&modem->sms_lock);
+
+  tracker = modem->sms_tracker;
+  if (tracker == NULL || g_hash_table_contains(tracker->tracks, uuid)) {
+    g_mutex_unlock(&modem->sms_lock);
+    return;
+  }
+
+  dropped = _tracker_trim(tracker, TRUE);
+
+  track = g_new0(struct sms_track, 1);
+  track->link.data = track;
+  track->uuid = g_strdup(uuid);
+  track->submitted = submitted;
+  track->accepted = g_get_monotonic_time();
+  track->state = OFONO_SMS_SENT_STATE_PENDING;
+
+  g_hash_table_insert(tracker->tracks, track->uuid, track);
+  g_queue_push_tail_link(&tracker->order, &track->link);
+
+  _latency_add(tracker, OFONO_SMS_LATENCY_ACCEPTED,
+        track->submitted, track->accepted);
+
+  g_mutex_unlock(&modem->sms_lock);
+
+  _tracks_free(dropped);
+}
+
+void sms_tracker_state(struct ofono_modem *modem, const char *uuid,
+      enum ofono_sms_sent_state state)
+{
+  struct sms_track *track;
+
+  g_mutex_lock(&modem->sms_lock);
+
+  track = _track_find(modem, uuid);
+  if (track != NULL && track->state == OFONO_SMS_SENT_STATE_PENDING) {
+    track->state = state;
+
+    if (state == OFONO_SMS_SENT_STATE_SENT) {
+      track->sent = g_get_monotonic_time();
+      _latency_add(modem->sms_tracker, OFONO_SMS_LATENCY_SENT,
+            track->accepted, track->sent);
+    }
+  }
+
+  g_mutex_unlock(&modem->sms_lock);
+}
+
+void sms_tracker_delivered(struct ofono_modem *modem, const char *uuid)
+{
+  struct sms_track *track;
+
+  g_mutex_lock(&modem->sms_lock);
+
+  track = _track_find(modem, uuid);
+  if (track != NULL && track->delivered == 0) {
+    track->delivered = g_get_monotonic_time();
+    _latency_add(modem->sms_tracker, OFONO_SMS_LATENCY_DELIVERED,
+          track->sent, track->delivered);
+    _latency_add(modem->sms_tracker, OFONO_SMS_LATENCY_TOTAL,
+          track->submitted, track->delivered);
+  }
+
+  g_mutex_unlock(&modem->sms_lock);
+}
+
+/* keeps the message signals subscribed, the handlers feed the tracker */
+static void _on_tracked_noti(enum ofono_noti noti, void *data,
+      void *user_data)
+{
+}
+
+EXPORT_API tapi_bool ofono_sms_tracker_enable(struct ofono_modem *modem,
+      unsigned int max_entries, unsigned int expiry)
+{
+  struct sms_tracker *tracker;
+
+  if (modem == NULL) {
+    tapi_error("invalid parameter");
+    return FALSE;
+  }
+
+  g_mutex_lock(&modem->sms_lock);
+
+  tracker = modem->sms_tracker;
+  if (tracker == NULL) {
+    tracker = g_new0(struct sms_tracker, 1);
+    tracker->tracks = g_hash_table_new(g_str_hash, g_str_equal);
+    g_queue_init(&tracker->order);
+    modem->sms_tracker = tracker;
+  }
+
+  tracker->max_entries = max_entries ? max_entries : DEFAULT_MAX_ENTRIES;
+  tracker->expiry = (gint64) (expiry ? expiry : DEFAULT_EXPIRY) *
+        G_USEC_PER_SEC;
+
+  g_mutex_unlock(&modem->sms_lock);
+
+  if (!ofono_register_notification_callback(modem,
+        OFONO_NOTI_MSG_STATUS_CHANGED, _on_tracked_noti, NULL, NULL) ||
+      !ofono_register_notification_callback(modem,
+        OFONO_NOTI_SMS_DELIVERY_REPORT, _on_tracked_noti, NULL, NULL)) {
+    ofono_sms_tracker_disable(modem);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+EXPORT_API void ofono_sms_tracker_disable(struct ofono_modem *modem)
+{
+  struct sms_tracker *tracker;
+
+  if (modem == NULL)
+    return;
+
+  ofono_unregister_notification_callback(modem,
+        OFONO_NOTI_MSG_STATUS_CHANGED, _on_tracked_noti);
+  ofono_unregister_notification_callback(modem,
+        OFONO_NOTI_SMS_DELIVERY_REPORT, _on_tracked_noti);
+
+  g_mutex_lock(&modem->sms_lock);
+  tracker = modem->sms_tracker;
+  modem->sms_tracker = NULL;
+  g_mutex_unlock(&modem->sms_lock);
+
+  if (tracker != NULL)
+    _tracker_free(tracker);
+}
+
+EXPORT_API tapi_bool ofono_sms_tracker_set_context(struct ofono_modem *modem,
+      const char *uuid, void *context, destroy_notify context_free)
+{
+  struct sms_track *track;
+  void *old_context = NULL;
+  destroy_notify old_free = NULL;
+
+  if (modem == NULL || uuid == NULL) {
+    tapi_error("invalid parameter");
+    return FALSE;
+  }
+
+  g_mutex_lock(&modem->sms_lock);
+
+  track = _track_find(modem, uuid);
+  if (track != NULL) {
+    old_context = track->context;
+    old_free = track->context_free;
+    track->context = context;
+    track->context_free = context_free;
+  }
+
+  g_mutex_unlock(&modem->sms_lock);
+
+  if (old_free != NULL)
+    old_free(old_context);
+
+  return track != NULL;
+}
+
+static int _since_submit(const struct sms_track *track, gint64 time)
+{
+  if (time == 0)
+    return -1;
+
+  return (int) MIN((time - track->submitted) / 1000, G_MAXINT);
+}
+
+EXPORT_API tapi_bool ofono_sms_tracker_lookup(struct ofono_modem *modem,
+      const char *uuid, struct ofono_sms_track_info *info)
+{
+  struct sms_track *track;
+  GSList *dropped;
+
+  if (modem == NULL || uuid == NULL || info == NULL) {
+    tapi_error("invalid parameter");
+    return FALSE;
+  }
+
+  g_mutex_lock(&modem->sms_lock);
+
+  dropped = modem->sms_tracker ?
+        _tracker_trim(modem->sms_tracker, FALSE) : NULL;
+
+  track = _track_find(modem, uuid);
+  if (track != NULL) {
+    info->context = track->context;
+    info->state = track->state;
+    info->delivered = track->delivered != 0;
+    info->accepted_ms = _since_submit(track, track->accepted);
+    info->sent_ms = _since_submit(track, track->sent);
+    info->delivered_ms = _since_submit(track, track->delivered);
+  }
+
+  g_mutex_unlock(&modem->sms_lock);
+
+  _tracks_free(dropped);
+
+  return track != NULL;
+}
+
+EXPORT_API tapi_bool ofono_sms_tracker_get_latency(struct ofono_modem *modem,
+      enum ofono_sms_latency which, struct ofono_sms_latency_stats *stats)
+{
+  const struct latency_histogram *h;
+
+  if (modem == NULL || stats == NULL ||
+      (unsigned int) which >= OFONO_SMS_LATENCY_MAX)
+    return FALSE;
+
+  g_mutex_lock(&modem->sms_lock);
+
+  if (modem->sms_tracker == NULL) {
+    g_mutex_unlock(&modem->sms_lock);
+    return FALSE;
+  }
+
+  h = &modem->sms_tracker->latency[which];
+  stats->count = h->count;
+  stats->p50 = _latency_percentile(h, 50);
+  stats->p90 = _latency_percentile(h, 90);
+  stats->p99 = _latency_percentile(h, 99);
+  stats->max = h->max;
+
+  g_mutex_unlock(&modem->sms_lock);
+
+  return TRUE;
+}
@@ -26,6 +26,7 @@ static void test_reg_notfication_callback();
 static void test_un_notfication_callback();
 static void test_has_interface();
 static void test_deinit();
+static void test_get_shared_call_stats();
 
 struct menu_info common_menu[] = {
   {"ofono_init", (menu_cb)ofono_init, main_menu, NULL},
@@ -36,6 +37,7 @@ struct menu_info common_menu[] = {
   {"ofono_unregister_notification_callback", test_un_notfication_callback, main_menu, NULL},
   {"ofono_has_interface", test_has_interface, main_menu, NULL},
   {"ofono_deinit", test_deinit, main_menu, NULL},
+  {"ofono_get_shared_call_stats", test_get_shared_call_stats, main_menu, NULL},
   {NULL, NULL, NULL, NULL}
 };
 
@@ -88,7 +90,7 @@ static void test_reg_notfication_callback()
 
   if (noti == 0) {
     int i = 0;
-    while (i <= OFONO_NOTI_SAT_MAIN_MENU) {
+    while (i < OFONO_NOTI_MAX) {
       ofono_register_notification_callback(g_modem, i, common_noti_cb,
             NULL, NULL);
       i++;
@@ -115,7 +117,7 @@ static void test_un_notfication_callback()
 
   if (noti == 0) {
     int i = 0;
-    while (i <= OFONO_NOTI_SAT_MAIN_MENU) {
+    while (i < OFONO_NOTI_MAX) {
       ofono_unregister_notification_callback(g_modem, i, common_noti_cb);
       i++;
     }
@@ -149,3 +151,11 @@ static void test_deinit()
   ofono_deinit();
   g_modem = NULL;
 }
+
+static void test_get_shared_call_stats()
+{
+  struct ofono_shared_call_stats stats;
+
+  if (ofono_get_shared_call_stats(&stats))
+    printf("calls: %lu, saved: %lu\n", stats.calls, stats.saved);
+}
@@ -0,0 +1,902 @@
+/*
+ * Copyright (C) 2013 Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Minimal stand-in for ofonod, for testing and benchmarking libofono
+ * without a modem. It owns "org.ofono" on the system bus given by
+ * DBUS_SYSTEM_BUS_ADDRESS (see run-mock.sh) and is driven by commands
+ * read from stdin, one per line:
+ *
+ *   latency <ms>            delay every method reply
+ *   add-modem               export one more modem, emits ModemAdded
+ *   remove-modem <path>     emits ModemRemoved
+ *   strength <0-100>        NetworkRegistration "Strength" of every modem
+ *   burst strength <n>      n Strength PropertyChanged per modem
+ *   burst sms <n>           n IncomingMessage per modem
+ *   incoming-call <number>  CallAdded on every modem
+ *   quit
+ *
+ * "ready" is printed on stdout once the name is owned.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <gio/gio.h>
+
+#define OFONO_SERVICE "org.ofono"
+#define OFONO_MANAGER_IFACE "org.ofono.Manager"
+#define OFONO_MODEM_IFACE "org.ofono.Modem"
+#define OFONO_SIM_MANAGER_IFACE "org.ofono.SimManager"
+#define OFONO_NETWORK_REGISTRATION_IFACE "org.ofono.NetworkRegistration"
+#define OFONO_VOICECALL_MANAGER_IFACE "org.ofono.VoiceCallManager"
+#define OFONO_VOICECALL_IFACE "org.ofono.VoiceCall"
+#define OFONO_MESSAGE_MANAGER_IFACE "org.ofono.MessageManager"
+#define OFONO_CONNMAN_IFACE "org.ofono.ConnectionManager"
+#define OFONO_CONTEXT_IFACE "org.ofono.ConnectionContext"
+#define OFONO_NETMON_INTERFACE "org.ofono.NetworkMonitor"
+
+#define PROPS_METHODS \
+  "<method name='GetProperties'>" \
+  "  <arg type='a{sv}' direction='out'/>" \
+  "</method>" \
+  "<method name='SetProperty'>" \
+  "  <arg type='s' direction='in'/>" \
+  "  <arg type='v' direction='in'/>" \
+  "</method>" \
+  "<signal name='PropertyChanged'>" \
+  "  <arg type='s'/>" \
+  "  <arg type='v'/>" \
+  "</signal>"
+
+static const char introspection_xml[] =
+  "<node>"
+  "<interface name='" OFONO_MANAGER_IFACE "'>"
+  "  <method name='GetModems'>"
+  "    <arg type='a(oa{sv})' direction='out'/>"
+  "  </method>"
+  "  <signal name='ModemAdded'><arg type='o'/><arg type='a{sv}'/></signal>"
+  "  <signal name='ModemRemoved'><arg type='o'/></signal>"
+  "</interface>"
+  "<interface name='" OFONO_MODEM_IFACE "'>" PROPS_METHODS "</interface>"
+  "<interface name='" OFONO_SIM_MANAGER_IFACE "'>" PROPS_METHODS "</interface>"
+  "<interface name='" OFONO_NETWORK_REGISTRATION_IFACE "'>" PROPS_METHODS
+  "  <method name='Register'/>"
+  "  <method name='Scan'>"
+  "    <arg type='a(oa{sv})' direction='out'/>"
+  "  </method>"
+  "  <method name='GetOperators'>"
+  "    <arg type='a(oa{sv})' direction='out'/>"
+  "  </method>"
+  "</interface>"
+  "<interface name='" OFONO_VOICECALL_MANAGER_IFACE "'>" PROPS_METHODS
+  "  <method name='GetCalls'>"
+  "    <arg type='a(oa{sv})' direction='out'/>"
+  "  </method>"
+  "  <method name='Dial'>"
+  "    <arg type='s' direction='in'/>"
+  "    <arg type='s' direction='in'/>"
+  "    <arg type='o' direction='out'/>"
+  "  </method>"
+  "  <method name='HangupAll'/>"
+  "  <signal name='CallAdded'><arg type='o'/><arg type='a{sv}'/></signal>"
+  "  <signal name='CallRemoved'><arg type='o'/></signal>"
+  "</interface>"
+  "<interface name='" OFONO_VOICECALL_IFACE "'>" PROPS_METHODS
+  "  <method name='Answer'/>"
+  "  <method name='Hangup'/>"
+  "</interface>"
+  "<interface name='" OFONO_MESSAGE_MANAGER_IFACE "'>" PROPS_METHODS
+  "  <method name='SendMessage'>"
+  "    <arg type='s' direction='in'/>"
+  "    <arg type='s' direction='in'/>"
+  "    <arg type='o' direction='out'/>"
+  "  </method>"
+  "  <signal name='IncomingMessage'><arg type='s'/><arg type='a{sv}'/></signal>"
+  "  <signal name='ImmediateMessage'><arg type='s'/><arg type='a{sv}'/></signal>"
+  "</interface>"
+  "<interface name='" OFONO_CONNMAN_IFACE "'>" PROPS_METHODS
+  "  <method name='GetContexts'>"
+  "    <arg type='a(oa{sv})' direction='out'/>"
+  "  </method>"
+  "  <method name='AddContext'>"
+  "    <arg type='s' direction='in'/>"
+  "    <arg type='o' direction='out'/>"
+  "  </method>"
+  "  <method name='RemoveContext'>"
+  "    <arg type='o' direction='in'/>"
+  "  </method>"
+  "  <method name='DeactivateAll'/>"
+  "  <signal name='ContextAdded'><arg type='o'/><arg type='a{sv}'/></signal>"
+  "  <signal name='ContextRemoved'><arg type='o'/></signal>"
+  "</interface>"
+  "<interface name='" OFONO_CONTEXT_IFACE "'>" PROPS_METHODS "</interface>"
+  "<interface name='" OFONO_NETMON_INTERFACE "'>"
+  "  <method name='GetServingCellInformation'>"
+  "    <arg type='a{sv}' direction='out'/>"
+  "  </method>"
+  "  <method name='GetCellsInformation'>"
+  "    <arg type='a(a{sv})' direction='out'/>"
+  "  </method>"
+  "</interface>"
+  "</node>";
+
+/* the interfaces exported on every modem, in "Interfaces" order */
+static const char *modem_ifaces[] = {
+  OFONO_SIM_MANAGER_IFACE,
+  OFONO_NETWORK_REGISTRATION_IFACE,
+  OFONO_VOICECALL_MANAGER_IFACE,
+  OFONO_MESSAGE_MANAGER_IFACE,
+  OFONO_CONNMAN_IFACE,
+  OFONO_NETMON_INTERFACE,
+};
+
+/* an exported object: a modem, a call or a context */
+struct mock_object {
+  gchar *path;
+  GHashTable *props; /* interface -> GHashTable (name -> GVariant) */
+  GArray *registrations; /* guint registration ids */
+};
+
+struct mock_modem {
+  struct mock_object *obj;
+  GHashTable *calls; /* path -> struct mock_object */
+  GHashTable *contexts; /* path -> struct mock_object */
+  guint last_call;
+  guint last_context;
+  guint last_message;
+};
+
+static GDBusConnection *s_conn;
+static GDBusNodeInfo *s_introspection;
+static GMainLoop *s_loop;
+static GPtrArray *s_modems; /* struct mock_modem */
+static guint s_last_modem;
+static guint s_latency_ms;
+
+static void _handle_method(GDBusConnection *conn, const gchar *sender,
+      const gchar *path, const gchar *iface, const gchar *method,
+      GVariant *params, GDBusMethodInvocation *invocation,
+      gpointer user_data);
+
+static const GDBusInterfaceVTable vtable = {
+  _handle_method, NULL, NULL
+};
+
+static GHashTable *_props(struct mock_object *obj, const char *iface)
+{
+  GHashTable *props = g_hash_table_lookup(obj->props, iface);
+
+  if (props == NULL) {
+    props = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+          (GDestroyNotify) g_variant_unref);
+    g_hash_table_insert(obj->props, g_strdup(iface), props);
+  }
+
+  return props;
+}
+
+static void _set_prop(struct mock_object *obj, const char *iface,
+      const char *key, GVariant *value)
+{
+  g_hash_table_replace(_props(obj, iface), g_strdup(key),
+        g_variant_ref_sink(value));
+}
+
+static GVariant *_props_dict(struct mock_object *obj, const char *iface)
+{
+  GVariantBuilder builder;
+  GHashTableIter iter;
+  gpointer key, value;
+
+  g_variant_builder_init(&builder, G_VARIANT_TYPE("a{sv}"));
+
+  g_hash_table_iter_init(&iter, _props(obj, iface));
+  while (g_hash_table_iter_next(&iter, &key, &value))
+    g_variant_builder_add(&builder, "{sv}", key, value);
+
+  return g_variant_builder_end(&builder);
+}
+
+static void _emit(const char *path, const char *iface, const char *name,
+      GVariant *params)
+{
+  g_dbus_connection_emit_signal(s_conn, NULL, path, iface, name, params,
+        NULL);
+}
+
+static void _prop_changed(struct mock_object *obj, const char *iface,
+      const char *key, GVariant *value)
+{
+  _set_prop(obj, iface, key, value);
+  _emit(obj->path, iface, "PropertyChanged",
+        g_variant_new("(sv)", key, g_hash_table_lookup(_props(obj, iface),
+        key)));
+}
+
+static struct mock_object *_object_new(const char *path,
+      const char **ifaces, int n_ifaces)
+{
+  struct mock_object *obj;
+  int i;
+
+  obj = g_new0(struct mock_object, 1);
+  obj->path = g_strdup(path);
+  obj->props = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+        (GDestroyNotify) g_hash_table_destroy);
+  obj->registrations = g_array_new(FALSE, FALSE, sizeof(guint));
+
+  for (i = 0; i < n_ifaces; i++) {
+    GError *error = NULL;
+    guint id;
+
+    id = g_dbus_connection_register_object(s_conn, path,
+          g_dbus_node_info_lookup_interface(s_introspection, ifaces[i]),
+          &vtable, obj, NULL, &error);
+    if (id == 0) {
+      g_printerr("register %s %s: %s\n", path, ifaces[i], error->message);
+      g_error_free(error);
+      continue;
+    }
+
+    g_array_append_val(obj->registrations, id);
+  }
+
+  return obj;
+}
+
+static void _object_free(gpointer data)
+{
+  struct mock_object *obj = data;
+  guint i;
+
+  for (i = 0; i < obj->registrations->len; i++)
+    g_dbus_connection_unregister_object(s_conn,
+          g_array_index(obj->registrations, guint, i));
+
+  g_array_free(obj->registrations, TRUE);
+  g_hash_table_destroy(obj->props);
+  g_free(obj->path);
+  g_free(obj);
+}
+
+static GVariant *_object_list(GHashTable *objects, const char *iface)
+{
+  GVariantBuilder builder;
+  GHashTableIter iter;
+  gpointer value;
+
+  g_variant_builder_init(&builder, G_VARIANT_TYPE("a(oa{sv})"));
+
+  g_hash_table_iter_init(&iter, objects);
+  while (g_hash_table_iter_next(&iter, NULL, &value)) {
+    struct mock_object *obj = value;
+    g_variant_builder_add(&builder, "(o@a{sv})", obj->path,
+          _props_dict(obj, iface));
+  }
+
+  return g_variant_builder_end(&builder);
+}
+
+static struct mock_modem *_find_modem(const char *path)
+{
+  guint i;
+
+  for (i = 0; i < s_modems->len; i++) {
+    struct mock_modem *modem = g_ptr_array_index(s_modems, i);
+
+    if (g_str_has_prefix(path, modem->obj->path) &&
+        (path[strlen(modem->obj->path)] == '\0' ||
+        path[strlen(modem->obj->path)] == '/'))
+      return modem;
+  }
+
+  return NULL;
+}
+
+static struct mock_object *_call_new(struct mock_modem *modem,
+      const char *number, const char *state)
+{
+  const char *ifaces[] = { OFONO_VOICECALL_IFACE };
+  struct mock_object *call;
+  gchar *path;
+
+  path = g_strdup_printf("%s/voicecall%02u", modem->obj->path,
+        ++modem->last_call);
+  call = _object_new(path, ifaces, G_N_ELEMENTS(ifaces));
+  g_free(path);
+
+  _set_prop(call, OFONO_VOICECALL_IFACE, "LineIdentification",
+        g_variant_new_string(number));
+  _set_prop(call, OFONO_VOICECALL_IFACE, "Name", g_variant_new_string(""));
+  _set_prop(call, OFONO_VOICECALL_IFACE, "State",
+        g_variant_new_string(state));
+  _set_prop(call, OFONO_VOICECALL_IFACE, "Multiparty",
+        g_variant_new_boolean(FALSE));
+  _set_prop(call, OFONO_VOICECALL_IFACE, "Emergency",
+        g_variant_new_boolean(FALSE));
+
+  g_hash_table_insert(modem->calls, call->path, call);
+
+  _emit(modem->obj->path, OFONO_VOICECALL_MANAGER_IFACE, "CallAdded",
+        g_variant_new("(o@a{sv})", call->path,
+        _props_dict(call, OFONO_VOICECALL_IFACE)));
+
+  return call;
+}
+
+static void _call_remove(struct mock_modem *modem, const char *path)
+{
+  gchar *p = g_strdup(path);
+
+  if (g_hash_table_remove(modem->calls, p))
+    _emit(modem->obj->path, OFONO_VOICECALL_MANAGER_IFACE, "CallRemoved",
+          g_variant_new("(o)", p));
+
+  g_free(p);
+}
+
+static struct mock_object *_context_new(struct mock_modem *modem,
+      const char *type)
+{
+  const char *ifaces[] = { OFONO_CONTEXT_IFACE };
+  struct mock_object *ctx;
+  gchar *path;
+
+  path = g_strdup_printf("%s/context%u", modem->obj->path,
+        ++modem->last_context);
+  ctx = _object_new(path, ifaces, G_N_ELEMENTS(ifaces));
+  g_free(path);
+
+  _set_prop(ctx, OFONO_CONTEXT_IFACE, "Type", g_variant_new_string(type));
+  _set_prop(ctx, OFONO_CONTEXT_IFACE, "Active", g_variant_new_boolean(FALSE));
+  _set_prop(ctx, OFONO_CONTEXT_IFACE, "Protocol", g_variant_new_string("ip"));
+  _set_prop(ctx, OFONO_CONTEXT_IFACE, "AccessPointName",
+        g_variant_new_string(""));
+  _set_prop(ctx, OFONO_CONTEXT_IFACE, "Username", g_variant_new_string(""));
+  _set_prop(ctx, OFONO_CONTEXT_IFACE, "Password", g_variant_new_string(""));
+
+  g_hash_table_insert(modem->contexts, ctx->path, ctx);
+
+  _emit(modem->obj->path, OFONO_CONNMAN_IFACE, "ContextAdded",
+        g_variant_new("(o@a{sv})", ctx->path,
+        _props_dict(ctx, OFONO_CONTEXT_IFACE)));
+
+  return ctx;
+}
+
+static GVariant *_cell_info(guint n)
+{
+  GVariantBuilder builder;
+
+  g_variant_builder_init(&builder, G_VARIANT_TYPE("a{sv}"));
+  g_variant_builder_add(&builder, "{sv}", "Technology",
+        g_variant_new_string("lte"));
+  g_variant_builder_add(&builder, "{sv}", "MobileCountryCode",
+        g_variant_new_string("001"));
+  g_variant_builder_add(&builder, "{sv}", "MobileNetworkCode",
+        g_variant_new_string("01"));
+  g_variant_builder_add(&builder, "{sv}", "LocationAreaCode",
+        g_variant_new_uint16(0x1000 + n));
+  g_variant_builder_add(&builder, "{sv}", "CellId",
+        g_variant_new_uint32(0x10000 + n));
+  g_variant_builder_add(&builder, "{sv}", "Strength",
+        g_variant_new_byte(20 + n % 10));
+
+  return g_variant_builder_end(&builder);
+}
+
+static GVariant *_operators(void)
+{
+  GVariantBuilder builder;
+  static const char *names[] = { "Mock One", "Mock Two", "Mock Three" };
+  static const char *status[] = { "current", "available", "forbidden" };
+  guint i;
+
+  g_variant_builder_init(&builder, G_VARIANT_TYPE("a(oa{sv})"));
+
+  for (i = 0; i < G_N_ELEMENTS(names); i++) {
+    GVariantBuilder props;
+    const char *techs[] = { "gsm", "lte", NULL };
+    gchar *path = g_strdup_printf("/operator/00101%u", i);
+
+    g_variant_builder_init(&props, G_VARIANT_TYPE("a{sv}"));
+    g_variant_builder_add(&props, "{sv}", "Name",
+          g_variant_new_string(names[i]));
+    g_variant_builder_add(&props, "{sv}", "Status",
+          g_variant_new_string(status[i]));
+    g_variant_builder_add(&props, "{sv}", "MobileCountryCode",
+          g_variant_new_string("001"));
+    g_variant_builder_add(&props, "{sv}", "MobileNetworkCode",
+          g_variant_new_string(i == 0 ? "01" : "02"));
+    g_variant_builder_add(&props, "{sv}", "Technologies",
+          g_variant_new_strv(techs, -1));
+
+    g_variant_builder_add(&builder, "(o@a{sv})", path,
+          g_variant_builder_end(&props));
+    g_free(path);
+  }
+
+  return g_variant_builder_end(&builder);
+}
+
+/* returns the reply parameters, NULL if an error has been returned */
+static GVariant *_dispatch(struct mock_object *obj, const gchar *iface,
+      const gchar *method, GVariant *params,
+      GDBusMethodInvocation *invocation)
+{
+  struct mock_modem *modem = _find_modem(obj->path);
+
+  if (g_strcmp0(method, "GetProperties") == 0)
+    return g_variant_new("(@a{sv})", _props_dict(obj, iface));
+
+  if (g_strcmp0(method, "SetProperty") == 0) {
+    const gchar *key;
+    GVariant *value;
+
+    g_variant_get(params, "(&sv)", &key, &value);
+    _prop_changed(obj, iface, key, value);
+    g_variant_unref(value);
+    return NULL;
+  }
+
+  if (g_strcmp0(method, "GetModems") == 0) {
+    GVariantBuilder builder;
+    guint i;
+
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("a(oa{sv})"));
+    for (i = 0; i < s_modems->len; i++) {
+      struct mock_modem *m = g_ptr_array_index(s_modems, i);
+      g_variant_builder_add(&builder, "(o@a{sv})", m->obj->path,
+            _props_dict(m->obj, OFONO_MODEM_IFACE));
+    }
+
+    return g_variant_new("(@a(oa{sv}))", g_variant_builder_end(&builder));
+  }
+
+  if (modem == NULL)
+    return NULL;
+
+  if (g_strcmp0(method, "Scan") == 0 ||
+      g_strcmp0(method, "GetOperators") == 0)
+    return g_variant_new("(@a(oa{sv}))", _operators());
+
+  if (g_strcmp0(method, "GetCalls") == 0)
+    return g_variant_new("(@a(oa{sv}))",
+          _object_list(modem->calls, OFONO_VOICECALL_IFACE));
+
+  if (g_strcmp0(method, "Dial") == 0) {
+    const gchar *number;
+    struct mock_object *call;
+
+    g_variant_get(params, "(&s&s)", &number, NULL);
+    call = _call_new(modem, number, "dialing");
+    return g_variant_new("(o)", call->path);
+  }
+
+  if (g_strcmp0(method, "HangupAll") == 0) {
+    GList *paths, *l;
+
+    paths = g_hash_table_get_keys(modem->calls);
+    for (l = paths; l; l = l->next)
+      _call_remove(modem, l->data);
+    g_list_free(paths);
+
+    return NULL;
+  }
+
+  if (g_strcmp0(method, "Answer") == 0) {
+    _prop_changed(obj, iface, "State", g_variant_new_string("active"));
+    return NULL;
+  }
+
+  if (g_strcmp0(method, "Hangup") == 0) {
+    _call_remove(modem, obj->path);
+    return NULL;
+  }
+
+  if (g_strcmp0(method, "SendMessage") == 0) {
+    gchar *path = g_strdup_printf("%s/message_%u", modem->obj->path,
+          ++modem->last_message);
+    GVariant *ret = g_variant_new("(o)", path);
+
+    g_free(path);
+    return ret;
+  }
+
+  if (g_strcmp0(method, "GetContexts") == 0)
+    return g_variant_new("(@a(oa{sv}))",
+          _object_list(modem->contexts, OFONO_CONTEXT_IFACE));
+
+  if (g_strcmp0(method, "AddContext") == 0) {
+    const gchar *type;
+
+    g_variant_get(params, "(&s)", &type);
+    return g_variant_new("(o)", _context_new(modem, type)->path);
+  }
+
+  if (g_strcmp0(method, "RemoveContext") == 0) {
+    gchar *path;
+
+    g_variant_get(params, "(o)", &path);
+    if (g_hash_table_remove(modem->contexts, path))
+      _emit(modem->obj->path, OFONO_CONNMAN_IFACE, "ContextRemoved",
+            g_variant_new("(o)", path));
+    g_free(path);
+    return NULL;
+  }
+
+  if (g_strcmp0(method, "GetServingCellInformation") == 0)
+    return g_variant_new("(@a{sv})", _cell_info(0));
+
+  if (g_strcmp0(method, "GetCellsInformation") == 0) {
+    GVariantBuilder builder;
+    guint i;
+
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("a(a{sv})"));
+    for (i = 0; i < 6; i++)
+      g_variant_builder_add(&builder, "(@a{sv})", _cell_info(i));
+
+    return g_variant_new("(@a(a{sv}))", g_variant_builder_end(&builder));
+  }
+
+  /* Register, DeactivateAll... nothing to do */
+  return NULL;
+}
+
+struct delayed_reply {
+  GDBusMethodInvocation *invocation;
+  GVariant *reply;
+};
+
+static gboolean _send_delayed_reply(gpointer user_data)
+{
+  struct delayed_reply *dr = user_data;
+
+  g_dbus_method_invocation_return_value(dr->invocation, dr->reply);
+  g_free(dr);
+
+  return FALSE;
+}
+
+static void _handle_method(GDBusConnection *conn, const gchar *sender,
+      const gchar *path, const gchar *iface, const gchar *method,
+      GVariant *params, GDBusMethodInvocation *invocation,
+      gpointer user_data)
+{
+  struct delayed_reply *dr;
+  GVariant *reply;
+
+  reply = _dispatch(user_data, iface, method, params, invocation);
+
+  if (s_latency_ms == 0) {
+    g_dbus_method_invocation_return_value(invocation, reply);
+    return;
+  }
+
+  dr = g_new0(struct delayed_reply, 1);
+  dr->invocation = invocation;
+  dr->reply = reply;
+  g_timeout_add(s_latency_ms, _send_delayed_reply, dr);
+}
+
+static struct mock_modem *_modem_add(void)
+{
+  struct mock_modem *modem;
+  const char *ifaces[G_N_ELEMENTS(modem_ifaces) + 1];
+  const char *names[] = { "0000000000", NULL };
+  gchar *path;
+  guint i;
+
+  ifaces[0] = OFONO_MODEM_IFACE;
+  for (i = 0; i < G_N_ELEMENTS(modem_ifaces); i++)
+    ifaces[i + 1] = modem_ifaces[i];
+
+  modem = g_new0(struct mock_modem, 1);
+
+  path = g_strdup_printf("/mock_%u", s_last_modem++);
+  modem->obj = _object_new(path, ifaces, G_N_ELEMENTS(ifaces));
+  g_free(path);
+
+  modem->calls = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+        _object_free);
+  modem->contexts = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+        _object_free);
+
+  _set_prop(modem->obj, OFONO_MODEM_IFACE, "Powered",
+        g_variant_new_boolean(TRUE));
+  _set_prop(modem->obj, OFONO_MODEM_IFACE, "Online",
+        g_variant_new_boolean(TRUE));
+  _set_prop(modem->obj, OFONO_MODEM_IFACE, "Manufacturer",
+        g_variant_new_string("libofono"));
+  _set_prop(modem->obj, OFONO_MODEM_IFACE, "Model",
+        g_variant_new_string("mock"));
+  _set_prop(modem->obj, OFONO_MODEM_IFACE, "Revision",
+        g_variant_new_string("1"));
+  _set_prop(modem->obj, OFONO_MODEM_IFACE, "Serial",
+        g_variant_new_string("000000000000000"));
+  _set_prop(modem->obj, OFONO_MODEM_IFACE, "Type",
+        g_variant_new_string("hardware"));
+  _set_prop(modem->obj, OFONO_MODEM_IFACE, "Interfaces",
+        g_variant_new_strv(modem_ifaces, G_N_ELEMENTS(modem_ifaces)));
+
+  _set_prop(modem->obj, OFONO_SIM_MANAGER_IFACE, "Present",
+        g_variant_new_boolean(TRUE));
+  _set_prop(modem->obj, OFONO_SIM_MANAGER_IFACE, "SubscriberIdentity",
+        g_variant_new_string("001010000000000"));
+  _set_prop(modem->obj, OFONO_SIM_MANAGER_IFACE, "CardIdentifier",
+        g_variant_new_string("8900000000000000000"));
+  _set_prop(modem->obj, OFONO_SIM_MANAGER_IFACE, "MobileCountryCode",
+        g_variant_new_string("001"));
+  _set_prop(modem->obj, OFONO_SIM_MANAGER_IFACE, "MobileNetworkCode",
+        g_variant_new_string("01"));
+  _set_prop(modem->obj, OFONO_SIM_MANAGER_IFACE, "SubscriberNumbers",
+        g_variant_new_strv(names, -1));
+  _set_prop(modem->obj, OFONO_SIM_MANAGER_IFACE, "PinRequired",
+        g_variant_new_string("none"));
+
+  _set_prop(modem->obj, OFONO_NETWORK_REGISTRATION_IFACE, "Status",
+        g_variant_new_string("registered"));
+  _set_prop(modem->obj, OFONO_NETWORK_REGISTRATION_IFACE, "Mode",
+        g_variant_new_string("auto"));
+  _set_prop(modem->obj, OFONO_NETWORK_REGISTRATION_IFACE, "Name",
+        g_variant_new_string("Mock One"));
+  _set_prop(modem->obj, OFONO_NETWORK_REGISTRATION_IFACE,
+        "MobileCountryCode", g_variant_new_string("001"));
+  _set_prop(modem->obj, OFONO_NETWORK_REGISTRATION_IFACE,
+        "MobileNetworkCode", g_variant_new_string("01"));
+  _set_prop(modem->obj, OFONO_NETWORK_REGISTRATION_IFACE, "Technology",
+        g_variant_new_string("lte"));
+  _set_prop(modem->obj, OFONO_NETWORK_REGISTRATION_IFACE, "Strength",
+        g_variant_new_byte(60));
+  _set_prop(modem->obj, OFONO_NETWORK_REGISTRATION_IFACE,
+        "LocationAreaCode", g_variant_new_uint16(0x1000));
+  _set_prop(modem->obj, OFONO_NETWORK_REGISTRATION_IFACE, "CellId",
+        g_variant_new_uint32(0x10000));
+
+  _set_prop(modem->obj, OFONO_VOICECALL_MANAGER_IFACE, "EmergencyNumbers",
+        g_variant_new_strv((const char *[]) { "112", "911", NULL }, -1));
+
+  _set_prop(modem->obj, OFONO_MESSAGE_MANAGER_IFACE, "ServiceCenterAddress",
+        g_variant_new_string("+10000000000"));
+  _set_prop(modem->obj, OFONO_MESSAGE_MANAGER_IFACE, "UseDeliveryReports",
+        g_variant_new_boolean(FALSE));
+
+  _set_prop(modem->obj, OFONO_CONNMAN_IFACE, "Attached",
+        g_variant_new_boolean(TRUE));
+  _set_prop(modem->obj, OFONO_CONNMAN_IFACE, "Bearer",
+        g_variant_new_string("lte"));
+  _set_prop(modem->obj, OFONO_CONNMAN_IFACE, "Powered",
+        g_variant_new_boolean(TRUE));
+  _set_prop(modem->obj, OFONO_CONNMAN_IFACE, "RoamingAllowed",
+        g_variant_new_boolean(FALSE));
+
+  g_ptr_array_add(s_modems, modem);
+
+  _context_new(modem, "internet");
+
+  return modem;
+}
+
+static void _modem_free(gpointer data)
+{
+  struct mock_modem *modem = data;
+
+  g_hash_table_destroy(modem->calls);
+  g_hash_table_destroy(modem->contexts);
+  _object_free(modem->obj);
+  g_free(modem);
+}
+
+static void _burst_strength(guint count)
+{
+  guint i, n;
+
+  for (n = 0; n < count; n++) {
+    for (i = 0; i < s_modems->len; i++) {
+      struct mock_modem *modem = g_ptr_array_index(s_modems, i);
+
+      _prop_changed(modem->obj, OFONO_NETWORK_REGISTRATION_IFACE, "Strength",
+            g_variant_new_byte(n % 101));
+    }
+  }
+}
+
+static void _burst_sms(guint count)
+{
+  GVariantBuilder builder;
+  guint i, n;
+
+  for (n = 0; n < count; n++) {
+    for (i = 0; i < s_modems->len; i++) {
+      struct mock_modem *modem = g_ptr_array_index(s_modems, i);
+      gchar *text = g_strdup_printf("mock message %u", n);
+
+      g_variant_builder_init(&builder, G_VARIANT_TYPE("a{sv}"));
+      g_variant_builder_add(&builder, "{sv}", "Sender",
+            g_variant_new_string("+10000000001"));
+      g_variant_builder_add(&builder, "{sv}", "SentTime",
+            g_variant_new_string("2013-01-01T12:00:00+0000"));
+      g_variant_builder_add(&builder, "{sv}", "LocalSentTime",
+            g_variant_new_string("2013-01-01T12:00:00+0000"));
+
+      _emit(modem->obj->path, OFONO_MESSAGE_MANAGER_IFACE, "IncomingMessage",
+            g_variant_new("(s@a{sv})", text, g_variant_builder_end(&builder)));
+      g_free(text);
+    }
+  }
+}
+
+static void _run_command(char *line)
+{
+  gchar **argv;
+  guint argc;
+
+  g_strstrip(line);
+  if (line[0] == '\0' || line[0] == '#')
+    return;
+
+  argv = g_strsplit_set(line, " \t", -1);
+  argc = g_strv_length(argv);
+
+  if (g_strcmp0(argv[0], "quit") == 0) {
+    g_main_loop_quit(s_loop);
+  } else if (g_strcmp0(argv[0], "latency") == 0 && argc == 2) {
+    s_latency_ms = atoi(argv[1]);
+  } else if (g_strcmp0(argv[0], "add-modem") == 0) {
+    struct mock_modem *modem = _modem_add();
+
+    _emit("/", OFONO_MANAGER_IFACE, "ModemAdded",
+          g_variant_new("(o@a{sv})", modem->obj->path,
+          _props_dict(modem->obj, OFONO_MODEM_IFACE)));
+  } else if (g_strcmp0(argv[0], "remove-modem") == 0 && argc == 2) {
+    struct mock_modem *modem = _find_modem(argv[1]);
+
+    if (modem != NULL) {
+      _emit("/", OFONO_MANAGER_IFACE, "ModemRemoved",
+            g_variant_new("(o)", modem->obj->path));
+      g_ptr_array_remove(s_modems, modem);
+    }
+  } else if (g_strcmp0(argv[0], "strength") == 0 && argc == 2) {
+    guint i;
+
+    for (i = 0; i < s_modems->len; i++) {
+      struct mock_modem *modem = g_ptr_array_index(s_modems, i);
+
+      _prop_changed(modem->obj, OFONO_NETWORK_REGISTRATION_IFACE, "Strength",
+            g_variant_new_byte(atoi(argv[1])));
+    }
+  } else if (g_strcmp0(argv[0], "burst") == 0 && argc == 3) {
+    if (g_strcmp0(argv[1], "strength") == 0)
+      _burst_strength(atoi(argv[2]));
+    else if (g_strcmp0(argv[1], "sms") == 0)
+      _burst_sms(atoi(argv[2]));
+    else
+      g_printerr("unknown burst: %s\n", argv[1]);
+  } else if (g_strcmp0(argv[0], "incoming-call") == 0 && argc == 2) {
+    guint i;
+
+    for (i = 0; i < s_modems->len; i++)
+      _call_new(g_ptr_array_index(s_modems, i), argv[1], "incoming");
+  } else {
+    g_printerr("unknown command: %s\n", line);
+  }
+
+  g_strfreev(argv);
+  g_dbus_connection_flush_sync(s_conn, NULL, NULL);
+}
+
+static gboolean _on_stdin(GIOChannel *channel, GIOCondition cond,
+      gpointer user_data)
+{
+  gchar *line = NULL;
+  GIOStatus status;
+
+  status = g_io_channel_read_line(channel, &line, NULL, NULL, NULL);
+  if (status == G_IO_STATUS_EOF || status == G_IO_STATUS_ERROR) {
+    g_main_loop_quit(s_loop);
+    return FALSE;
+  }
+
+  if (line != NULL) {
+    _run_command(line);
+    g_free(line);
+  }
+
+  return TRUE;
+}
+
+static void _on_name_acquired(GDBusConnection *conn, const gchar *name,
+      gpointer user_data)
+{
+  GIOChannel *channel;
+
+  printf("ready\n");
+  fflush(stdout);
+
+  channel = g_io_channel_unix_new(0);
+  g_io_add_watch(channel, G_IO_IN | G_IO_HUP, _on_stdin, NULL);
+  g_io_channel_unref(channel);
+}
+
+static void _on_name_lost(GDBusConnection *conn, const gchar *name,
+      gpointer user_data)
+{
+  g_printerr("can't own %s\n", name);
+  g_main_loop_quit(s_loop);
+}
+
+int main(int argc, char **argv)
+{
+  GError *error = NULL;
+  GOptionContext *options;
+  gint modems = 1, latency = 0;
+  GOptionEntry entries[] = {
+    { "modems", 'm', 0, G_OPTION_ARG_INT, &modems,
+      "Number of modems (default 1)", "N" },
+    { "latency", 'l', 0, G_OPTION_ARG_INT, &latency,
+      "Delay of every method reply (default 0)", "MS" },
+    { NULL }
+  };
+  guint owner;
+  gint i;
+
+#if !GLIB_CHECK_VERSION(2,35,0)
+  g_type_init();
+#endif
+
+  options = g_option_context_new("- mock ofono daemon");
+  g_option_context_add_main_entries(options, entries, NULL);
+  if (!g_option_context_parse(options, &argc, &argv, &error)) {
+    g_printerr("%s\n", error->message);
+    return 1;
+  }
+  g_option_context_free(options);
+
+  s_latency_ms = latency > 0 ? latency : 0;
+
+  s_conn = g_bus_get_sync(G_BUS_TYPE_SYSTEM, NULL, &error);
+  if (s_conn == NULL) {
+    g_printerr("can't connect to the bus: %s\n", error->message);
+    return 1;
+  }
+
+  s_introspection = g_dbus_node_info_new_for_xml(introspection_xml, NULL);
+  s_modems = g_ptr_array_new_with_free_func(_modem_free);
+
+  g_dbus_connection_register_object(s_conn, "/",
+        g_dbus_node_info_lookup_interface(s_introspection,
+        OFONO_MANAGER_IFACE), &vtable, NULL, NULL, NULL);
+
+  for (i = 0; i < modems; i++)
+    _modem_add();
+
+  owner = g_bus_own_name_on_connection(s_conn, OFONO_SERVICE,
+        G_BUS_NAME_OWNER_FLAGS_NONE, _on_name_acquired, _on_name_lost,
+        NULL, NULL);
+
+  s_loop = g_main_loop_new(NULL, FALSE);
+  g_main_loop_run(s_loop);
+
+  g_bus_unown_name(owner);
+  g_ptr_array_free(s_modems, TRUE);
+  g_dbus_node_info_unref(s_introspection);
+  g_object_unref(s_conn);
+  g_main_loop_unref(s_loop);
+
+  return 0;
+}
@@ -0,0 +1,330 @@
+/*
+ * Copyright (C) 2013 Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Non interactive test cases against mock-ofonod, run by ctest:
+ *
+ *   test/run-mock.sh [--modems N] -- ./mock-test <case> [N]
+ *
+ * The values checked are the ones mock-ofonod exports. The exit status is
+ * 0 if the case passed.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <gio/gio.h>
+
+#include "ofono-common.h"
+#include "ofono-call.h"
+#include "ofono-network.h"
+#include "ofono-sim.h"
+#include "ofono-sms.h"
+
+#define WAIT_TIMEOUT 5000 /* ms */
+
+#define CHECK(cond) \
+  do { \
+    if (!(cond)) { \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, \
+            #cond); \
+      return FALSE; \
+    } \
+  } while (0)
+
+static GMainLoop *s_loop;
+
+/* the last response or notification, reset by _wait() */
+static struct {
+  tapi_bool done;
+  TResult ret;
+  unsigned int call_id;
+  char *text;
+  char *sender;
+  struct ofono_modem *modem;
+} s_resp;
+
+static gboolean _on_wait_timeout(gpointer data)
+{
+  g_main_loop_quit(s_loop);
+  return G_SOURCE_REMOVE;
+}
+
+/* iterate until a response arrives, FALSE on timeout */
+static tapi_bool _wait(void)
+{
+  guint timer;
+
+  if (!s_resp.done) {
+    timer = g_timeout_add(WAIT_TIMEOUT, _on_wait_timeout, NULL);
+    g_main_loop_run(s_loop);
+    if (s_resp.done)
+      g_source_remove(timer);
+  }
+
+  if (!s_resp.done)
+    fprintf(stderr, "no response after %d ms\n", WAIT_TIMEOUT);
+
+  return s_resp.done;
+}
+
+static void _reset(void)
+{
+  g_free(s_resp.text);
+  g_free(s_resp.sender);
+  memset(&s_resp, 0, sizeof(s_resp));
+}
+
+static void _done(TResult ret)
+{
+  s_resp.done = TRUE;
+  s_resp.ret = ret;
+  g_main_loop_quit(s_loop);
+}
+
+static void _on_response(TResult ret, const void *data, const void *user_data)
+{
+  _done(ret);
+}
+
+static void _on_response_text(TResult ret, const void *data,
+      const void *user_data)
+{
+  s_resp.text = g_strdup(data);
+  _done(ret);
+}
+
+static void _on_response_call_id(TResult ret, const void *data,
+      const void *user_data)
+{
+  if (data != NULL)
+    s_resp.call_id = *(const unsigned int *) data;
+  _done(ret);
+}
+
+static void _on_response_modem(TResult ret, const void *data,
+      const void *user_data)
+{
+  s_resp.modem = (struct ofono_modem *) data;
+  _done(ret);
+}
+
+static void _on_incoming_sms(enum ofono_noti noti, void *data,
+      void *user_data)
+{
+  struct ofono_sms_incoming_noti *sms = data;
+
+  s_resp.text = g_strdup(sms->message);
+  s_resp.sender = g_strdup(sms->sender);
+  _done(TAPI_RESULT_OK);
+}
+
+/* feed a command to mock-ofonod, through the fifo of run-mock.sh */
+static tapi_bool _mock_command(const char *command)
+{
+  const char *input = getenv("MOCK_INPUT");
+  FILE *fifo;
+
+  CHECK(input != NULL);
+
+  fifo = fopen(input, "w");
+  CHECK(fifo != NULL);
+  fprintf(fifo, "%s\n", command);
+  fclose(fifo);
+
+  return TRUE;
+}
+
+static tapi_bool test_registration(struct ofono_modem *modem)
+{
+  struct registration_info info;
+
+  CHECK(ofono_network_get_registration_info(modem, &info));
+  CHECK(info.status == REG_STATUS_REGISTERED_HOME);
+  CHECK(info.act == ACCESS_TECH_EUTRAN);
+  CHECK(info.lac == 0x1000);
+  CHECK(info.cid == 0x10000);
+  CHECK(strcmp(info.mcc, "001") == 0);
+  CHECK(strcmp(info.mnc, "01") == 0);
+
+  return TRUE;
+}
+
+static tapi_bool test_sim(struct ofono_modem *modem)
+{
+  struct sim_info info;
+
+  CHECK(ofono_sim_get_info(modem, &info));
+  CHECK(info.status != SIM_STATUS_ABSENT);
+  CHECK(info.status != SIM_STATUS_LOCKED);
+  CHECK(info.pin_required == PIN_LOCK_NONE);
+  CHECK(strcmp(info.imsi, "001010000000000") == 0);
+  CHECK(strcmp(info.iccid, "8900000000000000000") == 0);
+  CHECK(strcmp(info.mcc, "001") == 0);
+  CHECK(strcmp(info.mnc, "01") == 0);
+  CHECK(strcmp(info.msisdn[0], "0000000000") == 0);
+
+  return TRUE;
+}
+
+static tapi_bool test_sms_send(struct ofono_modem *modem)
+{
+  CHECK(ofono_sms_send_sms(modem, "+10000000001", "mock test",
+        _on_response_text, NULL) != 0);
+  CHECK(_wait());
+  CHECK(s_resp.ret == TAPI_RESULT_OK);
+  CHECK(s_resp.text != NULL && strstr(s_resp.text, "/message_") != NULL);
+
+  return TRUE;
+}
+
+static tapi_bool test_sms_receive(struct ofono_modem *modem)
+{
+  CHECK(ofono_register_notification_callback(modem,
+        OFONO_NOTI_INCOMING_SMS, _on_incoming_sms, NULL, NULL));
+
+  /* a round trip, the bus has the match rule once it is answered */
+  CHECK(ofono_sms_get_sca(modem, _on_response_text, NULL) != 0);
+  CHECK(_wait());
+  CHECK(s_resp.ret == TAPI_RESULT_OK);
+  _reset();
+
+  CHECK(_mock_command("burst sms 1"));
+  CHECK(_wait());
+  CHECK(s_resp.sender != NULL && strcmp(s_resp.sender, "+10000000001") == 0);
+  CHECK(s_resp.text != NULL && strcmp(s_resp.text, "mock message 0") == 0);
+
+  ofono_unregister_notification_callback(modem, OFONO_NOTI_INCOMING_SMS,
+        _on_incoming_sms);
+
+  return TRUE;
+}
+
+static tapi_bool test_call(struct ofono_modem *modem)
+{
+  struct ofono_calls calls;
+  unsigned int call_id;
+
+  CHECK(ofono_call_dial(modem, "+10000000002", SS_CLIR_DEV_STATUS_DEFAULT,
+        _on_response_call_id, NULL) != 0);
+  CHECK(_wait());
+  CHECK(s_resp.ret == TAPI_RESULT_OK);
+  call_id = s_resp.call_id;
+  _reset();
+
+  CHECK(ofono_call_get_calls(modem, &calls));
+  CHECK(calls.count == 1);
+  CHECK(calls.calls[0].call_id == call_id);
+  CHECK(calls.calls[0].status == CALL_STATUS_DIALING);
+
+  CHECK(ofono_call_release_specific(modem, call_id, _on_response, NULL) != 0);
+  CHECK(_wait());
+  CHECK(s_resp.ret == TAPI_RESULT_OK);
+
+  CHECK(ofono_call_get_calls(modem, &calls));
+  CHECK(calls.count == 0);
+
+  return TRUE;
+}
+
+/* every modem of the registry comes up, the first one is already there */
+static tapi_bool test_modems(struct ofono_modem *modem, unsigned int count)
+{
+  struct str_list *modems;
+  tapi_bool powered;
+  int i;
+
+  modems = ofono_get_modems();
+  CHECK(modems != NULL);
+  CHECK((unsigned int) modems->count == count);
+
+  for (i = 1; i < modems->count; i++) {
+    ofono_modem_init_async(modems->data[i], _on_response_modem, NULL);
+    CHECK(_wait());
+    CHECK(s_resp.ret == TAPI_RESULT_OK);
+    CHECK(s_resp.modem != NULL);
+
+    CHECK(ofono_modem_get_power_status(s_resp.modem, &powered));
+    CHECK(powered);
+    CHECK(test_registration(s_resp.modem));
+
+    ofono_modem_deinit(s_resp.modem);
+    _reset();
+  }
+
+  ofono_string_list_free(modems);
+
+  return TRUE;
+}
+
+int main(int argc, char **argv)
+{
+  struct ofono_modem *modem;
+  const char *name;
+  tapi_bool ok;
+
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s registration|sim|sms-send|sms-receive|"
+          "call|modems <count>\n", argv[0]);
+    return 2;
+  }
+  name = argv[1];
+
+#if !GLIB_CHECK_VERSION(2,35,0)
+  g_type_init();
+#endif
+
+  s_loop = g_main_loop_new(NULL, FALSE);
+
+  if (!ofono_init()) {
+    fprintf(stderr, "ofono_init() failed\n");
+    return 1;
+  }
+
+  modem = ofono_modem_init(NULL);
+  if (modem == NULL) {
+    fprintf(stderr, "no modem\n");
+    ofono_deinit();
+    return 1;
+  }
+
+  if (strcmp(name, "registration") == 0)
+    ok = test_registration(modem);
+  else if (strcmp(name, "sim") == 0)
+    ok = test_sim(modem);
+  else if (strcmp(name, "sms-send") == 0)
+    ok = test_sms_send(modem);
+  else if (strcmp(name, "sms-receive") == 0)
+    ok = test_sms_receive(modem);
+  else if (strcmp(name, "call") == 0)
+    ok = test_call(modem);
+  else if (strcmp(name, "modems") == 0 && argc == 3)
+    ok = test_modems(modem, atoi(argv[2]));
+  else {
+    fprintf(stderr, "unknown test case: %s\n", name);
+    ok = FALSE;
+  }
+
+  _reset();
+  ofono_modem_deinit(modem);
+  ofono_deinit();
+  g_main_loop_unref(s_loop);
+
+  printf("%s: %s\n", name, ok ? "PASS" : "FAIL");
+
+  return ok ? 0 : 1;
+}
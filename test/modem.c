@@ -25,6 +25,8 @@ static void test_modem_set_online();
 static void test_modem_get_powered();
 static void test_modem_set_powered();
 static void test_modem_get_info();
+static void test_modem_get_info_async();
+static void test_modem_get_cache_stats();
 
 struct menu_info modem_menu[] = {
   {"ofono_modem_get_online", test_modem_get_online, main_menu, NULL},
@@ -32,6 +34,8 @@ struct menu_info modem_menu[] = {
   {"ofono_modem_get_powered", test_modem_get_powered, main_menu, NULL},
   {"ofono_modem_set_powered", test_modem_set_powered, main_menu, NULL},
   {"ofono_modem_get_info", test_modem_get_info, main_menu, NULL},
+  {"ofono_modem_get_info_async", test_modem_get_info_async, main_menu, NULL},
+  {"ofono_modem_get_cache_stats", test_modem_get_cache_stats, main_menu, NULL},
   {NULL, NULL, NULL, NULL}
 };
 
@@ -72,4 +76,29 @@ static void test_modem_get_info()
   struct modem_info info;
 
   ofono_modem_get_info(g_modem, &info);
-}
\ No newline at end of file
+}
+
+static void _on_get_info(TResult result, const void *resp,
+    const void *user_data)
+{
+  const struct modem_info *info = resp;
+
+  if (result != TAPI_RESULT_OK || info == NULL)
+    return;
+
+  printf("manufacturer: %s, model: %s, revision: %s, serial: %s\n",
+      info->manufacturer, info->model, info->revision, info->serial);
+}
+
+static void test_modem_get_info_async()
+{
+  ofono_modem_get_info_async(g_modem, _on_get_info, NULL);
+}
+
+static void test_modem_get_cache_stats()
+{
+  struct ofono_cache_stats stats;
+
+  if (ofono_modem_get_cache_stats(g_modem, &stats))
+    printf("cache hits: %lu, misses: %lu\n", stats.hits, stats.misses);
+}
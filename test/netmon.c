@@ -16,16 +16,19 @@
  */
 #include "main.h"
 #include "ofono-network.h"
+#include "ofono-netmon.h"
 
 extern struct ofono_modem *g_modem;
 extern struct menu_info main_menu[];
 
 static void test_netmon_get_serving_cell_info();
 static void test_netmon_get_cells_info();
+static void test_netmon_sampler();
 
 struct menu_info netmon_menu[] = {
   {"ofono_netmon_get_serving_cell_info", test_netmon_get_serving_cell_info, main_menu, NULL},
   {"ofono_netmon_get_cells_info", test_netmon_get_cells_info, main_menu, NULL},
+  {"ofono_netmon_sampler (start/stats)", test_netmon_sampler, main_menu, NULL},
   {NULL, NULL, NULL, NULL}
 };
 
@@ -39,3 +42,21 @@ static void test_netmon_get_cells_info()
   ofono_netmon_get_cells_info(g_modem, NULL, NULL);
 }
 
+
+static void test_netmon_sampler()
+{
+  static struct ofono_netmon_sampler *sampler;
+  struct ofono_netmon_sampler_stats stats;
+
+  if (sampler == NULL) {
+    sampler = ofono_netmon_sampler_new(g_modem, 1000, 60, TRUE);
+    printf("sampling every second\n");
+    return;
+  }
+
+  ofono_netmon_sampler_get_stats(sampler, &stats);
+  printf("samples %lu, failures %lu, rssi %u - %u (%.1f), ber %u - %u, "
+        "ta %u - %u\n", stats.samples, stats.failures,
+        stats.rssi.min, stats.rssi.max, stats.rssi.ewma,
+        stats.ber.min, stats.ber.max, stats.ta.min, stats.ta.max);
+}
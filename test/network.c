@@ -29,6 +29,8 @@ static void test_network_set_mode();
 static void test_network_register();
 static void test_network_auto_register();
 static void test_network_scan_operators();
+static void test_network_get_cached_operator();
+static void test_network_get_signal_filter_stats();
 
 struct menu_info network_menu[] = {
   {"ofono_network_get_registration_info", test_network_get_registration_info, main_menu, NULL},
@@ -40,6 +42,8 @@ struct menu_info network_menu[] = {
   {"ofono_network_register", test_network_register, main_menu, NULL},
   {"ofono_network_auto_register", test_network_auto_register, main_menu, NULL},
   {"ofono_network_scan_operators", test_network_scan_operators, main_menu, NULL},
+  {"ofono_network_get_cached_operator", test_network_get_cached_operator, main_menu, NULL},
+  {"ofono_network_get_signal_filter_stats", test_network_get_signal_filter_stats, main_menu, NULL},
   {NULL, NULL, NULL, NULL}
 };
 
@@ -107,3 +111,32 @@ static void test_network_scan_operators()
 {
   ofono_network_scan_operators(g_modem, NULL, NULL);
 }
+
+static void test_network_get_cached_operator()
+{
+  char plmn[256];
+  struct operator_info info;
+
+  printf("please input plmn (MCCMNC):\n");
+  if (scanf("%s", plmn) == EOF)
+    return;
+
+  if (!ofono_network_get_cached_operator(g_modem, plmn, &info)) {
+    printf("not cached\n");
+    return;
+  }
+
+  printf("%s: %s (%s), status: %d\n", info.plmn, info.name, info.path,
+      info.status);
+  g_free(info.name);
+  g_free(info.path);
+}
+
+static void test_network_get_signal_filter_stats()
+{
+  struct ofono_signal_filter_stats stats;
+
+  if (ofono_network_get_signal_filter_stats(g_modem, &stats))
+    printf("delivered: %lu, suppressed: %lu\n", stats.delivered,
+        stats.suppressed);
+}
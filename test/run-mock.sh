@@ -0,0 +1,55 @@
+#!/bin/sh
+#
+# Run a command against mock-ofonod on a private bus:
+#
+#   test/run-mock.sh [mock-ofonod options] -- command [args]
+#
+# MOCK_OFONOD may point to the mock binary, MOCK_SCRIPT to a file of
+# commands fed to it once it is ready. The command may send more through
+# the fifo named by MOCK_INPUT.
+
+dir=$(dirname "$0")
+mock=${MOCK_OFONOD:-./mock-ofonod}
+
+opts=""
+while [ $# -gt 0 ] && [ "$1" != "--" ]; do
+	opts="$opts $1"
+	shift
+done
+[ "$1" = "--" ] && shift
+
+if [ $# -eq 0 ]; then
+	echo "usage: $0 [mock-ofonod options] -- command [args]" >&2
+	exit 1
+fi
+
+tmp=$(mktemp -d)
+trap 'kill $mock_pid $bus_pid 2>/dev/null; rm -rf "$tmp"' EXIT
+
+dbus-daemon --config-file="$dir/mock-bus.conf" --print-address=3 \
+	--print-pid=4 --fork 3>"$tmp/address" 4>"$tmp/pid" || exit 1
+bus_pid=$(cat "$tmp/pid")
+DBUS_SYSTEM_BUS_ADDRESS=$(head -n 1 "$tmp/address")
+export DBUS_SYSTEM_BUS_ADDRESS
+
+mkfifo "$tmp/in"
+MOCK_INPUT="$tmp/in"
+export MOCK_INPUT
+$mock $opts <"$tmp/in" >"$tmp/out" &
+mock_pid=$!
+exec 5>"$tmp/in"
+
+while ! grep -q ready "$tmp/out" 2>/dev/null; do
+	kill -0 $mock_pid 2>/dev/null || exit 1
+	sleep 0.1
+done
+
+[ -n "$MOCK_SCRIPT" ] && cat "$MOCK_SCRIPT" >&5
+
+"$@"
+ret=$?
+
+echo quit >&5
+exec 5>&-
+wait $mock_pid
+exit $ret
@@ -25,6 +25,7 @@ static void test_sms_set_sca();
 static void test_sms_get_delivery_report();
 static void test_sms_set_delivery_report();
 static void test_sms_send_sms();
+static void test_sms_queue_send();
 static void test_sms_get_cbs_config();
 static void test_sms_set_cbs_powered();
 static void test_sms_set_cbs_topics();
@@ -35,6 +36,7 @@ struct menu_info sms_menu[] = {
   {"ofono_sms_get_delivery_report", test_sms_get_delivery_report, main_menu, NULL},
   {"ofono_sms_set_delivery_report", test_sms_set_delivery_report, main_menu, NULL},
   {"ofono_sms_send_sms", test_sms_send_sms, main_menu, NULL},
+  {"ofono_sms_queue_send", test_sms_queue_send, main_menu, NULL},
   {"ofono_sms_get_cbs_config", test_sms_get_cbs_config, main_menu, NULL},
   {"ofono_sms_set_cbs_powered", test_sms_set_cbs_powered, main_menu, NULL},
   {"ofono_sms_set_cbs_topics", test_sms_set_cbs_topics, main_menu, NULL},
@@ -85,6 +87,34 @@ static void test_sms_send_sms()
   ofono_sms_send_sms(g_modem, num, text, NULL, NULL);
 }
 
+static void on_sms_queue_report(const struct ofono_sms_queue_report *report,
+    void *user_data)
+{
+  printf("%s: state %d, result %d, uuid %s, attempts %u\n",
+        report->recipient, report->state, report->result,
+        report->uuid ? report->uuid : "-", report->attempts);
+}
+
+static void test_sms_queue_send()
+{
+  static struct ofono_sms_queue *queue;
+  char nums[256];
+  char text[256];
+  char **recipients;
+
+  printf("please input numbers and SMS content (e.g:10010,10086 hi):\n");
+  if (scanf("%s %s", nums, text) == EOF)
+    return;
+
+  if (queue == NULL)
+    queue = ofono_sms_queue_new(g_modem, 0);
+
+  recipients = g_strsplit(nums, ",", -1);
+  ofono_sms_queue_send(queue, text, (const char **) recipients,
+        g_strv_length(recipients), on_sms_queue_report, NULL);
+  g_strfreev(recipients);
+}
+
 static void test_sms_get_cbs_config()
 {
   ofono_sms_get_cbs_config(g_modem, NULL, NULL);